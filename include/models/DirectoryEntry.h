@@ -0,0 +1,34 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+// A single object returned by a directory search: its DN plus the requested
+// attributes. Attribute names are case-insensitive, as in LDAP.
+class DirectoryEntry {
+public:
+    DirectoryEntry();
+    explicit DirectoryEntry(const QString& distinguishedName);
+
+    // Getters
+    QString getDistinguishedName() const { return m_distinguishedName; }
+    QString getValue(const QString& attribute) const;
+    QStringList getValues(const QString& attribute) const;
+    bool hasAttribute(const QString& attribute) const;
+    QStringList getAttributeNames() const { return m_attributes.keys(); }
+
+    // Setters
+    void setDistinguishedName(const QString& dn) { m_distinguishedName = dn; }
+    void setValue(const QString& attribute, const QString& value);
+    void setValues(const QString& attribute, const QStringList& values);
+    void addValue(const QString& attribute, const QString& value);
+    void removeAttribute(const QString& attribute);
+    
+    // DN helpers: "CN=a,OU=b,DC=c" -> rdn "CN=a", parent "OU=b,DC=c"
+    static QString rdnOf(const QString& dn);
+    static QString parentOf(const QString& dn);
+
+private:
+    QString m_distinguishedName;
+    QHash<QString, QStringList> m_attributes; // keyed by lower-case attribute name
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <QString>
+#include <QStringView>
+#include <QHashFunctions>
+
+// Interned distinguished name. Every DN is stored once in a process-wide
+// parent-pointer trie: "CN=jdoe,OU=srv01,DC=example,DC=com" is the node
+// "CN=jdoe" under the node for "OU=srv01,DC=example,DC=com". DNs that differ
+// only in case or in spaces around separators share a node, so comparing two
+// handles is a pointer comparison.
+//
+// A node that a handle points at also keeps its rendered string, spelled as
+// the DN was first given, so toString() is a shared copy without a lock.
+// Nodes are reference counted (handles and child nodes) and leave the pool
+// with their last reference. Thread-safe.
+class DistinguishedName {
+public:
+    DistinguishedName() = default;
+    explicit DistinguishedName(QStringView dn);
+    DistinguishedName(const DistinguishedName& other);
+    DistinguishedName(DistinguishedName&& other) noexcept : m_node(other.m_node) { other.m_node = nullptr; }
+    DistinguishedName& operator=(const DistinguishedName& other);
+    DistinguishedName& operator=(DistinguishedName&& other) noexcept;
+    ~DistinguishedName();
+
+    bool isNull() const { return m_node == nullptr; }
+
+    QString toString() const;
+    // The DN one level up, or a null DN for a top-level one
+    DistinguishedName parent() const;
+
+    // Interned DNs (nodes) in the pool, for diagnostics
+    static qsizetype poolSize();
+
+    struct Node; // a trie node, see DistinguishedName.cpp
+
+    friend bool operator==(const DistinguishedName& a, const DistinguishedName& b) { return a.m_node == b.m_node; }
+    friend bool operator!=(const DistinguishedName& a, const DistinguishedName& b) { return a.m_node != b.m_node; }
+    friend size_t qHash(const DistinguishedName& dn, size_t seed = 0) { return ::qHash(quintptr(dn.m_node), seed); }
+
+private:
+    // Takes over a reference the caller already holds
+    explicit DistinguishedName(Node* node) : m_node(node) {}
+
+    Node* m_node = nullptr;
+};
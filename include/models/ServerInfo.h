@@ -3,6 +3,8 @@
 #include <QStringList>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QList>
+#include "models/DistinguishedName.h"
 
 class ServerInfo {
 public:
@@ -15,7 +17,9 @@ public:
     QString getRdpAddress() const { return m_rdpAddress; }
     int getRdpPort() const { return m_rdpPort; }
     QString getEnvironment() const { return m_environment; }
-    QStringList getUserList() const { return m_userList; }
+    QStringList getUserList() const;
+    QList<DistinguishedName> getUsers() const { return m_users; }
+    int userCount() const { return m_users.size(); }
     QJsonObject getMetadata() const { return m_metadata; }
     
     // Setters
@@ -24,7 +28,8 @@ public:
     void setRdpAddress(const QString& address) { m_rdpAddress = address; }
     void setRdpPort(int port) { m_rdpPort = port; }
     void setEnvironment(const QString& env) { m_environment = env; }
-    void setUserList(const QStringList& users) { m_userList = users; }
+    void setUserList(const QStringList& users);
+    void setUsers(const QList<DistinguishedName>& users) { m_users = users; }
     void setMetadata(const QJsonObject& metadata) { m_metadata = metadata; }
     
     // Add user to the list
@@ -43,6 +48,6 @@ private:
     QString m_rdpAddress;
     int m_rdpPort;
     QString m_environment; // prod, test, dev
-    QStringList m_userList;
+    QList<DistinguishedName> m_users; // interned user DNs
     QJsonObject m_metadata;
 };
@@ -1,6 +1,7 @@
 #pragma once
 #include <QString>
 #include <QDateTime>
+#include "models/DistinguishedName.h"
 
 class UserInfo {
 public:
@@ -12,7 +13,8 @@ public:
     QString getFullName() const { return m_fullName; }
     QString getFirstName() const { return m_firstName; }
     QString getLastName() const { return m_lastName; }
-    QString getDistinguishedName() const { return m_distinguishedName; }
+    QString getDistinguishedName() const { return m_distinguishedName.toString(); }
+    DistinguishedName getDn() const { return m_distinguishedName; }
     QString getServerName() const { return m_serverName; }
     QString getPassword() const { return m_password; }
     QDateTime getCreatedDate() const { return m_createdDate; }
@@ -24,7 +26,8 @@ public:
     void setFullName(const QString& fullName) { m_fullName = fullName; }
     void setFirstName(const QString& firstName) { m_firstName = firstName; }
     void setLastName(const QString& lastName) { m_lastName = lastName; }
-    void setDistinguishedName(const QString& dn) { m_distinguishedName = dn; }
+    void setDistinguishedName(const QString& dn) { m_distinguishedName = DistinguishedName(dn); }
+    void setDn(DistinguishedName dn) { m_distinguishedName = dn; }
     void setServerName(const QString& server) { m_serverName = server; }
     void setPassword(const QString& password) { m_password = password; }
     void setCreatedDate(const QDateTime& date) { m_createdDate = date; }
@@ -40,7 +43,7 @@ private:
     QString m_fullName;
     QString m_firstName;
     QString m_lastName;
-    QString m_distinguishedName;
+    DistinguishedName m_distinguishedName; // interned, see DistinguishedName
     QString m_serverName;
     QString m_password;
     QDateTime m_createdDate;
@@ -1,28 +1,179 @@
 #pragma once
 #include <QObject>
 #include <QStringList>
+#include <QHash>
+#include <QElapsedTimer>
 #include <memory>
 #include "models/ServerInfo.h"
 #include "models/UserInfo.h"
+#include "models/DirectoryEntry.h"
+#include "models/NormalizedUser.h"
+#include "services/DirectorySearch.h"
+#include "services/ADSessionCache.h"
+#include "services/ADObjectChangeSet.h"
+#include "services/IDirectoryBackend.h"
+#include "services/ResilientDirectoryBackend.h"
+#include "services/ADObjectCache.h"
+#include "services/DirectoryReplica.h"
+#include "services/LoginIndex.h"
+#include "services/OperationMetrics.h"
 
-#ifdef _WIN32
-#include <windows.h>
-#include <activeds.h>
-#include <adshlp.h>
-#include <comdef.h>
-#pragma comment(lib, "activeds.lib")
-#pragma comment(lib, "adsiid.lib")
-#endif
+struct ExistenceCheckStats {
+    quint64 checks = 0;           // serverExists() calls
+    quint64 directoryLookups = 0; // of those, answered by the directory
+};
+
+// Outcome of one user of deactivateUsers
+struct BulkDeactivateResult {
+    enum class Status {
+        Deactivated,  // also when the account was already disabled
+        NotFound,     // no such user
+        Failed,       // the directory rejected the change
+        NotAttempted  // never sent, e.g. the connection dropped first
+    };
+
+    QString dn;
+    Status status = Status::NotAttempted;
+    QString error; // empty when deactivated
+
+    bool isDeactivated() const { return status == Status::Deactivated; }
+};
+
+// A manager's settings, connection and shared state, captured on its own
+// thread so that workers on other threads can be built from it without
+// reading the manager (see ADWorkerSet)
+struct ADWorkerProfile {
+    RetryPolicy retryPolicy;
+    int searchPageSize = 0;
+    int existenceTtlMs = 0;
+    QString domain;
+    QString namingContext;
+    bool connected = false;
+    std::shared_ptr<ADObjectCache> objectCache;
+    std::shared_ptr<DirectoryReplica> replica;
+    std::shared_ptr<LoginIndex> loginIndex;
+};
 
 class ADManager : public QObject {
     Q_OBJECT
     
 public:
-    explicit ADManager(QObject* parent = nullptr);
+    // Marks one logical operation. While the outermost scope is alive, each
+    // server's existence is looked up in the directory at most once; nested
+    // calls (createUser -> createServerOU -> serverExists) reuse the answer
+    class OperationScope {
+    public:
+        explicit OperationScope(ADManager* manager);
+        ~OperationScope();
+        OperationScope(const OperationScope&) = delete;
+        OperationScope& operator=(const OperationScope&) = delete;
+        
+    private:
+        ADManager* m_manager;
+    };
+    
+    // Times one public entry point into OperationMetrics::global(). The call
+    // counts as failed if this manager emitted error() before it returned.
+    // Only the outermost scope records; entry points called by another one
+    // are part of its time
+    class MetricScope {
+    public:
+        MetricScope(ADManager* manager, DirectoryOperation operation);
+        ~MetricScope();
+        MetricScope(const MetricScope&) = delete;
+        MetricScope& operator=(const MetricScope&) = delete;
+        
+        // Leaves the call out, e.g. when it was answered without the directory
+        void skip() { m_recording = false; }
+        
+    private:
+        ADManager* m_manager;
+        DirectoryOperation m_operation;
+        bool m_recording;
+        quint64 m_errorsBefore;
+        QElapsedTimer m_timer;
+    };
+    
+    // Without a backend the platform default is used: ADSI on Windows,
+    // the in-memory directory elsewhere
+    explicit ADManager(QObject* parent = nullptr, std::unique_ptr<IDirectoryBackend> backend = nullptr);
     ~ADManager();
     
+    // Directory backends: "adsi" (Windows only), "ldap" (libldap builds) and "memory"
+    static std::unique_ptr<IDirectoryBackend> createBackend(const QString& type = QString());
+    void setBackend(std::unique_ptr<IDirectoryBackend> backend);
+    // The backend itself; ADManager reaches it through a retry layer
+    IDirectoryBackend* getBackend() const { return m_backend->inner(); }
+    
+    // Transient directory errors (busy, unavailable, timeout) are retried
+    // with backoff under every operation, behind a circuit breaker per DC.
+    // The backoff sleeps, so a manager on the GUI thread should not retry
+    // and leave that to its workers: they get the worker policy instead and
+    // share the breakers
+    void setRetryPolicy(const RetryPolicy& policy) { m_backend->setPolicy(policy); }
+    RetryPolicy retryPolicy() const { return m_backend->policy(); }
+    void setWorkerRetryPolicy(const RetryPolicy& policy) { m_workerRetryPolicy = policy; }
+    RetryPolicy workerRetryPolicy() const { return m_workerRetryPolicy; }
+    RetryStats retryStats() const { return m_backend->stats(); }
+    
+    // Accepts a DNS name (example.com) or a DN (DC=example,DC=com)
     bool connectToAD(const QString& domain = "");
+    // Takes over a connection a worker made (ADManagerAsync::connectToAD):
+    // the state changes at once and this manager's own backend binds on its
+    // first operation, so the calling thread never waits for the bind
+    void adoptConnection(const QString& domain, const QString& namingContext);
     bool isConnected() const { return m_connected; }
+    QString getDomain() const { return m_domain; }
+    QString getNamingContext() const { return m_namingContext; }
+    
+    // Creates a manager with the same settings and domain for use on another
+    // thread, on a clone of this manager's backend. Call it on this manager's
+    // thread; pool threads build theirs from a profile (ADWorkerSet)
+    std::unique_ptr<ADManager> createWorker() const;
+    ADWorkerProfile workerProfile() const;
+    // Takes over a profile's settings and shared state, and binds to its
+    // naming context if it is connected there and this manager is not
+    void applyWorkerProfile(const ADWorkerProfile& profile);
+    
+    // Paged search engine
+    static constexpr int DefaultSearchPageSize = 1000;
+    void setSearchPageSize(int pageSize);
+    int searchPageSize() const { return m_searchPageSize; }
+    bool search(const SearchRequest& request, const SearchPageCallback& onPage);
+    QList<DirectoryEntry> searchAll(const SearchRequest& request);
+    
+    // Cache of UserInfo/ServerInfo objects, revalidated by uSNChanged.
+    // Workers created by createWorker share this manager's cache
+    void setObjectCache(std::shared_ptr<ADObjectCache> cache);
+    ADObjectCache* getObjectCache() const { return m_objectCache.get(); }
+    ObjectCacheStats objectCacheStats() const { return m_objectCache->stats(); }
+    
+    // Local replica of servers and users. syncReplica() fetches only what
+    // changed since the replica's uSNChanged watermark, plus tombstones of
+    // deleted objects; a replica of another directory is rebuilt in full.
+    // Workers created by createWorker share this manager's replica
+    ReplicaSyncResult syncReplica();
+    bool saveReplica();
+    void setReplica(std::shared_ptr<DirectoryReplica> replica);
+    DirectoryReplica* getReplica() const { return m_replica.get(); }
+    bool isReplicaReady() const;
+    
+    // Taken logins by login base, for generateUniqueLogin. Shared with
+    // workers created by createWorker
+    void setLoginIndex(std::shared_ptr<LoginIndex> index);
+    LoginIndex* getLoginIndex() const { return m_loginIndex.get(); }
+    
+    // Outside an operation, existence answers are reused for this long, so
+    // back-to-back operations (a batch of createUser calls) share them too.
+    // 0 limits reuse to a single operation
+    static constexpr int DefaultExistenceTtlMs = 2000;
+    void setExistenceTtl(int ttlMs) { m_existenceTtlMs = ttlMs; }
+    ExistenceCheckStats existenceStats() const { return m_existenceStats; }
+    void resetExistenceStats() { m_existenceStats = ExistenceCheckStats(); }
+    
+    // Bind/session cache diagnostics
+    SessionCacheStats sessionCacheStats() const { return m_backend->sessionCacheStats(); }
+    void resetSessionCacheStats() { m_backend->resetSessionCacheStats(); }
     
     // Server/OU Management
     QStringList getServerList();
@@ -32,34 +183,86 @@ public:
     
     // User Management
     QStringList getUsersForServer(const QString& serverName);
+    // Member DNs of the server's group, one range (up to 1500 values on AD)
+    // per call; return false from onRange to stop early
+    bool streamServerMembers(const QString& serverName,
+                             const std::function<bool(const QStringList&)>& onRange);
+    QList<UserInfo> getUsersWithInfoForServer(const QString& serverName,
+                                              const QStringList& attributeList = QStringList());
+    bool streamUsersForServer(const QString& serverName,
+                              const std::function<bool(const QList<UserInfo>&)>& onPage,
+                              const QStringList& attributeList = QStringList());
+    // One window of a server's users in the given order, e.g. the rows a
+    // table shows; the server sorts and slices (sort + VLV controls) where
+    // it can. result.contentCount is the number of users in the server
+    bool getUsersWindow(const QString& serverName, const QList<SortKey>& order, const VlvWindow& window,
+                        QList<UserInfo>& users, VlvResult& result);
     UserInfo getUserInfo(const QString& userDN);
+    QList<UserInfo> getUsersByDN(const QStringList& userDNs);
     bool createUser(const UserInfo& user, const QString& serverName);
     bool updateUser(const UserInfo& user);
     bool deactivateUser(const QString& userDN);
+    // Disables many accounts at once: the flags of all targets come from one
+    // search, and the modifies go out as one batch that backends able to
+    // pipeline keep several of in flight. One result per DN, in order; a
+    // user not found, a rejected change and one never sent are told apart
+    QList<BulkDeactivateResult> deactivateUsers(const QStringList& userDNs);
     bool changePassword(const QString& userDN, const QString& newPassword);
     
     // Metadata Storage (using extensionAttributes)
     bool setServerMetadata(const QString& serverName, const QJsonObject& metadata);
     QJsonObject getServerMetadata(const QString& serverName);
     
+    // Staged writes: every change in the set is applied in one modify
+    bool commitChanges(const ADObjectChangeSet& changes);
+    
     // Validation
     bool serverExists(const QString& serverName);
     bool userExists(const QString& login);
+    // Picks from the login index; a pick from a base loaded earlier is
+    // confirmed with userExists, since others may have created it since
     QString generateUniqueLogin(const QString& firstName, const QString& lastName);
+    // Assigns unique logins to every valid user of a batch before anything
+    // is created: one fresh prefix search per distinct login base, then a
+    // single pass that also keeps the batch's own logins apart. A user's
+    // suggested login, if any, is used as its base
+    bool allocateLogins(QList<NormalizedUser>& users);
+    
+    // Directory entry -> model mapping (platform independent)
+    static QStringList defaultUserAttributes();
+    static UserInfo userInfoFromEntry(const DirectoryEntry& entry);
     
 signals:
     void connectionStatusChanged(bool connected);
     void operationProgress(const QString& operation, int progress);
     void error(const QString& errorMessage);
-    
-private slots:
-    void handleADError(const QString& operation, HRESULT hr);
+    void searchPageReady(const QList<DirectoryEntry>& page);
     
 private:
     bool m_connected;
-    QString m_domainDN;
-    QString m_serverContainer;
-    QString m_userContainer;
+    QString m_domain;
+    QString m_namingContext;
+    int m_searchPageSize;
+    std::unique_ptr<ResilientDirectoryBackend> m_backend;
+    RetryPolicy m_workerRetryPolicy;
+    std::shared_ptr<ADObjectCache> m_objectCache;
+    std::shared_ptr<DirectoryReplica> m_replica;
+    std::shared_ptr<LoginIndex> m_loginIndex;
+    
+    // Server existence memo, see OperationScope
+    struct ExistenceEntry {
+        bool exists = false;
+        quint64 operation = 0;
+        qint64 checkedMs = 0;
+    };
+    QHash<QString, ExistenceEntry> m_serverExistence; // lower-case server name
+    int m_operationDepth;
+    quint64 m_operationId;
+    int m_existenceTtlMs;
+    QElapsedTimer m_existenceClock;
+    ExistenceCheckStats m_existenceStats;
+    quint64 m_errorsReported; // error() emissions, see MetricScope
+    int m_metricDepth;
     
     // AD Helper methods
     QString buildUserDN(const QString& login, const QString& serverName);
@@ -67,12 +270,20 @@ private:
     QString buildServerOUDN(const QString& serverName);
     bool setADAttribute(const QString& objectDN, const QString& attribute, const QString& value);
     QString getADAttribute(const QString& objectDN, const QString& attribute);
-    
-#ifdef _WIN32
-    HRESULT getObject(const QString& distinguishedName, IDispatch** ppObject);
-    HRESULT getObjectAttribute(IDispatch* pObject, const QString& attributeName, VARIANT* pvAttribute);
-    HRESULT setObjectAttribute(IDispatch* pObject, const QString& attributeName, VARIANT* pvAttribute);
-    QString variantToString(VARIANT& var);
-    void releaseInterface(IUnknown* pInterface);
-#endif
+    void reportBackendError(const QString& operation);
+    // addEntry that also succeeds when the entry was created concurrently
+    bool addOrConfirm(const DirectoryEntry& entry, const QString& operation);
+    // Whether the object at dn was written after version, a uSNChanged value
+    bool changedSince(const QString& dn, const QString& version);
+    void invalidateCached(const QString& dn);
+    QString serverNameFromDN(const QString& dn) const;
+    QString replicaSource() const;
+    bool loadLoginBase(const QString& baseLogin);
+    // Reports its own errors
+    bool readGroupMembers(const QString& groupDN, const QStringList& attributes, DirectoryEntry& entry,
+                          const std::function<bool(const QStringList&)>& onRange);
+    void rememberServer(const QString& serverName, bool exists);
+    static QString loginBaseFor(const QString& firstName, const QString& lastName);
+    static QJsonObject decodeMetadata(const QString& value);
+    static QString namingContextFor(const QString& domain);
 };
@@ -0,0 +1,73 @@
+#pragma once
+#include <QObject>
+#include <QFuture>
+#include <QThreadPool>
+#include <QAtomicInteger>
+#include <functional>
+#include "services/ADManager.h"
+#include "services/ADWorkerSet.h"
+
+// Runs ADManager operations on a worker thread pool so the GUI thread never
+// waits on a domain controller. Every pool thread owns its own ADManager,
+// and with it its own COM apartment and binding cache, built from a snapshot
+// of the source (see ADWorkerSet) that is retaken whenever the source's
+// connection changes. Results are returned as QFutures and also re-emitted
+// as signals on the thread that owns this object.
+class ADManagerAsync : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ADManagerAsync(ADManager* source, int maxThreads = 4, QObject* parent = nullptr);
+    ~ADManagerAsync();
+
+    // Binds a worker to the domain and, once that succeeded, has the source
+    // take the connection over (ADManager::adoptConnection) on this thread.
+    // onBound runs on the worker between the two, e.g. to seed a test
+    // directory before anything is loaded from it
+    QFuture<bool> connectToAD(const QString& domain, const std::function<void(ADManager*)>& onBound = nullptr);
+    QFuture<QStringList> getServerList();
+    QFuture<ServerInfo> getServerInfo(const QString& serverName);
+    QFuture<UserInfo> getUserInfo(const QString& userDN);
+    QFuture<QStringList> getUsersForServer(const QString& serverName);
+    QFuture<bool> deactivateUser(const QString& userDN);
+    QFuture<QList<BulkDeactivateResult>> deactivateUsers(const QStringList& userDNs);
+    QFuture<bool> changePassword(const QString& userDN, const QString& newPassword);
+
+    // Fetches count users starting at row first (0-based) in the given
+    // order through userWindowLoaded; supersedes any load in flight.
+    // total and context come from the previous window, if any. The future
+    // is false when the window failed or a newer load superseded it
+    QFuture<bool> loadUserWindow(const QString& serverName, const QList<SortKey>& order, int first, int count,
+                                 int total = 0, const QByteArray& context = QByteArray());
+    // Writes the server's users as CSV; on any failure the partial file is
+    // removed, the cause goes out through error() and the count is -1
+    QFuture<int> exportUsers(const QString& serverName, const QString& fileName);
+    // A copy of users with logins made unique, see ADManager::allocateLogins
+    QFuture<QList<NormalizedUser>> allocateLogins(const QList<NormalizedUser>& users);
+
+    // Brings the shared replica up to date; see ADManager::syncReplica()
+    QFuture<ReplicaSyncResult> syncReplica();
+    QFuture<bool> saveReplica();
+
+    void waitForDone();
+
+signals:
+    void serversLoaded(const QStringList& servers);
+    void serverInfoLoaded(const ServerInfo& serverInfo);
+    void userInfoLoaded(const UserInfo& userInfo);
+    void userWindowLoaded(const QString& serverName, int firstRow, const QList<UserInfo>& users, int total,
+                          const QByteArray& context);
+    void usersDeactivated(const QList<BulkDeactivateResult>& results);
+    void exportFinished(const QString& fileName, int count, bool success);
+    void replicaSynced(const ReplicaSyncResult& result);
+    void operationFinished(const QString& operation, bool success);
+    void error(const QString& errorMessage);
+
+private:
+    ADManager* worker() { return m_workers.local(); }
+
+    ADManager* m_source; // only touched on this object's thread
+    QAtomicInteger<int> m_loadGeneration;
+    ADWorkerSet m_workers; // before the pool, see ADWorkerSet
+    QThreadPool m_pool;
+};
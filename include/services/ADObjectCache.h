@@ -0,0 +1,70 @@
+#pragma once
+#include <QString>
+#include <QVariant>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <list>
+
+struct ObjectCacheStats {
+    quint64 hits = 0;          // served without contacting the directory
+    quint64 revalidations = 0; // stale, but the directory confirmed it unchanged
+    quint64 misses = 0;        // absent, or changed in the directory
+    quint64 evictions = 0;
+    quint64 invalidations = 0;
+    qint64 bytes = 0;
+    int entries = 0;
+};
+
+// Bounded LRU cache of directory-derived objects (UserInfo, ServerInfo...),
+// each stored with the version token it was read at (uSNChanged, or
+// whenChanged where the directory has no USNs). Within the TTL an entry is
+// served as is; after that the caller revalidates it by comparing the token
+// with the directory's current one, which costs one tiny read instead of a
+// full reload.
+//
+// Size is accounted with a caller-supplied cost in bytes. Thread-safe, so
+// one instance can be shared by every ADManager worker.
+class ADObjectCache {
+public:
+    enum class Lookup { Miss, Fresh, Stale };
+
+    explicit ADObjectCache(qint64 maxBytes = 32 * 1024 * 1024, int ttlMs = 30000);
+
+    void setMaxBytes(qint64 maxBytes);
+    void setTtl(int ttlMs) { m_ttlMs = ttlMs; }
+    qint64 maxBytes() const { return m_maxBytes; }
+    int ttl() const { return m_ttlMs; }
+
+    // Fresh: use value. Stale: value and version are filled in; call
+    // revalidated() if the version still matches, otherwise reload.
+    Lookup lookup(const QString& key, QVariant& value, QString& version);
+    void insert(const QString& key, const QVariant& value, const QString& version, qint64 cost);
+    void revalidated(const QString& key);
+
+    void invalidate(const QString& key);
+    void clear();
+
+    ObjectCacheStats stats() const;
+    void resetStats();
+
+private:
+    struct Item {
+        QVariant value;
+        QString version;
+        qint64 cost = 0;
+        qint64 validatedMs = 0;
+        std::list<QString>::iterator lruPosition;
+    };
+
+    void removeLocked(QHash<QString, Item>::iterator it);
+    void shrinkLocked();
+
+    mutable QMutex m_mutex;
+    QHash<QString, Item> m_items;
+    std::list<QString> m_lru; // most recently used first
+    QElapsedTimer m_clock;
+    qint64 m_maxBytes;
+    int m_ttlMs;
+    ObjectCacheStats m_stats;
+};
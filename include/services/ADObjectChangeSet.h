@@ -0,0 +1,46 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+// Attribute modifications staged against a single directory object.
+// ADManager::commitChanges applies them all with one SetInfo (one LDAP modify).
+class ADObjectChangeSet {
+public:
+    enum class Operation {
+        Replace,  // ADS_PROPERTY_UPDATE
+        Append,   // ADS_PROPERTY_APPEND
+        Remove,   // ADS_PROPERTY_DELETE
+        Clear     // ADS_PROPERTY_CLEAR
+    };
+    
+    struct Change {
+        QString attribute;
+        Operation operation;
+        QStringList values;
+    };
+    
+    ADObjectChangeSet();
+    explicit ADObjectChangeSet(const QString& distinguishedName);
+    
+    QString getDistinguishedName() const { return m_distinguishedName; }
+    void setDistinguishedName(const QString& dn) { m_distinguishedName = dn; }
+    
+    // Staging (Put/PutEx equivalents)
+    ADObjectChangeSet& put(const QString& attribute, const QString& value);
+    ADObjectChangeSet& putValues(const QString& attribute, const QStringList& values);
+    ADObjectChangeSet& append(const QString& attribute, const QStringList& values);
+    ADObjectChangeSet& remove(const QString& attribute, const QStringList& values);
+    ADObjectChangeSet& clear(const QString& attribute);
+    
+    const QList<Change>& getChanges() const { return m_changes; }
+    bool isEmpty() const { return m_changes.isEmpty(); }
+    int size() const { return m_changes.size(); }
+    void reset() { m_changes.clear(); }
+    
+private:
+    void addChange(const QString& attribute, Operation operation, const QStringList& values);
+    
+    QString m_distinguishedName;
+    QList<Change> m_changes;
+};
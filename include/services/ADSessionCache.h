@@ -0,0 +1,66 @@
+#pragma once
+#include <QString>
+#include <QHash>
+#include <QPair>
+#include <QElapsedTimer>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <activeds.h>
+#endif
+
+struct SessionCacheStats {
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 evictions = 0;
+    int openSessions = 0;
+};
+
+// Keeps authenticated ADSI bindings alive between calls so repeated
+// attribute reads/writes on the same object skip the bind + auth handshake.
+// The naming context binding is pinned for the lifetime of the cache, which
+// also lets ADSI reuse its underlying LDAP connection for every other bind.
+class ADSessionCache {
+public:
+    explicit ADSessionCache(int maxSessions = 256, int idleTimeoutMs = 120000);
+    ~ADSessionCache();
+
+    void setMaxSessions(int maxSessions) { m_maxSessions = maxSessions; }
+    void setIdleTimeout(int idleTimeoutMs) { m_idleTimeoutMs = idleTimeoutMs; }
+
+#ifdef _WIN32
+    // Returns an AddRef'd interface for the object; release it as usual.
+    // fastBind skips the objectClass lookup and only exposes the base ADSI
+    // interfaces (IADs, IDirectoryObject, IDirectorySearch, ...).
+    HRESULT acquire(const QString& distinguishedName, REFIID riid, void** ppObject, bool fastBind = false);
+    HRESULT pinNamingContext(const QString& namingContextDN);
+#endif
+
+    void invalidate(const QString& distinguishedName);
+    void evictIdle();
+    void clear();
+
+    SessionCacheStats stats() const;
+    void resetStats();
+
+private:
+    using SessionKey = QPair<QString, bool>; // lower-case DN, fast bind
+
+    struct Session {
+#ifdef _WIN32
+        IUnknown* object = nullptr;
+#endif
+        qint64 lastUsedMs = 0;
+        bool pinned = false;
+    };
+
+    void evictLeastRecentlyUsed();
+    void release(Session& session);
+
+    QHash<SessionKey, Session> m_sessions;
+    QElapsedTimer m_clock;
+    qint64 m_lastSweepMs;
+    int m_maxSessions;
+    int m_idleTimeoutMs;
+    SessionCacheStats m_stats;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <QMutex>
+#include <QThreadStorage>
+#include <functional>
+#include <memory>
+#include "services/ADManager.h"
+
+// The per-thread ADManagers of a thread pool, built from a source manager
+// that lives on another thread (ADManagerAsync, BulkUserCreator,
+// BulkPasswordRotator). Pool threads never touch the source: refresh(),
+// called on the source's thread, captures its profile and a prototype of its
+// backend under a lock, and each pool thread builds or updates its own
+// manager from that snapshot.
+//
+// Declare the set before the QThreadPool it serves: the pool must be drained
+// (and its threads exit, deleting their managers) before the storage goes.
+class ADWorkerSet {
+public:
+    // onCreated runs on the pool thread for every new manager, before it
+    // binds, e.g. to forward its signals
+    explicit ADWorkerSet(ADManager* source, std::function<void(ADManager*)> onCreated = nullptr);
+    ADWorkerSet(const ADWorkerSet&) = delete;
+    ADWorkerSet& operator=(const ADWorkerSet&) = delete;
+
+    // Takes a new snapshot of the source; call on the source's thread after
+    // its connection or settings changed
+    void refresh();
+
+    // The calling thread's manager. Created on first use, rebuilt once the
+    // source has another backend, otherwise brought in line with the latest
+    // snapshot (settings, and the bind when the source moved or reconnected)
+    ADManager* local();
+
+private:
+    struct Worker {
+        std::unique_ptr<ADManager> manager;
+        quint64 backendGeneration = 0;
+        quint64 profileGeneration = 0;
+    };
+
+    ADManager* m_source;
+    std::function<void(ADManager*)> m_onCreated;
+
+    QMutex m_mutex;
+    // Only ever cloned, on the pool threads; created and destroyed on the
+    // source's thread, which matters for ADSI's COM apartments
+    std::unique_ptr<IDirectoryBackend> m_prototype;
+    const IDirectoryBackend* m_sourceBackend;
+    ADWorkerProfile m_profile;
+    quint64 m_backendGeneration;
+    quint64 m_profileGeneration;
+
+    QThreadStorage<Worker*> m_workers;
+};
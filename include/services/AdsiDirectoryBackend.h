@@ -0,0 +1,56 @@
+#pragma once
+#ifdef _WIN32
+#include "services/IDirectoryBackend.h"
+#include "services/ADSessionCache.h"
+
+#include <windows.h>
+#include <activeds.h>
+#include <adshlp.h>
+#include <comdef.h>
+#pragma comment(lib, "activeds.lib")
+#pragma comment(lib, "adsiid.lib")
+
+// Active Directory through ADSI. Each instance initializes COM for the
+// thread that creates it and must be destroyed on that same thread.
+class AdsiDirectoryBackend : public IDirectoryBackend {
+public:
+    AdsiDirectoryBackend();
+    ~AdsiDirectoryBackend() override;
+
+    QString getName() const override { return "adsi"; }
+    std::unique_ptr<IDirectoryBackend> clone() const override;
+
+    bool connect(const QString& namingContext) override;
+    QString getNamingContext() const override { return m_namingContext; }
+
+    bool search(const SearchRequest& request, const SearchPageCallback& onPage) override;
+    bool searchWindow(const SearchRequest& request, const VlvWindow& window,
+                      QList<DirectoryEntry>& entries, VlvResult& result) override;
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override;
+    bool entryExists(const QString& dn) override;
+
+    bool addEntry(const DirectoryEntry& entry) override;
+    bool modifyEntry(const ADObjectChangeSet& changes) override;
+    bool deleteEntry(const QString& dn) override;
+    bool setPassword(const QString& dn, const QString& password) override;
+
+    SessionCacheStats sessionCacheStats() const override { return m_sessionCache.stats(); }
+    void resetSessionCacheStats() override { m_sessionCache.resetStats(); }
+
+private:
+    HRESULT getObject(const QString& distinguishedName, IADs** ppObject);
+    HRESULT setObjectAttribute(IADs* pObject, const QString& attributeName, VARIANT* pvAttribute);
+    HRESULT stageChange(IADs* pObject, const ADObjectChangeSet::Change& change);
+    // With a window, runs a single VLV request instead of a paged search
+    HRESULT searchDirectory(const SearchRequest& request, const SearchPageCallback& onPage,
+                            const VlvWindow* window = nullptr, VlvResult* windowResult = nullptr);
+    QStringList searchColumnToStrings(const ADS_SEARCH_COLUMN& column);
+    QString variantToString(VARIANT& var);
+    void releaseInterface(IUnknown* pInterface);
+    bool fail(const QString& operation, HRESULT hr);
+
+    QString m_namingContext;
+    ADSessionCache m_sessionCache;
+    bool m_comInitialized;
+};
+#endif
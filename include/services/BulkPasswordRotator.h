@@ -0,0 +1,96 @@
+#pragma once
+#include <QObject>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "services/ADWorkerSet.h"
+#include "services/PasswordGenerator.h"
+#include "utils/SecureRecordFile.h"
+
+
+struct BulkRotateResult {
+    int index = -1;      // position in the list passed to start()
+    QString dn;
+    bool success = false;
+    QString error;       // empty on success
+    qint64 elapsedMs = 0;
+};
+
+// Sets a new password on a batch of accounts, e.g. every user of a
+// compromised server. The passwords are generated in one batch up front;
+// up to concurrency changePassword calls are in flight, each pool thread
+// on its own ADManager as in BulkUserCreator.
+//
+// New passwords never appear in results or signals; they go to an encrypted
+// SecureRecordFile that journals every change. A record is one compact JSON
+// object with "dn" and "status":
+//
+//   "pending"   written, with the new "password", before the change is sent
+//   "rotated"   the change was applied
+//   "failed"    it was not, with the "error"
+//
+// A pending record without an outcome (the job died in between) means the
+// password may or may not be in effect; the file has it either way. An
+// account whose pending record cannot be written is left alone, and any
+// record that cannot be written cancels the rest of the batch.
+class BulkPasswordRotator : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultConcurrency = 8;
+    static constexpr int DefaultProgressIntervalMs = 100;
+
+    BulkPasswordRotator(ADManager* source, PasswordGenerator* generator, QObject* parent = nullptr);
+    ~BulkPasswordRotator();
+
+    void setConcurrency(int concurrency);
+    int concurrency() const { return m_pool.maxThreadCount(); }
+    void setProgressInterval(int intervalMs);
+
+    // Returns false, with errorString() set, if a batch is already running
+    // or the output file cannot be created
+    bool start(const QStringList& userDNs, const PasswordPolicy& policy, const QString& outputFile,
+               const QString& passphrase);
+    // Items not yet started finish as cancelled; running ones complete
+    void cancel();
+    bool isRunning() const { return m_running; }
+    QString errorString() const;
+
+    // Every item's result, in input order, once finished() was emitted
+    QList<BulkRotateResult> results() const;
+
+signals:
+    void progress(int completed, int total);
+    void itemsFinished(const QList<BulkRotateResult>& results);
+    void finished(int rotated, int total, qint64 elapsedMs);
+
+private slots:
+    void flush();
+
+private:
+    ADManager* worker() { return m_workers.local(); }
+    BulkRotateResult rotateOne(int index, const QString& userDN, const QString& password);
+    bool writeRecord(const QJsonObject& record);
+
+    PasswordGenerator* m_generator;
+    bool m_running;
+    int m_total;
+    QAtomicInteger<int> m_completed;
+    QAtomicInteger<int> m_rotated;
+    QAtomicInteger<int> m_cancelled;
+    QElapsedTimer m_clock;
+    QTimer m_progressTimer;
+
+    mutable QMutex m_mutex;
+    QList<BulkRotateResult> m_results;  // by input index
+    QList<BulkRotateResult> m_pending;  // finished since the last flush
+    SecureRecordFile m_output;          // written under m_mutex
+    QString m_error;
+
+    ADWorkerSet m_workers; // before the pool, see ADWorkerSet
+    QThreadPool m_pool;
+};
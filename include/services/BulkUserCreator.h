@@ -0,0 +1,80 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "services/ADWorkerSet.h"
+#include "models/UserInfo.h"
+
+
+struct BulkCreateResult {
+    int index = -1;      // position in the list passed to start()
+    QString login;
+    bool success = false;
+    QString error;       // empty on success
+    qint64 elapsedMs = 0;
+};
+
+// Creates a batch of users with up to concurrency createUser calls in
+// flight. Each pool thread owns an ADManager built from a snapshot of the
+// source taken by start() (see ADWorkerSet), as in ADManagerAsync.
+//
+// Results and progress are collected on the worker threads and delivered on
+// the owner's thread at most once per progress interval, so a large batch
+// costs a handful of signals instead of one repaint per user.
+class BulkUserCreator : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultConcurrency = 8;
+    static constexpr int DefaultProgressIntervalMs = 100;
+
+    explicit BulkUserCreator(ADManager* source, QObject* parent = nullptr);
+    ~BulkUserCreator();
+
+    void setConcurrency(int concurrency);
+    int concurrency() const { return m_pool.maxThreadCount(); }
+    void setProgressInterval(int intervalMs);
+
+    // Returns false if a batch is already running
+    bool start(const QList<UserInfo>& users, const QString& serverName);
+    // Items not yet started finish as cancelled; running ones complete
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+    // Every item's result, in input order, once finished() was emitted
+    QList<BulkCreateResult> results() const;
+
+signals:
+    void progress(int completed, int total);
+    void itemsFinished(const QList<BulkCreateResult>& results);
+    void finished(int created, int total, qint64 elapsedMs);
+
+private slots:
+    void flush();
+
+private:
+    ADManager* worker() { return m_workers.local(); }
+    // Creates the server's OU and group; the error, or empty when both exist
+    QString prepareServer(const QString& serverName);
+    BulkCreateResult createOne(int index, const UserInfo& user, const QString& serverName);
+    void record(const BulkCreateResult& result);
+
+    bool m_running;
+    int m_total;
+    QAtomicInteger<int> m_completed;
+    QAtomicInteger<int> m_created;
+    QAtomicInteger<int> m_cancelled;
+    QElapsedTimer m_clock;
+    QTimer m_progressTimer;
+
+    mutable QMutex m_mutex;
+    QList<BulkCreateResult> m_results;  // by input index
+    QList<BulkCreateResult> m_pending;  // finished since the last flush
+
+    ADWorkerSet m_workers; // before the pool, see ADWorkerSet
+    QThreadPool m_pool;
+};
@@ -30,6 +30,16 @@ public:
     QString getAdDefaultUserGroup() const;
     QString getAdAdminGroup() const;
     QString getAdMetadataAttribute() const;
+    int getAdSearchPageSize() const;
+    QString getAdBackend() const;
+    int getAdMemorySeedUsers() const;
+    int getAdCacheTtl() const;
+    int getAdCacheMaxMegabytes() const;
+    int getAdBulkConcurrency() const;
+    int getAdRotationConcurrency() const;
+    QJsonObject getLdapSettings() const;
+    QJsonObject getRetrySettings() const;
+    QJsonObject getMetricsSettings() const;
     
     void setAdDomain(const QString& domain);
     void setAdUsersContainer(const QString& container);
@@ -38,6 +48,16 @@ public:
     void setAdDefaultUserGroup(const QString& group);
     void setAdAdminGroup(const QString& group);
     void setAdMetadataAttribute(const QString& attribute);
+    void setAdSearchPageSize(int pageSize);
+    void setAdBackend(const QString& backend);
+    void setAdMemorySeedUsers(int count);
+    void setAdCacheTtl(int ttlMs);
+    void setAdCacheMaxMegabytes(int megabytes);
+    void setAdBulkConcurrency(int concurrency);
+    void setAdRotationConcurrency(int concurrency);
+    void setLdapSettings(const QJsonObject& settings);
+    void setRetrySettings(const QJsonObject& settings);
+    void setMetricsSettings(const QJsonObject& settings);
     
     // Password Policy
     QJsonObject getPasswordPolicy() const;
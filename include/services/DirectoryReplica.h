@@ -0,0 +1,86 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+#include "models/DirectoryEntry.h"
+#include "services/DirectorySnapshot.h"
+
+struct ReplicaSyncResult {
+    bool success = false;
+    bool fullSync = false;
+    int updated = 0;            // objects added or changed
+    int deleted = 0;            // tombstones applied
+    qint64 watermark = 0;       // highest uSNChanged now in the replica
+    QStringList changedServers; // servers whose OU, group or users changed
+};
+
+// Local copy of the server OUs, groups and users under a naming context,
+// kept current by ADManager::syncReplica(). Objects are keyed by objectGUID,
+// which survives renames and deletion, so tombstones can be matched to the
+// object they replace. The watermark is the highest uSNChanged applied; the
+// next sync only asks for objects changed after it.
+//
+// Thread-safe; one instance is shared by every ADManager worker. save() and
+// load() persist the replica together with its watermark between runs, as a
+// DirectorySnapshot that the UI can also map directly at startup.
+class DirectoryReplica {
+public:
+    DirectoryReplica() = default;
+
+    // Identifies the directory the replica was built from; a replica from a
+    // different source is discarded by the next sync
+    QString getSource() const;
+    qint64 getWatermark() const;
+    void setWatermark(qint64 watermark);
+    void reset(const QString& source);
+    // Takes over another replica's contents, e.g. one staged by a full sync
+    void adopt(DirectoryReplica& other);
+
+    // serverName is the server OU the object belongs to (empty if none)
+    void upsert(const QString& serverName, const DirectoryEntry& entry);
+    // Returns the server the object belonged to, or an empty string
+    QString remove(const QString& objectGuid);
+
+    QStringList getServerNames() const;
+    QList<DirectoryEntry> getUsersForServer(const QString& serverName) const;
+    int entryCount() const;
+
+    // Only one sync may run at a time; a second caller gets false
+    bool tryBeginSync() { return m_syncing.testAndSetOrdered(0, 1); }
+    void endSync() { m_syncing.storeRelease(0); }
+
+    // Persisted storage; save() is a no-op without a path
+    void setStoragePath(const QString& path);
+    QString getStoragePath() const;
+    bool load();
+    bool save() const;
+
+    static QString keyOf(const DirectoryEntry& entry);
+
+private:
+    using Kind = DirectoryObjectKind;
+
+    struct Object {
+        Kind kind = Kind::Other;
+        QString server; // lower-case server name
+        DirectoryEntry entry;
+    };
+
+    static Kind kindOf(const DirectoryEntry& entry);
+    // Callers hold the write lock
+    void unlinkLocked(const QString& key, const Object& object);
+
+    mutable QReadWriteLock m_lock;
+    QString m_source;
+    qint64 m_watermark = 0;
+    QString m_storagePath;
+    QHash<QString, Object> m_objects;             // objectGUID -> object
+    QHash<QString, QSet<QString>> m_usersByServer; // lower-case server -> user keys
+    QMap<QString, QString> m_servers;             // lower-case server -> display name
+    QAtomicInteger<int> m_syncing{0};
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QByteArray>
+#include <functional>
+#include "models/DirectoryEntry.h"
+
+enum class SearchScope {
+    Base,
+    OneLevel,
+    Subtree
+};
+
+// Server-side sort key (RFC 2891); entries without the attribute sort last
+struct SortKey {
+    QString attribute;
+    bool reverse = false;
+};
+
+struct SearchRequest {
+    QString baseDN;
+    QString filter = "(objectClass=*)";
+    QStringList attributes;
+    SearchScope scope = SearchScope::Subtree;
+    int pageSize = 0;   // 0 = use the ADManager default
+    int sizeLimit = 0;  // 0 = no limit
+    bool includeDeleted = false; // also return tombstones (isDeleted=TRUE)
+    QList<SortKey> sortKeys;     // empty = server order
+};
+
+// Virtual list view window (draft-ietf-ldapext-ldapv3-vlv) over a sorted
+// result: beforeCount entries before the target, the target at offset, and
+// afterCount after it. Lets a view fetch only the rows it shows.
+struct VlvWindow {
+    int offset = 1;       // 1-based position of the target entry
+    int beforeCount = 0;
+    int afterCount = 0;
+    int contentCount = 0; // the caller's idea of the list size; 0 = unknown
+    QByteArray context;   // from the previous VlvResult, lets the server reuse its sorted list
+};
+
+struct VlvResult {
+    int targetPosition = 0; // 1-based position the server resolved the target to
+    int contentCount = 0;   // size of the whole sorted list
+    QByteArray context;
+};
+
+// Invoked once per page as it arrives; return false to stop the search early.
+using SearchPageCallback = std::function<bool(const QList<DirectoryEntry>& page)>;
+
+// Ranged retrieval of a large multi-valued attribute. AD returns at most
+// MaxValRange (1500) values of an attribute such as member per read and
+// names the slice it sent: "member;range=0-1499", then "member;range=1500-*"
+// for the last one. Asking for "member;range=<low>-*" gets the next slice.
+struct AttributeRange {
+    static constexpr int DefaultMaxValRange = 1500;
+
+    QString attribute;
+    int low = 0;
+    int high = -1; // -1 stands for '*', the final slice
+
+    bool isLast() const { return high < 0; }
+
+    QString toString() const {
+        return QString("%1;range=%2-%3").arg(attribute).arg(low)
+               .arg(high < 0 ? QString("*") : QString::number(high));
+    }
+
+    static bool parse(const QString& name, AttributeRange& range) {
+        const int option = name.indexOf(";range=", 0, Qt::CaseInsensitive);
+        if (option <= 0) {
+            return false;
+        }
+
+        const QString bounds = name.mid(option + 7);
+        const int dash = bounds.indexOf('-');
+        bool lowOk = false;
+        bool highOk = false;
+        range.attribute = name.left(option);
+        range.low = bounds.left(dash).toInt(&lowOk);
+        const QString high = bounds.mid(dash + 1);
+        range.high = high == "*" ? -1 : high.toInt(&highOk);
+        return dash > 0 && lowOk && (highOk || range.high == -1) && (range.high < 0 || range.high >= range.low);
+    }
+
+    // The ranged form of attribute in entry, if the server sent one
+    static bool find(const DirectoryEntry& entry, const QString& attribute, AttributeRange& range) {
+        const QString prefix = attribute.toLower() + ";range=";
+        for (const QString& name : entry.getAttributeNames()) {
+            if (name.startsWith(prefix) && parse(name, range)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
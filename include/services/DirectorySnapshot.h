@@ -0,0 +1,65 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QFile>
+#include "models/DirectoryEntry.h"
+
+enum class DirectoryObjectKind : quint8 { Server, Group, User, Other };
+
+// Compact on-disk image of a DirectoryReplica: a header, a table of
+// fixed-width server records, a table of fixed-width object records and one
+// UTF-16 string table they point into. Users are stored grouped by server,
+// so a server's users are one contiguous run of records.
+//
+// open() memory-maps the file and only reads the header and the server
+// table; entries are decoded on demand. That lets the UI show the last known
+// servers and users right at startup, long before the directory answers.
+// The file is a local cache in native byte order, written with write().
+class DirectorySnapshot {
+public:
+    struct Object {
+        DirectoryObjectKind kind = DirectoryObjectKind::Other;
+        QString server; // server name as displayed
+        DirectoryEntry entry;
+    };
+
+    DirectorySnapshot() = default;
+    ~DirectorySnapshot();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    QString getSource() const;
+    qint64 getWatermark() const;
+
+    QStringList getServerNames() const;
+    bool hasServer(const QString& serverName) const;
+    QList<DirectoryEntry> getUsersForServer(const QString& serverName) const;
+
+    int objectCount() const;
+    Object objectAt(int index) const;
+
+    static bool write(const QString& path, const QString& source, qint64 watermark, const QList<Object>& objects);
+
+private:
+    struct StringRef {
+        quint32 offset;
+        quint32 length;
+    };
+
+    struct Header;
+    struct ServerRecord;
+    struct ObjectRecord;
+
+    QString stringAt(const StringRef& ref) const;
+    const ServerRecord* serverAt(int index) const;
+    const ObjectRecord* recordAt(int index) const;
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QHash<QString, int> m_serverIndex; // lower-case server name -> server record
+};
@@ -0,0 +1,205 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <algorithm>
+#include "models/DirectoryEntry.h"
+#include "services/DirectorySearch.h"
+#include "services/ADObjectChangeSet.h"
+#include "services/ADSessionCache.h"
+
+// Backend-neutral classification of a failed directory operation
+enum class DirectoryError {
+    None,
+    NoSuchObject,
+    NoSuchAttribute,  // a value to remove is not there
+    AlreadyExists,
+    InvalidArgument,
+    InsufficientRights,
+    Busy,
+    Unavailable,
+    Timeout,
+    Other
+};
+
+// Outcome of one write of a batch
+struct DirectoryWriteResult {
+    DirectoryError error = DirectoryError::None;
+    QString message; // empty on success
+};
+
+// The primitive operations ADManager needs from a directory. ADManager holds
+// the AD-specific logic (layout of servers, groups and users); a backend only
+// knows how to search, read and write entries.
+//
+// A backend instance is used from a single thread. clone() creates an
+// unconnected instance for another thread; connect() it to the same naming
+// context to talk to the same directory.
+class IDirectoryBackend {
+public:
+    virtual ~IDirectoryBackend() = default;
+
+    virtual QString getName() const = 0;
+    virtual std::unique_ptr<IDirectoryBackend> clone() const = 0;
+
+    // Binds to the naming context; an empty string means the default one
+    virtual bool connect(const QString& namingContext) = 0;
+    virtual QString getNamingContext() const = 0;
+
+    // Identifies the directory instance where the naming context alone does
+    // not, e.g. an in-memory store that starts over on every run. Replicas
+    // built from another instance are discarded.
+    virtual QString getDirectoryId() const { return QString(); }
+
+    // The server this backend talks to, for per-server state such as the
+    // retry layer's circuit breakers; the naming context where binds are
+    // serverless and the domain picks the DC
+    virtual QString getEndpoint() const { return getNamingContext(); }
+
+    // Paged search; onPage is invoked once per page
+    virtual bool search(const SearchRequest& request, const SearchPageCallback& onPage) = 0;
+
+    // Returns false with lastError() == NoSuchObject when the entry is missing
+    virtual bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) = 0;
+    virtual bool entryExists(const QString& dn) = 0;
+
+    // Reads several entries; missing ones are skipped, the rest keep the
+    // order of dns. Backends that can pipeline requests override this.
+    virtual bool readEntries(const QStringList& dns, const QStringList& attributes, QList<DirectoryEntry>& entries) {
+        for (const QString& dn : dns) {
+            DirectoryEntry entry;
+            if (readEntry(dn, attributes, entry)) {
+                entries.append(entry);
+            } else if (lastError() != DirectoryError::NoSuchObject) {
+                return false;
+            }
+        }
+        clearError();
+        return true;
+    }
+
+    // One window of a sorted search; request.sortKeys gives the order.
+    // Backends that speak the sort and VLV controls fetch only the window;
+    // this fallback runs the whole search and slices it client-side.
+    virtual bool searchWindow(const SearchRequest& request, const VlvWindow& window,
+                              QList<DirectoryEntry>& entries, VlvResult& result) {
+        QList<DirectoryEntry> all;
+        if (!search(request, [&all](const QList<DirectoryEntry>& page) {
+                all.append(page);
+                return true;
+            })) {
+            return false;
+        }
+        sortEntries(all, request.sortKeys);
+        sliceWindow(all, window, entries, result);
+        return true;
+    }
+
+    virtual bool addEntry(const DirectoryEntry& entry) = 0;
+    virtual bool modifyEntry(const ADObjectChangeSet& changes) = 0;
+
+    // Applies several change sets; results gets one entry per change set
+    // sent, in order, and one failing does not stop the others. Returns false
+    // when the batch was cut short (e.g. the connection dropped): results is
+    // then shorter than changes, the change sets past its end were not sent,
+    // and lastError() says why. Backends that can pipeline requests override
+    // this.
+    virtual bool modifyEntries(const QList<ADObjectChangeSet>& changes, QList<DirectoryWriteResult>& results) {
+        results.clear();
+        results.reserve(changes.size());
+        for (const ADObjectChangeSet& change : changes) {
+            DirectoryWriteResult result;
+            if (!modifyEntry(change)) {
+                result.error = lastError();
+                result.message = lastErrorMessage();
+            }
+            results.append(result);
+        }
+        clearError();
+        return true;
+    }
+
+    virtual bool deleteEntry(const QString& dn) = 0;
+    virtual bool setPassword(const QString& dn, const QString& password) = 0;
+
+    // Connection reuse diagnostics, for backends that cache bindings
+    virtual SessionCacheStats sessionCacheStats() const { return SessionCacheStats(); }
+    virtual void resetSessionCacheStats() {}
+
+    // Error state of the last operation
+    DirectoryError lastError() const { return m_lastError; }
+    QString lastErrorMessage() const { return m_lastErrorMessage; }
+    long lastNativeError() const { return m_lastNativeError; }
+
+protected:
+    // Client-side equivalents of the sort and VLV controls. Integers compare
+    // numerically, other values case-insensitively; entries without the
+    // attribute order after all others, as RFC 2891 specifies
+    static void sortEntries(QList<DirectoryEntry>& entries, const QList<SortKey>& keys) {
+        if (keys.isEmpty()) {
+            return;
+        }
+        std::stable_sort(entries.begin(), entries.end(), [&keys](const DirectoryEntry& a, const DirectoryEntry& b) {
+            for (const SortKey& key : keys) {
+                const QString left = a.getValue(key.attribute);
+                const QString right = b.getValue(key.attribute);
+                int order = 0;
+                if (left.isEmpty() || right.isEmpty()) {
+                    order = int(left.isEmpty()) - int(right.isEmpty());
+                } else {
+                    bool leftNumeric = false;
+                    bool rightNumeric = false;
+                    const qlonglong leftNumber = left.toLongLong(&leftNumeric);
+                    const qlonglong rightNumber = right.toLongLong(&rightNumeric);
+                    order = leftNumeric && rightNumeric ? (leftNumber > rightNumber) - (leftNumber < rightNumber)
+                                                        : left.compare(right, Qt::CaseInsensitive);
+                }
+                if (order != 0) {
+                    return key.reverse ? order > 0 : order < 0;
+                }
+            }
+            return false;
+        });
+    }
+
+    static void sliceWindow(const QList<DirectoryEntry>& sorted, const VlvWindow& window,
+                            QList<DirectoryEntry>& entries, VlvResult& result) {
+        const int count = sorted.size();
+        result.contentCount = count;
+        result.context.clear();
+        if (count == 0) {
+            result.targetPosition = 0;
+            return;
+        }
+
+        // A caller's size estimate that is off scales the offset, so "90% of
+        // the way down" stays there as the list grows or shrinks
+        qint64 offset = window.offset;
+        if (window.contentCount > 0 && window.contentCount != count) {
+            offset = qint64(window.offset) * count / window.contentCount;
+        }
+        const int target = int(qBound<qint64>(1, offset, count));
+        const int first = qMax(0, target - 1 - window.beforeCount);
+        const int last = qMin(count - 1, target - 1 + window.afterCount);
+
+        entries = sorted.mid(first, last - first + 1);
+        result.targetPosition = target;
+    }
+
+    void clearError() {
+        m_lastError = DirectoryError::None;
+        m_lastErrorMessage.clear();
+        m_lastNativeError = 0;
+    }
+
+    void setError(DirectoryError error, const QString& message, long nativeError = 0) {
+        m_lastError = error;
+        m_lastErrorMessage = message;
+        m_lastNativeError = nativeError;
+    }
+
+private:
+    DirectoryError m_lastError = DirectoryError::None;
+    QString m_lastErrorMessage;
+    long m_lastNativeError = 0;
+};
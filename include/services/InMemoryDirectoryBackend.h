@@ -0,0 +1,87 @@
+#pragma once
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QReadWriteLock>
+#include <QUuid>
+#include "services/IDirectoryBackend.h"
+#include "utils/LdapFilter.h"
+
+// A directory held entirely in memory, with hash indexes on DN and parent DN
+// and a sorted one on sAMAccountName (for equality and prefix lookups). Evaluates filters client-side, so it behaves
+// like a small LDAP server without needing one. Used off Windows, for
+// benchmarks and headless runs.
+//
+// Deleted entries are kept as AD-style tombstones (isDeleted=TRUE, moved
+// under CN=Deleted Objects) that searches return only with includeDeleted,
+// so incremental sync can be exercised against it.
+//
+// Multi-valued attributes larger than MaxValRange come back in ranges
+// (member;range=0-1499 ...), as on AD, so ranged retrieval is exercised too.
+//
+// Clones share the same store, so worker threads see one directory.
+class InMemoryDirectoryBackend : public IDirectoryBackend {
+public:
+    static constexpr const char* DefaultNamingContext = "DC=example,DC=com";
+
+    InMemoryDirectoryBackend();
+
+    QString getName() const override { return "memory"; }
+    std::unique_ptr<IDirectoryBackend> clone() const override;
+
+    bool connect(const QString& namingContext) override;
+    QString getNamingContext() const override { return m_namingContext; }
+    QString getDirectoryId() const override { return m_store->id; }
+
+    bool search(const SearchRequest& request, const SearchPageCallback& onPage) override;
+    bool searchWindow(const SearchRequest& request, const VlvWindow& window,
+                      QList<DirectoryEntry>& entries, VlvResult& result) override;
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override;
+    bool entryExists(const QString& dn) override;
+
+    bool addEntry(const DirectoryEntry& entry) override;
+    bool modifyEntry(const ADObjectChangeSet& changes) override;
+    bool deleteEntry(const QString& dn) override;
+    bool setPassword(const QString& dn, const QString& password) override;
+
+    // Creates serverCount server OUs with a group each and spreads count
+    // users across them (SRV001 / user000001 ...). Requires connect().
+    void seedSyntheticUsers(int count, int serverCount = 10);
+
+    int entryCount() const;
+
+    // Values returned per attribute before ranged retrieval kicks in
+    void setMaxValRange(int maxValRange);
+    int maxValRange() const;
+
+private:
+    struct Store {
+        mutable QReadWriteLock lock;
+        QHash<QString, DirectoryEntry> entries;    // lower-case DN -> entry
+        QMap<QString, QString> byAccountName;      // lower-case sAMAccountName -> lower-case DN
+        QHash<QString, QSet<QString>> children;    // lower-case parent DN -> lower-case child DNs
+        QHash<QString, QString> passwords;         // lower-case DN -> password
+        QHash<QString, DirectoryEntry> tombstones; // lower-case tombstone DN -> entry
+        qint64 usn = 0;
+        int maxValRange = AttributeRange::DefaultMaxValRange;
+        QString id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    };
+
+    explicit InMemoryDirectoryBackend(std::shared_ptr<Store> store);
+
+    // Callers hold the write lock
+    void insertLocked(const QString& key, DirectoryEntry entry);
+    void stampLocked(DirectoryEntry& entry, bool created);
+
+    QStringList candidatesLocked(const QString& baseKey, SearchScope scope, const LdapFilter& filter) const;
+    // Keys of the entries a search matches, sorted and limited as requested
+    bool collectKeys(const SearchRequest& request, QStringList& keys);
+
+    // Callers hold a lock
+    const DirectoryEntry* findLocked(const QString& key) const;
+    DirectoryEntry projectLocked(const DirectoryEntry& entry, const QStringList& attributes) const;
+    static QString generalizedTimeNow();
+
+    std::shared_ptr<Store> m_store;
+    QString m_namingContext;
+};
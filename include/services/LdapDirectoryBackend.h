@@ -0,0 +1,67 @@
+#pragma once
+#ifdef HAVE_OPENLDAP
+#include "services/IDirectoryBackend.h"
+
+#include <ldap.h>
+
+struct LdapConnectionSettings {
+    QString uri;            // ldap://dc.example.com; empty = ldap://<DNS name of the naming context>
+    QString bindDN;         // DN or user@domain; empty = anonymous
+    QString password;
+    bool startTls = false;
+    int timeoutMs = 30000;
+    int maxOutstanding = 8; // requests kept in flight by readEntries and modifyEntries
+};
+
+// Any LDAP v3 server (Active Directory or slapd) through OpenLDAP's libldap.
+// Every request is sent with the asynchronous API (ldap_search_ext & co.) and
+// collected with ldap_result, so batch reads keep several requests in flight
+// on one connection instead of paying a round trip each.
+//
+// One connection per instance; use clone() for other threads.
+class LdapDirectoryBackend : public IDirectoryBackend {
+public:
+    explicit LdapDirectoryBackend(const LdapConnectionSettings& settings = LdapConnectionSettings());
+    ~LdapDirectoryBackend() override;
+
+    QString getName() const override { return "ldap"; }
+    std::unique_ptr<IDirectoryBackend> clone() const override;
+
+    LdapConnectionSettings getSettings() const { return m_settings; }
+    void setSettings(const LdapConnectionSettings& settings);
+
+    bool connect(const QString& namingContext) override;
+    QString getNamingContext() const override { return m_namingContext; }
+    QString getEndpoint() const override { return effectiveUri(); }
+    bool isActiveDirectory() const { return m_activeDirectory; }
+
+    bool search(const SearchRequest& request, const SearchPageCallback& onPage) override;
+    // Sort + VLV controls; falls back to a client-side window without VLV
+    bool searchWindow(const SearchRequest& request, const VlvWindow& window,
+                      QList<DirectoryEntry>& entries, VlvResult& result) override;
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override;
+    bool readEntries(const QStringList& dns, const QStringList& attributes, QList<DirectoryEntry>& entries) override;
+    bool entryExists(const QString& dn) override;
+
+    bool addEntry(const DirectoryEntry& entry) override;
+    bool modifyEntry(const ADObjectChangeSet& changes) override;
+    // Pipelined like readEntries
+    bool modifyEntries(const QList<ADObjectChangeSet>& changes, QList<DirectoryWriteResult>& results) override;
+    bool deleteEntry(const QString& dn) override;
+    bool setPassword(const QString& dn, const QString& password) override;
+
+private:
+    QString effectiveUri() const;
+    bool open();
+    void close();
+    bool readRootDSE();
+    bool waitForResult(const QString& operation, int msgid);
+    DirectoryEntry toEntry(LDAPMessage* message);
+    bool fail(const QString& operation, int resultCode, const QString& diagnostic = QString());
+
+    LdapConnectionSettings m_settings;
+    QString m_namingContext;
+    bool m_activeDirectory;
+    LDAP* m_ld;
+};
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <set>
+
+// Logins already taken in the directory, grouped by login base: for the base
+// "IPetrenko" the suffixes of IPetrenko, IPetrenko1, IPetrenko7 are {0, 1, 7}.
+// A base is loaded with one prefix search (sAMAccountName=IPetrenko*) and
+// afterwards kept current by noteTaken() as users are created, so picking
+// the lowest free suffix needs no further round trips.
+//
+// Logins created elsewhere are picked up when a base is reloaded after
+// maxAge; within it ADManager confirms a pick against the directory before
+// handing it out. Thread-safe, so one instance can be shared by every
+// ADManager.
+class LoginIndex {
+public:
+    explicit LoginIndex(int maxAgeMs = 60000);
+
+    void setMaxAge(int maxAgeMs);
+    int maxAge() const { return m_maxAgeMs; }
+
+    // True when the base was loaded within maxAge
+    bool isLoaded(const QString& base) const;
+    // Replaces what is known about base with the result of a prefix search
+    void load(const QString& base, const QStringList& logins);
+    // Records a login that was just created
+    void noteTaken(const QString& login);
+    void clear();
+
+    // Suffixes of base in use; 0 stands for the base itself
+    std::set<quint32> takenSuffixes(const QString& base) const;
+    // Lowest free login: base itself, then base1, base2...
+    QString lowestFree(const QString& base) const;
+
+    static QString loginFor(const QString& base, quint32 suffix);
+    static quint32 lowestFreeSuffix(const std::set<quint32>& taken);
+
+private:
+    struct Base {
+        std::set<quint32> suffixes;
+        qint64 loadedMs = 0;
+    };
+
+    // The suffix login has relative to base, if it is base followed by an
+    // optional decimal number without leading zeros
+    static bool suffixOf(const QString& login, const QString& base, quint32& suffix);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Base> m_bases; // keyed by lower-case base
+    QElapsedTimer m_clock;
+    int m_maxAgeMs;
+};
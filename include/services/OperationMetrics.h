@@ -0,0 +1,89 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <array>
+
+// ADManager entry points, grouped by what they ask of the directory
+enum class DirectoryOperation {
+    Bind,          // connectToAD
+    Search,        // search, searchAll
+    GetServerList,
+    GetServerInfo,
+    CreateServer,  // createServerOU, createServerGroup
+    GetUsers,      // a server's users: lists, streams and windows
+    GetUser,       // getUserInfo, getUsersByDN
+    CreateUser,
+    Modify,        // updateUser, commitChanges, deactivateUser(s)
+    SetPassword,
+    GetAttribute,  // single attributes and server metadata
+    SetAttribute,
+    ExistsCheck,   // serverExists, userExists
+    SyncReplica,
+    AllocateLogin, // generateUniqueLogin, allocateLogins
+    Count
+};
+
+struct LatencySummary {
+    quint64 count = 0;
+    quint64 errors = 0;
+    qint64 sumUs = 0;
+    qint64 maxUs = 0;
+    qint64 p50Us = 0;
+    qint64 p90Us = 0;
+    qint64 p99Us = 0;
+};
+
+// Latency histogram in the style of HdrHistogram: buckets are linear below
+// 32 us and log-linear above, 32 per power of two, so any recorded value is
+// reported within about 3% up to 2^40 us. Recording is a couple of relaxed
+// atomic increments and never takes a lock.
+class LatencyHistogram {
+public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxExponent = 39;
+    static constexpr int BucketCount = (MaxExponent - SubBucketBits + 2) * SubBuckets;
+
+    void record(qint64 micros, bool failed);
+    LatencySummary summary() const;
+    void reset();
+
+    // Largest value that falls into the bucket at index
+    static qint64 bucketUpperBound(int index);
+    static int bucketIndex(qint64 micros);
+
+private:
+    std::array<QAtomicInteger<quint64>, BucketCount> m_buckets{};
+    QAtomicInteger<quint64> m_errors{0};
+    QAtomicInteger<qint64> m_sumUs{0};
+    QAtomicInteger<qint64> m_maxUs{0};
+};
+
+// Process-wide latency and error counts per DirectoryOperation, fed by
+// every ADManager (workers included), plus exporters for monitoring.
+class OperationMetrics {
+public:
+    enum class Format { Prometheus, Json };
+
+    static OperationMetrics& global();
+
+    // Stable snake_case name used in exports, e.g. "get_server_info"
+    static QString operationName(DirectoryOperation operation);
+
+    void record(DirectoryOperation operation, qint64 micros, bool failed);
+    LatencySummary summary(DirectoryOperation operation) const;
+    void reset();
+
+    // Prometheus text exposition format: per operation a summary with
+    // p50/p90/p99 quantiles, _sum and _count in seconds, plus error
+    // counters and the maximum
+    QByteArray toPrometheus() const;
+    QByteArray toJson() const;
+    // Replaces the file atomically, so a reader never sees half of it
+    bool writeToFile(const QString& fileName, Format format, QString* error = nullptr) const;
+
+private:
+    std::array<LatencyHistogram, int(DirectoryOperation::Count)> m_histograms;
+};
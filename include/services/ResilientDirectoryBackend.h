@@ -0,0 +1,137 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QMutex>
+#include <functional>
+#include <memory>
+#include "services/IDirectoryBackend.h"
+
+struct RetryPolicy {
+    int maxAttempts = 4;           // per operation, the first one included
+    int initialBackoffMs = 100;    // before the first retry, doubling after each
+    int maxBackoffMs = 2000;
+    int breakerThreshold = 10;     // consecutive transient failures that open the circuit
+    int breakerCooldownMs = 10000; // how long it stays open before a probe
+};
+
+struct RetryStats {
+    quint64 retries = 0;       // attempts after the first
+    quint64 recovered = 0;     // operations that succeeded on a retry
+    quint64 exhausted = 0;     // operations still failing on their last attempt
+    quint64 rejected = 0;      // failed at once because the circuit was open
+    quint64 circuitOpened = 0;
+    bool circuitOpen = false;
+};
+
+// Circuit breaker of one directory endpoint (a DC, or the domain where
+// binds are serverless), shared by every backend that talks to it on any
+// thread. After breakerThreshold consecutive transient failures it opens
+// and requests fail at once; once the cooldown has passed a single probe
+// goes through, and its outcome closes or reopens the circuit.
+class CircuitBreaker {
+public:
+    enum class State { Closed, Open, HalfOpen };
+
+    static std::shared_ptr<CircuitBreaker> forEndpoint(const QString& endpoint);
+
+    // False while open; retryAfterMs then tells how long that lasts
+    bool allowRequest(const RetryPolicy& policy, int* retryAfterMs = nullptr);
+    // An answer from the directory, error or not, counts as success here
+    void recordSuccess();
+    void recordFailure(const RetryPolicy& policy);
+
+    void recordRetry();
+    void recordOutcome(bool recovered);
+
+    State state() const;
+    RetryStats stats() const;
+
+private:
+    mutable QMutex m_mutex;
+    State m_state = State::Closed;
+    int m_consecutiveFailures = 0;
+    bool m_probeInFlight = false;
+    QElapsedTimer m_openedAt;
+    RetryStats m_stats;
+};
+
+// Retry layer between ADManager and a directory backend. Operations that
+// fail with a transient error (Busy, Unavailable, Timeout) are retried with
+// exponential backoff and jitter, so a briefly overloaded DC costs a bulk
+// job some latency instead of failed items; past the breaker threshold the
+// endpoint's circuit opens and operations fail fast until it recovers.
+//
+// A write may fail in transit after the directory applied it. When a retry
+// then finds its effect in place the operation counts as done: AlreadyExists
+// for an add or a modify that only appends values, NoSuchAttribute for a
+// modify that only removes them, NoSuchObject for a delete. A search that
+// already delivered pages is not retried, so callers never see a page twice.
+//
+// Retries sleep between attempts; give a manager on the GUI thread a policy
+// with maxAttempts = 1 and leave the retrying to its workers.
+class ResilientDirectoryBackend : public IDirectoryBackend {
+public:
+    explicit ResilientDirectoryBackend(std::unique_ptr<IDirectoryBackend> inner,
+                                       const RetryPolicy& policy = RetryPolicy());
+
+    IDirectoryBackend* inner() const { return m_inner.get(); }
+    void setPolicy(const RetryPolicy& policy) { m_policy = policy; }
+    RetryPolicy policy() const { return m_policy; }
+    // Of the endpoint this backend currently talks to
+    RetryStats stats();
+
+    QString getName() const override { return m_inner->getName(); }
+    std::unique_ptr<IDirectoryBackend> clone() const override;
+
+    bool connect(const QString& namingContext) override;
+    // Binds on the first operation instead of now, for a manager that takes
+    // over a connection a worker already made (ADManager::adoptConnection)
+    void connectLater(const QString& namingContext);
+    QString getNamingContext() const override { return m_inner->getNamingContext(); }
+    QString getDirectoryId() const override { return m_inner->getDirectoryId(); }
+    QString getEndpoint() const override { return m_inner->getEndpoint(); }
+
+    bool search(const SearchRequest& request, const SearchPageCallback& onPage) override;
+    bool searchWindow(const SearchRequest& request, const VlvWindow& window,
+                      QList<DirectoryEntry>& entries, VlvResult& result) override;
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override;
+    bool readEntries(const QStringList& dns, const QStringList& attributes, QList<DirectoryEntry>& entries) override;
+    bool entryExists(const QString& dn) override;
+
+    bool addEntry(const DirectoryEntry& entry) override;
+    bool modifyEntry(const ADObjectChangeSet& changes) override;
+    // One batch to the backend; change sets that fail transiently are then
+    // retried one by one, and those a cut-short batch did not send are sent
+    // one by one
+    bool modifyEntries(const QList<ADObjectChangeSet>& changes, QList<DirectoryWriteResult>& results) override;
+    bool deleteEntry(const QString& dn) override;
+    bool setPassword(const QString& dn, const QString& password) override;
+
+    SessionCacheStats sessionCacheStats() const override { return m_inner->sessionCacheStats(); }
+    void resetSessionCacheStats() override { m_inner->resetSessionCacheStats(); }
+
+    static bool isTransient(DirectoryError error);
+    // Whether error is what a retry of changes gets once its first attempt
+    // was applied; Replace and Clear never tell, so mixed sets do not qualify
+    static bool isAlreadyApplied(const ADObjectChangeSet& changes, DirectoryError error);
+
+private:
+    // Runs attempt until it succeeds, fails for good or runs out of
+    // attempts. alreadyApplied recognizes the error a retried write gets
+    // when its first attempt went through; canRetry vetoes a retry.
+    // previousAttempts counts tries the caller already made
+    bool run(const std::function<bool()>& attempt,
+             const std::function<bool(DirectoryError)>& alreadyApplied = nullptr,
+             const std::function<bool()>& canRetry = nullptr, int previousAttempts = 0);
+    // Makes the bind connectLater() deferred; false if it failed
+    bool ensureConnected();
+    CircuitBreaker& breaker();
+    int backoffMs(int retry) const;
+    void adoptError();
+
+    std::unique_ptr<IDirectoryBackend> m_inner;
+    RetryPolicy m_policy;
+    QString m_endpoint;
+    std::shared_ptr<CircuitBreaker> m_breaker;
+    bool m_connectPending = false;
+    QString m_pendingContext;
+};
@@ -7,10 +7,13 @@
 #include <QLabel>
 #include <QProgressBar>
 #include <QCheckBox>
+#include <memory>
 
 #include "services/LLMService.h"
 #include "services/ADManager.h"
+#include "services/ADManagerAsync.h"
 #include "services/PasswordGenerator.h"
+#include "services/BulkUserCreator.h"
 #include "models/NormalizedUser.h"
 
 class CreateUsersDialog : public QDialog {
@@ -21,7 +24,11 @@ public:
     
     void setLLMService(LLMService* llmService);
     void setADManager(ADManager* adManager);
+    // Runs the login lookups after processing off the GUI thread
+    void setADManagerAsync(ADManagerAsync* adAsync);
     void setPasswordGenerator(PasswordGenerator* passwordGenerator);
+    // Number of users created in parallel
+    void setConcurrency(int concurrency);
     
     QString getSelectedServer() const;
     
@@ -34,9 +41,14 @@ private slots:
     void onProcessingError(const QString& error);
     void onProcessingProgress(int percentage);
     
+    void onCreateItemsFinished(const QList<BulkCreateResult>& results);
+    void onCreateProgress(int completed, int total);
+    void onCreateFinished(int created, int total, qint64 elapsedMs);
+    
 private:
     void setupUI();
     void updateTable(const QList<NormalizedUser>& users);
+    void finishProcessing();
     
     // UI components
     QComboBox* m_serverComboBox;
@@ -52,8 +64,12 @@ private:
     // Service references
     LLMService* m_llmService;
     ADManager* m_adManager;
+    ADManagerAsync* m_adAsync;
     PasswordGenerator* m_passwordGenerator;
+    std::unique_ptr<BulkUserCreator> m_bulkCreator;
+    int m_concurrency;
     
     // Internal data
     QList<NormalizedUser> m_processedUsers;
+    QList<int> m_createRows; // table row of each submitted user
 };
@@ -9,9 +9,12 @@
 #include <memory>
 
 #include "services/ADManager.h"
+#include "services/ADManagerAsync.h"
 #include "services/LLMService.h"
 #include "services/PasswordGenerator.h"
+#include "services/BulkPasswordRotator.h"
 #include "services/ConfigManager.h"
+#include "services/DirectorySnapshot.h"
 
 QT_BEGIN_NAMESPACE
 class QAction;
@@ -20,6 +23,7 @@ class QMenuBar;
 class QStatusBar;
 class QToolBar;
 class QDockWidget;
+class QTimer;
 QT_END_NAMESPACE
 
 class ServerTreeWidget;
@@ -43,6 +47,8 @@ private slots:
     void onUserDoubleClicked(const QString& userDN);
     void onDeactivateUser();
     void onChangePassword();
+    void onRotatePasswords();
+    void onRotationFinished(int rotated, int total, qint64 elapsedMs);
     void onCopyConnectionInfo();
     void onExportUsers();
     void onSettings();
@@ -53,6 +59,22 @@ private slots:
     void onADError(const QString& error);
     void onOperationProgress(const QString& operation, int progress);
     
+    // Async AD results
+    void onServersLoaded(const QStringList& servers);
+    void onUserWindowLoaded(const QString& serverName, int firstRow, const QList<UserInfo>& users, int total,
+                            const QByteArray& context);
+    void onUserSortChanged(int column, Qt::SortOrder order);
+    void fetchVisibleUsers();
+    void onUsersDeactivated(const QList<BulkDeactivateResult>& results);
+    void onUserInfoLoaded(const UserInfo& user);
+    void onServerInfoLoaded(const ServerInfo& serverInfo);
+    void onExportFinished(const QString& fileName, int count, bool success);
+    void onReplicaSynced(const ReplicaSyncResult& result);
+    void onAutoRefresh();
+    void connectToDirectory();
+    void refreshMetrics();
+    void exportMetrics();
+    
 private:
     void setupUI();
     void setupMenus();
@@ -60,8 +82,15 @@ private:
     void setupStatusBar();
     void setupConnections();
     
+    PasswordPolicy passwordPolicy() const;
+    void rotatePasswords(const QString& serverName, const QStringList& userDNs);
+    
     void loadServers();
     void loadUsers(const QString& serverName);
+    void appendUserRows(const QList<UserInfo>& users);
+    void setUserRow(int row, const UserInfo& user);
+    void requestUserWindow(int firstRow);
+    void refreshCurrentServer();
     void updateStatusBar();
     void showConnectionStatus(bool connected);
     void displayError(const QString& message);
@@ -76,6 +105,8 @@ private:
     UserDetailsWidget* m_userDetails;
     QTextEdit* m_logOutput;
     QDockWidget* m_logDock;
+    QTableWidget* m_metricsTable;
+    QDockWidget* m_metricsDock;
     
     // Status Bar
     QLabel* m_connectionStatus;
@@ -83,11 +114,36 @@ private:
     QLabel* m_userCount;
     QProgressBar* m_progressBar;
     
+    // Periodic incremental sync of the directory replica
+    QTimer* m_refreshTimer;
+    
+    // Operation metrics: the dock refreshes while visible, the export file
+    // is rewritten every interval when a path is configured
+    QTimer* m_metricsTimer;
+    QTimer* m_metricsExportTimer;
+    QString m_metricsExportPath;
+    OperationMetrics::Format m_metricsExportFormat;
+    QString m_metricsExportError; // last one logged, so a bad path is reported once
+    
+    // Live user table: rows are fetched a window at a time, sorted by the
+    // server, as they scroll into view
+    static constexpr int UserWindowSize = 100;
+    QTimer* m_userWindowTimer;
+    bool m_userWindowed;
+    bool m_userWindowPending;
+    quint64 m_userWindowRequest; // latest loadUserWindow, see requestUserWindow
+    int m_userTotal;
+    QByteArray m_userContext;
+    QList<SortKey> m_userOrder;
+    
     // Services
     std::unique_ptr<ADManager> m_adManager;
+    std::unique_ptr<ADManagerAsync> m_adAsync; // must be destroyed before m_adManager
     std::unique_ptr<LLMService> m_llmService;
     std::unique_ptr<PasswordGenerator> m_passwordGenerator;
+    std::unique_ptr<BulkPasswordRotator> m_passwordRotator; // created on first use
     std::unique_ptr<ConfigManager> m_configManager;
+    std::unique_ptr<DirectorySnapshot> m_snapshot; // until the first sync completes
     
     // Current state
     QString m_currentServer;
@@ -0,0 +1,46 @@
+#pragma once
+#include <QString>
+#include <QStringView>
+
+// RFC 4514 distinguished name tokenizer. Yields the RDNs of a DN left to
+// right as slices of the input, without copying:
+//
+//   DnTokenizer tokens(u"CN=Smith\\, J,OU=srv01,DC=example,DC=com");
+//   QStringView rdn;
+//   while (tokens.next(rdn)) { ... } // "CN=Smith\\, J", "OU=srv01", ...
+//
+// Escaped separators (\, \+ \2C) stay inside their value and multi-valued
+// RDNs (CN=a+UID=b) come back whole; attributeValue() picks one AVA out of
+// them. Values are returned as written, escapes included; unescape() decodes
+// one when a plain string is needed. A syntax error stops the iteration and
+// sets hasError(). Spaces around separators are tolerated, as AD does.
+class DnTokenizer {
+public:
+    explicit DnTokenizer(QStringView dn);
+
+    bool next(QStringView& rdn);
+    bool hasError() const { return m_error; }
+    QString errorString() const { return m_errorString; }
+
+    // Raw value of the AVA with the given type (case-insensitive) in rdn,
+    // or a null view if the RDN has no such AVA
+    static QStringView attributeValue(QStringView rdn, QStringView type);
+    // Decodes \X and \XX escapes (UTF-8 octets); #hex values are returned as is
+    static QString unescape(QStringView value);
+    // Whether two RDNs are the same: equal AVAs in the same order, types and
+    // unescaped values compared case-insensitively
+    static bool sameRdn(QStringView a, QStringView b);
+
+private:
+    // One AVA starting at pos, which is left on the first character after it
+    static bool scanAva(QStringView dn, qsizetype& pos, QStringView& type, QStringView& value,
+                        QString* error);
+    // One RDN starting at pos; end is left on the terminating comma or the end
+    static bool scanRdn(QStringView dn, qsizetype pos, qsizetype& end, QString* error);
+
+    QStringView m_dn;
+    qsizetype m_pos;
+    bool m_done;
+    bool m_error;
+    QString m_errorString;
+};
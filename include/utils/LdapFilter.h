@@ -0,0 +1,51 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <memory>
+#include "models/DirectoryEntry.h"
+
+// RFC 4515 search filter, parsed once and evaluated against DirectoryEntry
+// objects. Used by backends that evaluate filters client-side.
+class LdapFilter {
+public:
+    LdapFilter();
+
+    static LdapFilter parse(const QString& filter);
+    static QString escapeValue(const QString& value);
+
+    bool isValid() const { return m_root != nullptr; }
+    bool matches(const DirectoryEntry& entry) const;
+
+    // Value of an equality term on the attribute that every match must satisfy
+    // (the term itself or a direct child of a top-level AND), or a null string.
+    // Lets callers answer the filter from an index.
+    QString requiredEquality(const QString& attribute) const;
+
+    // Values of an OR whose terms are all equalities on the attribute, e.g.
+    // (|(dn=a)(dn=b)), where the OR is the filter or a direct child of a
+    // top-level AND; empty otherwise. Every match equals one of them.
+    QStringList requiredEqualities(const QString& attribute) const;
+
+    // Same for the initial part of a substring term (attr=prefix*), or a
+    // null string. Lets callers answer the filter from a sorted index.
+    QString requiredPrefix(const QString& attribute) const;
+
+private:
+    struct Node {
+        enum Type { And, Or, Not, Equal, Present, Substring, GreaterOrEqual, LessOrEqual };
+
+        Type type = Equal;
+        QString attribute;
+        QString value;
+        QStringList substrings; // Substring: initial, any..., final (initial/final may be empty)
+        QList<std::shared_ptr<Node>> children;
+    };
+
+    static std::shared_ptr<Node> parseNode(const QString& text, int& pos);
+    static bool unescape(const QString& raw, QString& value);
+    static bool matchesNode(const Node& node, const DirectoryEntry& entry);
+    static bool matchesValue(const Node& node, const QString& value);
+
+    std::shared_ptr<const Node> m_root;
+};
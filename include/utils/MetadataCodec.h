@@ -0,0 +1,37 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+
+// Text encoding of server metadata for a single string attribute
+// (extensionAttribute1, at most 1024 characters in the AD schema).
+//
+//   "{...}"          legacy compact JSON, still read and written when it is
+//                    the shorter form
+//   "adm1:<base64>"  format header, then base64 of one flags byte followed
+//                    by the CBOR encoding of the object, zlib-compressed
+//                    when FlagCompressed is set
+//
+// encode() picks the shortest of these, so switching formats never makes a
+// value longer.
+class MetadataCodec {
+public:
+    static constexpr int MaxEncodedLength = 1024;
+    static constexpr int CompressionThreshold = 128; // CBOR bytes
+
+    enum Flag : quint8 {
+        FlagCompressed = 0x01
+    };
+
+    static QString encode(const QJsonObject& metadata, bool allowCompression = true);
+    // Accepts both formats; anything unreadable yields an empty object
+    static QJsonObject decode(const QString& value);
+
+    static QString encodeJson(const QJsonObject& metadata);
+    static QString encodeBinary(const QJsonObject& metadata, bool compress);
+
+    static bool isBinary(const QString& value);
+
+private:
+    static constexpr char Header[] = "adm1:";
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Append-only file of records encrypted under a passphrase: the key is
+// derived with PBKDF2-HMAC-SHA256 from a random salt, and every record is
+// sealed on its own with AES-256-GCM. Records are flushed as they are
+// appended, so a job that stops halfway leaves what it wrote readable.
+//
+// Layout: "ADMREC" and a version byte, the 16-byte salt, the iteration
+// count (uint32, big endian); then per record a 12-byte nonce, the
+// ciphertext length (uint32, big endian), the ciphertext and the 16-byte
+// tag. A record's sequence number is authenticated along with it, so
+// records cannot be reordered or removed from the middle unnoticed.
+//
+// CNG (bcrypt) does the cryptography on Windows and OpenSSL elsewhere;
+// without either, isSupported() is false and nothing can be written.
+class SecureRecordFile {
+public:
+    static constexpr quint32 DefaultIterations = 200000;
+
+    SecureRecordFile();
+    ~SecureRecordFile();
+    SecureRecordFile(const SecureRecordFile&) = delete;
+    SecureRecordFile& operator=(const SecureRecordFile&) = delete;
+
+    static bool isSupported();
+
+    // Creates the file, replacing an existing one
+    bool create(const QString& fileName, const QString& passphrase, quint32 iterations = DefaultIterations);
+    bool append(const QByteArray& record);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_error; }
+
+    // Decrypts every record of a file. Fails on a wrong passphrase or a
+    // damaged file
+    static bool readAll(const QString& fileName, const QString& passphrase, QList<QByteArray>& records,
+                        QString* error = nullptr);
+
+private:
+    QFile m_file;
+    QByteArray m_key;
+    quint64 m_sequence;
+    QString m_error;
+};
@@ -0,0 +1,64 @@
+#include "models/DirectoryEntry.h"
+
+DirectoryEntry::DirectoryEntry() {
+}
+
+DirectoryEntry::DirectoryEntry(const QString& distinguishedName)
+    : m_distinguishedName(distinguishedName) {
+}
+
+QString DirectoryEntry::getValue(const QString& attribute) const {
+    auto it = m_attributes.constFind(attribute.toLower());
+    if (it == m_attributes.constEnd() || it->isEmpty()) {
+        return QString();
+    }
+    return it->first();
+}
+
+QStringList DirectoryEntry::getValues(const QString& attribute) const {
+    return m_attributes.value(attribute.toLower());
+}
+
+bool DirectoryEntry::hasAttribute(const QString& attribute) const {
+    return m_attributes.contains(attribute.toLower());
+}
+
+void DirectoryEntry::setValue(const QString& attribute, const QString& value) {
+    m_attributes.insert(attribute.toLower(), QStringList{value});
+}
+
+void DirectoryEntry::setValues(const QString& attribute, const QStringList& values) {
+    m_attributes.insert(attribute.toLower(), values);
+}
+
+void DirectoryEntry::addValue(const QString& attribute, const QString& value) {
+    m_attributes[attribute.toLower()].append(value);
+}
+
+void DirectoryEntry::removeAttribute(const QString& attribute) {
+    m_attributes.remove(attribute.toLower());
+}
+
+namespace {
+// Index of the first RDN separator, skipping backslash-escaped commas
+int firstSeparator(const QString& dn) {
+    for (int i = 0; i < dn.length(); ++i) {
+        if (dn[i] == '\\') {
+            ++i;
+        } else if (dn[i] == ',') {
+            return i;
+        }
+    }
+    return -1;
+}
+}
+
+QString DirectoryEntry::rdnOf(const QString& dn) {
+    int separator = firstSeparator(dn);
+    return separator < 0 ? dn : dn.left(separator).trimmed();
+}
+
+QString DirectoryEntry::parentOf(const QString& dn) {
+    int separator = firstSeparator(dn);
+    return separator < 0 ? QString() : dn.mid(separator + 1).trimmed();
+}
@@ -0,0 +1,210 @@
+#include "models/DistinguishedName.h"
+#include "utils/DnTokenizer.h"
+#include <QAtomicInteger>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QVarLengthArray>
+
+struct DistinguishedName::Node {
+    Node* parent;
+    QString rdn;
+    // Handles plus child nodes. Dropping the last reference happens under
+    // the pool's write lock, so a lookup (under the read lock) never revives
+    // a node that is being removed
+    QAtomicInteger<quint32> refs{0};
+    // The whole DN; set once, before the first handle to the node exists,
+    // and never changed afterwards
+    QString text;
+};
+
+namespace {
+using Node = DistinguishedName::Node;
+
+// The RDN view points into Node::rdn, or into the caller's string for a
+// lookup; a node's rdn never changes while it is in the index
+struct Key {
+    const Node* parent;
+    QStringView rdn;
+};
+
+bool operator==(const Key& a, const Key& b) {
+    return a.parent == b.parent && a.rdn.compare(b.rdn, Qt::CaseInsensitive) == 0;
+}
+
+size_t qHash(const Key& key, size_t seed) {
+    size_t hash = ::qHash(quintptr(key.parent), seed);
+    for (QChar c : key.rdn) {
+        hash = hash * 31 + c.toCaseFolded().unicode();
+    }
+    return hash;
+}
+
+struct Pool {
+    QReadWriteLock lock;
+    QHash<Key, Node*> index;
+};
+
+// Never destroyed: handles in other static objects may outlive it
+Pool& pool() {
+    static Pool* instance = new Pool;
+    return *instance;
+}
+
+QString render(const Node* node) {
+    QString result;
+    for (; node; node = node->parent) {
+        if (!result.isEmpty()) {
+            result += ',';
+        }
+        result += node->rdn;
+    }
+    return result;
+}
+
+// Drops one reference, removing the node (and any parent left without
+// references) once none remain. Only the last reference needs the lock
+void release(Node* node) {
+    quint32 refs = node->refs.loadAcquire();
+    while (refs > 1) {
+        if (node->refs.testAndSetOrdered(refs, refs - 1, refs)) {
+            return;
+        }
+    }
+
+    Pool& p = pool();
+    QWriteLocker locker(&p.lock);
+    while (node && node->refs.fetchAndSubOrdered(1) == 1) {
+        p.index.remove(Key{node->parent, node->rdn});
+        Node* parent = node->parent;
+        delete node;
+        node = parent;
+    }
+}
+}
+
+DistinguishedName::DistinguishedName(QStringView dn) {
+    if (dn.trimmed().isEmpty()) {
+        return;
+    }
+
+    // Right to left: the naming context first, the object's own RDN last
+    QVarLengthArray<QStringView, 8> rdns;
+    DnTokenizer tokens(dn);
+    QStringView rdn;
+    while (tokens.next(rdn)) {
+        rdns.append(rdn);
+    }
+    if (tokens.hasError()) {
+        // Not a DN we can split; keep it whole as a single node
+        rdns.clear();
+        rdns.append(dn.trimmed());
+    }
+
+    Pool& p = pool();
+
+    // Most lookups hit a node that already has its text: walk down under
+    // the read lock and take the reference there
+    {
+        QReadLocker locker(&p.lock);
+        Node* node = nullptr;
+        qsizetype i = rdns.size() - 1;
+        for (; i >= 0; --i) {
+            auto it = p.index.constFind(Key{node, rdns[i]});
+            if (it == p.index.constEnd()) {
+                break;
+            }
+            node = it.value();
+        }
+        if (i < 0 && !node->text.isEmpty()) {
+            node->refs.ref();
+            m_node = node;
+            return;
+        }
+    }
+
+    // Nodes may have gone since the read lock was dropped; start over
+    QWriteLocker locker(&p.lock);
+    Node* node = nullptr;
+    for (qsizetype i = rdns.size() - 1; i >= 0; --i) {
+        auto it = p.index.constFind(Key{node, rdns[i]});
+        if (it != p.index.constEnd()) {
+            node = it.value();
+            continue;
+        }
+
+        Node* child = new Node{node, rdns[i].toString()};
+        if (node) {
+            node->refs.ref();
+        }
+        p.index.insert(Key{node, child->rdn}, child);
+        node = child;
+    }
+
+    // Spelled as given here, not as the shared nodes above it were first seen
+    if (node->text.isEmpty()) {
+        QString text;
+        for (qsizetype i = 0; i < rdns.size(); ++i) {
+            if (i > 0) {
+                text += ',';
+            }
+            text += rdns[i];
+        }
+        node->text = text;
+    }
+    node->refs.ref();
+    m_node = node;
+}
+
+DistinguishedName::DistinguishedName(const DistinguishedName& other) : m_node(other.m_node) {
+    if (m_node) {
+        m_node->refs.ref();
+    }
+}
+
+DistinguishedName& DistinguishedName::operator=(const DistinguishedName& other) {
+    if (other.m_node != m_node) {
+        DistinguishedName copy(other);
+        std::swap(m_node, copy.m_node);
+    }
+    return *this;
+}
+
+DistinguishedName& DistinguishedName::operator=(DistinguishedName&& other) noexcept {
+    std::swap(m_node, other.m_node);
+    return *this;
+}
+
+DistinguishedName::~DistinguishedName() {
+    if (m_node) {
+        release(m_node);
+    }
+}
+
+QString DistinguishedName::toString() const {
+    return m_node ? m_node->text : QString();
+}
+
+DistinguishedName DistinguishedName::parent() const {
+    if (!m_node || !m_node->parent) {
+        return DistinguishedName();
+    }
+
+    // The parent stays referenced by this handle's node, so it cannot go
+    // away here; it may not have a text of its own yet
+    Node* parent = m_node->parent;
+    parent->refs.ref();
+    {
+        Pool& p = pool();
+        QWriteLocker locker(&p.lock);
+        if (parent->text.isEmpty()) {
+            parent->text = render(parent);
+        }
+    }
+    return DistinguishedName(parent);
+}
+
+qsizetype DistinguishedName::poolSize() {
+    Pool& p = pool();
+    QReadLocker locker(&p.lock);
+    return p.index.size();
+}
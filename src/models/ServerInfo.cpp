@@ -8,14 +8,32 @@ ServerInfo::ServerInfo(const QString& name, const QString& distinguishedName)
     : m_name(name), m_distinguishedName(distinguishedName), m_rdpPort(3389), m_environment("dev") {
 }
 
+QStringList ServerInfo::getUserList() const {
+    QStringList users;
+    users.reserve(m_users.size());
+    for (const DistinguishedName& user : m_users) {
+        users.append(user.toString());
+    }
+    return users;
+}
+
+void ServerInfo::setUserList(const QStringList& users) {
+    m_users.clear();
+    m_users.reserve(users.size());
+    for (const QString& user : users) {
+        m_users.append(DistinguishedName(user));
+    }
+}
+
 void ServerInfo::addUser(const QString& userDN) {
-    if (!m_userList.contains(userDN)) {
-        m_userList.append(userDN);
+    DistinguishedName dn(userDN);
+    if (!m_users.contains(dn)) {
+        m_users.append(dn);
     }
 }
 
 bool ServerInfo::removeUser(const QString& userDN) {
-    return m_userList.removeOne(userDN);
+    return m_users.removeOne(DistinguishedName(userDN));
 }
 
 QJsonObject ServerInfo::toJson() const {
@@ -28,8 +46,8 @@ QJsonObject ServerInfo::toJson() const {
     
     // Convert user list to JSON array
     QJsonArray userArray;
-    for (const QString& user : m_userList) {
-        userArray.append(user);
+    for (const DistinguishedName& user : m_users) {
+        userArray.append(user.toString());
     }
     json["userList"] = userArray;
     
@@ -51,7 +69,7 @@ ServerInfo ServerInfo::fromJson(const QJsonObject& json) {
     // Parse user list from JSON array
     QJsonArray userArray = json["userList"].toArray();
     for (const QJsonValue& value : userArray) {
-        info.m_userList.append(value.toString());
+        info.m_users.append(DistinguishedName(value.toString()));
     }
     
     // Parse metadata
@@ -1,79 +1,366 @@
 #include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+#include "utils/LdapFilter.h"
+#include "utils/DnTokenizer.h"
+#include "utils/MetadataCodec.h"
+#include <QVariant>
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QtCore/QRegularExpression>
+#include <QTimeZone>
+#include <QSet>
+#include <QVarLengthArray>
 
-ADManager::ADManager(QObject* parent) : QObject(parent), m_connected(false) {
 #ifdef _WIN32
-    // Initialize COM on creation
-    CoInitialize(NULL);
+#include "services/AdsiDirectoryBackend.h"
 #endif
+#ifdef HAVE_OPENLDAP
+#include "services/LdapDirectoryBackend.h"
+#endif
+
+namespace {
+// Attributes that identify an object's version, most precise first
+const QStringList kVersionAttributes = {"uSNChanged", "whenChanged", "modifyTimestamp"};
+
+QString versionOf(const DirectoryEntry& entry) {
+    for (const QString& attribute : kVersionAttributes) {
+        QString version = entry.getValue(attribute);
+        if (!version.isEmpty()) {
+            return version;
+        }
+    }
+    return QString();
+}
+
+// Rough heap footprint, for the object cache's size accounting
+qint64 approximateCost(const UserInfo& user) {
+    // The DN is an interned handle whose text is shared with every other copy
+    return 128 + 2 * (user.getLogin().size() + user.getFullName().size() + user.getFirstName().size() +
+                      user.getLastName().size() + user.getServerName().size());
+}
+
+qint64 approximateCost(const ServerInfo& server) {
+    qint64 cost = 256 + 2 * (server.getName().size() + server.getDistinguishedName().size());
+    cost += server.userCount() * qint64(sizeof(DistinguishedName));
+    return cost + QJsonDocument(server.getMetadata()).toJson(QJsonDocument::Compact).size();
+}
+}
+
+ADManager::ADManager(QObject* parent, std::unique_ptr<IDirectoryBackend> backend)
+    : QObject(parent), m_connected(false), m_searchPageSize(DefaultSearchPageSize),
+      m_backend(std::make_unique<ResilientDirectoryBackend>(backend ? std::move(backend) : createBackend())),
+      m_objectCache(std::make_shared<ADObjectCache>()),
+      m_replica(std::make_shared<DirectoryReplica>()),
+      m_loginIndex(std::make_shared<LoginIndex>()),
+      m_operationDepth(0), m_operationId(0), m_existenceTtlMs(DefaultExistenceTtlMs), m_errorsReported(0),
+      m_metricDepth(0) {
+    m_existenceClock.start();
+    connect(this, &ADManager::error, this, [this]() { ++m_errorsReported; }, Qt::DirectConnection);
+}
+
+ADManager::OperationScope::OperationScope(ADManager* manager)
+    : m_manager(manager) {
+    if (m_manager->m_operationDepth++ == 0) {
+        m_manager->m_operationId++;
+    }
+}
+
+ADManager::OperationScope::~OperationScope() {
+    m_manager->m_operationDepth--;
+}
+
+ADManager::MetricScope::MetricScope(ADManager* manager, DirectoryOperation operation)
+    : m_manager(manager), m_operation(operation), m_recording(manager->m_metricDepth++ == 0),
+      m_errorsBefore(manager->m_errorsReported) {
+    if (m_recording) {
+        m_timer.start();
+    }
+}
+
+ADManager::MetricScope::~MetricScope() {
+    --m_manager->m_metricDepth;
+    if (m_recording) {
+        OperationMetrics::global().record(m_operation, m_timer.nsecsElapsed() / 1000,
+                                          m_manager->m_errorsReported != m_errorsBefore);
+    }
 }
 
 ADManager::~ADManager() {
+}
+
+std::unique_ptr<IDirectoryBackend> ADManager::createBackend(const QString& type) {
+    const QString name = type.toLower();
+
 #ifdef _WIN32
-    // Uninitialize COM on destruction
-    CoUninitialize();
+    if (name.isEmpty() || name == "adsi") {
+        return std::make_unique<AdsiDirectoryBackend>();
+    }
 #endif
+#ifdef HAVE_OPENLDAP
+    if (name == "ldap") {
+        return std::make_unique<LdapDirectoryBackend>();
+    }
+#endif
+    if (name.isEmpty() || name == "memory") {
+        return std::make_unique<InMemoryDirectoryBackend>();
+    }
+    
+    return nullptr;
+}
+
+void ADManager::setBackend(std::unique_ptr<IDirectoryBackend> backend) {
+    m_backend = std::make_unique<ResilientDirectoryBackend>(backend ? std::move(backend) : createBackend(),
+                                                            m_backend->policy());
+    m_objectCache->clear();
+    m_loginIndex->clear();
+    m_serverExistence.clear();
+    
+    if (m_connected) {
+        m_connected = false;
+        m_namingContext.clear();
+        emit connectionStatusChanged(false);
+    }
 }
 
 bool ADManager::connectToAD(const QString& domain) {
-    bool result = false;
+    MetricScope metric(this, DirectoryOperation::Bind);
     
-#ifdef _WIN32
-    try {
-        // If domain is not provided, use the default domain
-        if (domain.isEmpty()) {
-            IADsNamespaces* pNamespaces = nullptr;
-            HRESULT hr = CoCreateInstance(CLSID_ADSystemInfo, NULL, CLSCTX_INPROC_SERVER, 
-                                         IID_IADsNamespaces, (void**)&pNamespaces);
+    m_domain = domain;
+    m_connected = false;
+    m_serverExistence.clear();
+    
+    // An empty naming context lets the backend use the domain's default one
+    if (!m_backend->connect(namingContextFor(domain))) {
+        reportBackendError("Connect to AD");
+        return false;
+    }
+    
+    m_namingContext = m_backend->getNamingContext();
+    m_connected = true;
+    emit connectionStatusChanged(true);
+    
+    return true;
+}
+
+void ADManager::adoptConnection(const QString& domain, const QString& namingContext) {
+    m_domain = domain;
+    m_serverExistence.clear();
+    m_backend->connectLater(namingContext);
+    m_namingContext = namingContext;
+    m_connected = true;
+    emit connectionStatusChanged(true);
+}
+
+std::unique_ptr<ADManager> ADManager::createWorker() const {
+    auto worker = std::make_unique<ADManager>(nullptr, m_backend->inner()->clone());
+    worker->applyWorkerProfile(workerProfile());
+    return worker;
+}
+
+ADWorkerProfile ADManager::workerProfile() const {
+    ADWorkerProfile profile;
+    profile.retryPolicy = m_workerRetryPolicy;
+    profile.searchPageSize = m_searchPageSize;
+    profile.existenceTtlMs = m_existenceTtlMs;
+    profile.domain = m_domain;
+    profile.namingContext = m_namingContext;
+    profile.connected = m_connected;
+    profile.objectCache = m_objectCache;
+    profile.replica = m_replica;
+    profile.loginIndex = m_loginIndex;
+    return profile;
+}
+
+void ADManager::applyWorkerProfile(const ADWorkerProfile& profile) {
+    setRetryPolicy(profile.retryPolicy);
+    setWorkerRetryPolicy(profile.retryPolicy);
+    setSearchPageSize(profile.searchPageSize);
+    setExistenceTtl(profile.existenceTtlMs);
+    setObjectCache(profile.objectCache);
+    setReplica(profile.replica);
+    setLoginIndex(profile.loginIndex);
+    
+    // Follows the source to whatever naming context it is bound to now
+    if (profile.connected && (!m_connected || m_namingContext != profile.namingContext)) {
+        if (connectToAD(profile.namingContext)) {
+            m_domain = profile.domain;
+        }
+    }
+}
+
+void ADManager::setObjectCache(std::shared_ptr<ADObjectCache> cache) {
+    m_objectCache = cache ? std::move(cache) : std::make_shared<ADObjectCache>();
+}
+
+void ADManager::setReplica(std::shared_ptr<DirectoryReplica> replica) {
+    m_replica = replica ? std::move(replica) : std::make_shared<DirectoryReplica>();
+}
+
+void ADManager::setLoginIndex(std::shared_ptr<LoginIndex> index) {
+    m_loginIndex = index ? std::move(index) : std::make_shared<LoginIndex>();
+}
+
+bool ADManager::isReplicaReady() const {
+    return m_connected && m_replica->getWatermark() > 0 && m_replica->getSource() == replicaSource();
+}
+
+ReplicaSyncResult ADManager::syncReplica() {
+    MetricScope metric(this, DirectoryOperation::SyncReplica);
+    
+    ReplicaSyncResult result;
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return result;
+    }
+    
+    if (!m_replica->tryBeginSync()) {
+        return result;
+    }
+    
+    // The replica saved by the last run is loaded lazily, off the GUI thread
+    if (m_replica->entryCount() == 0 && m_replica->getWatermark() == 0) {
+        m_replica->load();
+    }
+    
+    // A replica of another directory, or one never synced, is rebuilt
+    const QString source = replicaSource();
+    const qint64 watermark = m_replica->getWatermark();
+    result.fullSync = watermark <= 0 || m_replica->getSource() != source;
+    
+    QSet<QString> changedServers;
+    qint64 highest = result.fullSync ? 0 : watermark;
+    bool haveUsn = true;
+    
+    // Servers, their groups and their users in one subtree search
+    const QString objects = "(|(objectClass=organizationalUnit)(objectClass=group)"
+                            "(&(objectCategory=person)(objectClass=user)))";
+    SearchRequest request;
+    request.baseDN = m_namingContext;
+    request.filter = result.fullSync ? objects
+                                     : QString("(&%1(uSNChanged>=%2))").arg(objects).arg(watermark + 1);
+    request.attributes = defaultUserAttributes();
+    request.attributes << "objectGUID" << "objectClass" << "ou" << "extensionAttribute1" << "uSNChanged";
+    
+    // Full syncs stage into a new replica so readers keep the old one meanwhile
+    DirectoryReplica staged;
+    DirectoryReplica* target = m_replica.get();
+    if (result.fullSync) {
+        target = &staged;
+        target->reset(source);
+    }
+    
+    bool ok = search(request, [this, target, &result, &changedServers, &highest, &haveUsn](const QList<DirectoryEntry>& page) {
+        for (const DirectoryEntry& entry : page) {
+            // Only the server OUs right under the naming context and what lies below them
+            const QString serverName = serverNameFromDN(entry.getDistinguishedName());
+            if (serverName.isEmpty() || serverName.compare("Domain Controllers", Qt::CaseInsensitive) == 0) {
+                continue;
+            }
             
-            if (SUCCEEDED(hr)) {
-                m_domainDN = "LDAP://DC=example,DC=com"; // Default domain DN
-                releaseInterface(pNamespaces);
-            } else {
-                emit error("Failed to get default domain info");
-                return false;
+            target->upsert(serverName, entry);
+            changedServers.insert(serverName);
+            result.updated++;
+            
+            bool usnOk = false;
+            highest = qMax(highest, entry.getValue("uSNChanged").toLongLong(&usnOk));
+            haveUsn = haveUsn && usnOk;
+        }
+        return true;
+    });
+    
+    // Deletions only show up as tombstones
+    if (ok && !result.fullSync) {
+        SearchRequest deleted;
+        deleted.baseDN = m_namingContext;
+        deleted.filter = QString("(&(isDeleted=TRUE)(uSNChanged>=%1))").arg(watermark + 1);
+        deleted.attributes = {"objectGUID", "uSNChanged"};
+        deleted.includeDeleted = true;
+        
+        ok = search(deleted, [this, &result, &changedServers, &highest](const QList<DirectoryEntry>& page) {
+            for (const DirectoryEntry& entry : page) {
+                const QString serverName = m_replica->remove(DirectoryReplica::keyOf(entry));
+                if (!serverName.isEmpty()) {
+                    changedServers.insert(serverName);
+                    result.deleted++;
+                }
+                highest = qMax(highest, entry.getValue("uSNChanged").toLongLong());
             }
-        } else {
-            m_domainDN = "LDAP://" + domain;
+            return true;
+        });
+    }
+    
+    if (ok) {
+        if (result.fullSync) {
+            m_replica->adopt(staged);
         }
         
-        // Try to bind to the domain
-        IDirectorySearch* pDirSearch = nullptr;
-        HRESULT hr = ADsOpenObject(
-            reinterpret_cast<LPCWSTR>(m_domainDN.utf16()),
-            NULL,
-            NULL,
-            ADS_SECURE_AUTHENTICATION,
-            IID_IDirectorySearch,
-            (void**)&pDirSearch
-        );
+        // Without USNs (e.g. plain slapd) there is no watermark to resume
+        // from, and the next sync is a full one again
+        result.watermark = haveUsn ? highest : 0;
+        m_replica->setWatermark(result.watermark);
         
-        if (SUCCEEDED(hr)) {
-            m_connected = true;
-            // Set up container paths
-            m_serverContainer = "CN=Computers," + domain;
-            m_userContainer = "CN=Users," + domain;
-            
-            releaseInterface(pDirSearch);
-            result = true;
-            emit connectionStatusChanged(true);
-        } else {
-            handleADError("Connect to AD", hr);
-        }
-    } catch (...) {
-        emit error("Unknown exception when connecting to AD");
+        result.changedServers = QStringList(changedServers.begin(), changedServers.end());
+        result.changedServers.sort(Qt::CaseInsensitive);
+        result.success = true;
     }
-#else
-    emit error("AD functionality is only available on Windows");
-#endif
-
+    
+    m_replica->endSync();
     return result;
 }
 
+bool ADManager::saveReplica() {
+    if (!m_replica->save()) {
+        emit error(QString("Could not save the directory replica to %1").arg(m_replica->getStoragePath()));
+        return false;
+    }
+    return true;
+}
+
+void ADManager::setSearchPageSize(int pageSize) {
+    m_searchPageSize = pageSize > 0 ? pageSize : DefaultSearchPageSize;
+}
+
+bool ADManager::search(const SearchRequest& request, const SearchPageCallback& onPage) {
+    MetricScope metric(this, DirectoryOperation::Search);
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return false;
+    }
+    
+    SearchRequest effective = request;
+    if (effective.pageSize <= 0) {
+        effective.pageSize = m_searchPageSize;
+    }
+    
+    // Forward every page to listeners of searchPageReady as well as to the caller
+    SearchPageCallback forward = [this, &onPage](const QList<DirectoryEntry>& page) {
+        emit searchPageReady(page);
+        return onPage ? onPage(page) : true;
+    };
+    
+    if (!m_backend->search(effective, forward)) {
+        reportBackendError("Search");
+        return false;
+    }
+    
+    return true;
+}
+
+QList<DirectoryEntry> ADManager::searchAll(const SearchRequest& request) {
+    QList<DirectoryEntry> results;
+    search(request, [&results](const QList<DirectoryEntry>& page) {
+        results.append(page);
+        return true;
+    });
+    return results;
+}
+
 QStringList ADManager::getServerList() {
+    MetricScope metric(this, DirectoryOperation::GetServerList);
+    
     QStringList serverList;
     
     if (!m_connected) {
@@ -81,18 +368,28 @@ QStringList ADManager::getServerList() {
         return serverList;
     }
     
-#ifdef _WIN32
-    // Implementation for fetching server list from AD
-    // This would query the container where servers are stored
+    // Every server is an OU directly under the naming context
+    SearchRequest request;
+    request.baseDN = m_namingContext;
+    request.scope = SearchScope::OneLevel;
+    request.filter = "(&(objectClass=organizationalUnit)(!(ou=Domain Controllers)))";
+    request.attributes = {"ou"};
+    
+    for (const DirectoryEntry& entry : searchAll(request)) {
+        QString name = entry.getValue("ou");
+        if (name.isEmpty()) {
+            name = DirectoryEntry::rdnOf(entry.getDistinguishedName()).section('=', 1);
+        }
+        serverList << name;
+    }
+    serverList.sort(Qt::CaseInsensitive);
     
-    // Sample mock data
-    serverList << "SERVER01" << "SERVER02" << "DEVSERVER" << "TESTSERVER";
-#endif
-
     return serverList;
 }
 
 ServerInfo ADManager::getServerInfo(const QString& serverName) {
+    MetricScope metric(this, DirectoryOperation::GetServerInfo);
+    
     ServerInfo serverInfo;
     
     if (!m_connected) {
@@ -100,36 +397,82 @@ ServerInfo ADManager::getServerInfo(const QString& serverName) {
         return serverInfo;
     }
     
-    if (!serverExists(serverName)) {
+    OperationScope scope(this);
+    
+    // Served from cache while fresh; once stale, one tiny search tells
+    // whether the server's group changed since it was read
+    const QString cacheKey = "server:" + serverName.toLower();
+    QVariant cached;
+    QString version;
+    ADObjectCache::Lookup state = m_objectCache->lookup(cacheKey, cached, version);
+    if (state == ADObjectCache::Lookup::Fresh) {
+        return cached.value<ServerInfo>();
+    }
+    
+    // The aggregate is the group's membership and metadata, so the group's
+    // own uSNChanged is its version
+    const QString groupDN = buildServerGroupDN(serverName);
+    if (state == ADObjectCache::Lookup::Stale && !changedSince(groupDN, version)) {
+        m_objectCache->revalidated(cacheKey);
+        return cached.value<ServerInfo>();
+    }
+    
+    // Two base reads: the OU, which is also the existence check, and the
+    // group with its members and metadata
+    DirectoryEntry ou;
+    if (!m_backend->readEntry(buildServerOUDN(serverName), {"ou"}, ou)) {
+        m_objectCache->invalidate(cacheKey);
+        if (m_backend->lastError() != DirectoryError::NoSuchObject) {
+            reportBackendError("Get server info");
+            return serverInfo;
+        }
+        rememberServer(serverName, false);
         emit error(QString("Server %1 does not exist").arg(serverName));
         return serverInfo;
     }
+    rememberServer(serverName, true);
     
-#ifdef _WIN32
-    // Implementation for fetching server information from AD
-    // This would query AD for the server object and its attributes
-    
-    // For now, create mock data
-    serverInfo.setName(serverName);
+    const QString name = ou.getValue("ou");
+    serverInfo.setName(name.isEmpty() ? serverName : name);
     serverInfo.setDistinguishedName(buildServerOUDN(serverName));
     serverInfo.setRdpAddress(serverName + ".example.com");
     serverInfo.setRdpPort(3389);
-    serverInfo.setEnvironment(serverName.toLower().contains("dev") ? "dev" : 
+    serverInfo.setEnvironment(serverName.toLower().contains("dev") ? "dev" :
                              (serverName.toLower().contains("test") ? "test" : "prod"));
     
-    // Get users for this server
-    QStringList users = getUsersForServer(serverName);
-    serverInfo.setUserList(users);
+    // Every user of the server is a member of its group (see createUser).
+    // Large groups take one more read per 1500 members
+    DirectoryEntry group;
+    QList<DistinguishedName> members;
+    const bool readMembers = readGroupMembers(groupDN, {"extensionAttribute1", "uSNChanged"}, group,
+                                              [&members](const QStringList& range) {
+        members.reserve(members.size() + range.size());
+        for (const QString& member : range) {
+            members.append(DistinguishedName(member));
+        }
+        return true;
+    });
+    if (!readMembers) {
+        // A partial aggregate must not be cached as the server's state
+        return ServerInfo();
+    }
+    serverInfo.setUsers(members);
+    serverInfo.setMetadata(decodeMetadata(group.getValue("extensionAttribute1")));
+    
+    bool haveUsn = false;
+    const qint64 watermark = group.getValue("uSNChanged").toLongLong(&haveUsn);
+    
+    // Without USNs the entry cannot be revalidated; it still serves within the TTL
+    m_objectCache->insert(cacheKey, QVariant::fromValue(serverInfo),
+                          haveUsn ? QString::number(watermark) : QString(),
+                          approximateCost(serverInfo));
     
-    // Get metadata
-    QJsonObject metadata = getServerMetadata(serverName);
-    serverInfo.setMetadata(metadata);
-#endif
-
     return serverInfo;
 }
 
 bool ADManager::createServerOU(const QString& serverName) {
+    MetricScope metric(this, DirectoryOperation::CreateServer);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
@@ -140,66 +483,160 @@ bool ADManager::createServerOU(const QString& serverName) {
         return true;
     }
     
-#ifdef _WIN32
-    // Implementation for creating a new OU for the server in AD
-    // For now, return true as if it was successful
+    DirectoryEntry ou(buildServerOUDN(serverName));
+    ou.setValues("objectClass", {"top", "organizationalUnit"});
+    ou.setValue("ou", serverName);
+    
+    if (!addOrConfirm(ou, "Create server OU")) {
+        return false;
+    }
+    rememberServer(serverName, true);
+    
     return true;
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
 }
 
 bool ADManager::createServerGroup(const QString& serverName) {
+    MetricScope metric(this, DirectoryOperation::CreateServer);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
     }
     
     QString groupDN = buildServerGroupDN(serverName);
+    if (m_backend->entryExists(groupDN)) {
+        return true;
+    }
     
-#ifdef _WIN32
-    // Implementation for creating a new group for the server in AD
-    // For now, return true as if it was successful
-    return true;
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    // Global security group (ADS_GROUP_TYPE_GLOBAL_GROUP | ADS_GROUP_TYPE_SECURITY_ENABLED)
+    DirectoryEntry group(groupDN);
+    group.setValues("objectClass", {"top", "group"});
+    group.setValue("cn", serverName + "-Group");
+    group.setValue("sAMAccountName", serverName + "-Group");
+    group.setValue("groupType", "-2147483646");
+    
+    return addOrConfirm(group, "Create server group");
 }
 
 QStringList ADManager::getUsersForServer(const QString& serverName) {
     QStringList userList;
+    streamServerMembers(serverName, [&userList](const QStringList& members) {
+        userList.append(members);
+        return true;
+    });
+    return userList;
+}
+
+bool ADManager::streamServerMembers(const QString& serverName,
+                                    const std::function<bool(const QStringList&)>& onRange) {
+    MetricScope metric(this, DirectoryOperation::GetUsers);
     
     if (!m_connected) {
         emit error("Not connected to AD");
-        return userList;
+        return false;
     }
     
     if (!serverExists(serverName)) {
         emit error(QString("Server %1 does not exist").arg(serverName));
-        return userList;
+        return false;
     }
     
-#ifdef _WIN32
-    // Implementation for fetching users for a specific server from AD
-    // This would query the group or OU associated with the server and get its members
-    
-    // Sample mock data
-    if (serverName == "SERVER01") {
-        userList << "CN=User1,OU=SERVER01,DC=example,DC=com" 
-                << "CN=User2,OU=SERVER01,DC=example,DC=com";
-    } else if (serverName == "DEVSERVER") {
-        userList << "CN=DevUser1,OU=DEVSERVER,DC=example,DC=com"
-                << "CN=DevUser2,OU=DEVSERVER,DC=example,DC=com"
-                << "CN=DevUser3,OU=DEVSERVER,DC=example,DC=com";
+    // Every user of the server is a member of its group (see createUser)
+    DirectoryEntry group;
+    return readGroupMembers(buildServerGroupDN(serverName), {}, group, onRange);
+}
+
+QList<UserInfo> ADManager::getUsersWithInfoForServer(const QString& serverName, const QStringList& attributeList) {
+    QList<UserInfo> users;
+    streamUsersForServer(serverName, [&users](const QList<UserInfo>& page) {
+        users.append(page);
+        return true;
+    }, attributeList);
+    return users;
+}
+
+bool ADManager::streamUsersForServer(const QString& serverName,
+                                     const std::function<bool(const QList<UserInfo>&)>& onPage,
+                                     const QStringList& attributeList) {
+    MetricScope metric(this, DirectoryOperation::GetUsers);
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return false;
     }
-#endif
+    
+    if (!serverExists(serverName)) {
+        emit error(QString("Server %1 does not exist").arg(serverName));
+        return false;
+    }
+    
+    // Always fetch what userInfoFromEntry needs, plus anything the caller asked for
+    SearchRequest request;
+    request.baseDN = buildServerOUDN(serverName);
+    request.filter = "(&(objectCategory=person)(objectClass=user))";
+    request.attributes = defaultUserAttributes();
+    for (const QString& attribute : attributeList) {
+        if (!request.attributes.contains(attribute, Qt::CaseInsensitive)) {
+            request.attributes << attribute;
+        }
+    }
+    
+    // One paged subtree search on the server OU instead of a bind per user DN
+    return search(request, [&serverName, &onPage](const QList<DirectoryEntry>& page) {
+        QList<UserInfo> users;
+        users.reserve(page.size());
+        for (const DirectoryEntry& entry : page) {
+            UserInfo user = userInfoFromEntry(entry);
+            if (user.getServerName().isEmpty()) {
+                user.setServerName(serverName);
+            }
+            users.append(user);
+        }
+        return onPage(users);
+    });
+}
 
-    return userList;
+bool ADManager::getUsersWindow(const QString& serverName, const QList<SortKey>& order, const VlvWindow& window,
+                               QList<UserInfo>& users, VlvResult& result) {
+    MetricScope metric(this, DirectoryOperation::GetUsers);
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return false;
+    }
+    
+    if (!serverExists(serverName)) {
+        emit error(QString("Server %1 does not exist").arg(serverName));
+        return false;
+    }
+    
+    SearchRequest request;
+    request.baseDN = buildServerOUDN(serverName);
+    request.filter = "(&(objectCategory=person)(objectClass=user))";
+    request.attributes = defaultUserAttributes();
+    request.sortKeys = order.isEmpty() ? QList<SortKey>{SortKey{"displayName", false}} : order;
+    
+    QList<DirectoryEntry> entries;
+    if (!m_backend->searchWindow(request, window, entries, result)) {
+        reportBackendError("Get users window");
+        return false;
+    }
+    
+    users.reserve(users.size() + entries.size());
+    for (const DirectoryEntry& entry : entries) {
+        UserInfo user = userInfoFromEntry(entry);
+        if (user.getServerName().isEmpty()) {
+            user.setServerName(serverName);
+        }
+        users.append(user);
+    }
+    
+    return true;
 }
 
 UserInfo ADManager::getUserInfo(const QString& userDN) {
+    MetricScope metric(this, DirectoryOperation::GetUser);
+    
     UserInfo userInfo;
     
     if (!m_connected) {
@@ -207,62 +644,71 @@ UserInfo ADManager::getUserInfo(const QString& userDN) {
         return userInfo;
     }
     
-#ifdef _WIN32
-    // Implementation for fetching user information from AD
-    // This would query AD for the user object and its attributes
-      // Extract server name from the DN
-    QRegularExpression serverRegex("OU=([^,]+),");
-    QRegularExpressionMatch serverMatch = serverRegex.match(userDN);
-    if (serverMatch.hasMatch()) {
-        QString serverName = serverMatch.captured(1);
-        userInfo.setServerName(serverName);
-    }
-    
-    // Extract login from the DN
-    QRegularExpression loginRegex("CN=([^,]+),");
-    QRegularExpressionMatch loginMatch = loginRegex.match(userDN);
-    if (loginMatch.hasMatch()) {
-        QString login = loginMatch.captured(1);
-        userInfo.setLogin(login);
-    }
-    
-    // Set distinguished name
-    userInfo.setDistinguishedName(userDN);
-    
-    // For now, create mock data
-    if (userDN.contains("User1")) {
-        userInfo.setFullName("Ivan Petrov");
-        userInfo.setFirstName("Ivan");
-        userInfo.setLastName("Petrov");
-        userInfo.setCreatedDate(QDateTime::currentDateTime().addDays(-30));
-        userInfo.setLastLogin(QDateTime::currentDateTime().addDays(-2));
-        userInfo.setActive(true);
-    } else if (userDN.contains("User2")) {
-        userInfo.setFullName("Olga Sidorova");
-        userInfo.setFirstName("Olga");
-        userInfo.setLastName("Sidorova");
-        userInfo.setCreatedDate(QDateTime::currentDateTime().addDays(-15));
-        userInfo.setLastLogin(QDateTime::currentDateTime().addDays(-5));
-        userInfo.setActive(true);
-    } else if (userDN.contains("DevUser")) {
-        userInfo.setFullName("Developer User");
-        userInfo.setFirstName("Developer");
-        userInfo.setLastName("User");
-        userInfo.setCreatedDate(QDateTime::currentDateTime().addDays(-60));
-        userInfo.setLastLogin(QDateTime::currentDateTime().addDays(-1));
-        userInfo.setActive(true);
+    const QString cacheKey = "user:" + userDN.toLower();
+    QVariant cached;
+    QString version;
+    ADObjectCache::Lookup state = m_objectCache->lookup(cacheKey, cached, version);
+    if (state == ADObjectCache::Lookup::Fresh) {
+        return cached.value<UserInfo>();
     }
-#endif
-
+    
+    // Stale: re-read only the version attributes and keep the copy if unchanged
+    if (state == ADObjectCache::Lookup::Stale && !version.isEmpty()) {
+        DirectoryEntry current;
+        if (m_backend->readEntry(userDN, kVersionAttributes, current) && versionOf(current) == version) {
+            m_objectCache->revalidated(cacheKey);
+            return cached.value<UserInfo>();
+        }
+    }
+    
+    DirectoryEntry entry;
+    if (!m_backend->readEntry(userDN, defaultUserAttributes() + kVersionAttributes, entry)) {
+        m_objectCache->invalidate(cacheKey);
+        reportBackendError("Get user info");
+        return userInfo;
+    }
+    
+    userInfo = userInfoFromEntry(entry);
+    m_objectCache->insert(cacheKey, QVariant::fromValue(userInfo), versionOf(entry), approximateCost(userInfo));
+    
     return userInfo;
 }
 
+QList<UserInfo> ADManager::getUsersByDN(const QStringList& userDNs) {
+    MetricScope metric(this, DirectoryOperation::GetUser);
+    
+    QList<UserInfo> users;
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return users;
+    }
+    
+    // One batch read: backends that can pipeline send all lookups at once
+    QList<DirectoryEntry> entries;
+    if (!m_backend->readEntries(userDNs, defaultUserAttributes(), entries)) {
+        reportBackendError("Get user info");
+        return users;
+    }
+    
+    users.reserve(entries.size());
+    for (const DirectoryEntry& entry : entries) {
+        users.append(userInfoFromEntry(entry));
+    }
+    
+    return users;
+}
+
 bool ADManager::createUser(const UserInfo& user, const QString& serverName) {
+    MetricScope metric(this, DirectoryOperation::CreateUser);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
     }
     
+    OperationScope scope(this);
+    
     // Create server OU and group if they don't exist
     if (!serverExists(serverName)) {
         if (!createServerOU(serverName)) {
@@ -276,25 +722,62 @@ bool ADManager::createUser(const UserInfo& user, const QString& serverName) {
         }
     }
     
-    // Check if the user already exists
+    // Check if the user already exists. Someone else may have taken the
+    // login since it was allocated; the index learns it for the next pick
     if (userExists(user.getLogin())) {
+        m_loginIndex->noteTaken(user.getLogin());
         emit error(QString("User %1 already exists").arg(user.getLogin()));
         return false;
     }
     
-#ifdef _WIN32
-    // Implementation for creating a new user in AD
-    // This would create a user in the server's OU and add them to the server's group
+    QString userDN = buildUserDN(user.getLogin(), serverName);
     
-    // For now, return true as if it was successful
-    return true;
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    DirectoryEntry entry(userDN);
+    entry.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+    entry.setValue("cn", user.getLogin());
+    entry.setValue("sAMAccountName", user.getLogin());
+    if (!m_domain.isEmpty() && !m_domain.contains('=')) {
+        entry.setValue("userPrincipalName", user.getLogin() + "@" + m_domain);
+    }
+    if (!user.getFirstName().isEmpty()) {
+        entry.setValue("givenName", user.getFirstName());
+    }
+    if (!user.getLastName().isEmpty()) {
+        entry.setValue("sn", user.getLastName());
+    }
+    if (!user.getFullName().isEmpty()) {
+        entry.setValue("displayName", user.getFullName());
+    }
+    // Created disabled: a domain password policy rejects enabled accounts without a password
+    entry.setValue("userAccountControl", "514");
+    
+    if (!m_backend->addEntry(entry)) {
+        reportBackendError("Create user");
+        return false;
+    }
+    invalidateCached(userDN);
+    m_loginIndex->noteTaken(user.getLogin());
+    
+    if (!user.getPassword().isEmpty() && !m_backend->setPassword(userDN, user.getPassword())) {
+        reportBackendError("Set initial password");
+        return false;
+    }
+    
+    // ADS_UF_NORMAL_ACCOUNT, now enabled
+    ADObjectChangeSet enable(userDN);
+    enable.put("userAccountControl", user.isActive() ? "512" : "514");
+    if (!commitChanges(enable)) {
+        return false;
+    }
+    
+    ADObjectChangeSet membership(buildServerGroupDN(serverName));
+    membership.append("member", userDN);
+    return commitChanges(membership);
 }
 
 bool ADManager::updateUser(const UserInfo& user) {
+    MetricScope metric(this, DirectoryOperation::Modify);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
@@ -305,54 +788,206 @@ bool ADManager::updateUser(const UserInfo& user) {
         return false;
     }
     
-#ifdef _WIN32
-    // Implementation for updating user information in AD
-    // This would update the user's attributes in AD
+    QString userDN = user.getDistinguishedName();
+    if (userDN.isEmpty()) {
+        userDN = buildUserDN(user.getLogin(), user.getServerName());
+    }
     
-    // For now, return true as if it was successful
-    return true;
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    // All name attributes go out in a single modify
+    ADObjectChangeSet changes(userDN);
+    changes.put("givenName", user.getFirstName())
+           .put("sn", user.getLastName())
+           .put("displayName", user.getFullName());
+    
+    return commitChanges(changes);
 }
 
 bool ADManager::deactivateUser(const QString& userDN) {
+    MetricScope metric(this, DirectoryOperation::Modify);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
     }
     
-#ifdef _WIN32
-    // Implementation for deactivating a user in AD
-    // This would typically set the user's account to disabled
+    DirectoryEntry entry;
+    if (!m_backend->readEntry(userDN, {"userAccountControl"}, entry)) {
+        reportBackendError("Deactivate user");
+        return false;
+    }
     
-    // For now, return true as if it was successful
-    return true;
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    // Set ADS_UF_ACCOUNTDISABLE, keeping the other account flags
+    bool ok = false;
+    int accountControl = entry.getValue("userAccountControl").toInt(&ok);
+    if (!ok) {
+        accountControl = 0x200; // ADS_UF_NORMAL_ACCOUNT
+    }
+    
+    ADObjectChangeSet changes(userDN);
+    changes.put("userAccountControl", QString::number(accountControl | 0x2));
+    
+    return commitChanges(changes);
+}
+
+QList<BulkDeactivateResult> ADManager::deactivateUsers(const QStringList& userDNs) {
+    MetricScope metric(this, DirectoryOperation::Modify);
+    
+    QList<BulkDeactivateResult> results(userDNs.size());
+    for (int i = 0; i < userDNs.size(); ++i) {
+        results[i].dn = userDNs[i];
+    }
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        for (BulkDeactivateResult& result : results) {
+            result.error = "Not connected to AD";
+        }
+        return results;
+    }
+    
+    // userAccountControl of every target from one search: an OR of the DNs,
+    // split only when the list would make an unreasonably long filter
+    const int maxTerms = 1000;
+    QHash<DistinguishedName, QString> accountControls;
+    for (int start = 0; start < userDNs.size(); start += maxTerms) {
+        QString terms;
+        for (const QString& dn : userDNs.mid(start, maxTerms)) {
+            terms += QString("(distinguishedName=%1)").arg(LdapFilter::escapeValue(dn));
+        }
+        
+        SearchRequest request;
+        request.baseDN = m_namingContext;
+        request.filter = QString("(&(objectClass=user)(|%1))").arg(terms);
+        request.attributes = {"distinguishedName", "userAccountControl"};
+        
+        const bool found = search(request, [&accountControls](const QList<DirectoryEntry>& page) {
+            for (const DirectoryEntry& entry : page) {
+                accountControls.insert(DistinguishedName(entry.getDistinguishedName()),
+                                       entry.getValue("userAccountControl"));
+            }
+            return true;
+        });
+        if (!found) {
+            for (BulkDeactivateResult& result : results) {
+                result.error = "Could not read the accounts to deactivate";
+            }
+            return results;
+        }
+    }
+    
+    // Set ADS_UF_ACCOUNTDISABLE where it is not set yet, keeping the other
+    // account flags. A DN listed twice is modified once
+    QList<ADObjectChangeSet> changes;
+    QList<int> changeOf(userDNs.size(), -1);
+    QHash<DistinguishedName, int> queued;
+    for (int i = 0; i < userDNs.size(); ++i) {
+        const DistinguishedName dn(userDNs[i]);
+        auto it = accountControls.constFind(dn);
+        if (it == accountControls.constEnd()) {
+            results[i].status = BulkDeactivateResult::Status::NotFound;
+            results[i].error = QString("User %1 does not exist").arg(userDNs[i]);
+            continue;
+        }
+        
+        bool ok = false;
+        int accountControl = it.value().toInt(&ok);
+        if (!ok) {
+            accountControl = 0x200; // ADS_UF_NORMAL_ACCOUNT
+        }
+        if (accountControl & 0x2) {
+            results[i].status = BulkDeactivateResult::Status::Deactivated;
+            continue;
+        }
+        
+        if (!queued.contains(dn)) {
+            ADObjectChangeSet change(userDNs[i]);
+            change.put("userAccountControl", QString::number(accountControl | 0x2));
+            queued.insert(dn, changes.size());
+            changes.append(change);
+            
+            // Drop cached copies even on failure: the write may have applied
+            invalidateCached(userDNs[i]);
+        }
+        changeOf[i] = queued.value(dn);
+    }
+    
+    // A batch cut short sends only the first writes.size() change sets
+    QList<DirectoryWriteResult> writes;
+    const bool completed = m_backend->modifyEntries(changes, writes);
+    const QString reason = completed ? QString() : m_backend->lastErrorMessage();
+    const QString notAttempted = reason.isEmpty() ? QString("Not attempted") : "Not attempted: " + reason;
+    
+    int failed = 0;
+    int missing = 0;
+    int unsent = 0;
+    for (int i = 0; i < userDNs.size(); ++i) {
+        if (changeOf[i] >= writes.size()) {
+            results[i].status = BulkDeactivateResult::Status::NotAttempted;
+            results[i].error = notAttempted;
+        } else if (changeOf[i] >= 0) {
+            const DirectoryWriteResult& write = writes[changeOf[i]];
+            if (write.error == DirectoryError::None) {
+                results[i].status = BulkDeactivateResult::Status::Deactivated;
+            } else {
+                results[i].status = BulkDeactivateResult::Status::Failed;
+                results[i].error = write.message.isEmpty() ? QString("Unknown error") : write.message;
+            }
+        }
+        
+        switch (results[i].status) {
+        case BulkDeactivateResult::Status::Failed:
+            ++failed;
+            break;
+        case BulkDeactivateResult::Status::NotFound:
+            ++missing;
+            break;
+        case BulkDeactivateResult::Status::NotAttempted:
+            ++unsent;
+            break;
+        case BulkDeactivateResult::Status::Deactivated:
+            break;
+        }
+    }
+    
+    QStringList problems;
+    if (failed > 0) {
+        problems << QString("%1 could not be deactivated").arg(failed);
+    }
+    if (missing > 0) {
+        problems << QString("%1 do not exist").arg(missing);
+    }
+    if (unsent > 0) {
+        problems << (reason.isEmpty() ? QString("%1 were not attempted").arg(unsent)
+                                      : QString("%1 were not attempted (%2)").arg(unsent).arg(reason));
+    }
+    if (!problems.isEmpty()) {
+        emit error(QString("AD Error during Deactivate users: of %1 users, %2")
+                   .arg(userDNs.size()).arg(problems.join(", ")));
+    }
+    
+    return results;
 }
 
 bool ADManager::changePassword(const QString& userDN, const QString& newPassword) {
+    MetricScope metric(this, DirectoryOperation::SetPassword);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
     }
     
-#ifdef _WIN32
-    // Implementation for changing a user's password in AD
+    if (!m_backend->setPassword(userDN, newPassword)) {
+        reportBackendError("Change password");
+        return false;
+    }
     
-    // For now, return true as if it was successful
+    invalidateCached(userDN);
     return true;
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
 }
 
 bool ADManager::setServerMetadata(const QString& serverName, const QJsonObject& metadata) {
+    MetricScope metric(this, DirectoryOperation::SetAttribute);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
@@ -364,19 +999,46 @@ bool ADManager::setServerMetadata(const QString& serverName, const QJsonObject&
     }
     
     QString groupDN = buildServerGroupDN(serverName);
-    QString jsonString = QJsonDocument(metadata).toJson(QJsonDocument::Compact);
+    QString encoded = MetadataCodec::encode(metadata);
+    if (encoded.length() > MetadataCodec::MaxEncodedLength) {
+        emit error(QString("Metadata for %1 is too large (%2 characters encoded, at most %3)")
+                   .arg(serverName).arg(encoded.length()).arg(MetadataCodec::MaxEncodedLength));
+        return false;
+    }
     
-#ifdef _WIN32
-    // Implementation for storing metadata in AD
-    // This would set an extensionAttribute on the server's group or OU
-    return setADAttribute(groupDN, "extensionAttribute1", jsonString);
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    // Metadata lives in an extensionAttribute on the server's group
+    ADObjectChangeSet changes(groupDN);
+    changes.put("extensionAttribute1", encoded);
+    
+    return commitChanges(changes);
+}
+
+bool ADManager::commitChanges(const ADObjectChangeSet& changes) {
+    MetricScope metric(this, DirectoryOperation::Modify);
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return false;
+    }
+    
+    if (changes.isEmpty()) {
+        return true;
+    }
+    
+    // Drop cached copies even on failure: the write may have partially applied
+    invalidateCached(changes.getDistinguishedName());
+    
+    if (!m_backend->modifyEntry(changes)) {
+        reportBackendError("Commit changes");
+        return false;
+    }
+    
+    return true;
 }
 
 QJsonObject ADManager::getServerMetadata(const QString& serverName) {
+    MetricScope metric(this, DirectoryOperation::GetAttribute);
+    
     QJsonObject metadata;
     
     if (!m_connected) {
@@ -391,252 +1053,473 @@ QJsonObject ADManager::getServerMetadata(const QString& serverName) {
     
     QString groupDN = buildServerGroupDN(serverName);
     
-#ifdef _WIN32
-    // Implementation for retrieving metadata from AD
-    // This would get the extensionAttribute from the server's group or OU
-    
-    QString jsonString = getADAttribute(groupDN, "extensionAttribute1");
-    if (!jsonString.isEmpty()) {
-        QJsonDocument doc = QJsonDocument::fromJson(jsonString.toUtf8());
-        if (!doc.isNull() && doc.isObject()) {
-            metadata = doc.object();
-        }
-    }
-#endif
-
-    return metadata;
+    return decodeMetadata(getADAttribute(groupDN, "extensionAttribute1"));
 }
 
 bool ADManager::serverExists(const QString& serverName) {
+    MetricScope metric(this, DirectoryOperation::ExistsCheck);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
     }
     
-    QString ouDN = buildServerOUDN(serverName);
+    if (serverName.isEmpty()) {
+        return false;
+    }
+    
+    m_existenceStats.checks++;
+    auto it = m_serverExistence.constFind(serverName.toLower());
+    if (it != m_serverExistence.constEnd()) {
+        const bool sameOperation = m_operationDepth > 0 && it->operation == m_operationId;
+        if (sameOperation || m_existenceClock.elapsed() - it->checkedMs < m_existenceTtlMs) {
+            metric.skip();
+            return it->exists;
+        }
+    }
+    
+    m_existenceStats.directoryLookups++;
+    const bool exists = m_backend->entryExists(buildServerOUDN(serverName));
     
-#ifdef _WIN32
-    // Implementation for checking if a server exists in AD
-    // This would check if the server's OU exists
-    
-    // For now, we'll say all servers exist
-    QStringList knownServers = {"SERVER01", "SERVER02", "DEVSERVER", "TESTSERVER"};
-    return knownServers.contains(serverName);
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    // A failed lookup is not an answer worth keeping
+    if (m_backend->lastError() == DirectoryError::None) {
+        rememberServer(serverName, exists);
+    }
+    
+    return exists;
+}
+
+void ADManager::rememberServer(const QString& serverName, bool exists) {
+    ExistenceEntry entry;
+    entry.exists = exists;
+    entry.operation = m_operationDepth > 0 ? m_operationId : 0;
+    entry.checkedMs = m_existenceClock.elapsed();
+    m_serverExistence.insert(serverName.toLower(), entry);
 }
 
 bool ADManager::userExists(const QString& login) {
+    MetricScope metric(this, DirectoryOperation::ExistsCheck);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return false;
     }
     
-#ifdef _WIN32
-    // Implementation for checking if a user exists in AD
+    if (login.isEmpty()) {
+        return false;
+    }
     
-    // For now, say these users already exist
-    QStringList existingUsers = {"user1", "user2", "devuser1", "devuser2", "devuser3"};
-    return existingUsers.contains(login.toLower());
-#else
-    emit error("AD functionality is only available on Windows");
-    return false;
-#endif
+    // sAMAccountName is unique across the whole domain
+    SearchRequest request;
+    request.baseDN = m_namingContext;
+    request.filter = QString("(&(objectClass=user)(sAMAccountName=%1))").arg(LdapFilter::escapeValue(login));
+    request.attributes = {"distinguishedName"};
+    request.sizeLimit = 1;
+    
+    bool found = false;
+    search(request, [&found](const QList<DirectoryEntry>& page) {
+        found = !page.isEmpty();
+        return false;
+    });
+    
+    return found;
 }
 
 QString ADManager::generateUniqueLogin(const QString& firstName, const QString& lastName) {
+    MetricScope metric(this, DirectoryOperation::AllocateLogin);
+    
     if (!m_connected) {
         emit error("Not connected to AD");
         return QString();
     }
     
-    // Basic algorithm: first letter of first name + last name
-    QString baseLogin = firstName.left(1).toUpper() + lastName;
-      // Remove spaces and special characters
-    baseLogin.remove(QRegularExpression("[^a-zA-Z0-9]"));
+    const QString baseLogin = loginBaseFor(firstName, lastName);
+    if (baseLogin.isEmpty()) {
+        return QString();
+    }
     
-    // If the login already exists, append a number
-    QString login = baseLogin;
-    int suffix = 1;
+    // One prefix search loads every taken suffix; the lowest free one is
+    // then picked locally instead of probing base1, base2... one by one
+    const bool loaded = m_loginIndex->isLoaded(baseLogin);
+    if (!loaded && !loadLoginBase(baseLogin)) {
+        return QString();
+    }
     
-    while (userExists(login)) {
-        login = baseLogin + QString::number(suffix++);
+    // A base loaded earlier does not know logins created since by others;
+    // the pick is confirmed and, if taken meanwhile, the base reloaded
+    QString login = m_loginIndex->lowestFree(baseLogin);
+    if (loaded && userExists(login)) {
+        if (!loadLoginBase(baseLogin)) {
+            return QString();
+        }
+        login = m_loginIndex->lowestFree(baseLogin);
     }
     
     return login;
 }
 
-void ADManager::handleADError(const QString& operation, HRESULT hr) {
-#ifdef _WIN32
-    _com_error err(hr);
-    LPCTSTR errMsg = err.ErrorMessage();
-    QString qErrorMsg = QString::fromWCharArray(errMsg);
-    
-    emit error(QString("AD Error during %1: %2 (0x%3)")
-              .arg(operation)
-              .arg(qErrorMsg)
-              .arg(QString::number(hr, 16)));
-#else
-    Q_UNUSED(operation);
-    Q_UNUSED(hr);
-#endif
+bool ADManager::allocateLogins(QList<NormalizedUser>& users) {
+    MetricScope metric(this, DirectoryOperation::AllocateLogin);
+    
+    if (!m_connected) {
+        emit error("Not connected to AD");
+        return false;
+    }
+    
+    // Base per user, and one lookup per distinct base. Each batch reloads
+    // its bases whatever their age: the logins are shown for review and
+    // created later, so they should be free as of now, including logins
+    // created by other admins since the index last saw the base
+    QStringList bases;
+    QSet<QString> reloaded;
+    bases.reserve(users.size());
+    for (const NormalizedUser& user : users) {
+        QString base = user.getGeneratedLogin();
+        base.remove(QRegularExpression("[^a-zA-Z0-9]"));
+        if (base.isEmpty()) {
+            base = loginBaseFor(user.getFirstName(), user.getLastName());
+        }
+        bases << base;
+        
+        if (user.getIsValid() && !base.isEmpty() && !reloaded.contains(base.toLower())) {
+            if (!loadLoginBase(base)) {
+                return false;
+            }
+            reloaded.insert(base.toLower());
+        }
+    }
+    
+    // Suffixes taken per base, extended as the batch claims them. The
+    // assigned set also catches bases that overlap (IPetrenko1 as a base
+    // and as IPetrenko's first suffix)
+    QHash<QString, std::set<quint32>> taken;
+    QSet<QString> assigned;
+    for (int i = 0; i < users.size(); ++i) {
+        if (!users[i].getIsValid() || bases[i].isEmpty()) {
+            continue;
+        }
+        
+        const QString key = bases[i].toLower();
+        auto it = taken.find(key);
+        if (it == taken.end()) {
+            it = taken.insert(key, m_loginIndex->takenSuffixes(bases[i]));
+        }
+        
+        QString login;
+        do {
+            const quint32 suffix = LoginIndex::lowestFreeSuffix(*it);
+            it->insert(suffix);
+            login = LoginIndex::loginFor(bases[i], suffix);
+        } while (assigned.contains(login.toLower()));
+        
+        assigned.insert(login.toLower());
+        users[i].setGeneratedLogin(login);
+    }
+    
+    return true;
 }
 
-QString ADManager::buildUserDN(const QString& login, const QString& serverName) {
-    return QString("CN=%1,OU=%2,%3")
-           .arg(login)
-           .arg(serverName)
-           .arg(m_domainDN.mid(7)); // Remove "LDAP://" prefix
+QString ADManager::loginBaseFor(const QString& firstName, const QString& lastName) {
+    // First letter of first name + last name, without spaces and special characters
+    QString baseLogin = firstName.left(1).toUpper() + lastName;
+    baseLogin.remove(QRegularExpression("[^a-zA-Z0-9]"));
+    return baseLogin;
 }
 
-QString ADManager::buildServerGroupDN(const QString& serverName) {
-    return QString("CN=%1-Group,OU=%2,%3")
-           .arg(serverName)
-           .arg(serverName)
-           .arg(m_domainDN.mid(7)); // Remove "LDAP://" prefix
+bool ADManager::loadLoginBase(const QString& baseLogin) {
+    // sAMAccountName is unique across users and groups alike
+    SearchRequest request;
+    request.baseDN = m_namingContext;
+    request.filter = QString("(sAMAccountName=%1*)").arg(LdapFilter::escapeValue(baseLogin));
+    request.attributes = {"sAMAccountName"};
+    
+    QStringList logins;
+    bool ok = search(request, [&logins](const QList<DirectoryEntry>& page) {
+        for (const DirectoryEntry& entry : page) {
+            logins << entry.getValue("sAMAccountName");
+        }
+        return true;
+    });
+    if (!ok) {
+        return false;
+    }
+    
+    m_loginIndex->load(baseLogin, logins);
+    return true;
 }
 
-QString ADManager::buildServerOUDN(const QString& serverName) {
-    return QString("OU=%1,%2")
-           .arg(serverName)
-           .arg(m_domainDN.mid(7)); // Remove "LDAP://" prefix
+QJsonObject ADManager::decodeMetadata(const QString& value) {
+    // Binary (CBOR) values and legacy JSON alike
+    return MetadataCodec::decode(value);
 }
 
-bool ADManager::setADAttribute(const QString& objectDN, const QString& attribute, const QString& value) {
-#ifdef _WIN32
-    bool result = false;
-    IDispatch* pObject = nullptr;
-    
-    HRESULT hr = getObject(objectDN, &pObject);
-    if (SUCCEEDED(hr) && pObject) {
-        VARIANT var;
-        VariantInit(&var);
-        var.vt = VT_BSTR;
-        var.bstrVal = SysAllocString(reinterpret_cast<const OLECHAR*>(value.utf16()));
+bool ADManager::readGroupMembers(const QString& groupDN, const QStringList& attributes, DirectoryEntry& entry,
+                                 const std::function<bool(const QStringList&)>& onRange) {
+    // The first read asks for plain member alongside the other attributes.
+    // A server that caps multi-valued attributes (AD: MaxValRange) answers
+    // with the slice it sent, member;range=0-1499, and only then do later
+    // reads ask for member;range=<low>-* until the slice ending in * arrives
+    QStringList request = attributes;
+    request << "member";
+    AttributeRange next{"member", 0, -1};
+    
+    while (true) {
+        DirectoryEntry chunk;
+        if (!m_backend->readEntry(groupDN, request, chunk)) {
+            reportBackendError("Read group members");
+            return false;
+        }
+        if (next.low == 0) {
+            entry = chunk;
+        }
+        
+        AttributeRange sent;
+        if (!AttributeRange::find(chunk, "member", sent)) {
+            // Sent whole; an empty group has no member attribute at all
+            const QStringList members = chunk.getValues("member");
+            if (!members.isEmpty()) {
+                onRange(members);
+            }
+            return true;
+        }
         
-        hr = setObjectAttribute(pObject, attribute, &var);
-        result = SUCCEEDED(hr);
+        // A slice that does not move forward would loop forever
+        if (!sent.isLast() && sent.high < next.low) {
+            emit error(QString("AD Error during Read group members: %1 of %2 does not advance past %3")
+                       .arg(sent.toString(), groupDN).arg(next.low));
+            return false;
+        }
+        
+        const QStringList members = chunk.getValues(sent.toString());
+        if ((!members.isEmpty() && !onRange(members)) || sent.isLast()) {
+            return true;
+        }
         
-        VariantClear(&var);
-        releaseInterface(pObject);
+        next.low = sent.high + 1;
+        request = QStringList{next.toString()};
+    }
+}
+
+bool ADManager::changedSince(const QString& dn, const QString& version) {
+    bool ok = false;
+    const qint64 watermark = version.toLongLong(&ok);
+    if (!ok) {
+        return true;
     }
     
-    return result;
-#else
-    Q_UNUSED(objectDN);
-    Q_UNUSED(attribute);
-    Q_UNUSED(value);
-    return false;
-#endif
+    // The object itself, e.g. a server's group, matches only if it was
+    // written after the watermark. A search failure (e.g. the group is
+    // gone) counts as changed
+    SearchRequest request;
+    request.baseDN = dn;
+    request.scope = SearchScope::Base;
+    request.filter = QString("(uSNChanged>=%1)").arg(watermark + 1);
+    request.attributes = {"distinguishedName"};
+    request.sizeLimit = 1;
+    
+    bool changed = false;
+    if (!m_backend->search(request, [&changed](const QList<DirectoryEntry>& page) {
+            changed = !page.isEmpty();
+            return false;
+        })) {
+        return true;
+    }
+    
+    return changed;
 }
 
-QString ADManager::getADAttribute(const QString& objectDN, const QString& attribute) {
-#ifdef _WIN32
-    QString result;
-    IDispatch* pObject = nullptr;
+void ADManager::invalidateCached(const QString& dn) {
+    m_objectCache->invalidate("user:" + dn.toLower());
     
-    HRESULT hr = getObject(objectDN, &pObject);
-    if (SUCCEEDED(hr) && pObject) {
-        VARIANT var;
-        VariantInit(&var);
-        
-        hr = getObjectAttribute(pObject, attribute, &var);
-        if (SUCCEEDED(hr)) {
-            result = variantToString(var);
+    // Any write below a server OU also changes that server's aggregate
+    QString serverName = serverNameFromDN(dn);
+    if (!serverName.isEmpty()) {
+        m_objectCache->invalidate("server:" + serverName.toLower());
+    }
+}
+
+QString ADManager::serverNameFromDN(const QString& dn) const {
+    if (m_namingContext.isEmpty()) {
+        return QString();
+    }
+    
+    // Compared RDN by RDN, so case, escapes and spacing do not matter
+    QVarLengthArray<QStringView, 8> rdns;
+    QVarLengthArray<QStringView, 4> context;
+    QStringView rdn;
+    DnTokenizer tokens(dn);
+    while (tokens.next(rdn)) {
+        rdns.append(rdn);
+    }
+    DnTokenizer contextTokens(m_namingContext);
+    while (contextTokens.next(rdn)) {
+        context.append(rdn);
+    }
+    if (tokens.hasError() || contextTokens.hasError()) {
+        return QString();
+    }
+    
+    // The RDN right under the naming context: OU=<server>
+    const qsizetype top = rdns.size() - context.size() - 1;
+    if (top < 0) {
+        return QString();
+    }
+    for (qsizetype i = 0; i < context.size(); ++i) {
+        if (!DnTokenizer::sameRdn(rdns[top + 1 + i], context[i])) {
+            return QString();
         }
-        
-        VariantClear(&var);
-        releaseInterface(pObject);
     }
     
-    return result;
-#else
-    Q_UNUSED(objectDN);
-    Q_UNUSED(attribute);
-    return QString();
-#endif
+    QStringView ou = DnTokenizer::attributeValue(rdns[top], u"OU");
+    return ou.isNull() ? QString() : DnTokenizer::unescape(ou);
 }
 
-#ifdef _WIN32
-HRESULT ADManager::getObject(const QString& distinguishedName, IDispatch** ppObject) {
-    return ADsOpenObject(
-        reinterpret_cast<LPCWSTR>(QString("LDAP://" + distinguishedName).utf16()),
-        NULL,
-        NULL,
-        ADS_SECURE_AUTHENTICATION,
-        IID_IDispatch,
-        (void**)ppObject
-    );
+QString ADManager::replicaSource() const {
+    QString source = QString("%1|%2").arg(m_backend->getName(), m_namingContext.toLower());
+    const QString directoryId = m_backend->getDirectoryId();
+    if (!directoryId.isEmpty()) {
+        source += "|" + directoryId;
+    }
+    return source;
 }
 
-HRESULT ADManager::getObjectAttribute(IDispatch* pObject, const QString& attributeName, VARIANT* pvAttribute) {
-    if (!pObject || !pvAttribute) {
-        return E_INVALIDARG;
+bool ADManager::addOrConfirm(const DirectoryEntry& entry, const QString& operation) {
+    if (m_backend->addEntry(entry)) {
+        return true;
     }
     
-    HRESULT hr = E_FAIL;
-    DISPID dispid;
-    OLECHAR* szMember = (OLECHAR*)reinterpret_cast<const OLECHAR*>(attributeName.utf16());
+    // Created by someone else since the existence check, e.g. another worker
+    // of a parallel batch: that is what the caller wanted. AlreadyExists for
+    // an entry that is not there is a clash elsewhere (sAMAccountName)
+    if (m_backend->lastError() == DirectoryError::AlreadyExists) {
+        const QString message = m_backend->lastErrorMessage();
+        if (m_backend->entryExists(entry.getDistinguishedName())) {
+            return true;
+        }
+        emit error(QString("AD Error during %1: %2").arg(operation, message));
+        return false;
+    }
     
-    hr = pObject->GetIDsOfNames(IID_NULL, &szMember, 1, LOCALE_USER_DEFAULT, &dispid);
-    if (SUCCEEDED(hr)) {
-        DISPPARAMS dp = {NULL, NULL, 0, 0};
-        hr = pObject->Invoke(dispid, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_PROPERTYGET, &dp, pvAttribute, NULL, NULL);
+    reportBackendError(operation);
+    return false;
+}
+
+void ADManager::reportBackendError(const QString& operation) {
+    QString message = m_backend->lastErrorMessage();
+    if (message.isEmpty()) {
+        message = "Unknown error";
     }
     
-    return hr;
+    emit error(QString("AD Error during %1: %2").arg(operation, message));
 }
 
-HRESULT ADManager::setObjectAttribute(IDispatch* pObject, const QString& attributeName, VARIANT* pvAttribute) {
-    if (!pObject || !pvAttribute) {
-        return E_INVALIDARG;
+QString ADManager::namingContextFor(const QString& domain) {
+    // Already a DN, or empty for the backend's default
+    if (domain.isEmpty() || domain.contains('=')) {
+        return domain;
     }
     
-    HRESULT hr = E_FAIL;
-    DISPID dispid;
-    OLECHAR* szMember = (OLECHAR*)reinterpret_cast<const OLECHAR*>(attributeName.utf16());
+    // example.com -> DC=example,DC=com
+    QStringList components;
+    for (const QString& label : domain.split('.', Qt::SkipEmptyParts)) {
+        components << "DC=" + label;
+    }
+    return components.join(',');
+}
+
+QString ADManager::buildUserDN(const QString& login, const QString& serverName) {
+    return QString("CN=%1,OU=%2,%3")
+           .arg(login)
+           .arg(serverName)
+           .arg(m_namingContext);
+}
+
+QString ADManager::buildServerGroupDN(const QString& serverName) {
+    return QString("CN=%1-Group,OU=%2,%3")
+           .arg(serverName)
+           .arg(serverName)
+           .arg(m_namingContext);
+}
+
+QString ADManager::buildServerOUDN(const QString& serverName) {
+    return QString("OU=%1,%2")
+           .arg(serverName)
+           .arg(m_namingContext);
+}
+
+QStringList ADManager::defaultUserAttributes() {
+    return {"distinguishedName", "cn", "sAMAccountName", "givenName", "sn", "displayName",
+            "whenCreated", "lastLogonTimestamp", "userAccountControl"};
+}
+
+UserInfo ADManager::userInfoFromEntry(const DirectoryEntry& entry) {
+    UserInfo userInfo;
     
-    hr = pObject->GetIDsOfNames(IID_NULL, &szMember, 1, LOCALE_USER_DEFAULT, &dispid);
-    if (SUCCEEDED(hr)) {
-        DISPPARAMS dp = {pvAttribute, NULL, 1, 0};
-        DISPID dispidPut = DISPID_PROPERTYPUT;
-        dp.rgdispidNamedArgs = &dispidPut;
-        dp.cNamedArgs = 1;
-        
-        hr = pObject->Invoke(dispid, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_PROPERTYPUT, &dp, NULL, NULL, NULL);
-        
-        // If property was set successfully, save changes
-        if (SUCCEEDED(hr)) {
-            IADs* pIADs = nullptr;
-            hr = pObject->QueryInterface(IID_IADs, (void**)&pIADs);
-            if (SUCCEEDED(hr) && pIADs) {
-                hr = pIADs->SetInfo();
-                releaseInterface(pIADs);
-            }
+    QString dn = entry.getValue("distinguishedName");
+    if (dn.isEmpty()) {
+        dn = entry.getDistinguishedName();
+    }
+    userInfo.setDistinguishedName(dn);
+    
+    // Server OU is the first OU component of the DN
+    DnTokenizer tokens(dn);
+    QStringView rdn;
+    while (tokens.next(rdn)) {
+        QStringView ou = DnTokenizer::attributeValue(rdn, u"OU");
+        if (!ou.isNull()) {
+            userInfo.setServerName(DnTokenizer::unescape(ou));
+            break;
         }
     }
     
-    return hr;
-}
-
-QString ADManager::variantToString(VARIANT& var) {
-    QString result;
+    QString login = entry.getValue("sAMAccountName");
+    userInfo.setLogin(login.isEmpty() ? entry.getValue("cn") : login);
+    userInfo.setFirstName(entry.getValue("givenName"));
+    userInfo.setLastName(entry.getValue("sn"));
+    
+    QString fullName = entry.getValue("displayName");
+    if (fullName.isEmpty()) {
+        fullName = QString("%1 %2").arg(userInfo.getFirstName(), userInfo.getLastName()).trimmed();
+    }
+    if (fullName.isEmpty()) {
+        fullName = entry.getValue("cn");
+    }
+    userInfo.setFullName(fullName);
+    
+    // whenCreated is a GeneralizedTime string, e.g. 20250612093000.0Z
+    QString whenCreated = entry.getValue("whenCreated");
+    if (whenCreated.length() >= 14) {
+        QDateTime created = QDateTime::fromString(whenCreated.left(14), "yyyyMMddHHmmss");
+        created.setTimeZone(QTimeZone::UTC);
+        userInfo.setCreatedDate(created.toLocalTime());
+    }
     
-    if (var.vt == VT_BSTR) {
-        result = QString::fromWCharArray(var.bstrVal);
-    } else if (var.vt == VT_ARRAY | VT_VARIANT) {
-        // Handle array types if needed
+    // lastLogonTimestamp is a FILETIME: 100ns intervals since 1601-01-01 UTC
+    bool ok = false;
+    qint64 fileTime = entry.getValue("lastLogonTimestamp").toLongLong(&ok);
+    if (ok && fileTime > 0) {
+        const qint64 epochOffsetMs = 11644473600000LL;
+        userInfo.setLastLogin(QDateTime::fromMSecsSinceEpoch(fileTime / 10000 - epochOffsetMs));
     }
     
-    return result;
+    // ADS_UF_ACCOUNTDISABLE
+    int accountControl = entry.getValue("userAccountControl").toInt(&ok);
+    userInfo.setActive(!ok || !(accountControl & 0x2));
+    
+    return userInfo;
+}
+
+bool ADManager::setADAttribute(const QString& objectDN, const QString& attribute, const QString& value) {
+    ADObjectChangeSet changes(objectDN);
+    changes.put(attribute, value);
+    return commitChanges(changes);
 }
 
-void ADManager::releaseInterface(IUnknown* pInterface) {
-    if (pInterface) {
-        pInterface->Release();
-        pInterface = nullptr;
+QString ADManager::getADAttribute(const QString& objectDN, const QString& attribute) {
+    // Read from the directory rather than a cached binding, so the value is current
+    DirectoryEntry entry;
+    if (!m_backend->readEntry(objectDN, {attribute}, entry)) {
+        return QString();
     }
+    return entry.getValue(attribute);
 }
-#endif
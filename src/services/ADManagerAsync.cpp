@@ -0,0 +1,230 @@
+#include "services/ADManagerAsync.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+ADManagerAsync::ADManagerAsync(ADManager* source, int maxThreads, QObject* parent)
+    : QObject(parent), m_source(source), m_loadGeneration(0), m_workers(source, [this](ADManager* manager) {
+          connect(manager, &ADManager::error, this, &ADManagerAsync::error);
+      }) {
+    m_pool.setMaxThreadCount(qMax(1, maxThreads));
+
+    // Workers follow the source when it connects, reconnects or changes backend
+    connect(source, &ADManager::connectionStatusChanged, this, [this]() {
+        m_workers.refresh();
+    });
+
+    // Keep worker threads (and their bindings) alive instead of expiring them after 30s
+    m_pool.setExpiryTimeout(-1);
+}
+
+ADManagerAsync::~ADManagerAsync() {
+    // Drop window loads still in flight, then drain the pool
+    m_loadGeneration.fetchAndAddOrdered(1);
+    m_pool.waitForDone();
+}
+
+void ADManagerAsync::waitForDone() {
+    m_pool.waitForDone();
+}
+
+QFuture<bool> ADManagerAsync::connectToAD(const QString& domain, const std::function<void(ADManager*)>& onBound) {
+    QFuture<QString> future = QtConcurrent::run(&m_pool, [this, domain, onBound]() {
+        ADManager* manager = worker();
+        if (!manager->connectToAD(domain)) {
+            return QString();
+        }
+        if (onBound) {
+            onBound(manager);
+        }
+        return manager->getNamingContext();
+    });
+
+    return future.then(this, [this, domain](const QString& namingContext) {
+        const bool connected = !namingContext.isEmpty();
+        if (connected) {
+            m_source->adoptConnection(domain, namingContext);
+        }
+        emit operationFinished("Connect to AD", connected);
+        return connected;
+    });
+}
+
+QFuture<QStringList> ADManagerAsync::getServerList() {
+    QFuture<QStringList> future = QtConcurrent::run(&m_pool, [this]() {
+        return worker()->getServerList();
+    });
+
+    return future.then(this, [this](const QStringList& servers) {
+        emit serversLoaded(servers);
+        return servers;
+    });
+}
+
+QFuture<ServerInfo> ADManagerAsync::getServerInfo(const QString& serverName) {
+    QFuture<ServerInfo> future = QtConcurrent::run(&m_pool, [this, serverName]() {
+        return worker()->getServerInfo(serverName);
+    });
+
+    return future.then(this, [this](const ServerInfo& serverInfo) {
+        emit serverInfoLoaded(serverInfo);
+        return serverInfo;
+    });
+}
+
+QFuture<UserInfo> ADManagerAsync::getUserInfo(const QString& userDN) {
+    QFuture<UserInfo> future = QtConcurrent::run(&m_pool, [this, userDN]() {
+        return worker()->getUserInfo(userDN);
+    });
+
+    return future.then(this, [this](const UserInfo& userInfo) {
+        emit userInfoLoaded(userInfo);
+        return userInfo;
+    });
+}
+
+QFuture<bool> ADManagerAsync::deactivateUser(const QString& userDN) {
+    QFuture<bool> future = QtConcurrent::run(&m_pool, [this, userDN]() {
+        return worker()->deactivateUser(userDN);
+    });
+
+    return future.then(this, [this](bool success) {
+        emit operationFinished("Deactivate user", success);
+        return success;
+    });
+}
+
+QFuture<QList<BulkDeactivateResult>> ADManagerAsync::deactivateUsers(const QStringList& userDNs) {
+    QFuture<QList<BulkDeactivateResult>> future = QtConcurrent::run(&m_pool, [this, userDNs]() {
+        return worker()->deactivateUsers(userDNs);
+    });
+
+    return future.then(this, [this](const QList<BulkDeactivateResult>& results) {
+        const bool success = std::all_of(results.cbegin(), results.cend(), [](const BulkDeactivateResult& result) {
+            return result.isDeactivated();
+        });
+        emit usersDeactivated(results);
+        emit operationFinished("Deactivate users", success);
+        return results;
+    });
+}
+
+QFuture<bool> ADManagerAsync::changePassword(const QString& userDN, const QString& newPassword) {
+    QFuture<bool> future = QtConcurrent::run(&m_pool, [this, userDN, newPassword]() {
+        return worker()->changePassword(userDN, newPassword);
+    });
+
+    return future.then(this, [this](bool success) {
+        emit operationFinished("Change password", success);
+        return success;
+    });
+}
+
+QFuture<bool> ADManagerAsync::loadUserWindow(const QString& serverName, const QList<SortKey>& order, int first,
+                                             int count, int total, const QByteArray& context) {
+    const int generation = m_loadGeneration.fetchAndAddOrdered(1) + 1;
+
+    VlvWindow window;
+    window.offset = first + 1;
+    window.afterCount = qMax(0, count - 1);
+    window.contentCount = total;
+    window.context = context;
+
+    QFuture<bool> future = QtConcurrent::run(&m_pool, [this, serverName, order, window, generation]() {
+        QList<UserInfo> users;
+        VlvResult result;
+        if (m_loadGeneration.loadAcquire() != generation ||
+            !worker()->getUsersWindow(serverName, order, window, users, result)) {
+            return false;
+        }
+
+        // Only the latest window is of interest to the view
+        if (m_loadGeneration.loadAcquire() == generation) {
+            emit userWindowLoaded(serverName, qMax(0, result.targetPosition - 1), users, result.contentCount,
+                                  result.context);
+        }
+        return true;
+    });
+    return future;
+}
+
+QFuture<int> ADManagerAsync::exportUsers(const QString& serverName, const QString& fileName) {
+    QFuture<int> future = QtConcurrent::run(&m_pool, [this, serverName, fileName]() {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            emit error(QString("Could not open %1 for writing: %2").arg(fileName, file.errorString()));
+            return -1;
+        }
+
+        QTextStream out(&file);
+        out << "Full Name,Login,Status,Created Date,Last Login\n";
+
+        // Write each page as it arrives instead of holding the whole server in memory
+        int exported = 0;
+        const bool read = worker()->streamUsersForServer(serverName, [&out, &exported](const QList<UserInfo>& page) {
+            for (const UserInfo& user : page) {
+                out << QString("%1,%2,%3,%4,%5\n")
+                       .arg(user.getFullName())
+                       .arg(user.getLogin())
+                       .arg(user.isActive() ? "Active" : "Disabled")
+                       .arg(user.getCreatedDate().toString("yyyy-MM-dd"))
+                       .arg(user.getLastLogin().toString("yyyy-MM-dd"));
+            }
+            exported += page.size();
+            return out.status() == QTextStream::Ok;
+        });
+        out.flush();
+        const bool written = out.status() == QTextStream::Ok && file.error() == QFileDevice::NoError;
+
+        // A server that is gone, a search that broke off or a full disk
+        // would leave a truncated file that looks complete; the worker has
+        // already reported directory errors
+        if (read && !written) {
+            emit error(QString("Could not write %1: %2").arg(fileName, file.errorString()));
+        }
+        if (!read || !written) {
+            file.remove();
+            return -1;
+        }
+
+        file.close();
+        return exported;
+    });
+
+    return future.then(this, [this, fileName](int count) {
+        emit exportFinished(fileName, qMax(count, 0), count >= 0);
+        return count;
+    });
+}
+
+QFuture<QStringList> ADManagerAsync::getUsersForServer(const QString& serverName) {
+    return QtConcurrent::run(&m_pool, [this, serverName]() {
+        return worker()->getUsersForServer(serverName);
+    });
+}
+
+QFuture<QList<NormalizedUser>> ADManagerAsync::allocateLogins(const QList<NormalizedUser>& users) {
+    return QtConcurrent::run(&m_pool, [this, users]() {
+        QList<NormalizedUser> allocated = users;
+        worker()->allocateLogins(allocated);
+        return allocated;
+    });
+}
+
+QFuture<ReplicaSyncResult> ADManagerAsync::syncReplica() {
+    QFuture<ReplicaSyncResult> future = QtConcurrent::run(&m_pool, [this]() {
+        return worker()->syncReplica();
+    });
+
+    return future.then(this, [this](const ReplicaSyncResult& result) {
+        emit replicaSynced(result);
+        return result;
+    });
+}
+
+QFuture<bool> ADManagerAsync::saveReplica() {
+    return QtConcurrent::run(&m_pool, [this]() {
+        return worker()->saveReplica();
+    });
+}
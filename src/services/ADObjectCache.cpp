@@ -0,0 +1,122 @@
+#include "services/ADObjectCache.h"
+#include <QMutexLocker>
+
+ADObjectCache::ADObjectCache(qint64 maxBytes, int ttlMs)
+    : m_maxBytes(maxBytes), m_ttlMs(ttlMs) {
+    m_clock.start();
+}
+
+void ADObjectCache::setMaxBytes(qint64 maxBytes) {
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = maxBytes;
+    shrinkLocked();
+}
+
+ADObjectCache::Lookup ADObjectCache::lookup(const QString& key, QVariant& value, QString& version) {
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_items.find(key);
+    if (it == m_items.end()) {
+        m_stats.misses++;
+        return Lookup::Miss;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->lruPosition);
+    value = it->value;
+    version = it->version;
+
+    if (m_clock.elapsed() - it->validatedMs < m_ttlMs) {
+        m_stats.hits++;
+        return Lookup::Fresh;
+    }
+
+    // Counted as a miss or a revalidation once the caller knows which
+    return Lookup::Stale;
+}
+
+void ADObjectCache::insert(const QString& key, const QVariant& value, const QString& version, qint64 cost) {
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_items.find(key);
+    if (it != m_items.end()) {
+        // Replacing a cached copy means the stale entry had changed
+        removeLocked(it);
+        m_stats.misses++;
+    }
+
+    // Never let one object flush the whole cache
+    if (cost > m_maxBytes / 2) {
+        return;
+    }
+
+    Item item;
+    item.value = value;
+    item.version = version;
+    item.cost = cost;
+    item.validatedMs = m_clock.elapsed();
+    m_lru.push_front(key);
+    item.lruPosition = m_lru.begin();
+
+    m_items.insert(key, item);
+    m_stats.bytes += cost;
+    shrinkLocked();
+}
+
+void ADObjectCache::revalidated(const QString& key) {
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_items.find(key);
+    if (it != m_items.end()) {
+        it->validatedMs = m_clock.elapsed();
+        m_stats.revalidations++;
+    }
+}
+
+void ADObjectCache::invalidate(const QString& key) {
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_items.find(key);
+    if (it != m_items.end()) {
+        removeLocked(it);
+        m_stats.invalidations++;
+    }
+}
+
+void ADObjectCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_items.clear();
+    m_lru.clear();
+    m_stats.bytes = 0;
+}
+
+ObjectCacheStats ADObjectCache::stats() const {
+    QMutexLocker locker(&m_mutex);
+    ObjectCacheStats stats = m_stats;
+    stats.entries = m_items.size();
+    return stats;
+}
+
+void ADObjectCache::resetStats() {
+    QMutexLocker locker(&m_mutex);
+    const qint64 bytes = m_stats.bytes;
+    m_stats = ObjectCacheStats();
+    m_stats.bytes = bytes;
+}
+
+void ADObjectCache::removeLocked(QHash<QString, Item>::iterator it) {
+    m_stats.bytes -= it->cost;
+    m_lru.erase(it->lruPosition);
+    m_items.erase(it);
+}
+
+void ADObjectCache::shrinkLocked() {
+    while (m_stats.bytes > m_maxBytes && !m_lru.empty()) {
+        auto it = m_items.find(m_lru.back());
+        if (it == m_items.end()) {
+            m_lru.pop_back();
+            continue;
+        }
+        removeLocked(it);
+        m_stats.evictions++;
+    }
+}
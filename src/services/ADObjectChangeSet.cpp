@@ -0,0 +1,57 @@
+#include "services/ADObjectChangeSet.h"
+
+ADObjectChangeSet::ADObjectChangeSet() {
+}
+
+ADObjectChangeSet::ADObjectChangeSet(const QString& distinguishedName)
+    : m_distinguishedName(distinguishedName) {
+}
+
+ADObjectChangeSet& ADObjectChangeSet::put(const QString& attribute, const QString& value) {
+    // An empty value cannot be written to AD; clearing the attribute is the equivalent
+    if (value.isEmpty()) {
+        return clear(attribute);
+    }
+    addChange(attribute, Operation::Replace, QStringList{value});
+    return *this;
+}
+
+ADObjectChangeSet& ADObjectChangeSet::putValues(const QString& attribute, const QStringList& values) {
+    if (values.isEmpty()) {
+        return clear(attribute);
+    }
+    addChange(attribute, Operation::Replace, values);
+    return *this;
+}
+
+ADObjectChangeSet& ADObjectChangeSet::append(const QString& attribute, const QStringList& values) {
+    if (!values.isEmpty()) {
+        addChange(attribute, Operation::Append, values);
+    }
+    return *this;
+}
+
+ADObjectChangeSet& ADObjectChangeSet::remove(const QString& attribute, const QStringList& values) {
+    if (!values.isEmpty()) {
+        addChange(attribute, Operation::Remove, values);
+    }
+    return *this;
+}
+
+ADObjectChangeSet& ADObjectChangeSet::clear(const QString& attribute) {
+    addChange(attribute, Operation::Clear, QStringList());
+    return *this;
+}
+
+void ADObjectChangeSet::addChange(const QString& attribute, Operation operation, const QStringList& values) {
+    // A later replace/clear of the same attribute supersedes earlier staged changes
+    if (operation == Operation::Replace || operation == Operation::Clear) {
+        for (int i = m_changes.size() - 1; i >= 0; --i) {
+            if (m_changes[i].attribute.compare(attribute, Qt::CaseInsensitive) == 0) {
+                m_changes.removeAt(i);
+            }
+        }
+    }
+    
+    m_changes.append(Change{attribute, operation, values});
+}
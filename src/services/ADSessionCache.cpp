@@ -0,0 +1,159 @@
+#include "services/ADSessionCache.h"
+
+namespace {
+// Idle sessions are swept at most this often, so acquire() stays O(1) in the common case
+const qint64 kSweepIntervalMs = 1000;
+}
+
+ADSessionCache::ADSessionCache(int maxSessions, int idleTimeoutMs)
+    : m_lastSweepMs(0), m_maxSessions(maxSessions), m_idleTimeoutMs(idleTimeoutMs) {
+    m_clock.start();
+}
+
+ADSessionCache::~ADSessionCache() {
+    clear();
+}
+
+#ifdef _WIN32
+HRESULT ADSessionCache::acquire(const QString& distinguishedName, REFIID riid, void** ppObject, bool fastBind) {
+    if (!ppObject) {
+        return E_INVALIDARG;
+    }
+    *ppObject = nullptr;
+
+    const qint64 now = m_clock.elapsed();
+    if (now - m_lastSweepMs >= kSweepIntervalMs) {
+        evictIdle();
+    }
+
+    SessionKey key(distinguishedName.toLower(), fastBind);
+    auto it = m_sessions.find(key);
+    if (it != m_sessions.end()) {
+        HRESULT hr = it->object->QueryInterface(riid, ppObject);
+        if (SUCCEEDED(hr)) {
+            it->lastUsedMs = now;
+            m_stats.hits++;
+            return hr;
+        }
+        // Cached binding does not expose the requested interface; rebind below
+        release(*it);
+        m_sessions.erase(it);
+    }
+
+    m_stats.misses++;
+
+    DWORD flags = ADS_SECURE_AUTHENTICATION;
+    if (fastBind) {
+        flags |= ADS_FAST_BIND;
+    }
+
+    IUnknown* pObject = nullptr;
+    HRESULT hr = ADsOpenObject(
+        reinterpret_cast<LPCWSTR>(QString("LDAP://" + distinguishedName).utf16()),
+        NULL,
+        NULL,
+        flags,
+        IID_IUnknown,
+        (void**)&pObject
+    );
+    if (FAILED(hr) || !pObject) {
+        return FAILED(hr) ? hr : E_FAIL;
+    }
+
+    hr = pObject->QueryInterface(riid, ppObject);
+    if (FAILED(hr)) {
+        pObject->Release();
+        return hr;
+    }
+
+    if (m_sessions.size() >= m_maxSessions) {
+        evictLeastRecentlyUsed();
+    }
+
+    Session session;
+    session.object = pObject; // the cache owns this reference
+    session.lastUsedMs = now;
+    m_sessions.insert(key, session);
+
+    return hr;
+}
+
+HRESULT ADSessionCache::pinNamingContext(const QString& namingContextDN) {
+    IUnknown* pObject = nullptr;
+    HRESULT hr = acquire(namingContextDN, IID_IUnknown, (void**)&pObject, true);
+    if (SUCCEEDED(hr)) {
+        m_sessions[SessionKey(namingContextDN.toLower(), true)].pinned = true;
+        pObject->Release();
+    }
+    return hr;
+}
+#endif
+
+void ADSessionCache::invalidate(const QString& distinguishedName) {
+    const QString dn = distinguishedName.toLower();
+    for (bool fastBind : {false, true}) {
+        auto it = m_sessions.find(SessionKey(dn, fastBind));
+        if (it != m_sessions.end() && !it->pinned) {
+            release(*it);
+            m_sessions.erase(it);
+        }
+    }
+}
+
+void ADSessionCache::evictIdle() {
+    const qint64 now = m_clock.elapsed();
+    m_lastSweepMs = now;
+
+    for (auto it = m_sessions.begin(); it != m_sessions.end();) {
+        if (!it->pinned && now - it->lastUsedMs > m_idleTimeoutMs) {
+            release(*it);
+            it = m_sessions.erase(it);
+            m_stats.evictions++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ADSessionCache::clear() {
+    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        release(*it);
+    }
+    m_sessions.clear();
+}
+
+SessionCacheStats ADSessionCache::stats() const {
+    SessionCacheStats stats = m_stats;
+    stats.openSessions = m_sessions.size();
+    return stats;
+}
+
+void ADSessionCache::resetStats() {
+    m_stats = SessionCacheStats();
+}
+
+void ADSessionCache::evictLeastRecentlyUsed() {
+    auto oldest = m_sessions.end();
+    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        if (!it->pinned && (oldest == m_sessions.end() || it->lastUsedMs < oldest->lastUsedMs)) {
+            oldest = it;
+        }
+    }
+
+    if (oldest != m_sessions.end()) {
+        release(*oldest);
+        m_sessions.erase(oldest);
+        m_stats.evictions++;
+    }
+}
+
+void ADSessionCache::release(Session& session) {
+#ifdef _WIN32
+    if (session.object) {
+        session.object->Release();
+        session.object = nullptr;
+    }
+#else
+    Q_UNUSED(session);
+#endif
+}
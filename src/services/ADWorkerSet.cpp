@@ -0,0 +1,63 @@
+#include "services/ADWorkerSet.h"
+#include <QMutexLocker>
+
+ADWorkerSet::ADWorkerSet(ADManager* source, std::function<void(ADManager*)> onCreated)
+    : m_source(source), m_onCreated(std::move(onCreated)), m_sourceBackend(nullptr),
+      m_backendGeneration(0), m_profileGeneration(0) {
+    refresh();
+}
+
+void ADWorkerSet::refresh() {
+    const ADWorkerProfile profile = m_source->workerProfile();
+    const IDirectoryBackend* backend = m_source->getBackend();
+
+    // Cloned every time so new workers pick up changed backend settings;
+    // existing workers are only rebuilt when the backend itself changed
+    std::unique_ptr<IDirectoryBackend> prototype = backend->clone();
+
+    QMutexLocker locker(&m_mutex);
+    m_prototype.swap(prototype);
+    if (backend != m_sourceBackend) {
+        m_sourceBackend = backend;
+        ++m_backendGeneration;
+    }
+    m_profile = profile;
+    ++m_profileGeneration;
+}
+
+ADManager* ADWorkerSet::local() {
+    Worker* worker = m_workers.hasLocalData() ? m_workers.localData() : nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    if (worker && worker->profileGeneration == m_profileGeneration &&
+        (!m_profile.connected || worker->manager->isConnected())) {
+        return worker->manager.get();
+    }
+
+    std::unique_ptr<IDirectoryBackend> backend;
+    if (!worker || worker->backendGeneration != m_backendGeneration) {
+        backend = m_prototype->clone();
+    }
+    const ADWorkerProfile profile = m_profile;
+    const quint64 backendGeneration = m_backendGeneration;
+    const quint64 profileGeneration = m_profileGeneration;
+    locker.unlock();
+
+    // Binding may take a while and happens outside the lock. A manager is
+    // created and destroyed on its own thread, with its backend
+    if (!worker) {
+        worker = new Worker;
+        m_workers.setLocalData(worker);
+    }
+    if (backend) {
+        worker->manager = std::make_unique<ADManager>(nullptr, std::move(backend));
+        if (m_onCreated) {
+            m_onCreated(worker->manager.get());
+        }
+    }
+    worker->manager->applyWorkerProfile(profile);
+    worker->backendGeneration = backendGeneration;
+    worker->profileGeneration = profileGeneration;
+
+    return worker->manager.get();
+}
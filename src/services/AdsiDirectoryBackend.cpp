@@ -0,0 +1,629 @@
+#include "services/AdsiDirectoryBackend.h"
+#ifdef _WIN32
+#include <QVector>
+
+namespace {
+DirectoryError classify(HRESULT hr) {
+    switch (static_cast<unsigned long>(hr)) {
+    case 0x80072030: // ERROR_DS_NO_SUCH_OBJECT
+        return DirectoryError::NoSuchObject;
+    case 0x8007200A: // ERROR_DS_NO_ATTRIBUTE_OR_VALUE
+        return DirectoryError::NoSuchAttribute;
+    case 0x80071392: // ERROR_OBJECT_ALREADY_EXISTS
+    case 0x80072071: // ERROR_DS_ATTRIBUTE_OR_VALUE_EXISTS
+        return DirectoryError::AlreadyExists;
+    case 0x80070005: // E_ACCESSDENIED
+    case 0x80072098: // ERROR_DS_INSUFF_ACCESS_RIGHTS
+        return DirectoryError::InsufficientRights;
+    case 0x8007200E: // ERROR_DS_BUSY
+        return DirectoryError::Busy;
+    case 0x8007200F: // ERROR_DS_UNAVAILABLE
+    case 0x8007203A: // ERROR_DS_SERVER_DOWN
+        return DirectoryError::Unavailable;
+    case 0x80072022: // ERROR_DS_TIMELIMIT_EXCEEDED
+    case 0x800705B4: // ERROR_TIMEOUT
+        return DirectoryError::Timeout;
+    case 0x80070057: // E_INVALIDARG
+    case 0x80005000: // E_ADS_BAD_PATHNAME
+        return DirectoryError::InvalidArgument;
+    default:
+        return DirectoryError::Other;
+    }
+}
+}
+
+AdsiDirectoryBackend::AdsiDirectoryBackend() {
+    // Initialize COM for the creating thread
+    m_comInitialized = SUCCEEDED(CoInitialize(NULL));
+}
+
+AdsiDirectoryBackend::~AdsiDirectoryBackend() {
+    // Cached bindings must be released while COM is still initialized
+    m_sessionCache.clear();
+
+    if (m_comInitialized) {
+        CoUninitialize();
+    }
+}
+
+std::unique_ptr<IDirectoryBackend> AdsiDirectoryBackend::clone() const {
+    // Bindings are per thread: the clone opens its own on connect()
+    return std::make_unique<AdsiDirectoryBackend>();
+}
+
+bool AdsiDirectoryBackend::connect(const QString& namingContext) {
+    clearError();
+    m_sessionCache.clear();
+    m_namingContext = namingContext;
+
+    // No naming context given: ask RootDSE for the domain's default one
+    if (m_namingContext.isEmpty()) {
+        IADs* pRootDSE = nullptr;
+        HRESULT hr = ADsOpenObject(L"LDAP://RootDSE", NULL, NULL, ADS_SECURE_AUTHENTICATION,
+                                   IID_IADs, (void**)&pRootDSE);
+        if (FAILED(hr)) {
+            return fail("Read RootDSE", hr);
+        }
+
+        VARIANT var;
+        VariantInit(&var);
+        BSTR name = SysAllocString(L"defaultNamingContext");
+        hr = pRootDSE->Get(name, &var);
+        SysFreeString(name);
+        if (SUCCEEDED(hr)) {
+            m_namingContext = variantToString(var);
+        }
+        VariantClear(&var);
+        releaseInterface(pRootDSE);
+
+        if (FAILED(hr)) {
+            return fail("Read default naming context", hr);
+        }
+    }
+
+    // Bind to the domain and keep that binding open for the session,
+    // so later binds reuse the authenticated LDAP connection
+    HRESULT hr = m_sessionCache.pinNamingContext(m_namingContext);
+    if (FAILED(hr)) {
+        return fail("Connect to AD", hr);
+    }
+
+    return true;
+}
+
+bool AdsiDirectoryBackend::search(const SearchRequest& request, const SearchPageCallback& onPage) {
+    clearError();
+
+    HRESULT hr = searchDirectory(request, onPage);
+    if (FAILED(hr)) {
+        return fail("Search", hr);
+    }
+    return true;
+}
+
+bool AdsiDirectoryBackend::searchWindow(const SearchRequest& request, const VlvWindow& window,
+                                       QList<DirectoryEntry>& entries, VlvResult& result) {
+    clearError();
+
+    if (request.sortKeys.isEmpty()) {
+        setError(DirectoryError::InvalidArgument, "A window search needs sort keys");
+        return false;
+    }
+
+    result = VlvResult();
+    HRESULT hr = searchDirectory(request, [&entries](const QList<DirectoryEntry>& page) {
+        entries.append(page);
+        return true;
+    }, &window, &result);
+    if (FAILED(hr)) {
+        return fail("Window search", hr);
+    }
+    return true;
+}
+
+bool AdsiDirectoryBackend::readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) {
+    clearError();
+
+    // A base-scope search returns every requested attribute in one round trip
+    SearchRequest request;
+    request.baseDN = dn;
+    request.scope = SearchScope::Base;
+    request.attributes = attributes;
+    request.pageSize = 1;
+
+    bool found = false;
+    HRESULT hr = searchDirectory(request, [&entry, &found](const QList<DirectoryEntry>& page) {
+        if (!page.isEmpty()) {
+            entry = page.first();
+            found = true;
+        }
+        return false;
+    });
+
+    if (FAILED(hr)) {
+        return fail("Read entry", hr);
+    }
+    if (!found) {
+        setError(DirectoryError::NoSuchObject, QString("Object %1 does not exist").arg(dn));
+    }
+    return found;
+}
+
+bool AdsiDirectoryBackend::entryExists(const QString& dn) {
+    DirectoryEntry entry;
+    if (readEntry(dn, {"distinguishedName"}, entry)) {
+        return true;
+    }
+
+    // A missing object is an answer, not an error
+    if (lastError() == DirectoryError::NoSuchObject) {
+        clearError();
+    }
+    return false;
+}
+
+bool AdsiDirectoryBackend::addEntry(const DirectoryEntry& entry) {
+    clearError();
+
+    const QString dn = entry.getDistinguishedName();
+    const QString parentDN = DirectoryEntry::parentOf(dn);
+    const QStringList objectClasses = entry.getValues("objectClass");
+    if (parentDN.isEmpty() || objectClasses.isEmpty()) {
+        setError(DirectoryError::InvalidArgument, QString("Cannot create %1: missing parent or objectClass").arg(dn));
+        return false;
+    }
+
+    IADsContainer* pContainer = nullptr;
+    HRESULT hr = m_sessionCache.acquire(parentDN, IID_IADsContainer, (void**)&pContainer, true);
+    if (FAILED(hr) || !pContainer) {
+        return fail("Bind parent container", hr);
+    }
+
+    // The most specific class is listed last (top, person, ..., user)
+    BSTR className = SysAllocString(reinterpret_cast<const OLECHAR*>(objectClasses.last().utf16()));
+    BSTR rdn = SysAllocString(reinterpret_cast<const OLECHAR*>(DirectoryEntry::rdnOf(dn).utf16()));
+    IDispatch* pDispatch = nullptr;
+    hr = pContainer->Create(className, rdn, &pDispatch);
+    SysFreeString(className);
+    SysFreeString(rdn);
+    releaseInterface(pContainer);
+
+    if (FAILED(hr) || !pDispatch) {
+        return fail("Create object", hr);
+    }
+
+    IADs* pObject = nullptr;
+    hr = pDispatch->QueryInterface(IID_IADs, (void**)&pObject);
+    releaseInterface(pDispatch);
+    if (FAILED(hr)) {
+        return fail("Create object", hr);
+    }
+
+    // Stage all mandatory and initial attributes, then create with one SetInfo.
+    // objectClass and the naming attribute are already set by Create
+    const QString namingAttribute = DirectoryEntry::rdnOf(dn).section('=', 0, 0).trimmed().toLower();
+    ADObjectChangeSet initial(dn);
+    for (const QString& attribute : entry.getAttributeNames()) {
+        if (attribute == "objectclass" || attribute == "distinguishedname" || attribute == namingAttribute) {
+            continue;
+        }
+        initial.putValues(attribute, entry.getValues(attribute));
+    }
+    for (const ADObjectChangeSet::Change& change : initial.getChanges()) {
+        hr = stageChange(pObject, change);
+        if (FAILED(hr)) {
+            break;
+        }
+    }
+    if (SUCCEEDED(hr)) {
+        hr = pObject->SetInfo();
+    }
+    releaseInterface(pObject);
+
+    if (FAILED(hr)) {
+        return fail("Create object", hr);
+    }
+    return true;
+}
+
+bool AdsiDirectoryBackend::modifyEntry(const ADObjectChangeSet& changes) {
+    clearError();
+
+    IADs* pObject = nullptr;
+    HRESULT hr = getObject(changes.getDistinguishedName(), &pObject);
+    if (FAILED(hr) || !pObject) {
+        return fail("Bind object", hr);
+    }
+
+    for (const ADObjectChangeSet::Change& change : changes.getChanges()) {
+        hr = stageChange(pObject, change);
+        if (FAILED(hr)) {
+            break;
+        }
+    }
+
+    // One SetInfo writes every staged attribute in a single LDAP modify
+    if (SUCCEEDED(hr)) {
+        hr = pObject->SetInfo();
+    }
+    releaseInterface(pObject);
+
+    if (FAILED(hr)) {
+        // Drop the cached binding so its dirty property cache is not reused
+        m_sessionCache.invalidate(changes.getDistinguishedName());
+        return fail("Commit changes", hr);
+    }
+
+    return true;
+}
+
+bool AdsiDirectoryBackend::deleteEntry(const QString& dn) {
+    clearError();
+
+    IADsDeleteOps* pDeleteOps = nullptr;
+    HRESULT hr = m_sessionCache.acquire(dn, IID_IADsDeleteOps, (void**)&pDeleteOps, true);
+    if (FAILED(hr) || !pDeleteOps) {
+        return fail("Bind object", hr);
+    }
+
+    hr = pDeleteOps->DeleteObject(0);
+    releaseInterface(pDeleteOps);
+    m_sessionCache.invalidate(dn);
+
+    if (FAILED(hr)) {
+        return fail("Delete object", hr);
+    }
+    return true;
+}
+
+bool AdsiDirectoryBackend::setPassword(const QString& dn, const QString& password) {
+    clearError();
+
+    // IADsUser is a class-specific interface, so this needs a full bind
+    IADsUser* pUser = nullptr;
+    HRESULT hr = m_sessionCache.acquire(dn, IID_IADsUser, (void**)&pUser, false);
+    if (FAILED(hr) || !pUser) {
+        return fail("Bind user", hr);
+    }
+
+    BSTR bstrPassword = SysAllocString(reinterpret_cast<const OLECHAR*>(password.utf16()));
+    hr = pUser->SetPassword(bstrPassword);
+    SecureZeroMemory(bstrPassword, SysStringByteLen(bstrPassword));
+    SysFreeString(bstrPassword);
+    releaseInterface(pUser);
+
+    if (FAILED(hr)) {
+        return fail("Set password", hr);
+    }
+    return true;
+}
+
+bool AdsiDirectoryBackend::fail(const QString& operation, HRESULT hr) {
+    _com_error err(hr);
+    QString message = QString::fromWCharArray(err.ErrorMessage());
+
+    setError(classify(hr),
+             QString("%1: %2 (0x%3)")
+                 .arg(operation)
+                 .arg(message)
+                 .arg(QString::number(static_cast<unsigned long>(hr), 16)),
+             hr);
+    return false;
+}
+
+HRESULT AdsiDirectoryBackend::getObject(const QString& distinguishedName, IADs** ppObject) {
+    // IADs::Get/Put work on the base interface, so a fast bind is enough
+    return m_sessionCache.acquire(distinguishedName, IID_IADs, (void**)ppObject, true);
+}
+
+HRESULT AdsiDirectoryBackend::setObjectAttribute(IADs* pObject, const QString& attributeName, VARIANT* pvAttribute) {
+    if (!pObject || !pvAttribute) {
+        return E_INVALIDARG;
+    }
+
+    // Only stages the value in the property cache; the caller issues the SetInfo
+    BSTR name = SysAllocString(reinterpret_cast<const OLECHAR*>(attributeName.utf16()));
+    HRESULT hr = pObject->Put(name, *pvAttribute);
+    SysFreeString(name);
+
+    return hr;
+}
+
+HRESULT AdsiDirectoryBackend::stageChange(IADs* pObject, const ADObjectChangeSet::Change& change) {
+    VARIANT var;
+    VariantInit(&var);
+    HRESULT hr = S_OK;
+
+    // Single-valued replace is a plain Put
+    if (change.operation == ADObjectChangeSet::Operation::Replace && change.values.size() == 1) {
+        var.vt = VT_BSTR;
+        var.bstrVal = SysAllocString(reinterpret_cast<const OLECHAR*>(change.values.first().utf16()));
+        hr = setObjectAttribute(pObject, change.attribute, &var);
+        VariantClear(&var);
+        return hr;
+    }
+
+    long controlCode = ADS_PROPERTY_UPDATE;
+    switch (change.operation) {
+    case ADObjectChangeSet::Operation::Replace:
+        controlCode = ADS_PROPERTY_UPDATE;
+        break;
+    case ADObjectChangeSet::Operation::Append:
+        controlCode = ADS_PROPERTY_APPEND;
+        break;
+    case ADObjectChangeSet::Operation::Remove:
+        controlCode = ADS_PROPERTY_DELETE;
+        break;
+    case ADObjectChangeSet::Operation::Clear:
+        controlCode = ADS_PROPERTY_CLEAR;
+        break;
+    }
+
+    if (change.operation != ADObjectChangeSet::Operation::Clear) {
+        QStringList values = change.values;
+        QVector<LPWSTR> valuePtrs;
+        valuePtrs.reserve(values.size());
+        for (QString& value : values) {
+            valuePtrs.append(reinterpret_cast<LPWSTR>(value.data()));
+        }
+        hr = ADsBuildVarArrayStr(valuePtrs.data(), static_cast<DWORD>(valuePtrs.size()), &var);
+        if (FAILED(hr)) {
+            return hr;
+        }
+    }
+
+    BSTR name = SysAllocString(reinterpret_cast<const OLECHAR*>(change.attribute.utf16()));
+    hr = pObject->PutEx(controlCode, name, var);
+    SysFreeString(name);
+    VariantClear(&var);
+
+    return hr;
+}
+
+HRESULT AdsiDirectoryBackend::searchDirectory(const SearchRequest& request, const SearchPageCallback& onPage,
+                                              const VlvWindow* window, VlvResult* windowResult) {
+    IDirectorySearch* pSearch = nullptr;
+    HRESULT hr = m_sessionCache.acquire(request.baseDN, IID_IDirectorySearch, (void**)&pSearch, true);
+    if (FAILED(hr) || !pSearch) {
+        return hr;
+    }
+
+    ADS_SCOPEENUM scope = ADS_SCOPE_SUBTREE;
+    if (request.scope == SearchScope::Base) {
+        scope = ADS_SCOPE_BASE;
+    } else if (request.scope == SearchScope::OneLevel) {
+        scope = ADS_SCOPE_ONELEVEL;
+    }
+
+    const int pageSize = request.pageSize > 0 ? request.pageSize : 1000;
+
+    // CACHE_RESULTS=FALSE keeps ADSI from holding every row client-side,
+    // so memory stays bounded by one page regardless of result size
+    ADS_SEARCHPREF_INFO prefs[7];
+    prefs[0].dwSearchPref = ADS_SEARCHPREF_SEARCH_SCOPE;
+    prefs[0].vValue.dwType = ADSTYPE_INTEGER;
+    prefs[0].vValue.Integer = scope;
+    prefs[1].dwSearchPref = ADS_SEARCHPREF_CACHE_RESULTS;
+    prefs[1].vValue.dwType = ADSTYPE_BOOLEAN;
+    prefs[1].vValue.Boolean = FALSE;
+    prefs[2].dwSearchPref = ADS_SEARCHPREF_SIZE_LIMIT;
+    prefs[2].vValue.dwType = ADSTYPE_INTEGER;
+    prefs[2].vValue.Integer = request.sizeLimit;
+    DWORD prefCount = 3;
+    if (!window) {
+        // Paging and VLV are mutually exclusive; a window is a single request
+        prefs[prefCount].dwSearchPref = ADS_SEARCHPREF_PAGESIZE;
+        prefs[prefCount].vValue.dwType = ADSTYPE_INTEGER;
+        prefs[prefCount].vValue.Integer = pageSize;
+        ++prefCount;
+    }
+    if (request.includeDeleted) {
+        // Tombstones live under CN=Deleted Objects and are only returned
+        // with the Show Deleted control, which this preference sends
+        prefs[prefCount].dwSearchPref = ADS_SEARCHPREF_TOMBSTONE;
+        prefs[prefCount].vValue.dwType = ADSTYPE_BOOLEAN;
+        prefs[prefCount].vValue.Boolean = TRUE;
+        ++prefCount;
+    }
+
+    // Server-side sort control; the key names must outlive the search
+    QStringList sortAttributes;
+    QVector<ADS_SORTKEY> sortKeys;
+    for (const SortKey& key : request.sortKeys) {
+        sortAttributes << key.attribute;
+    }
+    sortKeys.reserve(sortAttributes.size());
+    for (int i = 0; i < sortAttributes.size(); ++i) {
+        ADS_SORTKEY sortKey;
+        sortKey.pszAttrType = reinterpret_cast<LPWSTR>(sortAttributes[i].data());
+        sortKey.pszReserved = nullptr;
+        sortKey.fReverseorder = request.sortKeys[i].reverse ? TRUE : FALSE;
+        sortKeys.append(sortKey);
+    }
+    if (!sortKeys.isEmpty()) {
+        prefs[prefCount].dwSearchPref = ADS_SEARCHPREF_SORT_ON;
+        prefs[prefCount].vValue.dwType = ADSTYPE_PROV_SPECIFIC;
+        prefs[prefCount].vValue.ProviderSpecific.dwLength = static_cast<DWORD>(sizeof(ADS_SORTKEY) * sortKeys.size());
+        prefs[prefCount].vValue.ProviderSpecific.lpValue = reinterpret_cast<LPBYTE>(sortKeys.data());
+        ++prefCount;
+    }
+
+    QByteArray context = window ? window->context : QByteArray();
+    ADS_VLV vlv;
+    if (window) {
+        vlv.dwBeforeCount = static_cast<DWORD>(window->beforeCount);
+        vlv.dwAfterCount = static_cast<DWORD>(window->afterCount);
+        vlv.dwOffset = static_cast<DWORD>(window->offset);
+        vlv.dwContentCount = static_cast<DWORD>(window->contentCount);
+        vlv.pszTarget = nullptr;
+        vlv.dwContextIDLength = static_cast<DWORD>(context.size());
+        vlv.lpContextID = context.isEmpty() ? nullptr : reinterpret_cast<LPBYTE>(context.data());
+
+        prefs[prefCount].dwSearchPref = ADS_SEARCHPREF_VLV;
+        prefs[prefCount].vValue.dwType = ADSTYPE_PROV_SPECIFIC;
+        prefs[prefCount].vValue.ProviderSpecific.dwLength = sizeof(ADS_VLV);
+        prefs[prefCount].vValue.ProviderSpecific.lpValue = reinterpret_cast<LPBYTE>(&vlv);
+        ++prefCount;
+    }
+
+    hr = pSearch->SetSearchPreference(prefs, prefCount);
+    if (FAILED(hr)) {
+        releaseInterface(pSearch);
+        return hr;
+    }
+
+    // Keep the UTF-16 buffers alive for the duration of the search
+    QStringList attributeNames = request.attributes;
+    if (!attributeNames.contains("distinguishedName", Qt::CaseInsensitive)) {
+        attributeNames << "distinguishedName";
+    }
+    QVector<LPWSTR> attributePtrs;
+    attributePtrs.reserve(attributeNames.size());
+    for (QString& name : attributeNames) {
+        attributePtrs.append(reinterpret_cast<LPWSTR>(name.data()));
+    }
+
+    QString filter = request.filter;
+    ADS_SEARCH_HANDLE hSearch = nullptr;
+    hr = pSearch->ExecuteSearch(reinterpret_cast<LPWSTR>(filter.data()),
+                                attributePtrs.data(),
+                                static_cast<DWORD>(attributePtrs.size()),
+                                &hSearch);
+    if (FAILED(hr)) {
+        releaseInterface(pSearch);
+        return hr;
+    }
+
+    // GetNextRow requests the next page from the server when the current
+    // one is exhausted; hand rows to the caller in page-sized batches
+    QList<DirectoryEntry> page;
+    page.reserve(pageSize);
+    bool stopped = false;
+
+    while ((hr = pSearch->GetNextRow(hSearch)) != S_ADS_NOMORE_ROWS && SUCCEEDED(hr)) {
+        DirectoryEntry entry;
+        // Walk the columns the server sent rather than the names asked for:
+        // a multi-valued attribute over MaxValRange comes back as the slice
+        // it holds (member;range=0-1499) even when plain member was asked,
+        // and readers find it under that name (AttributeRange::find)
+        LPWSTR columnName = nullptr;
+        while (pSearch->GetNextColumnName(hSearch, &columnName) == S_OK) {
+            const QString name = QString::fromWCharArray(columnName);
+            ADS_SEARCH_COLUMN column;
+            if (name.compare(QString::fromWCharArray(ADS_VLV_RESPONSE), Qt::CaseInsensitive) != 0 &&
+                SUCCEEDED(pSearch->GetColumn(hSearch, columnName, &column))) {
+                entry.setValues(name, searchColumnToStrings(column));
+                pSearch->FreeColumn(&column);
+            }
+            FreeADsMem(columnName);
+        }
+        entry.setDistinguishedName(entry.getValue("distinguishedName"));
+        page.append(entry);
+
+        // The VLV response is exposed as a pseudo-column once rows arrive
+        if (windowResult && page.size() == 1 && windowResult->contentCount == 0) {
+            ADS_SEARCH_COLUMN column;
+            if (SUCCEEDED(pSearch->GetColumn(hSearch, const_cast<LPWSTR>(ADS_VLV_RESPONSE), &column))) {
+                if (column.dwNumValues > 0 && column.pADsValues[0].dwType == ADSTYPE_PROV_SPECIFIC &&
+                    column.pADsValues[0].ProviderSpecific.dwLength >= sizeof(ADS_VLV)) {
+                    const ADS_VLV* response = reinterpret_cast<const ADS_VLV*>(column.pADsValues[0].ProviderSpecific.lpValue);
+                    windowResult->targetPosition = static_cast<int>(response->dwOffset);
+                    windowResult->contentCount = static_cast<int>(response->dwContentCount);
+                    windowResult->context = QByteArray(reinterpret_cast<const char*>(response->lpContextID),
+                                                       static_cast<int>(response->dwContextIDLength));
+                }
+                pSearch->FreeColumn(&column);
+            }
+        }
+
+        if (page.size() >= pageSize) {
+            stopped = !onPage(page);
+            page.clear();
+            if (stopped) {
+                pSearch->AbandonSearch(hSearch);
+                break;
+            }
+        }
+    }
+
+    if (!stopped && !page.isEmpty() && SUCCEEDED(hr)) {
+        onPage(page);
+    }
+
+    pSearch->CloseSearchHandle(hSearch);
+    releaseInterface(pSearch);
+
+    return (stopped || hr == S_ADS_NOMORE_ROWS) ? S_OK : hr;
+}
+
+QStringList AdsiDirectoryBackend::searchColumnToStrings(const ADS_SEARCH_COLUMN& column) {
+    QStringList values;
+
+    for (DWORD i = 0; i < column.dwNumValues; ++i) {
+        const ADSVALUE& value = column.pADsValues[i];
+
+        switch (value.dwType) {
+        case ADSTYPE_DN_STRING:
+            values << QString::fromWCharArray(value.DNString);
+            break;
+        case ADSTYPE_CASE_EXACT_STRING:
+            values << QString::fromWCharArray(value.CaseExactString);
+            break;
+        case ADSTYPE_CASE_IGNORE_STRING:
+            values << QString::fromWCharArray(value.CaseIgnoreString);
+            break;
+        case ADSTYPE_PRINTABLE_STRING:
+            values << QString::fromWCharArray(value.PrintableString);
+            break;
+        case ADSTYPE_NUMERIC_STRING:
+            values << QString::fromWCharArray(value.NumericString);
+            break;
+        case ADSTYPE_BOOLEAN:
+            values << (value.Boolean ? "TRUE" : "FALSE");
+            break;
+        case ADSTYPE_INTEGER:
+            values << QString::number(value.Integer);
+            break;
+        case ADSTYPE_LARGE_INTEGER:
+            values << QString::number(value.LargeInteger.QuadPart);
+            break;
+        case ADSTYPE_UTC_TIME: {
+            // Normalize to GeneralizedTime so all callers parse one format
+            const SYSTEMTIME& st = value.UTCTime;
+            values << QString("%1%2%3%4%5%6.0Z")
+                      .arg(st.wYear, 4, 10, QChar('0'))
+                      .arg(st.wMonth, 2, 10, QChar('0'))
+                      .arg(st.wDay, 2, 10, QChar('0'))
+                      .arg(st.wHour, 2, 10, QChar('0'))
+                      .arg(st.wMinute, 2, 10, QChar('0'))
+                      .arg(st.wSecond, 2, 10, QChar('0'));
+            break;
+        }
+        case ADSTYPE_OCTET_STRING:
+            values << QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(value.OctetString.lpValue),
+                                                     static_cast<int>(value.OctetString.dwLength)).toHex());
+            break;
+        default:
+            break;
+        }
+    }
+
+    return values;
+}
+
+QString AdsiDirectoryBackend::variantToString(VARIANT& var) {
+    QString result;
+
+    if (var.vt == VT_BSTR) {
+        result = QString::fromWCharArray(var.bstrVal);
+    }
+
+    return result;
+}
+
+void AdsiDirectoryBackend::releaseInterface(IUnknown* pInterface) {
+    if (pInterface) {
+        pInterface->Release();
+    }
+}
+#endif
@@ -0,0 +1,177 @@
+#include "services/BulkPasswordRotator.h"
+#include "services/ADManager.h"
+#include <QJsonDocument>
+#include <QMutexLocker>
+
+BulkPasswordRotator::BulkPasswordRotator(ADManager* source, PasswordGenerator* generator, QObject* parent)
+    : QObject(parent), m_generator(generator), m_running(false), m_total(0),
+      m_completed(0), m_rotated(0), m_cancelled(0), m_workers(source) {
+    m_pool.setMaxThreadCount(DefaultConcurrency);
+    m_pool.setExpiryTimeout(-1);
+
+    m_progressTimer.setInterval(DefaultProgressIntervalMs);
+    connect(&m_progressTimer, &QTimer::timeout, this, &BulkPasswordRotator::flush);
+}
+
+BulkPasswordRotator::~BulkPasswordRotator() {
+    m_cancelled.storeRelease(1);
+    m_pool.waitForDone();
+}
+
+void BulkPasswordRotator::setConcurrency(int concurrency) {
+    m_pool.setMaxThreadCount(qMax(1, concurrency));
+}
+
+void BulkPasswordRotator::setProgressInterval(int intervalMs) {
+    m_progressTimer.setInterval(qMax(10, intervalMs));
+}
+
+bool BulkPasswordRotator::start(const QStringList& userDNs, const PasswordPolicy& policy,
+                                const QString& outputFile, const QString& passphrase) {
+    QMutexLocker locker(&m_mutex);
+    if (m_running) {
+        m_error = tr("A rotation is already running");
+        return false;
+    }
+
+    m_error.clear();
+    if (!m_output.create(outputFile, passphrase)) {
+        m_error = m_output.errorString();
+        return false;
+    }
+
+    m_workers.refresh();
+    m_running = true;
+    m_total = userDNs.size();
+    m_completed.storeRelease(0);
+    m_rotated.storeRelease(0);
+    m_cancelled.storeRelease(0);
+    m_results = QList<BulkRotateResult>(userDNs.size());
+    m_pending.clear();
+    locker.unlock();
+
+    // Every password in one batch, before any account is touched
+    const QStringList passwords = m_generator->generatePasswords(userDNs.size(), policy);
+
+    m_clock.start();
+    m_progressTimer.start();
+
+    // The pool's thread count is the concurrency window; the rest queue up
+    for (int i = 0; i < userDNs.size(); ++i) {
+        m_pool.start([this, i, userDN = userDNs[i], password = passwords[i]]() {
+            const BulkRotateResult result = rotateOne(i, userDN, password);
+
+            QMutexLocker locker(&m_mutex);
+            m_results[i] = result;
+            m_pending.append(result);
+            if (result.success) {
+                m_rotated.fetchAndAddOrdered(1);
+            }
+            m_completed.fetchAndAddOrdered(1);
+        });
+    }
+
+    if (userDNs.isEmpty()) {
+        flush();
+    }
+    return true;
+}
+
+void BulkPasswordRotator::cancel() {
+    m_cancelled.storeRelease(1);
+}
+
+QString BulkPasswordRotator::errorString() const {
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+QList<BulkRotateResult> BulkPasswordRotator::results() const {
+    QMutexLocker locker(&m_mutex);
+    return m_results;
+}
+
+BulkRotateResult BulkPasswordRotator::rotateOne(int index, const QString& userDN, const QString& password) {
+    BulkRotateResult result;
+    result.index = index;
+    result.dn = userDN;
+
+    if (m_cancelled.loadAcquire()) {
+        result.error = tr("Cancelled");
+        return result;
+    }
+
+    // Journaled before the change, so the password is kept even if the job
+    // dies before the outcome is known
+    QJsonObject pending;
+    pending["dn"] = userDN;
+    pending["status"] = "pending";
+    pending["password"] = password;
+    if (!writeRecord(pending)) {
+        result.error = tr("Password not changed, it could not be saved: %1").arg(errorString());
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // As in BulkUserCreator: keep the last error ADManager reports for this item
+    ADManager* manager = worker();
+    QString lastError;
+    QMetaObject::Connection connection = connect(manager, &ADManager::error, [&lastError](const QString& message) {
+        lastError = message;
+    });
+
+    result.success = manager->changePassword(userDN, password);
+    disconnect(connection);
+
+    result.error = result.success ? QString() : (lastError.isEmpty() ? tr("Unknown error") : lastError);
+    result.elapsedMs = timer.elapsed();
+
+    // The pending record already holds the password, so a lost outcome
+    // only stops the batch
+    QJsonObject outcome;
+    outcome["dn"] = userDN;
+    outcome["status"] = result.success ? "rotated" : "failed";
+    if (!result.success) {
+        outcome["error"] = result.error;
+    }
+    writeRecord(outcome);
+    return result;
+}
+
+bool BulkPasswordRotator::writeRecord(const QJsonObject& record) {
+    // A record that cannot be written stops the batch: the next passwords
+    // would be set without being kept
+    QMutexLocker locker(&m_mutex);
+    if (!m_output.append(QJsonDocument(record).toJson(QJsonDocument::Compact))) {
+        m_error = m_output.errorString();
+        m_cancelled.storeRelease(1);
+        return false;
+    }
+    return true;
+}
+
+void BulkPasswordRotator::flush() {
+    QList<BulkRotateResult> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pending);
+    }
+
+    const int completed = m_completed.loadAcquire();
+    if (!pending.isEmpty()) {
+        emit itemsFinished(pending);
+        emit progress(completed, m_total);
+    }
+
+    if (m_running && completed >= m_total) {
+        m_progressTimer.stop();
+        {
+            QMutexLocker locker(&m_mutex);
+            m_output.close();
+        }
+        m_running = false;
+        emit finished(m_rotated.loadAcquire(), m_total, m_clock.elapsed());
+    }
+}
@@ -0,0 +1,160 @@
+#include "services/BulkUserCreator.h"
+#include "services/ADManager.h"
+#include <QMutexLocker>
+
+BulkUserCreator::BulkUserCreator(ADManager* source, QObject* parent)
+    : QObject(parent), m_running(false), m_total(0),
+      m_completed(0), m_created(0), m_cancelled(0), m_workers(source) {
+    m_pool.setMaxThreadCount(DefaultConcurrency);
+    m_pool.setExpiryTimeout(-1);
+
+    m_progressTimer.setInterval(DefaultProgressIntervalMs);
+    connect(&m_progressTimer, &QTimer::timeout, this, &BulkUserCreator::flush);
+}
+
+BulkUserCreator::~BulkUserCreator() {
+    m_cancelled.storeRelease(1);
+    m_pool.waitForDone();
+}
+
+void BulkUserCreator::setConcurrency(int concurrency) {
+    m_pool.setMaxThreadCount(qMax(1, concurrency));
+}
+
+void BulkUserCreator::setProgressInterval(int intervalMs) {
+    m_progressTimer.setInterval(qMax(10, intervalMs));
+}
+
+bool BulkUserCreator::start(const QList<UserInfo>& users, const QString& serverName) {
+    if (m_running) {
+        return false;
+    }
+
+    // Workers see the source as it is now; start() runs on its thread
+    m_workers.refresh();
+
+    m_running = true;
+    m_total = users.size();
+    m_completed.storeRelease(0);
+    m_created.storeRelease(0);
+    m_cancelled.storeRelease(0);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_results = QList<BulkCreateResult>(users.size());
+        m_pending.clear();
+    }
+
+    m_clock.start();
+    m_progressTimer.start();
+
+    if (users.isEmpty()) {
+        flush();
+        return true;
+    }
+
+    // The server's OU and group are created once, before the fan-out, so
+    // the batch's creates do not race each other to make them
+    m_pool.start([this, users, serverName]() {
+        const QString serverError = prepareServer(serverName);
+
+        // The pool's thread count is the concurrency window; the rest queue up
+        for (int i = 0; i < users.size(); ++i) {
+            if (!serverError.isEmpty()) {
+                BulkCreateResult result;
+                result.index = i;
+                result.login = users[i].getLogin();
+                result.error = serverError;
+                record(result);
+                continue;
+            }
+            m_pool.start([this, i, user = users[i], serverName]() {
+                record(createOne(i, user, serverName));
+            });
+        }
+    });
+    return true;
+}
+
+void BulkUserCreator::cancel() {
+    m_cancelled.storeRelease(1);
+}
+
+QList<BulkCreateResult> BulkUserCreator::results() const {
+    QMutexLocker locker(&m_mutex);
+    return m_results;
+}
+
+QString BulkUserCreator::prepareServer(const QString& serverName) {
+    ADManager* manager = worker();
+    QString lastError;
+    QMetaObject::Connection connection = connect(manager, &ADManager::error, [&lastError](const QString& message) {
+        lastError = message;
+    });
+
+    const bool ready = manager->createServerOU(serverName) && manager->createServerGroup(serverName);
+    disconnect(connection);
+
+    if (ready) {
+        return QString();
+    }
+    return lastError.isEmpty() ? tr("Failed to create server %1").arg(serverName) : lastError;
+}
+
+void BulkUserCreator::record(const BulkCreateResult& result) {
+    QMutexLocker locker(&m_mutex);
+    m_results[result.index] = result;
+    m_pending.append(result);
+    if (result.success) {
+        m_created.fetchAndAddOrdered(1);
+    }
+    m_completed.fetchAndAddOrdered(1);
+}
+
+BulkCreateResult BulkUserCreator::createOne(int index, const UserInfo& user, const QString& serverName) {
+    BulkCreateResult result;
+    result.index = index;
+    result.login = user.getLogin();
+
+    if (m_cancelled.loadAcquire()) {
+        result.error = tr("Cancelled");
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // ADManager reports failures through error(); keep the last one for this
+    // item. The functor runs directly on this thread, as the emitter
+    ADManager* manager = worker();
+    QString lastError;
+    QMetaObject::Connection connection = connect(manager, &ADManager::error, [&lastError](const QString& message) {
+        lastError = message;
+    });
+
+    result.success = manager->createUser(user, serverName);
+    disconnect(connection);
+
+    result.error = result.success ? QString() : (lastError.isEmpty() ? tr("Unknown error") : lastError);
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+void BulkUserCreator::flush() {
+    QList<BulkCreateResult> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pending);
+    }
+
+    const int completed = m_completed.loadAcquire();
+    if (!pending.isEmpty()) {
+        emit itemsFinished(pending);
+        emit progress(completed, m_total);
+    }
+
+    if (m_running && completed >= m_total) {
+        m_progressTimer.stop();
+        m_running = false;
+        emit finished(m_created.loadAcquire(), m_total, m_clock.elapsed());
+    }
+}
@@ -199,6 +199,94 @@ QString ConfigManager::getAdMetadataAttribute() const {
     return adConfig.value("metadata_attribute").toString("extensionAttribute1");
 }
 
+int ConfigManager::getAdSearchPageSize() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return 1000;
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("search_page_size").toInt(1000);
+}
+
+QString ConfigManager::getAdBackend() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return QString();
+    }
+    
+    // Empty means the platform default (ADSI on Windows, in-memory elsewhere)
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("backend").toString();
+}
+
+int ConfigManager::getAdMemorySeedUsers() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return 0;
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("memory_seed_users").toInt(0);
+}
+
+int ConfigManager::getAdCacheTtl() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return 30000;
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("cache_ttl_ms").toInt(30000);
+}
+
+int ConfigManager::getAdCacheMaxMegabytes() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return 32;
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("cache_max_mb").toInt(32);
+}
+
+int ConfigManager::getAdBulkConcurrency() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return 8;
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("bulk_concurrency").toInt(8);
+}
+
+int ConfigManager::getAdRotationConcurrency() const {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        return 8;
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    return adConfig.value("rotation_concurrency").toInt(8);
+}
+
+QJsonObject ConfigManager::getLdapSettings() const {
+    if (!m_config.contains("ldap") || !m_config["ldap"].isObject()) {
+        return QJsonObject();
+    }
+    
+    return m_config["ldap"].toObject();
+}
+
+QJsonObject ConfigManager::getRetrySettings() const {
+    if (!m_config.contains("retry") || !m_config["retry"].isObject()) {
+        return QJsonObject();
+    }
+    
+    return m_config["retry"].toObject();
+}
+
+QJsonObject ConfigManager::getMetricsSettings() const {
+    if (!m_config.contains("metrics") || !m_config["metrics"].isObject()) {
+        return QJsonObject();
+    }
+    
+    return m_config["metrics"].toObject();
+}
+
 void ConfigManager::setAdDomain(const QString& domain) {
     QJsonObject adConfig = m_config.value("ad").toObject();
     adConfig["domain"] = domain;
@@ -257,6 +345,88 @@ void ConfigManager::setAdMetadataAttribute(const QString& attribute) {
     m_config["ad"] = adConfig;
 }
 
+void ConfigManager::setAdSearchPageSize(int pageSize) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["search_page_size"] = pageSize;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setAdBackend(const QString& backend) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["backend"] = backend;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setAdMemorySeedUsers(int count) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["memory_seed_users"] = count;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setAdCacheTtl(int ttlMs) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["cache_ttl_ms"] = ttlMs;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setAdCacheMaxMegabytes(int megabytes) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["cache_max_mb"] = megabytes;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setAdBulkConcurrency(int concurrency) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["bulk_concurrency"] = concurrency;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setAdRotationConcurrency(int concurrency) {
+    if (!m_config.contains("ad") || !m_config["ad"].isObject()) {
+        m_config["ad"] = QJsonObject();
+    }
+    
+    QJsonObject adConfig = m_config["ad"].toObject();
+    adConfig["rotation_concurrency"] = concurrency;
+    m_config["ad"] = adConfig;
+}
+
+void ConfigManager::setLdapSettings(const QJsonObject& settings) {
+    m_config["ldap"] = settings;
+}
+
+void ConfigManager::setRetrySettings(const QJsonObject& settings) {
+    m_config["retry"] = settings;
+}
+
+void ConfigManager::setMetricsSettings(const QJsonObject& settings) {
+    m_config["metrics"] = settings;
+}
+
 QJsonObject ConfigManager::getPasswordPolicy() const {
     if (!m_config.contains("password_policy") || !m_config["password_policy"].isObject()) {
         return QJsonObject(); // Default policy will be used
@@ -315,8 +485,41 @@ void ConfigManager::initializeDefaultConfig() {
     adConfig["default_user_group"] = "CN=Users,CN=Builtin";
     adConfig["admin_group"] = "CN=Administrators,CN=Builtin";
     adConfig["metadata_attribute"] = "extensionAttribute1";
+    adConfig["search_page_size"] = 1000;
+    adConfig["backend"] = "";
+    adConfig["memory_seed_users"] = 0;
+    adConfig["cache_ttl_ms"] = 30000;
+    adConfig["cache_max_mb"] = 32;
+    adConfig["bulk_concurrency"] = 8;
+    adConfig["rotation_concurrency"] = 8;
     config["ad"] = adConfig;
     
+    // LDAP backend settings (used when ad.backend is "ldap")
+    QJsonObject ldapConfig;
+    ldapConfig["uri"] = "";
+    ldapConfig["bind_dn"] = "";
+    ldapConfig["password"] = "";
+    ldapConfig["start_tls"] = true;
+    ldapConfig["timeout_ms"] = 30000;
+    ldapConfig["max_outstanding"] = 8;
+    config["ldap"] = ldapConfig;
+    
+    // Retries of transient directory errors and the per-DC circuit breaker
+    QJsonObject retryConfig;
+    retryConfig["max_attempts"] = 4;
+    retryConfig["initial_backoff_ms"] = 100;
+    retryConfig["max_backoff_ms"] = 2000;
+    retryConfig["breaker_threshold"] = 10;
+    retryConfig["breaker_cooldown_ms"] = 10000;
+    config["retry"] = retryConfig;
+    
+    // Operation latency export; an empty path turns it off
+    QJsonObject metricsConfig;
+    metricsConfig["export_path"] = "";
+    metricsConfig["format"] = "prometheus";
+    metricsConfig["interval_ms"] = 15000;
+    config["metrics"] = metricsConfig;
+    
     // Password policy
     QJsonObject passwordPolicy;
     passwordPolicy["minLength"] = 12;
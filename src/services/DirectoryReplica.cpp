@@ -0,0 +1,221 @@
+#include "services/DirectoryReplica.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+QString DirectoryReplica::getSource() const {
+    QReadLocker locker(&m_lock);
+    return m_source;
+}
+
+qint64 DirectoryReplica::getWatermark() const {
+    QReadLocker locker(&m_lock);
+    return m_watermark;
+}
+
+void DirectoryReplica::setWatermark(qint64 watermark) {
+    QWriteLocker locker(&m_lock);
+    m_watermark = watermark;
+}
+
+void DirectoryReplica::reset(const QString& source) {
+    QWriteLocker locker(&m_lock);
+    m_source = source;
+    m_watermark = 0;
+    m_objects.clear();
+    m_usersByServer.clear();
+    m_servers.clear();
+}
+
+void DirectoryReplica::adopt(DirectoryReplica& other) {
+    QWriteLocker otherLocker(&other.m_lock);
+    QWriteLocker locker(&m_lock);
+    m_source = other.m_source;
+    m_watermark = other.m_watermark;
+    m_objects = std::move(other.m_objects);
+    m_usersByServer = std::move(other.m_usersByServer);
+    m_servers = std::move(other.m_servers);
+}
+
+QString DirectoryReplica::keyOf(const DirectoryEntry& entry) {
+    // Directories without objectGUID (plain slapd) fall back to the DN
+    const QString guid = entry.getValue("objectGUID");
+    if (!guid.isEmpty()) {
+        return guid.toLower();
+    }
+
+    QString dn = entry.getValue("distinguishedName");
+    if (dn.isEmpty()) {
+        dn = entry.getDistinguishedName();
+    }
+    return dn.toLower();
+}
+
+DirectoryReplica::Kind DirectoryReplica::kindOf(const DirectoryEntry& entry) {
+    const QStringList classes = entry.getValues("objectClass");
+    if (classes.contains("organizationalUnit", Qt::CaseInsensitive)) {
+        return Kind::Server;
+    }
+    if (classes.contains("group", Qt::CaseInsensitive)) {
+        return Kind::Group;
+    }
+    if (classes.contains("user", Qt::CaseInsensitive) && !classes.contains("computer", Qt::CaseInsensitive)) {
+        return Kind::User;
+    }
+    return Kind::Other;
+}
+
+void DirectoryReplica::upsert(const QString& serverName, const DirectoryEntry& entry) {
+    const QString key = keyOf(entry);
+    if (key.isEmpty()) {
+        return;
+    }
+
+    Object object;
+    object.kind = kindOf(entry);
+    object.server = serverName.toLower();
+    object.entry = entry;
+
+    // Only the OU named after the server stands for it, not OUs nested below
+    if (object.kind == Kind::Server &&
+        DirectoryEntry::rdnOf(entry.getDistinguishedName()).compare("OU=" + serverName, Qt::CaseInsensitive) != 0) {
+        object.kind = Kind::Other;
+    }
+
+    QWriteLocker locker(&m_lock);
+
+    // A changed object may have moved to another server
+    auto it = m_objects.find(key);
+    if (it != m_objects.end()) {
+        unlinkLocked(key, *it);
+    }
+
+    if (!object.server.isEmpty()) {
+        if (object.kind == Kind::Server) {
+            m_servers.insert(object.server, serverName);
+        } else if (object.kind == Kind::User) {
+            m_usersByServer[object.server].insert(key);
+        }
+    }
+
+    m_objects.insert(key, object);
+}
+
+QString DirectoryReplica::remove(const QString& objectGuid) {
+    const QString key = objectGuid.toLower();
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_objects.find(key);
+    if (it == m_objects.end()) {
+        return QString();
+    }
+
+    const QString server = it->server;
+    unlinkLocked(key, *it);
+    m_objects.erase(it);
+    return server;
+}
+
+void DirectoryReplica::unlinkLocked(const QString& key, const Object& object) {
+    if (object.server.isEmpty()) {
+        return;
+    }
+
+    if (object.kind == Kind::Server) {
+        m_servers.remove(object.server);
+    } else if (object.kind == Kind::User) {
+        auto users = m_usersByServer.find(object.server);
+        if (users != m_usersByServer.end()) {
+            users->remove(key);
+            if (users->isEmpty()) {
+                m_usersByServer.erase(users);
+            }
+        }
+    }
+}
+
+QStringList DirectoryReplica::getServerNames() const {
+    QReadLocker locker(&m_lock);
+    return m_servers.values();
+}
+
+QList<DirectoryEntry> DirectoryReplica::getUsersForServer(const QString& serverName) const {
+    QList<DirectoryEntry> users;
+
+    QReadLocker locker(&m_lock);
+    const QSet<QString> keys = m_usersByServer.value(serverName.toLower());
+    users.reserve(keys.size());
+    for (const QString& key : keys) {
+        auto it = m_objects.constFind(key);
+        if (it != m_objects.constEnd()) {
+            users.append(it->entry);
+        }
+    }
+
+    return users;
+}
+
+int DirectoryReplica::entryCount() const {
+    QReadLocker locker(&m_lock);
+    return m_objects.size();
+}
+
+void DirectoryReplica::setStoragePath(const QString& path) {
+    QWriteLocker locker(&m_lock);
+    m_storagePath = path;
+}
+
+QString DirectoryReplica::getStoragePath() const {
+    QReadLocker locker(&m_lock);
+    return m_storagePath;
+}
+
+bool DirectoryReplica::load() {
+    DirectorySnapshot snapshot;
+    if (!snapshot.open(getStoragePath())) {
+        return false;
+    }
+
+    // Read into a fresh replica, then swap it in
+    DirectoryReplica loaded;
+    loaded.m_source = snapshot.getSource();
+    loaded.m_watermark = snapshot.getWatermark();
+    loaded.m_objects.reserve(snapshot.objectCount());
+
+    for (int i = 0; i < snapshot.objectCount(); ++i) {
+        DirectorySnapshot::Object object = snapshot.objectAt(i);
+        loaded.upsert(object.server, object.entry);
+    }
+
+    adopt(loaded);
+    return true;
+}
+
+bool DirectoryReplica::save() const {
+    QString path;
+    QString source;
+    qint64 watermark = 0;
+    QList<DirectorySnapshot::Object> objects;
+    {
+        // Entries are implicitly shared, so copying them out is cheap and
+        // the file is written without holding the lock
+        QReadLocker locker(&m_lock);
+        if (m_storagePath.isEmpty()) {
+            return true;
+        }
+        path = m_storagePath;
+        source = m_source;
+        watermark = m_watermark;
+
+        objects.reserve(m_objects.size());
+        for (auto it = m_objects.constBegin(); it != m_objects.constEnd(); ++it) {
+            DirectorySnapshot::Object object;
+            object.kind = it->kind;
+            // The original case of the server name is kept by the OU's display name
+            object.server = m_servers.value(it->server, it->server);
+            object.entry = it->entry;
+            objects.append(object);
+        }
+    }
+
+    return DirectorySnapshot::write(path, source, watermark, objects);
+}
@@ -0,0 +1,348 @@
+#include "services/DirectorySnapshot.h"
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QMap>
+#include <cstring>
+
+namespace {
+const quint32 kSnapshotMagic = 0x41445353; // "ADSS"
+const quint32 kSnapshotVersion = 1;
+const quint32 kNoRecord = 0xFFFFFFFF;
+
+// Attributes kept per object, one string reference each
+const char* const kColumns[] = {
+    "objectGUID", "distinguishedName", "cn", "sAMAccountName", "givenName", "sn", "displayName",
+    "whenCreated", "lastLogonTimestamp", "userAccountControl", "ou", "extensionAttribute1", "uSNChanged"
+};
+constexpr int kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+constexpr int kDistinguishedNameColumn = 1;
+
+QStringList objectClassesOf(DirectoryObjectKind kind) {
+    switch (kind) {
+    case DirectoryObjectKind::Server:
+        return {"top", "organizationalUnit"};
+    case DirectoryObjectKind::Group:
+        return {"top", "group"};
+    case DirectoryObjectKind::User:
+        return {"top", "person", "organizationalPerson", "user"};
+    case DirectoryObjectKind::Other:
+        break;
+    }
+    return QStringList();
+}
+
+qint64 align8(qint64 offset) {
+    return (offset + 7) & ~qint64(7);
+}
+}
+
+struct DirectorySnapshot::Header {
+    quint32 magic;
+    quint32 version;
+    qint64 watermark;
+    StringRef source;
+    quint32 serverCount;
+    quint32 objectCount;
+    quint64 serverOffset;
+    quint64 objectOffset;
+    quint64 stringOffset;
+    quint64 stringLength; // in UTF-16 code units
+};
+
+struct DirectorySnapshot::ServerRecord {
+    StringRef name;
+    quint32 ouRecord;
+    quint32 firstUser;
+    quint32 userCount;
+    quint32 reserved;
+};
+
+struct DirectorySnapshot::ObjectRecord {
+    quint8 kind;
+    quint8 reserved[3];
+    quint32 server; // server record, or kNoRecord
+    StringRef columns[kColumnCount];
+};
+
+DirectorySnapshot::~DirectorySnapshot() {
+    close();
+}
+
+bool DirectorySnapshot::open(const QString& path) {
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < qint64(sizeof(Header))) {
+        close();
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        close();
+        return false;
+    }
+
+    // Reject anything that does not fit the file before touching records
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    const quint64 size = quint64(m_size);
+    if (header->magic != kSnapshotMagic || header->version != kSnapshotVersion ||
+        header->serverOffset + quint64(header->serverCount) * sizeof(ServerRecord) > size ||
+        header->objectOffset + quint64(header->objectCount) * sizeof(ObjectRecord) > size ||
+        header->stringOffset + header->stringLength * sizeof(char16_t) > size) {
+        close();
+        return false;
+    }
+
+    m_serverIndex.reserve(header->serverCount);
+    for (quint32 i = 0; i < header->serverCount; ++i) {
+        m_serverIndex.insert(stringAt(serverAt(i)->name).toLower(), int(i));
+    }
+
+    return true;
+}
+
+void DirectorySnapshot::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_serverIndex.clear();
+    m_file.close();
+}
+
+QString DirectorySnapshot::getSource() const {
+    return isOpen() ? stringAt(reinterpret_cast<const Header*>(m_data)->source) : QString();
+}
+
+qint64 DirectorySnapshot::getWatermark() const {
+    return isOpen() ? reinterpret_cast<const Header*>(m_data)->watermark : 0;
+}
+
+QStringList DirectorySnapshot::getServerNames() const {
+    QStringList names;
+    if (!isOpen()) {
+        return names;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    names.reserve(header->serverCount);
+    for (quint32 i = 0; i < header->serverCount; ++i) {
+        const ServerRecord* server = serverAt(i);
+        if (server->ouRecord != kNoRecord) {
+            names << stringAt(server->name);
+        }
+    }
+
+    return names;
+}
+
+bool DirectorySnapshot::hasServer(const QString& serverName) const {
+    auto it = m_serverIndex.constFind(serverName.toLower());
+    return it != m_serverIndex.constEnd() && serverAt(*it)->ouRecord != kNoRecord;
+}
+
+QList<DirectoryEntry> DirectorySnapshot::getUsersForServer(const QString& serverName) const {
+    QList<DirectoryEntry> users;
+
+    auto it = m_serverIndex.constFind(serverName.toLower());
+    if (it == m_serverIndex.constEnd()) {
+        return users;
+    }
+
+    const ServerRecord* server = serverAt(*it);
+    const quint64 end = quint64(server->firstUser) + server->userCount;
+    if (end > quint64(objectCount())) {
+        return users;
+    }
+
+    users.reserve(server->userCount);
+    for (quint32 i = server->firstUser; i < end; ++i) {
+        users.append(objectAt(int(i)).entry);
+    }
+
+    return users;
+}
+
+int DirectorySnapshot::objectCount() const {
+    return isOpen() ? int(reinterpret_cast<const Header*>(m_data)->objectCount) : 0;
+}
+
+DirectorySnapshot::Object DirectorySnapshot::objectAt(int index) const {
+    Object object;
+    const ObjectRecord* record = recordAt(index);
+    if (!record) {
+        return object;
+    }
+
+    object.kind = record->kind <= quint8(DirectoryObjectKind::Other) ? DirectoryObjectKind(record->kind)
+                                                                    : DirectoryObjectKind::Other;
+    const ServerRecord* server = record->server != kNoRecord ? serverAt(int(record->server)) : nullptr;
+    if (server) {
+        object.server = stringAt(server->name);
+    }
+
+    for (int column = 0; column < kColumnCount; ++column) {
+        const QString value = stringAt(record->columns[column]);
+        if (!value.isEmpty()) {
+            object.entry.setValue(kColumns[column], value);
+        }
+    }
+    object.entry.setDistinguishedName(object.entry.getValue("distinguishedName"));
+
+    const QStringList classes = objectClassesOf(object.kind);
+    if (!classes.isEmpty()) {
+        object.entry.setValues("objectClass", classes);
+    }
+    if (object.kind == DirectoryObjectKind::User) {
+        object.entry.setValue("objectCategory", "person");
+    }
+
+    return object;
+}
+
+QString DirectorySnapshot::stringAt(const StringRef& ref) const {
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    if (ref.length == 0 || quint64(ref.offset) + ref.length > header->stringLength) {
+        return QString();
+    }
+
+    const QChar* strings = reinterpret_cast<const QChar*>(m_data + header->stringOffset);
+    return QString(strings + ref.offset, int(ref.length));
+}
+
+const DirectorySnapshot::ServerRecord* DirectorySnapshot::serverAt(int index) const {
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    if (index < 0 || quint32(index) >= header->serverCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<const ServerRecord*>(m_data + header->serverOffset) + index;
+}
+
+const DirectorySnapshot::ObjectRecord* DirectorySnapshot::recordAt(int index) const {
+    if (!isOpen()) {
+        return nullptr;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(m_data);
+    if (index < 0 || quint32(index) >= header->objectCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<const ObjectRecord*>(m_data + header->objectOffset) + index;
+}
+
+bool DirectorySnapshot::write(const QString& path, const QString& source, qint64 watermark,
+                              const QList<Object>& objects) {
+    // Servers sorted by name; each one's users become one run of records
+    QMap<QString, QString> serverNames; // lower-case -> as displayed
+    for (const Object& object : objects) {
+        if (!object.server.isEmpty() && !serverNames.contains(object.server.toLower())) {
+            serverNames.insert(object.server.toLower(), object.server);
+        }
+    }
+
+    QHash<QString, quint32> serverIndex;
+    QList<ServerRecord> servers;
+    servers.reserve(serverNames.size());
+    for (auto it = serverNames.constBegin(); it != serverNames.constEnd(); ++it) {
+        serverIndex.insert(it.key(), quint32(servers.size()));
+        servers.append(ServerRecord{{0, 0}, kNoRecord, 0, 0, 0});
+    }
+
+    QList<QList<int>> usersByServer(servers.size());
+    QList<int> others;
+    for (int i = 0; i < objects.size(); ++i) {
+        const Object& object = objects[i];
+        if (object.kind == DirectoryObjectKind::User && !object.server.isEmpty()) {
+            usersByServer[serverIndex.value(object.server.toLower())].append(i);
+        } else {
+            others.append(i);
+        }
+    }
+
+    QList<int> order;
+    order.reserve(objects.size());
+    for (int s = 0; s < servers.size(); ++s) {
+        servers[s].firstUser = quint32(order.size());
+        servers[s].userCount = quint32(usersByServer[s].size());
+        order.append(usersByServer[s]);
+    }
+    order.append(others);
+
+    // Strings are appended as they are referenced; the empty string is {0, 0}
+    QString strings;
+    auto addString = [&strings](const QString& value) {
+        StringRef ref{quint32(strings.size()), quint32(value.size())};
+        strings.append(value);
+        return ref;
+    };
+
+    int s = 0;
+    for (auto it = serverNames.constBegin(); it != serverNames.constEnd(); ++it, ++s) {
+        servers[s].name = addString(it.value());
+    }
+
+    QList<ObjectRecord> records;
+    records.reserve(order.size());
+    for (int index : order) {
+        const Object& object = objects[index];
+
+        ObjectRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.kind = quint8(object.kind);
+        record.server = object.server.isEmpty() ? kNoRecord : serverIndex.value(object.server.toLower());
+        for (int column = 0; column < kColumnCount; ++column) {
+            QString value = object.entry.getValue(kColumns[column]);
+            if (column == kDistinguishedNameColumn && value.isEmpty()) {
+                value = object.entry.getDistinguishedName();
+            }
+            record.columns[column] = addString(value);
+        }
+
+        if (object.kind == DirectoryObjectKind::Server && record.server != kNoRecord) {
+            servers[record.server].ouRecord = quint32(records.size());
+        }
+        records.append(record);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kSnapshotMagic;
+    header.version = kSnapshotVersion;
+    header.watermark = watermark;
+    header.source = addString(source);
+    header.serverCount = quint32(servers.size());
+    header.objectCount = quint32(records.size());
+    header.serverOffset = quint64(align8(sizeof(Header)));
+    header.objectOffset = quint64(align8(header.serverOffset + servers.size() * sizeof(ServerRecord)));
+    header.stringOffset = quint64(align8(header.objectOffset + records.size() * sizeof(ObjectRecord)));
+    header.stringLength = quint64(strings.size());
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // QSaveFile replaces the old snapshot only once the new one is complete
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    auto pad = [&file](quint64 offset) {
+        const qint64 gap = qint64(offset) - file.pos();
+        if (gap > 0) {
+            file.write(QByteArray(gap, '\0'));
+        }
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(header.serverOffset);
+    file.write(reinterpret_cast<const char*>(servers.constData()), servers.size() * sizeof(ServerRecord));
+    pad(header.objectOffset);
+    file.write(reinterpret_cast<const char*>(records.constData()), records.size() * sizeof(ObjectRecord));
+    pad(header.stringOffset);
+    file.write(reinterpret_cast<const char*>(strings.constData()), strings.size() * sizeof(QChar));
+
+    return file.commit();
+}
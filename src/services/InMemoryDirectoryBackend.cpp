@@ -0,0 +1,627 @@
+#include "services/InMemoryDirectoryBackend.h"
+#include <QDateTime>
+#include <QUuid>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+namespace {
+QString keyOf(const QString& dn) {
+    return dn.trimmed().toLower();
+}
+
+bool inScope(const QString& key, const QString& baseKey, SearchScope scope) {
+    switch (scope) {
+    case SearchScope::Base:
+        return key == baseKey;
+    case SearchScope::OneLevel:
+        return DirectoryEntry::parentOf(key) == baseKey;
+    case SearchScope::Subtree:
+        return key == baseKey || key.endsWith("," + baseKey);
+    }
+    return false;
+}
+
+// FILETIME for "now": 100ns intervals since 1601-01-01 UTC
+qint64 fileTimeFromMSecs(qint64 msecs) {
+    return (msecs + 11644473600000LL) * 10000;
+}
+}
+
+InMemoryDirectoryBackend::InMemoryDirectoryBackend()
+    : m_store(std::make_shared<Store>()) {
+}
+
+InMemoryDirectoryBackend::InMemoryDirectoryBackend(std::shared_ptr<Store> store)
+    : m_store(std::move(store)) {
+}
+
+std::unique_ptr<IDirectoryBackend> InMemoryDirectoryBackend::clone() const {
+    // Shares the store: every clone sees the same entries
+    return std::unique_ptr<IDirectoryBackend>(new InMemoryDirectoryBackend(m_store));
+}
+
+bool InMemoryDirectoryBackend::connect(const QString& namingContext) {
+    clearError();
+    m_namingContext = namingContext.isEmpty() ? QString(DefaultNamingContext) : namingContext;
+
+    // The naming context head is created on first use, like a fresh domain
+    QWriteLocker locker(&m_store->lock);
+    const QString key = keyOf(m_namingContext);
+    if (!m_store->entries.contains(key)) {
+        DirectoryEntry root(m_namingContext);
+        root.setValues("objectClass", {"top", "domain", "domainDNS"});
+        root.setValue("dc", DirectoryEntry::rdnOf(m_namingContext).section('=', 1));
+        stampLocked(root, true);
+        insertLocked(key, root);
+    }
+
+    return true;
+}
+
+bool InMemoryDirectoryBackend::search(const SearchRequest& request, const SearchPageCallback& onPage) {
+    QStringList keys;
+    if (!collectKeys(request, keys)) {
+        return false;
+    }
+
+    // Materialize one page at a time and call back without holding the
+    // lock, so the callback may use the backend itself
+    const int pageSize = request.pageSize > 0 ? request.pageSize : 1000;
+    for (int start = 0; start < keys.size(); start += pageSize) {
+        QList<DirectoryEntry> page;
+        page.reserve(qMin(pageSize, keys.size() - start));
+        {
+            QReadLocker locker(&m_store->lock);
+            for (int i = start; i < keys.size() && i < start + pageSize; ++i) {
+                if (const DirectoryEntry* entry = findLocked(keys[i])) {
+                    page.append(projectLocked(*entry, request.attributes));
+                }
+            }
+        }
+
+        if (!page.isEmpty() && !onPage(page)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool InMemoryDirectoryBackend::searchWindow(const SearchRequest& request, const VlvWindow& window,
+                                            QList<DirectoryEntry>& entries, VlvResult& result) {
+    QStringList keys;
+    if (!collectKeys(request, keys)) {
+        return false;
+    }
+
+    // Only the window is materialized, as a VLV-capable server would send it
+    QList<DirectoryEntry> order;
+    order.reserve(keys.size());
+    for (const QString& key : keys) {
+        order.append(DirectoryEntry(key));
+    }
+    QList<DirectoryEntry> slice;
+    sliceWindow(order, window, slice, result);
+
+    QReadLocker locker(&m_store->lock);
+    entries.reserve(entries.size() + slice.size());
+    for (const DirectoryEntry& item : slice) {
+        if (const DirectoryEntry* entry = findLocked(item.getDistinguishedName())) {
+            entries.append(projectLocked(*entry, request.attributes));
+        }
+    }
+    return true;
+}
+
+bool InMemoryDirectoryBackend::collectKeys(const SearchRequest& request, QStringList& keys) {
+    clearError();
+
+    const LdapFilter filter = LdapFilter::parse(request.filter);
+    if (!filter.isValid()) {
+        setError(DirectoryError::InvalidArgument, QString("Invalid search filter %1").arg(request.filter));
+        return false;
+    }
+
+    const QString baseKey = keyOf(request.baseDN);
+    QReadLocker locker(&m_store->lock);
+    if (!m_store->entries.contains(baseKey)) {
+        setError(DirectoryError::NoSuchObject, QString("Object %1 does not exist").arg(request.baseDN));
+        return false;
+    }
+    keys = candidatesLocked(baseKey, request.scope, filter);
+
+    if (request.includeDeleted && request.scope != SearchScope::Base) {
+        for (auto it = m_store->tombstones.constBegin(); it != m_store->tombstones.constEnd(); ++it) {
+            if (inScope(it.key(), baseKey, SearchScope::Subtree) && filter.matches(*it)) {
+                keys.append(it.key());
+            }
+        }
+    }
+
+    if (!request.sortKeys.isEmpty()) {
+        // Sort on copies holding just the sort attributes, keyed by DN key
+        QList<DirectoryEntry> order;
+        order.reserve(keys.size());
+        for (const QString& key : keys) {
+            DirectoryEntry item(key);
+            if (const DirectoryEntry* entry = findLocked(key)) {
+                for (const SortKey& sortKey : request.sortKeys) {
+                    item.setValues(sortKey.attribute, entry->getValues(sortKey.attribute));
+                }
+            }
+            order.append(item);
+        }
+        sortEntries(order, request.sortKeys);
+        for (int i = 0; i < order.size(); ++i) {
+            keys[i] = order[i].getDistinguishedName();
+        }
+    }
+
+    if (request.sizeLimit > 0 && keys.size() > request.sizeLimit) {
+        keys = keys.mid(0, request.sizeLimit);
+    }
+    return true;
+}
+
+const DirectoryEntry* InMemoryDirectoryBackend::findLocked(const QString& key) const {
+    auto it = m_store->entries.constFind(key);
+    if (it != m_store->entries.constEnd()) {
+        return &*it;
+    }
+    auto tombstone = m_store->tombstones.constFind(key);
+    return tombstone != m_store->tombstones.constEnd() ? &*tombstone : nullptr;
+}
+
+bool InMemoryDirectoryBackend::readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) {
+    clearError();
+
+    QReadLocker locker(&m_store->lock);
+    auto it = m_store->entries.constFind(keyOf(dn));
+    if (it == m_store->entries.constEnd()) {
+        setError(DirectoryError::NoSuchObject, QString("Object %1 does not exist").arg(dn));
+        return false;
+    }
+
+    entry = projectLocked(*it, attributes);
+    return true;
+}
+
+bool InMemoryDirectoryBackend::entryExists(const QString& dn) {
+    clearError();
+
+    QReadLocker locker(&m_store->lock);
+    return m_store->entries.contains(keyOf(dn));
+}
+
+bool InMemoryDirectoryBackend::addEntry(const DirectoryEntry& entry) {
+    clearError();
+
+    const QString dn = entry.getDistinguishedName();
+    const QString key = keyOf(dn);
+    if (key.isEmpty() || entry.getValues("objectClass").isEmpty()) {
+        setError(DirectoryError::InvalidArgument, QString("Cannot create %1: missing DN or objectClass").arg(dn));
+        return false;
+    }
+
+    QWriteLocker locker(&m_store->lock);
+    if (m_store->entries.contains(key)) {
+        setError(DirectoryError::AlreadyExists, QString("Object %1 already exists").arg(dn));
+        return false;
+    }
+
+    if (!m_store->entries.contains(keyOf(DirectoryEntry::parentOf(dn)))) {
+        setError(DirectoryError::NoSuchObject, QString("Parent of %1 does not exist").arg(dn));
+        return false;
+    }
+
+    // sAMAccountName is unique across the domain, as in AD
+    const QString accountName = entry.getValue("sAMAccountName").toLower();
+    if (!accountName.isEmpty() && m_store->byAccountName.contains(accountName)) {
+        setError(DirectoryError::AlreadyExists,
+                 QString("Account name %1 is already in use").arg(entry.getValue("sAMAccountName")));
+        return false;
+    }
+
+    DirectoryEntry stored = entry;
+    stampLocked(stored, true);
+    insertLocked(key, stored);
+
+    return true;
+}
+
+bool InMemoryDirectoryBackend::modifyEntry(const ADObjectChangeSet& changes) {
+    clearError();
+
+    const QString key = keyOf(changes.getDistinguishedName());
+
+    QWriteLocker locker(&m_store->lock);
+    auto it = m_store->entries.find(key);
+    if (it == m_store->entries.end()) {
+        setError(DirectoryError::NoSuchObject,
+                 QString("Object %1 does not exist").arg(changes.getDistinguishedName()));
+        return false;
+    }
+
+    // Apply to a copy so a rejected change set leaves the entry untouched
+    DirectoryEntry entry = *it;
+    const QString oldAccountName = entry.getValue("sAMAccountName").toLower();
+
+    for (const ADObjectChangeSet::Change& change : changes.getChanges()) {
+        switch (change.operation) {
+        case ADObjectChangeSet::Operation::Replace:
+            if (change.values.isEmpty()) {
+                entry.removeAttribute(change.attribute);
+            } else {
+                entry.setValues(change.attribute, change.values);
+            }
+            break;
+
+        case ADObjectChangeSet::Operation::Append: {
+            QStringList values = entry.getValues(change.attribute);
+            for (const QString& value : change.values) {
+                if (!values.contains(value, Qt::CaseInsensitive)) {
+                    values.append(value);
+                }
+            }
+            entry.setValues(change.attribute, values);
+            break;
+        }
+
+        case ADObjectChangeSet::Operation::Remove: {
+            QStringList values = entry.getValues(change.attribute);
+            for (const QString& value : change.values) {
+                values.removeIf([&value](const QString& existing) {
+                    return existing.compare(value, Qt::CaseInsensitive) == 0;
+                });
+            }
+            if (values.isEmpty()) {
+                entry.removeAttribute(change.attribute);
+            } else {
+                entry.setValues(change.attribute, values);
+            }
+            break;
+        }
+
+        case ADObjectChangeSet::Operation::Clear:
+            entry.removeAttribute(change.attribute);
+            break;
+        }
+    }
+
+    const QString newAccountName = entry.getValue("sAMAccountName").toLower();
+    if (newAccountName != oldAccountName) {
+        if (!newAccountName.isEmpty() && m_store->byAccountName.contains(newAccountName)) {
+            setError(DirectoryError::AlreadyExists,
+                     QString("Account name %1 is already in use").arg(entry.getValue("sAMAccountName")));
+            return false;
+        }
+        m_store->byAccountName.remove(oldAccountName);
+        if (!newAccountName.isEmpty()) {
+            m_store->byAccountName.insert(newAccountName, key);
+        }
+    }
+
+    stampLocked(entry, false);
+    *it = entry;
+
+    return true;
+}
+
+bool InMemoryDirectoryBackend::deleteEntry(const QString& dn) {
+    clearError();
+
+    const QString key = keyOf(dn);
+
+    QWriteLocker locker(&m_store->lock);
+    auto it = m_store->entries.find(key);
+    if (it == m_store->entries.end()) {
+        setError(DirectoryError::NoSuchObject, QString("Object %1 does not exist").arg(dn));
+        return false;
+    }
+
+    if (!m_store->children.value(key).isEmpty()) {
+        setError(DirectoryError::Other, QString("Object %1 has child objects").arg(dn));
+        return false;
+    }
+
+    const QString accountName = it->getValue("sAMAccountName").toLower();
+    if (!accountName.isEmpty()) {
+        m_store->byAccountName.remove(accountName);
+    }
+
+    const QString parentKey = DirectoryEntry::parentOf(key);
+    auto parent = m_store->children.find(parentKey);
+    if (parent != m_store->children.end()) {
+        parent->remove(key);
+        if (parent->isEmpty()) {
+            m_store->children.erase(parent);
+        }
+    }
+
+    // Keep a tombstone the way AD does: renamed under CN=Deleted Objects
+    // with most attributes stripped and a fresh uSNChanged
+    const QString guid = it->getValue("objectGUID");
+    const QString tombstoneDN = QString("%1\\0ADEL:%2,CN=Deleted Objects,%3")
+                                    .arg(DirectoryEntry::rdnOf(it->getDistinguishedName()), guid, m_namingContext);
+    DirectoryEntry tombstone(tombstoneDN);
+    for (const char* attribute : {"objectGUID", "objectClass", "sAMAccountName", "uSNCreated", "whenCreated"}) {
+        if (it->hasAttribute(attribute)) {
+            tombstone.setValues(attribute, it->getValues(attribute));
+        }
+    }
+    tombstone.setValue("distinguishedName", tombstoneDN);
+    tombstone.setValue("isDeleted", "TRUE");
+    tombstone.setValue("lastKnownParent", DirectoryEntry::parentOf(it->getDistinguishedName()));
+    stampLocked(tombstone, false);
+    m_store->tombstones.insert(keyOf(tombstoneDN), tombstone);
+
+    m_store->children.remove(key);
+    m_store->passwords.remove(key);
+    m_store->entries.erase(it);
+
+    return true;
+}
+
+bool InMemoryDirectoryBackend::setPassword(const QString& dn, const QString& password) {
+    clearError();
+
+    const QString key = keyOf(dn);
+
+    QWriteLocker locker(&m_store->lock);
+    auto it = m_store->entries.find(key);
+    if (it == m_store->entries.end()) {
+        setError(DirectoryError::NoSuchObject, QString("Object %1 does not exist").arg(dn));
+        return false;
+    }
+
+    m_store->passwords.insert(key, password);
+    it->setValue("pwdLastSet", QString::number(fileTimeFromMSecs(QDateTime::currentMSecsSinceEpoch())));
+    stampLocked(*it, false);
+
+    return true;
+}
+
+void InMemoryDirectoryBackend::seedSyntheticUsers(int count, int serverCount) {
+    if (m_namingContext.isEmpty()) {
+        connect(QString());
+    }
+    serverCount = qMax(1, serverCount);
+
+    QWriteLocker locker(&m_store->lock);
+    m_store->entries.reserve(m_store->entries.size() + count + 2 * serverCount);
+
+    QStringList groupKeys;
+    QStringList ouDNs;
+    for (int s = 1; s <= serverCount; ++s) {
+        const QString serverName = QString("SRV%1").arg(s, 3, 10, QChar('0'));
+        const QString ouDN = QString("OU=%1,%2").arg(serverName, m_namingContext);
+        const QString groupDN = QString("CN=%1-Group,%2").arg(serverName, ouDN);
+
+        if (!m_store->entries.contains(keyOf(ouDN))) {
+            DirectoryEntry ou(ouDN);
+            ou.setValues("objectClass", {"top", "organizationalUnit"});
+            ou.setValue("ou", serverName);
+            stampLocked(ou, true);
+            insertLocked(keyOf(ouDN), ou);
+        }
+
+        if (!m_store->entries.contains(keyOf(groupDN))) {
+            DirectoryEntry group(groupDN);
+            group.setValues("objectClass", {"top", "group"});
+            group.setValue("cn", serverName + "-Group");
+            group.setValue("sAMAccountName", serverName + "-Group");
+            group.setValue("groupType", "-2147483646");
+            stampLocked(group, true);
+            insertLocked(keyOf(groupDN), group);
+        }
+
+        ouDNs << ouDN;
+        groupKeys << keyOf(groupDN);
+    }
+
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const QString now = generalizedTimeNow();
+    int created = 0;
+
+    for (int i = 1; created < count; ++i) {
+        const QString login = QString("user%1").arg(i, 6, 10, QChar('0'));
+        if (m_store->byAccountName.contains(login)) {
+            continue;
+        }
+
+        const int server = created % serverCount;
+        const QString userDN = QString("CN=%1,%2").arg(login, ouDNs[server]);
+
+        DirectoryEntry user(userDN);
+        user.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+        user.setValue("objectCategory", "person");
+        user.setValue("cn", login);
+        user.setValue("sAMAccountName", login);
+        user.setValue("givenName", "User");
+        user.setValue("sn", QString::number(i));
+        user.setValue("displayName", QString("User %1").arg(i));
+        user.setValue("userAccountControl", "512");
+        user.setValue("whenCreated", now);
+        user.setValue("lastLogonTimestamp", QString::number(fileTimeFromMSecs(nowMs - qint64(i) * 60000)));
+        stampLocked(user, true);
+        insertLocked(keyOf(userDN), user);
+
+        m_store->entries[groupKeys[server]].addValue("member", userDN);
+        ++created;
+    }
+
+    for (const QString& groupKey : groupKeys) {
+        stampLocked(m_store->entries[groupKey], false);
+    }
+}
+
+int InMemoryDirectoryBackend::entryCount() const {
+    QReadLocker locker(&m_store->lock);
+    return m_store->entries.size();
+}
+
+void InMemoryDirectoryBackend::setMaxValRange(int maxValRange) {
+    QWriteLocker locker(&m_store->lock);
+    m_store->maxValRange = qMax(1, maxValRange);
+}
+
+int InMemoryDirectoryBackend::maxValRange() const {
+    QReadLocker locker(&m_store->lock);
+    return m_store->maxValRange;
+}
+
+void InMemoryDirectoryBackend::insertLocked(const QString& key, DirectoryEntry entry) {
+    entry.setValue("distinguishedName", entry.getDistinguishedName());
+
+    const QString accountName = entry.getValue("sAMAccountName").toLower();
+    if (!accountName.isEmpty()) {
+        m_store->byAccountName.insert(accountName, key);
+    }
+
+    m_store->children[DirectoryEntry::parentOf(key)].insert(key);
+    m_store->entries.insert(key, entry);
+}
+
+void InMemoryDirectoryBackend::stampLocked(DirectoryEntry& entry, bool created) {
+    const QString usn = QString::number(++m_store->usn);
+    const QString now = generalizedTimeNow();
+
+    if (created) {
+        if (!entry.hasAttribute("objectGUID")) {
+            entry.setValue("objectGUID", QString::fromLatin1(QUuid::createUuid().toRfc4122().toHex()));
+        }
+        entry.setValue("uSNCreated", usn);
+        if (!entry.hasAttribute("whenCreated")) {
+            entry.setValue("whenCreated", now);
+        }
+    }
+
+    entry.setValue("uSNChanged", usn);
+    entry.setValue("whenChanged", now);
+}
+
+QStringList InMemoryDirectoryBackend::candidatesLocked(const QString& baseKey, SearchScope scope,
+                                                       const LdapFilter& filter) const {
+    QStringList keys;
+
+    auto accept = [this, &filter, &keys](const QString& key) {
+        auto it = m_store->entries.constFind(key);
+        if (it != m_store->entries.constEnd() && filter.matches(*it)) {
+            keys.append(key);
+        }
+    };
+
+    if (scope == SearchScope::Base) {
+        accept(baseKey);
+        return keys;
+    }
+
+    // Equality on an indexed attribute narrows the search to one entry
+    const QString accountName = filter.requiredEquality("sAMAccountName");
+    if (!accountName.isNull()) {
+        const QString key = m_store->byAccountName.value(accountName.toLower());
+        if (!key.isEmpty() && inScope(key, baseKey, scope)) {
+            accept(key);
+        }
+        return keys;
+    }
+
+    // Prefix terms (sAMAccountName=base*) walk a range of the sorted index
+    const QString prefix = filter.requiredPrefix("sAMAccountName");
+    if (!prefix.isNull()) {
+        const QString lowered = prefix.toLower();
+        const QMap<QString, QString>& index = m_store->byAccountName;
+        for (auto it = index.lowerBound(lowered); it != index.constEnd() && it.key().startsWith(lowered); ++it) {
+            if (inScope(it.value(), baseKey, scope)) {
+                accept(it.value());
+            }
+        }
+        return keys;
+    }
+
+    const QString dn = filter.requiredEquality("distinguishedName");
+    if (!dn.isNull()) {
+        const QString key = keyOf(dn);
+        if (inScope(key, baseKey, scope)) {
+            accept(key);
+        }
+        return keys;
+    }
+
+    // A list of DNs, (|(distinguishedName=a)(distinguishedName=b)...), is a
+    // lookup per DN
+    const QStringList dns = filter.requiredEqualities("distinguishedName");
+    if (!dns.isEmpty()) {
+        QSet<QString> seen;
+        for (const QString& value : dns) {
+            const QString key = keyOf(value);
+            if (!seen.contains(key) && inScope(key, baseKey, scope)) {
+                seen.insert(key);
+                accept(key);
+            }
+        }
+        return keys;
+    }
+
+    // Otherwise walk the subtree through the parent index
+    if (scope == SearchScope::Subtree) {
+        accept(baseKey);
+    }
+
+    QStringList pending{baseKey};
+    while (!pending.isEmpty()) {
+        const QString parentKey = pending.takeLast();
+        const QSet<QString> children = m_store->children.value(parentKey);
+        for (const QString& child : children) {
+            accept(child);
+            if (scope == SearchScope::Subtree) {
+                pending.append(child);
+            }
+        }
+    }
+
+    return keys;
+}
+
+DirectoryEntry InMemoryDirectoryBackend::projectLocked(const DirectoryEntry& entry, const QStringList& attributes) const {
+    if (attributes.isEmpty()) {
+        return entry;
+    }
+
+    const int maxValRange = qMax(1, m_store->maxValRange);
+    DirectoryEntry result(entry.getDistinguishedName());
+    for (const QString& attribute : attributes) {
+        AttributeRange range;
+        const bool ranged = AttributeRange::parse(attribute, range);
+        if (!ranged) {
+            range.attribute = attribute;
+        }
+        if (!entry.hasAttribute(range.attribute)) {
+            continue;
+        }
+
+        // Implicitly shared, so only the slice handed out is copied
+        const QStringList values = entry.getValues(range.attribute);
+        if (!ranged && values.size() <= maxValRange) {
+            result.setValues(attribute, values);
+            continue;
+        }
+
+        // Like AD: never more than maxValRange values, and the slice sent
+        // is named in the attribute ("member;range=0-1499")
+        const int low = qMin<qsizetype>(range.low, values.size());
+        int last = low + maxValRange - 1;
+        if (range.high >= 0) {
+            last = qMin(last, range.high);
+        }
+        AttributeRange sent{range.attribute, low, last >= values.size() - 1 ? -1 : last};
+        result.setValues(sent.toString(), values.mid(low, sent.isLast() ? -1 : last - low + 1));
+    }
+    result.setValue("distinguishedName", entry.getDistinguishedName());
+
+    return result;
+}
+
+QString InMemoryDirectoryBackend::generalizedTimeNow() {
+    return QDateTime::currentDateTimeUtc().toString("yyyyMMddHHmmss") + ".0Z";
+}
@@ -0,0 +1,970 @@
+#include "services/LdapDirectoryBackend.h"
+#ifdef HAVE_OPENLDAP
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <vector>
+
+namespace {
+// Active Directory's LDAP_CAP_ACTIVE_DIRECTORY_OID in supportedCapabilities
+const char* const ActiveDirectoryCapability = "1.2.840.113556.1.4.800";
+const char* const ShowDeletedControl = "1.2.840.113556.1.4.417";
+
+// Attributes with binary syntax; reported as hex, like the ADSI backend does
+const QSet<QString>& binaryAttributes() {
+    static const QSet<QString> attributes = {"objectguid", "objectsid", "msexchmailboxguid", "thumbnailphoto"};
+    return attributes;
+}
+
+DirectoryError classify(int resultCode) {
+    switch (resultCode) {
+    case LDAP_NO_SUCH_OBJECT:
+        return DirectoryError::NoSuchObject;
+    case LDAP_NO_SUCH_ATTRIBUTE:
+        return DirectoryError::NoSuchAttribute;
+    case LDAP_ALREADY_EXISTS:
+    case LDAP_TYPE_OR_VALUE_EXISTS:
+        return DirectoryError::AlreadyExists;
+    case LDAP_INSUFFICIENT_ACCESS:
+    case LDAP_INVALID_CREDENTIALS:
+    case LDAP_STRONG_AUTH_REQUIRED:
+    case LDAP_CONFIDENTIALITY_REQUIRED:
+        return DirectoryError::InsufficientRights;
+    case LDAP_BUSY:
+        return DirectoryError::Busy;
+    case LDAP_UNAVAILABLE:
+    case LDAP_SERVER_DOWN:
+    case LDAP_CONNECT_ERROR:
+        return DirectoryError::Unavailable;
+    case LDAP_TIMEOUT:
+    case LDAP_TIMELIMIT_EXCEEDED:
+        return DirectoryError::Timeout;
+    case LDAP_FILTER_ERROR:
+    case LDAP_PARAM_ERROR:
+    case LDAP_INVALID_SYNTAX:
+    case LDAP_INVALID_DN_SYNTAX:
+    case LDAP_CONSTRAINT_VIOLATION:
+    case LDAP_OBJECT_CLASS_VIOLATION:
+    case LDAP_UNDEFINED_TYPE:
+        return DirectoryError::InvalidArgument;
+    default:
+        return DirectoryError::Other;
+    }
+}
+
+int toLdapScope(SearchScope scope) {
+    switch (scope) {
+    case SearchScope::Base:
+        return LDAP_SCOPE_BASE;
+    case SearchScope::OneLevel:
+        return LDAP_SCOPE_ONELEVEL;
+    default:
+        return LDAP_SCOPE_SUBTREE;
+    }
+}
+
+// Server-side sort control (RFC 2891) for keys; null on failure or no keys
+LDAPControl* createSortControl(LDAP* ld, const QList<SortKey>& keys, bool critical) {
+    if (keys.isEmpty()) {
+        return nullptr;
+    }
+
+    // Key list string syntax: "-attr" sorts in reverse
+    QStringList parts;
+    for (const SortKey& key : keys) {
+        parts << (key.reverse ? "-" : "") + key.attribute;
+    }
+    QByteArray keyString = parts.join(' ').toUtf8();
+
+    LDAPSortKey** keyList = nullptr;
+    if (ldap_create_sort_keylist(&keyList, keyString.data()) != LDAP_SUCCESS) {
+        return nullptr;
+    }
+    LDAPControl* control = nullptr;
+    if (ldap_create_sort_control(ld, keyList, critical ? 1 : 0, &control) != LDAP_SUCCESS) {
+        control = nullptr;
+    }
+    ldap_free_sort_keylist(keyList);
+    return control;
+}
+
+struct timeval toTimeval(int ms) {
+    struct timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    return tv;
+}
+
+// NULL-terminated char* array over UTF-8 copies of the attribute names
+class AttributeList {
+public:
+    explicit AttributeList(const QStringList& attributes) {
+        for (const QString& attribute : attributes) {
+            m_names.append(attribute.toUtf8());
+        }
+        for (QByteArray& name : m_names) {
+            m_pointers.push_back(name.data());
+        }
+        m_pointers.push_back(nullptr);
+    }
+
+    // An empty list means all user attributes
+    char** get() { return m_names.isEmpty() ? nullptr : m_pointers.data(); }
+
+private:
+    QList<QByteArray> m_names;
+    std::vector<char*> m_pointers;
+};
+
+// Owns the LDAPMod array handed to ldap_add_ext / ldap_modify_ext
+class ModificationList {
+public:
+    void add(int operation, const QString& attribute, const QList<QByteArray>& values) {
+        Modification mod;
+        mod.operation = operation;
+        mod.type = attribute.toUtf8();
+        mod.values = values;
+        m_mods.push_back(mod);
+    }
+
+    void add(int operation, const QString& attribute, const QStringList& values) {
+        QList<QByteArray> encoded;
+        for (const QString& value : values) {
+            encoded.append(value.toUtf8());
+        }
+        add(operation, attribute, encoded);
+    }
+
+    bool isEmpty() const { return m_mods.empty(); }
+
+    LDAPMod** get() {
+        m_ldapMods.assign(m_mods.size(), LDAPMod());
+        m_pointers.clear();
+
+        for (size_t i = 0; i < m_mods.size(); ++i) {
+            Modification& mod = m_mods[i];
+            mod.bervals.clear();
+            mod.berPointers.clear();
+            for (QByteArray& value : mod.values) {
+                struct berval bv;
+                bv.bv_len = static_cast<ber_len_t>(value.size());
+                bv.bv_val = value.data();
+                mod.bervals.push_back(bv);
+            }
+            for (struct berval& bv : mod.bervals) {
+                mod.berPointers.push_back(&bv);
+            }
+            mod.berPointers.push_back(nullptr);
+
+            LDAPMod& ldapMod = m_ldapMods[i];
+            ldapMod.mod_op = mod.operation | LDAP_MOD_BVALUES;
+            ldapMod.mod_type = mod.type.data();
+            ldapMod.mod_bvalues = mod.values.isEmpty() ? nullptr : mod.berPointers.data();
+            m_pointers.push_back(&ldapMod);
+        }
+        m_pointers.push_back(nullptr);
+
+        return m_pointers.data();
+    }
+
+private:
+    struct Modification {
+        int operation = LDAP_MOD_REPLACE;
+        QByteArray type;
+        QList<QByteArray> values;
+        std::vector<struct berval> bervals;
+        std::vector<struct berval*> berPointers;
+    };
+
+    std::vector<Modification> m_mods;
+    std::vector<LDAPMod> m_ldapMods;
+    std::vector<LDAPMod*> m_pointers;
+};
+
+void addModifications(ModificationList& mods, const ADObjectChangeSet& changes) {
+    for (const ADObjectChangeSet::Change& change : changes.getChanges()) {
+        switch (change.operation) {
+        case ADObjectChangeSet::Operation::Replace:
+            mods.add(LDAP_MOD_REPLACE, change.attribute, change.values);
+            break;
+        case ADObjectChangeSet::Operation::Append:
+            mods.add(LDAP_MOD_ADD, change.attribute, change.values);
+            break;
+        case ADObjectChangeSet::Operation::Remove:
+            mods.add(LDAP_MOD_DELETE, change.attribute, change.values);
+            break;
+        case ADObjectChangeSet::Operation::Clear:
+            // A value-less replace clears without failing on an absent attribute
+            mods.add(LDAP_MOD_REPLACE, change.attribute, QStringList());
+            break;
+        }
+    }
+}
+}
+
+LdapDirectoryBackend::LdapDirectoryBackend(const LdapConnectionSettings& settings)
+    : m_settings(settings), m_activeDirectory(false), m_ld(nullptr) {
+}
+
+LdapDirectoryBackend::~LdapDirectoryBackend() {
+    close();
+}
+
+std::unique_ptr<IDirectoryBackend> LdapDirectoryBackend::clone() const {
+    // Same server and credentials, separate connection
+    return std::make_unique<LdapDirectoryBackend>(m_settings);
+}
+
+void LdapDirectoryBackend::setSettings(const LdapConnectionSettings& settings) {
+    m_settings = settings;
+    close();
+}
+
+bool LdapDirectoryBackend::connect(const QString& namingContext) {
+    clearError();
+    close();
+    m_namingContext = namingContext;
+
+    if (!open() || !readRootDSE()) {
+        return false;
+    }
+
+    if (m_namingContext.isEmpty()) {
+        setError(DirectoryError::NoSuchObject, "Server does not advertise a naming context");
+        return false;
+    }
+
+    return true;
+}
+
+QString LdapDirectoryBackend::effectiveUri() const {
+    if (!m_settings.uri.isEmpty()) {
+        return m_settings.uri;
+    }
+
+    // DC=example,DC=com -> ldap://example.com; AD publishes its DCs under the domain name
+    QStringList labels;
+    for (const QString& component : m_namingContext.split(',', Qt::SkipEmptyParts)) {
+        if (component.trimmed().startsWith("DC=", Qt::CaseInsensitive)) {
+            labels << component.trimmed().mid(3);
+        }
+    }
+    return labels.isEmpty() ? QString("ldap://localhost") : "ldap://" + labels.join('.');
+}
+
+bool LdapDirectoryBackend::open() {
+    if (m_ld) {
+        return true;
+    }
+
+    const QString uri = effectiveUri();
+    int rc = ldap_initialize(&m_ld, uri.toUtf8().constData());
+    if (rc != LDAP_SUCCESS) {
+        m_ld = nullptr;
+        return fail("Connect to " + uri, rc);
+    }
+
+    int version = LDAP_VERSION3;
+    ldap_set_option(m_ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+    // AD returns referrals to other partitions; chasing them rebinds anonymously
+    ldap_set_option(m_ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
+    struct timeval networkTimeout = toTimeval(m_settings.timeoutMs);
+    ldap_set_option(m_ld, LDAP_OPT_NETWORK_TIMEOUT, &networkTimeout);
+
+    if (m_settings.startTls) {
+        rc = ldap_start_tls_s(m_ld, nullptr, nullptr);
+        if (rc != LDAP_SUCCESS) {
+            close();
+            return fail("Start TLS", rc);
+        }
+    }
+
+    QByteArray bindDN = m_settings.bindDN.toUtf8();
+    QByteArray password = m_settings.password.toUtf8();
+    struct berval credentials;
+    credentials.bv_len = static_cast<ber_len_t>(password.size());
+    credentials.bv_val = password.data();
+
+    int msgid = 0;
+    rc = ldap_sasl_bind(m_ld, bindDN.isEmpty() ? nullptr : bindDN.constData(), LDAP_SASL_SIMPLE,
+                        &credentials, nullptr, nullptr, &msgid);
+    password.fill('\0');
+    if (rc != LDAP_SUCCESS) {
+        close();
+        return fail("Bind", rc);
+    }
+    if (!waitForResult("Bind", msgid)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void LdapDirectoryBackend::close() {
+    if (m_ld) {
+        ldap_unbind_ext(m_ld, nullptr, nullptr);
+        m_ld = nullptr;
+    }
+}
+
+bool LdapDirectoryBackend::readRootDSE() {
+    SearchRequest request;
+    request.baseDN = "";
+    request.scope = SearchScope::Base;
+    request.attributes = {"defaultNamingContext", "namingContexts", "supportedCapabilities"};
+
+    // The RootDSE does not take the paged results control, so read it with a plain base search
+    AttributeList attributes(request.attributes);
+    struct timeval timeout = toTimeval(m_settings.timeoutMs);
+    int msgid = 0;
+    int rc = ldap_search_ext(m_ld, "", LDAP_SCOPE_BASE, "(objectClass=*)", attributes.get(), 0,
+                             nullptr, nullptr, &timeout, 1, &msgid);
+    if (rc != LDAP_SUCCESS) {
+        return fail("Read RootDSE", rc);
+    }
+
+    DirectoryEntry rootDSE;
+    LDAPMessage* result = nullptr;
+    while ((rc = ldap_result(m_ld, msgid, LDAP_MSG_ONE, &timeout, &result)) > 0) {
+        const int type = ldap_msgtype(result);
+        if (type == LDAP_RES_SEARCH_ENTRY) {
+            rootDSE = toEntry(result);
+        }
+        ldap_msgfree(result);
+        if (type == LDAP_RES_SEARCH_RESULT) {
+            break;
+        }
+    }
+    if (rc <= 0) {
+        return fail("Read RootDSE", rc == 0 ? LDAP_TIMEOUT : rc);
+    }
+
+    m_activeDirectory = rootDSE.getValues("supportedCapabilities").contains(ActiveDirectoryCapability);
+
+    if (m_namingContext.isEmpty()) {
+        // slapd has no defaultNamingContext; fall back to its first database suffix
+        m_namingContext = rootDSE.getValue("defaultNamingContext");
+        if (m_namingContext.isEmpty()) {
+            m_namingContext = rootDSE.getValue("namingContexts");
+        }
+    }
+
+    return true;
+}
+
+bool LdapDirectoryBackend::search(const SearchRequest& request, const SearchPageCallback& onPage) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    const int scope = toLdapScope(request.scope);
+    const QByteArray base = request.baseDN.toUtf8();
+    const QByteArray filter = request.filter.toUtf8();
+    AttributeList attributes(request.attributes);
+    struct timeval timeout = toTimeval(m_settings.timeoutMs);
+    const int pageSize = request.pageSize > 0 ? request.pageSize : 1000;
+
+    // Sorted by the server when asked; not critical, so a server without
+    // the control still answers, in its own order
+    LDAPControl* sortControl = createSortControl(m_ld, request.sortKeys, false);
+
+    // Simple paged results (RFC 2696): one request per page, resumed with the cookie
+    struct berval cookie = {0, nullptr};
+    bool more = true;
+    bool ok = true;
+
+    while (more && ok) {
+        LDAPControl* pageControl = nullptr;
+        int rc = ldap_create_page_control(m_ld, pageSize, cookie.bv_val ? &cookie : nullptr, 0, &pageControl);
+        if (cookie.bv_val) {
+            ldap_memfree(cookie.bv_val);
+            cookie.bv_val = nullptr;
+            cookie.bv_len = 0;
+        }
+        if (rc != LDAP_SUCCESS) {
+            ldap_control_free(sortControl);
+            return fail("Search", rc);
+        }
+
+        // AD only returns tombstones with the Show Deleted control; other
+        // servers ignore it since it is not critical
+        LDAPControl showDeleted;
+        showDeleted.ldctl_oid = const_cast<char*>(ShowDeletedControl);
+        showDeleted.ldctl_value.bv_len = 0;
+        showDeleted.ldctl_value.bv_val = nullptr;
+        showDeleted.ldctl_iscritical = 0;
+
+        LDAPControl* serverControls[] = {pageControl, nullptr, nullptr, nullptr};
+        int controlCount = 1;
+        if (sortControl) {
+            serverControls[controlCount++] = sortControl;
+        }
+        if (request.includeDeleted) {
+            serverControls[controlCount++] = &showDeleted;
+        }
+        int msgid = 0;
+        rc = ldap_search_ext(m_ld, base.constData(), scope, filter.constData(), attributes.get(), 0,
+                             serverControls, nullptr, &timeout, request.sizeLimit, &msgid);
+        ldap_control_free(pageControl);
+        if (rc != LDAP_SUCCESS) {
+            ldap_control_free(sortControl);
+            return fail("Search", rc);
+        }
+
+        QList<DirectoryEntry> page;
+        page.reserve(pageSize);
+        more = false;
+
+        LDAPMessage* result = nullptr;
+        bool done = false;
+        while (!done) {
+            rc = ldap_result(m_ld, msgid, LDAP_MSG_ONE, &timeout, &result);
+            if (rc <= 0) {
+                ldap_abandon_ext(m_ld, msgid, nullptr, nullptr);
+                ldap_control_free(sortControl);
+                return fail("Search", rc == 0 ? LDAP_TIMEOUT : rc);
+            }
+
+            switch (ldap_msgtype(result)) {
+            case LDAP_RES_SEARCH_ENTRY:
+                page.append(toEntry(result));
+                break;
+
+            case LDAP_RES_SEARCH_RESULT: {
+                int resultCode = LDAP_SUCCESS;
+                char* diagnostic = nullptr;
+                LDAPControl** controls = nullptr;
+                ldap_parse_result(m_ld, result, &resultCode, nullptr, &diagnostic, nullptr, &controls, 0);
+
+                if (resultCode != LDAP_SUCCESS &&
+                    !(resultCode == LDAP_SIZELIMIT_EXCEEDED && request.sizeLimit > 0)) {
+                    ok = fail("Search", resultCode, diagnostic ? QString::fromUtf8(diagnostic) : QString());
+                } else if (controls) {
+                    LDAPControl* response = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, controls, nullptr);
+                    ber_int_t estimate = 0;
+                    if (response && ldap_parse_pageresponse_control(m_ld, response, &estimate, &cookie) == LDAP_SUCCESS) {
+                        more = cookie.bv_val && cookie.bv_len > 0;
+                    }
+                }
+
+                if (diagnostic) {
+                    ldap_memfree(diagnostic);
+                }
+                if (controls) {
+                    ldap_controls_free(controls);
+                }
+                done = true;
+                break;
+            }
+
+            default:
+                // Continuation references point at other partitions; not followed
+                break;
+            }
+
+            ldap_msgfree(result);
+        }
+
+        if (ok && !page.isEmpty() && !onPage(page)) {
+            more = false;
+        }
+    }
+
+    if (cookie.bv_val) {
+        ldap_memfree(cookie.bv_val);
+    }
+    ldap_control_free(sortControl);
+
+    return ok;
+}
+
+bool LdapDirectoryBackend::searchWindow(const SearchRequest& request, const VlvWindow& window,
+                                        QList<DirectoryEntry>& entries, VlvResult& result) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    // VLV only works on a sorted result, so here the sort must be honoured
+    LDAPControl* sortControl = createSortControl(m_ld, request.sortKeys, true);
+    if (!sortControl) {
+        setError(DirectoryError::InvalidArgument,
+                 request.sortKeys.isEmpty() ? "A window search needs sort keys" : "Invalid sort keys");
+        return false;
+    }
+
+    struct berval context = {static_cast<ber_len_t>(window.context.size()),
+                             const_cast<char*>(window.context.constData())};
+    LDAPVLVInfo vlv;
+    vlv.ldvlv_version = 1;
+    vlv.ldvlv_before_count = window.beforeCount;
+    vlv.ldvlv_after_count = window.afterCount;
+    vlv.ldvlv_offset = window.offset;
+    vlv.ldvlv_count = window.contentCount;
+    vlv.ldvlv_attrvalue = nullptr;
+    vlv.ldvlv_context = window.context.isEmpty() ? nullptr : &context;
+    vlv.ldvlv_extradata = nullptr;
+
+    LDAPControl* vlvControl = nullptr;
+    int rc = ldap_create_vlv_control(m_ld, &vlv, &vlvControl);
+    if (rc != LDAP_SUCCESS) {
+        ldap_control_free(sortControl);
+        return fail("Window search", rc);
+    }
+
+    const QByteArray base = request.baseDN.toUtf8();
+    const QByteArray filter = request.filter.toUtf8();
+    AttributeList attributes(request.attributes);
+    struct timeval timeout = toTimeval(m_settings.timeoutMs);
+
+    LDAPControl* serverControls[] = {sortControl, vlvControl, nullptr};
+    int msgid = 0;
+    rc = ldap_search_ext(m_ld, base.constData(), toLdapScope(request.scope), filter.constData(), attributes.get(), 0,
+                         serverControls, nullptr, &timeout, request.sizeLimit, &msgid);
+    ldap_control_free(sortControl);
+    ldap_control_free(vlvControl);
+    if (rc != LDAP_SUCCESS) {
+        return fail("Window search", rc);
+    }
+
+    QList<DirectoryEntry> rows;
+    bool ok = true;
+    bool supported = true;
+    bool done = false;
+    while (!done) {
+        LDAPMessage* message = nullptr;
+        rc = ldap_result(m_ld, msgid, LDAP_MSG_ONE, &timeout, &message);
+        if (rc <= 0) {
+            ldap_abandon_ext(m_ld, msgid, nullptr, nullptr);
+            return fail("Window search", rc == 0 ? LDAP_TIMEOUT : rc);
+        }
+
+        switch (ldap_msgtype(message)) {
+        case LDAP_RES_SEARCH_ENTRY:
+            rows.append(toEntry(message));
+            break;
+
+        case LDAP_RES_SEARCH_RESULT: {
+            int resultCode = LDAP_SUCCESS;
+            char* diagnostic = nullptr;
+            LDAPControl** controls = nullptr;
+            ldap_parse_result(m_ld, message, &resultCode, nullptr, &diagnostic, nullptr, &controls, 0);
+
+            LDAPControl* response = controls ? ldap_control_find(LDAP_CONTROL_VLVRESPONSE, controls, nullptr) : nullptr;
+            if (resultCode == LDAP_UNAVAILABLE_CRITICAL_EXTENSION || (resultCode == LDAP_SUCCESS && !response)) {
+                supported = false;
+            } else if (resultCode != LDAP_SUCCESS) {
+                ok = fail("Window search", resultCode, diagnostic ? QString::fromUtf8(diagnostic) : QString());
+            } else {
+                ber_int_t target = 0;
+                ber_int_t count = 0;
+                ber_int_t vlvResult = LDAP_SUCCESS;
+                struct berval* contextOut = nullptr;
+                rc = ldap_parse_vlvresponse_control(m_ld, response, &target, &count, &contextOut, &vlvResult);
+                if (rc != LDAP_SUCCESS || vlvResult != LDAP_SUCCESS) {
+                    ok = fail("Window search", rc != LDAP_SUCCESS ? rc : vlvResult);
+                } else {
+                    result.targetPosition = target;
+                    result.contentCount = count;
+                    result.context = contextOut ? QByteArray(contextOut->bv_val, static_cast<int>(contextOut->bv_len))
+                                                : QByteArray();
+                }
+                if (contextOut) {
+                    ber_bvfree(contextOut);
+                }
+            }
+
+            if (diagnostic) {
+                ldap_memfree(diagnostic);
+            }
+            if (controls) {
+                ldap_controls_free(controls);
+            }
+            done = true;
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        ldap_msgfree(message);
+    }
+
+    // Servers without VLV (slapd lacking the sssvlv overlay) get the
+    // client-side fallback
+    if (!supported) {
+        return IDirectoryBackend::searchWindow(request, window, entries, result);
+    }
+
+    if (ok) {
+        entries.append(rows);
+    }
+    return ok;
+}
+
+bool LdapDirectoryBackend::readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) {
+    QList<DirectoryEntry> entries;
+    if (!readEntries({dn}, attributes, entries)) {
+        return false;
+    }
+
+    if (entries.isEmpty()) {
+        setError(DirectoryError::NoSuchObject, QString("Object %1 does not exist").arg(dn));
+        return false;
+    }
+
+    entry = entries.first();
+    return true;
+}
+
+bool LdapDirectoryBackend::readEntries(const QStringList& dns, const QStringList& attributes,
+                                       QList<DirectoryEntry>& entries) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    AttributeList attributeList(attributes);
+    struct timeval timeout = toTimeval(m_settings.timeoutMs);
+    const int maxOutstanding = qMax(1, m_settings.maxOutstanding);
+
+    QVector<DirectoryEntry> results(dns.size());
+    QVector<bool> found(dns.size(), false);
+    QHash<int, int> pending; // msgid -> index into dns
+    int next = 0;
+
+    auto abandonPending = [this, &pending]() {
+        for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            ldap_abandon_ext(m_ld, it.key(), nullptr, nullptr);
+        }
+    };
+
+    // Keep up to maxOutstanding base searches in flight and match the
+    // responses back by message id as they arrive
+    while (next < dns.size() || !pending.isEmpty()) {
+        while (next < dns.size() && pending.size() < maxOutstanding) {
+            int msgid = 0;
+            int rc = ldap_search_ext(m_ld, dns[next].toUtf8().constData(), LDAP_SCOPE_BASE, "(objectClass=*)",
+                                     attributeList.get(), 0, nullptr, nullptr, &timeout, 1, &msgid);
+            if (rc != LDAP_SUCCESS) {
+                abandonPending();
+                return fail("Read entry", rc);
+            }
+            pending.insert(msgid, next++);
+        }
+
+        LDAPMessage* result = nullptr;
+        int rc = ldap_result(m_ld, LDAP_RES_ANY, LDAP_MSG_ONE, &timeout, &result);
+        if (rc <= 0) {
+            abandonPending();
+            return fail("Read entry", rc == 0 ? LDAP_TIMEOUT : rc);
+        }
+
+        auto it = pending.find(ldap_msgid(result));
+        if (it != pending.end()) {
+            const int type = ldap_msgtype(result);
+            if (type == LDAP_RES_SEARCH_ENTRY) {
+                results[it.value()] = toEntry(result);
+                found[it.value()] = true;
+            } else if (type == LDAP_RES_SEARCH_RESULT) {
+                int resultCode = LDAP_SUCCESS;
+                ldap_parse_result(m_ld, result, &resultCode, nullptr, nullptr, nullptr, nullptr, 0);
+                pending.erase(it);
+
+                // A missing entry is not an error for a batch read
+                if (resultCode != LDAP_SUCCESS && resultCode != LDAP_NO_SUCH_OBJECT) {
+                    ldap_msgfree(result);
+                    abandonPending();
+                    return fail("Read entry", resultCode);
+                }
+            }
+        }
+        ldap_msgfree(result);
+    }
+
+    for (int i = 0; i < results.size(); ++i) {
+        if (found[i]) {
+            entries.append(results[i]);
+        }
+    }
+
+    return true;
+}
+
+bool LdapDirectoryBackend::entryExists(const QString& dn) {
+    DirectoryEntry entry;
+    if (readEntry(dn, {"1.1"}, entry)) {
+        return true;
+    }
+
+    if (lastError() == DirectoryError::NoSuchObject) {
+        clearError();
+    }
+    return false;
+}
+
+bool LdapDirectoryBackend::addEntry(const DirectoryEntry& entry) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    ModificationList mods;
+    for (const QString& attribute : entry.getAttributeNames()) {
+        if (attribute == "distinguishedname") {
+            continue;
+        }
+        mods.add(LDAP_MOD_ADD, attribute, entry.getValues(attribute));
+    }
+
+    int msgid = 0;
+    int rc = ldap_add_ext(m_ld, entry.getDistinguishedName().toUtf8().constData(), mods.get(),
+                          nullptr, nullptr, &msgid);
+    if (rc != LDAP_SUCCESS) {
+        return fail("Create object", rc);
+    }
+
+    return waitForResult("Create object", msgid);
+}
+
+bool LdapDirectoryBackend::modifyEntry(const ADObjectChangeSet& changes) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    ModificationList mods;
+    addModifications(mods, changes);
+    if (mods.isEmpty()) {
+        return true;
+    }
+
+    int msgid = 0;
+    int rc = ldap_modify_ext(m_ld, changes.getDistinguishedName().toUtf8().constData(), mods.get(),
+                             nullptr, nullptr, &msgid);
+    if (rc != LDAP_SUCCESS) {
+        return fail("Commit changes", rc);
+    }
+
+    return waitForResult("Commit changes", msgid);
+}
+
+bool LdapDirectoryBackend::modifyEntries(const QList<ADObjectChangeSet>& changes,
+                                         QList<DirectoryWriteResult>& results) {
+    clearError();
+    results.clear();
+    if (!open()) {
+        return false;
+    }
+    results.resize(changes.size());
+
+    struct timeval timeout = toTimeval(m_settings.timeoutMs);
+    const int maxOutstanding = qMax(1, m_settings.maxOutstanding);
+
+    QHash<int, int> pending; // msgid -> index into changes
+    int next = 0;
+
+    // Ends the batch: requests sent but not answered fail with its error,
+    // as they may or may not have been applied; those not sent yet get no
+    // result
+    auto failBatch = [&](int resultCode) {
+        for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            ldap_abandon_ext(m_ld, it.key(), nullptr, nullptr);
+        }
+        fail("Commit changes", resultCode);
+
+        const DirectoryWriteResult failed{lastError(), lastErrorMessage()};
+        for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            results[it.value()] = failed;
+        }
+        results.resize(next);
+        return false;
+    };
+
+    // As in readEntries: up to maxOutstanding modifies in flight, the
+    // responses matched back by message id. A rejected modify fails only
+    // its own change set
+    while (next < changes.size() || !pending.isEmpty()) {
+        while (next < changes.size() && pending.size() < maxOutstanding) {
+            ModificationList mods;
+            addModifications(mods, changes[next]);
+            if (mods.isEmpty()) {
+                ++next;
+                continue;
+            }
+
+            int msgid = 0;
+            int rc = ldap_modify_ext(m_ld, changes[next].getDistinguishedName().toUtf8().constData(), mods.get(),
+                                     nullptr, nullptr, &msgid);
+            if (rc != LDAP_SUCCESS) {
+                return failBatch(rc);
+            }
+            pending.insert(msgid, next++);
+        }
+
+        if (pending.isEmpty()) {
+            break;
+        }
+
+        LDAPMessage* result = nullptr;
+        int rc = ldap_result(m_ld, LDAP_RES_ANY, LDAP_MSG_ALL, &timeout, &result);
+        if (rc <= 0) {
+            return failBatch(rc == 0 ? LDAP_TIMEOUT : rc);
+        }
+
+        auto it = pending.find(ldap_msgid(result));
+        if (it != pending.end()) {
+            int resultCode = LDAP_SUCCESS;
+            char* diagnostic = nullptr;
+            ldap_parse_result(m_ld, result, &resultCode, nullptr, &diagnostic, nullptr, nullptr, 0);
+
+            const QString message = diagnostic ? QString::fromUtf8(diagnostic) : QString();
+            if (diagnostic) {
+                ldap_memfree(diagnostic);
+            }
+
+            if (resultCode != LDAP_SUCCESS) {
+                fail("Commit changes", resultCode, message);
+                results[it.value()] = DirectoryWriteResult{lastError(), lastErrorMessage()};
+            }
+            pending.erase(it);
+        }
+        ldap_msgfree(result);
+    }
+
+    clearError();
+    return true;
+}
+
+bool LdapDirectoryBackend::deleteEntry(const QString& dn) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    int msgid = 0;
+    int rc = ldap_delete_ext(m_ld, dn.toUtf8().constData(), nullptr, nullptr, &msgid);
+    if (rc != LDAP_SUCCESS) {
+        return fail("Delete object", rc);
+    }
+
+    return waitForResult("Delete object", msgid);
+}
+
+bool LdapDirectoryBackend::setPassword(const QString& dn, const QString& password) {
+    clearError();
+    if (!open()) {
+        return false;
+    }
+
+    int msgid = 0;
+    int rc = LDAP_SUCCESS;
+
+    if (m_activeDirectory) {
+        // AD takes the quoted password as UTF-16LE in unicodePwd; the DC
+        // only accepts this over an encrypted connection
+        const QString quoted = "\"" + password + "\"";
+        QByteArray encoded(reinterpret_cast<const char*>(quoted.utf16()), quoted.size() * 2);
+
+        ModificationList mods;
+        mods.add(LDAP_MOD_REPLACE, "unicodePwd", QList<QByteArray>{encoded});
+        rc = ldap_modify_ext(m_ld, dn.toUtf8().constData(), mods.get(), nullptr, nullptr, &msgid);
+        encoded.fill('\0');
+    } else {
+        // Other servers: Password Modify extended operation (RFC 3062)
+        QByteArray user = dn.toUtf8();
+        QByteArray secret = password.toUtf8();
+        struct berval userBv = {static_cast<ber_len_t>(user.size()), user.data()};
+        struct berval secretBv = {static_cast<ber_len_t>(secret.size()), secret.data()};
+        rc = ldap_passwd(m_ld, &userBv, nullptr, &secretBv, nullptr, nullptr, &msgid);
+        secret.fill('\0');
+    }
+
+    if (rc != LDAP_SUCCESS) {
+        return fail("Set password", rc);
+    }
+
+    return waitForResult("Set password", msgid);
+}
+
+bool LdapDirectoryBackend::waitForResult(const QString& operation, int msgid) {
+    struct timeval timeout = toTimeval(m_settings.timeoutMs);
+    LDAPMessage* result = nullptr;
+
+    int rc = ldap_result(m_ld, msgid, LDAP_MSG_ALL, &timeout, &result);
+    if (rc <= 0) {
+        ldap_abandon_ext(m_ld, msgid, nullptr, nullptr);
+        return fail(operation, rc == 0 ? LDAP_TIMEOUT : rc);
+    }
+
+    int resultCode = LDAP_SUCCESS;
+    char* diagnostic = nullptr;
+    ldap_parse_result(m_ld, result, &resultCode, nullptr, &diagnostic, nullptr, nullptr, 1);
+
+    const QString message = diagnostic ? QString::fromUtf8(diagnostic) : QString();
+    if (diagnostic) {
+        ldap_memfree(diagnostic);
+    }
+
+    if (resultCode != LDAP_SUCCESS) {
+        return fail(operation, resultCode, message);
+    }
+    return true;
+}
+
+DirectoryEntry LdapDirectoryBackend::toEntry(LDAPMessage* message) {
+    char* dn = ldap_get_dn(m_ld, message);
+    DirectoryEntry entry(dn ? QString::fromUtf8(dn) : QString());
+    if (dn) {
+        ldap_memfree(dn);
+    }
+
+    BerElement* ber = nullptr;
+    for (char* attribute = ldap_first_attribute(m_ld, message, &ber); attribute;
+         attribute = ldap_next_attribute(m_ld, message, ber)) {
+        const QString name = QString::fromUtf8(attribute);
+        const bool binary = binaryAttributes().contains(name.toLower());
+
+        QStringList values;
+        struct berval** bervals = ldap_get_values_len(m_ld, message, attribute);
+        for (int i = 0; bervals && bervals[i]; ++i) {
+            const QByteArray raw(bervals[i]->bv_val, static_cast<int>(bervals[i]->bv_len));
+            values << (binary ? QString::fromLatin1(raw.toHex()) : QString::fromUtf8(raw));
+        }
+        if (bervals) {
+            ldap_value_free_len(bervals);
+        }
+
+        entry.setValues(name, values);
+        ldap_memfree(attribute);
+    }
+    if (ber) {
+        ber_free(ber, 0);
+    }
+
+    if (!entry.hasAttribute("distinguishedName")) {
+        entry.setValue("distinguishedName", entry.getDistinguishedName());
+    }
+
+    return entry;
+}
+
+bool LdapDirectoryBackend::fail(const QString& operation, int resultCode, const QString& diagnostic) {
+    QString message = QString("%1: %2").arg(operation, QString::fromUtf8(ldap_err2string(resultCode)));
+    if (!diagnostic.isEmpty()) {
+        message += " (" + diagnostic + ")";
+    }
+
+    setError(classify(resultCode), message, resultCode);
+
+    // The connection is gone; the next call reconnects
+    if (resultCode == LDAP_SERVER_DOWN || resultCode == LDAP_CONNECT_ERROR) {
+        close();
+    }
+
+    return false;
+}
+#endif
@@ -0,0 +1,107 @@
+#include "services/LoginIndex.h"
+#include <QMutexLocker>
+
+LoginIndex::LoginIndex(int maxAgeMs)
+    : m_maxAgeMs(maxAgeMs) {
+    m_clock.start();
+}
+
+void LoginIndex::setMaxAge(int maxAgeMs) {
+    QMutexLocker locker(&m_mutex);
+    m_maxAgeMs = maxAgeMs;
+}
+
+bool LoginIndex::isLoaded(const QString& base) const {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_bases.constFind(base.toLower());
+    return it != m_bases.constEnd() && m_clock.elapsed() - it->loadedMs < m_maxAgeMs;
+}
+
+void LoginIndex::load(const QString& base, const QStringList& logins) {
+    Base entry;
+    for (const QString& login : logins) {
+        quint32 suffix = 0;
+        if (suffixOf(login, base, suffix)) {
+            entry.suffixes.insert(suffix);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    entry.loadedMs = m_clock.elapsed();
+    m_bases.insert(base.toLower(), entry);
+}
+
+void LoginIndex::noteTaken(const QString& login) {
+    QMutexLocker locker(&m_mutex);
+
+    // Every split into base + trailing digits may name a loaded base:
+    // "IPetrenko12" belongs to IPetrenko12, IPetrenko1 and IPetrenko
+    int split = login.length();
+    while (split > 0) {
+        auto it = m_bases.find(login.left(split).toLower());
+        quint32 suffix = 0;
+        if (it != m_bases.end() && suffixOf(login, login.left(split), suffix)) {
+            it->suffixes.insert(suffix);
+        }
+
+        if (login[split - 1] < '0' || login[split - 1] > '9') {
+            break;
+        }
+        --split;
+    }
+}
+
+void LoginIndex::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_bases.clear();
+}
+
+std::set<quint32> LoginIndex::takenSuffixes(const QString& base) const {
+    QMutexLocker locker(&m_mutex);
+    return m_bases.value(base.toLower()).suffixes;
+}
+
+QString LoginIndex::lowestFree(const QString& base) const {
+    return loginFor(base, lowestFreeSuffix(takenSuffixes(base)));
+}
+
+QString LoginIndex::loginFor(const QString& base, quint32 suffix) {
+    return suffix == 0 ? base : base + QString::number(suffix);
+}
+
+quint32 LoginIndex::lowestFreeSuffix(const std::set<quint32>& taken) {
+    // The set is sorted, so the first gap is the answer
+    quint32 candidate = 0;
+    for (quint32 suffix : taken) {
+        if (suffix != candidate) {
+            break;
+        }
+        ++candidate;
+    }
+    return candidate;
+}
+
+bool LoginIndex::suffixOf(const QString& login, const QString& base, quint32& suffix) {
+    if (!login.startsWith(base, Qt::CaseInsensitive)) {
+        return false;
+    }
+
+    const QString rest = login.mid(base.length());
+    if (rest.isEmpty()) {
+        suffix = 0;
+        return true;
+    }
+
+    if (rest[0] == '0') {
+        return false;
+    }
+    for (const QChar c : rest) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+
+    bool ok = false;
+    suffix = rest.toUInt(&ok);
+    return ok;
+}
@@ -0,0 +1,220 @@
+#include "services/OperationMetrics.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QtMath>
+
+namespace {
+int highestBit(quint64 value) {
+    int bit = -1;
+    while (value) {
+        value >>= 1;
+        ++bit;
+    }
+    return bit;
+}
+
+QString seconds(qint64 micros) {
+    return QString::number(micros / 1e6, 'g', 9);
+}
+}
+
+int LatencyHistogram::bucketIndex(qint64 micros) {
+    const quint64 value = quint64(qBound<qint64>(0, micros, (qint64(1) << (MaxExponent + 1)) - 1));
+    if (value < quint64(SubBuckets)) {
+        return int(value);
+    }
+
+    // The top SubBucketBits + 1 bits of the value select the bucket
+    const int exponent = highestBit(value);
+    const int shift = exponent - SubBucketBits;
+    return shift * SubBuckets + int(value >> shift);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index) {
+    if (index < 2 * SubBuckets) {
+        return index;
+    }
+
+    const int shift = index / SubBuckets - 1;
+    const qint64 mantissa = index % SubBuckets + SubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 micros, bool failed) {
+    micros = qMax<qint64>(0, micros);
+    m_buckets[bucketIndex(micros)].fetchAndAddRelaxed(1);
+    m_sumUs.fetchAndAddRelaxed(micros);
+    if (failed) {
+        m_errors.fetchAndAddRelaxed(1);
+    }
+
+    qint64 max = m_maxUs.loadRelaxed();
+    while (micros > max && !m_maxUs.testAndSetRelaxed(max, micros, max)) {
+    }
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    // Buckets are read one by one while others may record; the summary is
+    // consistent with the bucket counts it read
+    std::array<quint64, BucketCount> counts;
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        counts[i] = m_buckets[i].loadRelaxed();
+        total += counts[i];
+    }
+
+    LatencySummary summary;
+    summary.count = total;
+    summary.errors = qMin(m_errors.loadRelaxed(), total);
+    summary.sumUs = m_sumUs.loadRelaxed();
+    summary.maxUs = m_maxUs.loadRelaxed();
+    if (total == 0) {
+        return summary;
+    }
+
+    // Each percentile is the upper bound of the bucket holding that rank,
+    // capped by the largest value actually seen
+    const double quantiles[] = {0.50, 0.90, 0.99};
+    qint64* targets[] = {&summary.p50Us, &summary.p90Us, &summary.p99Us};
+    int next = 0;
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount && next < 3; ++i) {
+        seen += counts[i];
+        while (next < 3 && seen >= quint64(qCeil(quantiles[next] * total))) {
+            *targets[next++] = qMin(bucketUpperBound(i), summary.maxUs);
+        }
+    }
+
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (QAtomicInteger<quint64>& bucket : m_buckets) {
+        bucket.storeRelaxed(0);
+    }
+    m_errors.storeRelaxed(0);
+    m_sumUs.storeRelaxed(0);
+    m_maxUs.storeRelaxed(0);
+}
+
+OperationMetrics& OperationMetrics::global() {
+    static OperationMetrics instance;
+    return instance;
+}
+
+QString OperationMetrics::operationName(DirectoryOperation operation) {
+    switch (operation) {
+    case DirectoryOperation::Bind: return "bind";
+    case DirectoryOperation::Search: return "search";
+    case DirectoryOperation::GetServerList: return "get_server_list";
+    case DirectoryOperation::GetServerInfo: return "get_server_info";
+    case DirectoryOperation::CreateServer: return "create_server";
+    case DirectoryOperation::GetUsers: return "get_users";
+    case DirectoryOperation::GetUser: return "get_user";
+    case DirectoryOperation::CreateUser: return "create_user";
+    case DirectoryOperation::Modify: return "modify";
+    case DirectoryOperation::SetPassword: return "set_password";
+    case DirectoryOperation::GetAttribute: return "get_attribute";
+    case DirectoryOperation::SetAttribute: return "set_attribute";
+    case DirectoryOperation::ExistsCheck: return "exists_check";
+    case DirectoryOperation::SyncReplica: return "sync_replica";
+    case DirectoryOperation::AllocateLogin: return "allocate_login";
+    case DirectoryOperation::Count: break;
+    }
+    return QString();
+}
+
+void OperationMetrics::record(DirectoryOperation operation, qint64 micros, bool failed) {
+    m_histograms[int(operation)].record(micros, failed);
+}
+
+LatencySummary OperationMetrics::summary(DirectoryOperation operation) const {
+    return m_histograms[int(operation)].summary();
+}
+
+void OperationMetrics::reset() {
+    for (LatencyHistogram& histogram : m_histograms) {
+        histogram.reset();
+    }
+}
+
+QByteArray OperationMetrics::toPrometheus() const {
+    QString text;
+    text += "# HELP admanager_operation_duration_seconds Latency of ADManager operations.\n";
+    text += "# TYPE admanager_operation_duration_seconds summary\n";
+
+    QList<LatencySummary> summaries;
+    for (int i = 0; i < int(DirectoryOperation::Count); ++i) {
+        summaries.append(m_histograms[i].summary());
+    }
+
+    for (int i = 0; i < summaries.size(); ++i) {
+        const QString label = QString("operation=\"%1\"").arg(operationName(DirectoryOperation(i)));
+        const LatencySummary& s = summaries[i];
+        text += QString("admanager_operation_duration_seconds{%1,quantile=\"0.5\"} %2\n").arg(label, seconds(s.p50Us));
+        text += QString("admanager_operation_duration_seconds{%1,quantile=\"0.9\"} %2\n").arg(label, seconds(s.p90Us));
+        text += QString("admanager_operation_duration_seconds{%1,quantile=\"0.99\"} %2\n").arg(label, seconds(s.p99Us));
+        text += QString("admanager_operation_duration_seconds_sum{%1} %2\n").arg(label, seconds(s.sumUs));
+        text += QString("admanager_operation_duration_seconds_count{%1} %2\n").arg(label).arg(s.count);
+    }
+
+    text += "# HELP admanager_operation_errors_total ADManager operations that reported an error.\n";
+    text += "# TYPE admanager_operation_errors_total counter\n";
+    for (int i = 0; i < summaries.size(); ++i) {
+        text += QString("admanager_operation_errors_total{operation=\"%1\"} %2\n")
+                    .arg(operationName(DirectoryOperation(i))).arg(summaries[i].errors);
+    }
+
+    text += "# HELP admanager_operation_max_duration_seconds Slowest ADManager operation since start.\n";
+    text += "# TYPE admanager_operation_max_duration_seconds gauge\n";
+    for (int i = 0; i < summaries.size(); ++i) {
+        text += QString("admanager_operation_max_duration_seconds{operation=\"%1\"} %2\n")
+                    .arg(operationName(DirectoryOperation(i)), seconds(summaries[i].maxUs));
+    }
+
+    return text.toUtf8();
+}
+
+QByteArray OperationMetrics::toJson() const {
+    QJsonArray operations;
+    for (int i = 0; i < int(DirectoryOperation::Count); ++i) {
+        const LatencySummary s = m_histograms[i].summary();
+        QJsonObject operation;
+        operation["name"] = operationName(DirectoryOperation(i));
+        operation["count"] = double(s.count);
+        operation["errors"] = double(s.errors);
+        operation["sum_us"] = double(s.sumUs);
+        operation["p50_us"] = double(s.p50Us);
+        operation["p90_us"] = double(s.p90Us);
+        operation["p99_us"] = double(s.p99Us);
+        operation["max_us"] = double(s.maxUs);
+        operations.append(operation);
+    }
+
+    QJsonObject root;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
+    root["operations"] = operations;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool OperationMetrics::writeToFile(const QString& fileName, Format format, QString* error) const {
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    file.write(format == Format::Json ? toJson() : toPrometheus());
+    if (!file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,365 @@
+#include "services/ResilientDirectoryBackend.h"
+#include <QHash>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QThread>
+#include <algorithm>
+
+std::shared_ptr<CircuitBreaker> CircuitBreaker::forEndpoint(const QString& endpoint) {
+    // One breaker per endpoint for the process lifetime; there are few
+    static QMutex registryMutex;
+    static QHash<QString, std::shared_ptr<CircuitBreaker>> registry;
+
+    QMutexLocker locker(&registryMutex);
+    std::shared_ptr<CircuitBreaker>& breaker = registry[endpoint.toLower()];
+    if (!breaker) {
+        breaker = std::make_shared<CircuitBreaker>();
+    }
+    return breaker;
+}
+
+bool CircuitBreaker::allowRequest(const RetryPolicy& policy, int* retryAfterMs) {
+    QMutexLocker locker(&m_mutex);
+    switch (m_state) {
+    case State::Closed:
+        return true;
+
+    case State::Open: {
+        const qint64 remaining = policy.breakerCooldownMs - m_openedAt.elapsed();
+        if (remaining <= 0) {
+            // Cooldown over: this request is the probe
+            m_state = State::HalfOpen;
+            m_probeInFlight = true;
+            return true;
+        }
+        if (retryAfterMs) {
+            *retryAfterMs = int(remaining);
+        }
+        m_stats.rejected++;
+        return false;
+    }
+
+    case State::HalfOpen:
+        // Everyone else waits for the probe's outcome
+        if (retryAfterMs) {
+            *retryAfterMs = 0;
+        }
+        m_stats.rejected++;
+        return false;
+    }
+
+    return true;
+}
+
+void CircuitBreaker::recordSuccess() {
+    QMutexLocker locker(&m_mutex);
+    m_consecutiveFailures = 0;
+    m_probeInFlight = false;
+    m_state = State::Closed;
+}
+
+void CircuitBreaker::recordFailure(const RetryPolicy& policy) {
+    QMutexLocker locker(&m_mutex);
+    m_consecutiveFailures++;
+
+    const bool probeFailed = m_state == State::HalfOpen && m_probeInFlight;
+    if (probeFailed || (m_state == State::Closed && m_consecutiveFailures >= qMax(1, policy.breakerThreshold))) {
+        m_state = State::Open;
+        m_probeInFlight = false;
+        m_openedAt.start();
+        m_stats.circuitOpened++;
+    }
+}
+
+void CircuitBreaker::recordRetry() {
+    QMutexLocker locker(&m_mutex);
+    m_stats.retries++;
+}
+
+void CircuitBreaker::recordOutcome(bool recovered) {
+    QMutexLocker locker(&m_mutex);
+    if (recovered) {
+        m_stats.recovered++;
+    } else {
+        m_stats.exhausted++;
+    }
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    QMutexLocker locker(&m_mutex);
+    return m_state;
+}
+
+RetryStats CircuitBreaker::stats() const {
+    QMutexLocker locker(&m_mutex);
+    RetryStats stats = m_stats;
+    stats.circuitOpen = m_state != State::Closed;
+    return stats;
+}
+
+ResilientDirectoryBackend::ResilientDirectoryBackend(std::unique_ptr<IDirectoryBackend> inner,
+                                                     const RetryPolicy& policy)
+    : m_inner(std::move(inner)), m_policy(policy) {
+}
+
+std::unique_ptr<IDirectoryBackend> ResilientDirectoryBackend::clone() const {
+    return std::make_unique<ResilientDirectoryBackend>(m_inner->clone(), m_policy);
+}
+
+RetryStats ResilientDirectoryBackend::stats() {
+    return breaker().stats();
+}
+
+bool ResilientDirectoryBackend::isTransient(DirectoryError error) {
+    return error == DirectoryError::Busy || error == DirectoryError::Unavailable ||
+           error == DirectoryError::Timeout;
+}
+
+bool ResilientDirectoryBackend::isAlreadyApplied(const ADObjectChangeSet& changes, DirectoryError error) {
+    ADObjectChangeSet::Operation only;
+    if (error == DirectoryError::AlreadyExists) {
+        only = ADObjectChangeSet::Operation::Append;
+    } else if (error == DirectoryError::NoSuchAttribute) {
+        only = ADObjectChangeSet::Operation::Remove;
+    } else {
+        return false;
+    }
+
+    return !changes.isEmpty() &&
+           std::all_of(changes.getChanges().cbegin(), changes.getChanges().cend(),
+                       [only](const ADObjectChangeSet::Change& change) { return change.operation == only; });
+}
+
+CircuitBreaker& ResilientDirectoryBackend::breaker() {
+    // The endpoint is known once connected and may change on reconnect
+    const QString endpoint = m_inner->getName() + ":" + m_inner->getEndpoint();
+    if (!m_breaker || endpoint != m_endpoint) {
+        m_endpoint = endpoint;
+        m_breaker = CircuitBreaker::forEndpoint(endpoint);
+    }
+    return *m_breaker;
+}
+
+int ResilientDirectoryBackend::backoffMs(int retry) const {
+    // Exponential, capped, with "equal jitter": half of the step is fixed
+    // and half random, so concurrent workers spread out but still back off
+    const qint64 step = qMin<qint64>(qMax(0, m_policy.maxBackoffMs),
+                                     qint64(qMax(0, m_policy.initialBackoffMs)) << qMin(retry - 1, 20));
+    const qint64 half = step / 2;
+    return int(half + QRandomGenerator::global()->bounded(half + 1));
+}
+
+void ResilientDirectoryBackend::adoptError() {
+    if (m_inner->lastError() == DirectoryError::None) {
+        clearError();
+    } else {
+        setError(m_inner->lastError(), m_inner->lastErrorMessage(), m_inner->lastNativeError());
+    }
+}
+
+bool ResilientDirectoryBackend::ensureConnected() {
+    if (!m_connectPending) {
+        return true;
+    }
+
+    m_connectPending = false;
+    if (!run([this]() { return m_inner->connect(m_pendingContext); })) {
+        m_connectPending = true;
+        return false;
+    }
+    return true;
+}
+
+bool ResilientDirectoryBackend::run(const std::function<bool()>& attempt,
+                                    const std::function<bool(DirectoryError)>& alreadyApplied,
+                                    const std::function<bool()>& canRetry, int previousAttempts) {
+    if (!ensureConnected()) {
+        return false;
+    }
+
+    CircuitBreaker& circuit = breaker();
+    const int maxAttempts = qMax(1, m_policy.maxAttempts);
+
+    for (int tries = previousAttempts + 1;; ++tries) {
+        const bool retrying = tries > 1;
+        if (retrying) {
+            QThread::msleep(backoffMs(tries - 1));
+        }
+
+        int retryAfterMs = 0;
+        if (!circuit.allowRequest(m_policy, &retryAfterMs)) {
+            const QString reason = retrying ? m_inner->lastErrorMessage() : QString();
+            setError(DirectoryError::Unavailable,
+                     QString("%1 is not answering; requests are paused for %2 s%3")
+                         .arg(m_inner->getEndpoint().isEmpty() ? QString("The directory") : m_inner->getEndpoint())
+                         .arg(qMax(1, (retryAfterMs + 999) / 1000))
+                         .arg(reason.isEmpty() ? QString() : " (" + reason + ")"));
+            if (retrying) {
+                circuit.recordOutcome(false);
+            }
+            return false;
+        }
+
+        if (retrying) {
+            circuit.recordRetry();
+        }
+
+        if (attempt()) {
+            circuit.recordSuccess();
+            if (retrying) {
+                circuit.recordOutcome(true);
+            }
+            clearError();
+            return true;
+        }
+
+        const DirectoryError error = m_inner->lastError();
+        if (!isTransient(error)) {
+            // The directory answered; only the request was wrong
+            circuit.recordSuccess();
+            if (retrying && alreadyApplied && alreadyApplied(error)) {
+                circuit.recordOutcome(true);
+                clearError();
+                return true;
+            }
+            if (retrying) {
+                circuit.recordOutcome(false);
+            }
+            adoptError();
+            return false;
+        }
+
+        circuit.recordFailure(m_policy);
+        if (tries >= maxAttempts || (canRetry && !canRetry())) {
+            if (retrying) {
+                circuit.recordOutcome(false);
+            }
+            adoptError();
+            return false;
+        }
+    }
+}
+
+bool ResilientDirectoryBackend::connect(const QString& namingContext) {
+    m_connectPending = false;
+    return run([&]() { return m_inner->connect(namingContext); });
+}
+
+void ResilientDirectoryBackend::connectLater(const QString& namingContext) {
+    m_pendingContext = namingContext;
+    m_connectPending = true;
+}
+
+bool ResilientDirectoryBackend::search(const SearchRequest& request, const SearchPageCallback& onPage) {
+    bool delivered = false;
+    SearchPageCallback forward = [&delivered, &onPage](const QList<DirectoryEntry>& page) {
+        delivered = true;
+        return onPage ? onPage(page) : true;
+    };
+
+    return run([&]() { return m_inner->search(request, forward); }, nullptr, [&delivered]() { return !delivered; });
+}
+
+bool ResilientDirectoryBackend::searchWindow(const SearchRequest& request, const VlvWindow& window,
+                                             QList<DirectoryEntry>& entries, VlvResult& result) {
+    return run([&]() {
+        entries.clear();
+        return m_inner->searchWindow(request, window, entries, result);
+    });
+}
+
+bool ResilientDirectoryBackend::readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) {
+    return run([&]() { return m_inner->readEntry(dn, attributes, entry); });
+}
+
+bool ResilientDirectoryBackend::readEntries(const QStringList& dns, const QStringList& attributes,
+                                            QList<DirectoryEntry>& entries) {
+    const qsizetype initialSize = entries.size();
+    return run([&]() {
+        entries.resize(initialSize);
+        return m_inner->readEntries(dns, attributes, entries);
+    });
+}
+
+bool ResilientDirectoryBackend::entryExists(const QString& dn) {
+    // false is also the answer "does not exist", told apart by lastError()
+    bool exists = false;
+    run([&]() {
+        exists = m_inner->entryExists(dn);
+        return exists || m_inner->lastError() == DirectoryError::None;
+    });
+    return exists;
+}
+
+bool ResilientDirectoryBackend::addEntry(const DirectoryEntry& entry) {
+    return run([&]() { return m_inner->addEntry(entry); },
+               [](DirectoryError error) { return error == DirectoryError::AlreadyExists; });
+}
+
+bool ResilientDirectoryBackend::modifyEntry(const ADObjectChangeSet& changes) {
+    return run([&]() { return m_inner->modifyEntry(changes); },
+               [&changes](DirectoryError error) { return isAlreadyApplied(changes, error); });
+}
+
+bool ResilientDirectoryBackend::modifyEntries(const QList<ADObjectChangeSet>& changes,
+                                              QList<DirectoryWriteResult>& results) {
+    results.clear();
+    if (!ensureConnected()) {
+        return false;
+    }
+
+    CircuitBreaker& circuit = breaker();
+    if (circuit.allowRequest(m_policy)) {
+        if (m_inner->modifyEntries(changes, results) || !isTransient(m_inner->lastError())) {
+            circuit.recordSuccess();
+        } else {
+            circuit.recordFailure(m_policy);
+        }
+    }
+
+    // What the batch sent and failed transiently may have been applied; it
+    // is retried on its own
+    const int sent = qMin(results.size(), changes.size());
+    results.resize(sent);
+    for (int i = 0; i < sent; ++i) {
+        if (!isTransient(results[i].error)) {
+            continue;
+        }
+        if (run([&]() { return m_inner->modifyEntry(changes[i]); },
+                [&](DirectoryError error) { return isAlreadyApplied(changes[i], error); }, nullptr, 1)) {
+            results[i] = DirectoryWriteResult();
+        } else {
+            results[i] = DirectoryWriteResult{lastError(), lastErrorMessage()};
+        }
+    }
+
+    // What it did not send (cut short, or held back by the open circuit) is
+    // sent one by one, up to the first change set that cannot be sent at
+    // all; that one and the rest stay without a result
+    for (int i = sent; i < changes.size(); ++i) {
+        bool attempted = false;
+        const bool applied = run(
+            [&]() {
+                attempted = true;
+                return m_inner->modifyEntry(changes[i]);
+            },
+            [&](DirectoryError error) { return isAlreadyApplied(changes[i], error); });
+        if (!attempted) {
+            return false;
+        }
+        results.append(applied ? DirectoryWriteResult() : DirectoryWriteResult{lastError(), lastErrorMessage()});
+    }
+
+    clearError();
+    return true;
+}
+
+bool ResilientDirectoryBackend::deleteEntry(const QString& dn) {
+    return run([&]() { return m_inner->deleteEntry(dn); },
+               [](DirectoryError error) { return error == DirectoryError::NoSuchObject; });
+}
+
+bool ResilientDirectoryBackend::setPassword(const QString& dn, const QString& password) {
+    // A password reset is idempotent
+    return run([&]() { return m_inner->setPassword(dn, password); });
+}
@@ -5,10 +5,11 @@
 #include <QGroupBox>
 #include <QMessageBox>
 #include <QHeaderView>
-#include <QApplication>
 
 CreateUsersDialog::CreateUsersDialog(const QStringList& servers, QWidget* parent)
-    : QDialog(parent), m_llmService(nullptr), m_adManager(nullptr), m_passwordGenerator(nullptr)
+    : QDialog(parent), m_llmService(nullptr), m_adManager(nullptr), m_adAsync(nullptr),
+      m_passwordGenerator(nullptr),
+      m_concurrency(BulkUserCreator::DefaultConcurrency)
 {
     setWindowTitle(tr("Create Users"));
     
@@ -32,6 +33,28 @@ void CreateUsersDialog::setLLMService(LLMService* llmService)
 void CreateUsersDialog::setADManager(ADManager* adManager)
 {
     m_adManager = adManager;
+    m_bulkCreator.reset();
+    
+    if (m_adManager) {
+        m_bulkCreator = std::make_unique<BulkUserCreator>(m_adManager);
+        m_bulkCreator->setConcurrency(m_concurrency);
+        connect(m_bulkCreator.get(), &BulkUserCreator::itemsFinished, this, &CreateUsersDialog::onCreateItemsFinished);
+        connect(m_bulkCreator.get(), &BulkUserCreator::progress, this, &CreateUsersDialog::onCreateProgress);
+        connect(m_bulkCreator.get(), &BulkUserCreator::finished, this, &CreateUsersDialog::onCreateFinished);
+    }
+}
+
+void CreateUsersDialog::setADManagerAsync(ADManagerAsync* adAsync)
+{
+    m_adAsync = adAsync;
+}
+
+void CreateUsersDialog::setConcurrency(int concurrency)
+{
+    m_concurrency = qMax(1, concurrency);
+    if (m_bulkCreator) {
+        m_bulkCreator->setConcurrency(m_concurrency);
+    }
 }
 
 void CreateUsersDialog::setPasswordGenerator(PasswordGenerator* passwordGenerator)
@@ -153,6 +176,7 @@ void CreateUsersDialog::onProcessClicked()
     m_userListEdit->setEnabled(false);
     m_serverComboBox->setEnabled(false);
     m_processButton->setEnabled(false);
+    m_createButton->setEnabled(false);
     
     // Process user list
     m_llmService->processUserList(userList);
@@ -187,12 +211,11 @@ void CreateUsersDialog::onCreateUsersClicked()
     // Generate passwords if needed
     bool generatePasswords = m_createPasswordsCheckbox->isChecked();
     
-    // Create users
-    int created = 0;
-    int total = m_processedUsers.size();
-    
+    // Only valid rows are submitted; m_createRows maps each back to its row
+    QList<UserInfo> users;
+    m_createRows.clear();
     for (int i = 0; i < m_processedUsers.size(); i++) {
-        NormalizedUser& normalizedUser = m_processedUsers[i];
+        const NormalizedUser& normalizedUser = m_processedUsers[i];
         
         if (!normalizedUser.getIsValid()) {
             continue;
@@ -211,35 +234,52 @@ void CreateUsersDialog::onCreateUsersClicked()
             user.setPassword(password);
         }
         
-        // Create user in AD
-        bool success = m_adManager->createUser(user, serverName);
-        
-        if (success) {
-            created++;
-            
-            // Update table to show success
-            m_resultsTable->item(i, 0)->setBackground(QBrush(QColor(200, 255, 200)));
-        } else {
-            // Update table to show failure
-            m_resultsTable->item(i, 0)->setBackground(QBrush(QColor(255, 200, 200)));
+        users.append(user);
+        m_createRows.append(i);
+    }
+    
+    // Users are created on worker threads; results arrive through
+    // onCreateItemsFinished and onCreateFinished
+    m_cancelButton->setText(tr("Stop"));
+    m_bulkCreator->start(users, serverName);
+}
+
+void CreateUsersDialog::onCreateItemsFinished(const QList<BulkCreateResult>& results)
+{
+    for (const BulkCreateResult& result : results) {
+        const int row = m_createRows.value(result.index, -1);
+        if (row < 0 || !m_resultsTable->item(row, 0)) {
+            continue;
         }
         
-        // Update progress
-        int progress = (i + 1) * 100 / total;
-        m_progressBar->setValue(progress);
-        QApplication::processEvents();
+        // Green for created, red for failed
+        QTableWidgetItem* item = m_resultsTable->item(row, 0);
+        item->setBackground(result.success ? QBrush(QColor(200, 255, 200)) : QBrush(QColor(255, 200, 200)));
+        item->setToolTip(result.error);
     }
+}
+
+void CreateUsersDialog::onCreateProgress(int completed, int total)
+{
+    m_progressBar->setValue(total > 0 ? completed * 100 / total : 100);
+}
+
+void CreateUsersDialog::onCreateFinished(int created, int total, qint64 elapsedMs)
+{
+    QString serverName = m_serverComboBox->currentText();
     
     // Show results
     QMessageBox::information(this, tr("Users Created"),
-                           tr("Created %1 of %2 users on server %3.")
+                           tr("Created %1 of %2 users on server %3 in %4 s.")
                            .arg(created)
                            .arg(total)
-                           .arg(serverName));
+                           .arg(serverName)
+                           .arg(elapsedMs / 1000.0, 0, 'f', 1));
     
     // Re-enable inputs
     m_resultsTable->setEnabled(true);
     m_createButton->setEnabled(true);
+    m_cancelButton->setText(tr("Cancel"));
     m_progressBar->setVisible(false);
     
     // Close if successful
@@ -250,19 +290,41 @@ void CreateUsersDialog::onCreateUsersClicked()
 
 void CreateUsersDialog::onCancelClicked()
 {
+    // While creating, the button stops the batch; onCreateFinished follows
+    if (m_bulkCreator && m_bulkCreator->isRunning()) {
+        m_bulkCreator->cancel();
+        return;
+    }
+    
     reject();
 }
 
 void CreateUsersDialog::onUserListProcessed(const QList<NormalizedUser>& users)
 {
     m_processedUsers = users;
-    updateTable(users);
-    
+    updateTable(m_processedUsers);
+    
+    // Make the logins unique against the directory and within the batch
+    // now, so duplicates show in the table instead of failing on create.
+    // The lookups run on the pool; the inputs stay disabled until they end
+    if (m_adAsync && m_adManager && m_adManager->isConnected()) {
+        m_adAsync->allocateLogins(users).then(this, [this](const QList<NormalizedUser>& allocated) {
+            m_processedUsers = allocated;
+            updateTable(m_processedUsers);
+            finishProcessing();
+        });
+        return;
+    }
+    finishProcessing();
+}
+
+void CreateUsersDialog::finishProcessing()
+{
     m_progressBar->setVisible(false);
     m_userListEdit->setEnabled(true);
     m_serverComboBox->setEnabled(true);
     m_processButton->setEnabled(true);
-    m_createButton->setEnabled(!users.isEmpty());
+    m_createButton->setEnabled(!m_processedUsers.isEmpty());
 }
 
 void CreateUsersDialog::onProcessingError(const QString& error)
@@ -2,11 +2,14 @@
 #include "ui/ServerTreeWidget.h"
 #include "ui/UserDetailsWidget.h"
 #include "ui/CreateUsersDialog.h"
+#include "services/InMemoryDirectoryBackend.h"
+#include "services/LdapDirectoryBackend.h"
 
 #include <QApplication>
 #include <QCloseEvent>
 #include <QDockWidget>
 #include <QHeaderView>
+#include <QScrollBar>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -16,17 +19,21 @@
 #include <QDateTime>
 #include <QClipboard>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QStandardPaths>
 #include <QSettings>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget* parent)
-    : QMainWindow(parent)
+    : QMainWindow(parent), m_userWindowed(false), m_userWindowPending(false), m_userWindowRequest(0),
+      m_userTotal(0)
 {
     // Initialize services
     m_configManager = std::make_unique<ConfigManager>(this);
     m_configManager->loadConfig();
     
-    m_adManager = std::make_unique<ADManager>(this);
+    m_adManager = std::make_unique<ADManager>(this, ADManager::createBackend(m_configManager->getAdBackend()));
     m_llmService = std::make_unique<LLMService>(this);
     m_passwordGenerator = std::make_unique<PasswordGenerator>(this);
     
@@ -34,6 +41,49 @@ MainWindow::MainWindow(QWidget* parent)
     m_llmService->setApiKey(m_configManager->getLlmApiKey());
     m_llmService->setEndpoint(m_configManager->getLlmEndpoint());
     m_llmService->setModel(m_configManager->getLlmModel());
+    m_adManager->setSearchPageSize(m_configManager->getAdSearchPageSize());
+    m_adManager->getObjectCache()->setTtl(m_configManager->getAdCacheTtl());
+    m_adManager->getObjectCache()->setMaxBytes(qint64(m_configManager->getAdCacheMaxMegabytes()) * 1024 * 1024);
+    
+    QJsonObject retryConfig = m_configManager->getRetrySettings();
+    RetryPolicy retryPolicy;
+    retryPolicy.maxAttempts = retryConfig.value("max_attempts").toInt(retryPolicy.maxAttempts);
+    retryPolicy.initialBackoffMs = retryConfig.value("initial_backoff_ms").toInt(retryPolicy.initialBackoffMs);
+    retryPolicy.maxBackoffMs = retryConfig.value("max_backoff_ms").toInt(retryPolicy.maxBackoffMs);
+    retryPolicy.breakerThreshold = retryConfig.value("breaker_threshold").toInt(retryPolicy.breakerThreshold);
+    retryPolicy.breakerCooldownMs = retryConfig.value("breaker_cooldown_ms").toInt(retryPolicy.breakerCooldownMs);
+    m_adManager->setWorkerRetryPolicy(retryPolicy);
+    // The GUI thread never sleeps in a backoff; its workers retry
+    RetryPolicy guiRetryPolicy = retryPolicy;
+    guiRetryPolicy.maxAttempts = 1;
+    m_adManager->setRetryPolicy(guiRetryPolicy);
+    
+    // The snapshot of the last run is mapped and shown at once; the replica
+    // itself is loaded from it by the first sync, off the GUI thread
+    const QString snapshotPath =
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/directory.snapshot";
+    m_adManager->getReplica()->setStoragePath(snapshotPath);
+    m_snapshot = std::make_unique<DirectorySnapshot>();
+    if (!m_snapshot->open(snapshotPath)) {
+        m_snapshot.reset();
+    }
+    
+#ifdef HAVE_OPENLDAP
+    if (auto* ldapBackend = dynamic_cast<LdapDirectoryBackend*>(m_adManager->getBackend())) {
+        QJsonObject ldapConfig = m_configManager->getLdapSettings();
+        LdapConnectionSettings settings;
+        settings.uri = ldapConfig.value("uri").toString();
+        settings.bindDN = ldapConfig.value("bind_dn").toString();
+        settings.password = ldapConfig.value("password").toString();
+        settings.startTls = ldapConfig.value("start_tls").toBool(settings.startTls);
+        settings.timeoutMs = ldapConfig.value("timeout_ms").toInt(settings.timeoutMs);
+        settings.maxOutstanding = ldapConfig.value("max_outstanding").toInt(settings.maxOutstanding);
+        ldapBackend->setSettings(settings);
+    }
+#endif
+    
+    // Created once m_adManager is configured: its workers start from a snapshot of it
+    m_adAsync = std::make_unique<ADManagerAsync>(m_adManager.get(), 4, this);
     
     // Set up the UI
     setupUI();
@@ -42,12 +92,30 @@ MainWindow::MainWindow(QWidget* parent)
     setupStatusBar();
     setupConnections();
     
-    // Initialize with AD connection
-    m_adManager->connectToAD(m_configManager->getAdDomain());
-    
-    // Load servers 
+    // Show what the snapshot knows; the directory is contacted once the window is up
     loadServers();
     
+    // Only objects changed since the replica's watermark are fetched from here on
+    m_refreshTimer = new QTimer(this);
+    connect(m_refreshTimer, &QTimer::timeout, this, &MainWindow::onAutoRefresh);
+    int refreshSeconds = m_configManager->getAutoRefreshInterval();
+    if (refreshSeconds > 0) {
+        m_refreshTimer->start(refreshSeconds * 1000);
+    }
+    QTimer::singleShot(0, this, &MainWindow::connectToDirectory);
+    
+    // Latency histograms of every directory operation, for scraping
+    QJsonObject metricsConfig = m_configManager->getMetricsSettings();
+    m_metricsExportPath = metricsConfig.value("export_path").toString();
+    m_metricsExportFormat = metricsConfig.value("format").toString().compare("json", Qt::CaseInsensitive) == 0
+                                ? OperationMetrics::Format::Json
+                                : OperationMetrics::Format::Prometheus;
+    m_metricsExportTimer = new QTimer(this);
+    connect(m_metricsExportTimer, &QTimer::timeout, this, &MainWindow::exportMetrics);
+    if (!m_metricsExportPath.isEmpty()) {
+        m_metricsExportTimer->start(qMax(1000, metricsConfig.value("interval_ms").toInt(15000)));
+    }
+    
     // Set window properties
     setWindowTitle(tr("AD User Manager"));
     setMinimumSize(800, 600);
@@ -58,6 +126,29 @@ MainWindow::~MainWindow()
 {
 }
 
+void MainWindow::connectToDirectory()
+{
+    // Populate the in-memory directory for offline and load testing. The
+    // worker that binds seeds it, through the store its clones share, before
+    // the connection is adopted and servers are loaded from it
+    std::function<void(ADManager*)> seed;
+    const int seedUsers = m_configManager->getAdMemorySeedUsers();
+    if (seedUsers > 0) {
+        seed = [seedUsers](ADManager* manager) {
+            if (auto* memoryBackend = dynamic_cast<InMemoryDirectoryBackend*>(manager->getBackend())) {
+                memoryBackend->seedSyntheticUsers(seedUsers);
+            }
+        };
+    }
+    
+    // The bind runs on the pool; the snapshot stays usable meanwhile. Once
+    // adopted, onADConnectionChanged loads the servers
+    m_adAsync->connectToAD(m_configManager->getAdDomain(), seed).then(this, [this](bool) {
+        // Reconciles the snapshot with the directory in the background
+        onAutoRefresh();
+    });
+}
+
 void MainWindow::closeEvent(QCloseEvent* event)
 {
     // Save any settings or state before closing
@@ -84,10 +175,16 @@ void MainWindow::setupUI()
     m_userTable->setHorizontalHeaderLabels({tr("Full Name"), tr("Login"), tr("Status"), tr("Created Date")});
     m_userTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     m_userTable->setSelectionBehavior(QTableWidget::SelectRows);
-    m_userTable->setSelectionMode(QTableWidget::SingleSelection);
+    m_userTable->setSelectionMode(QTableWidget::ExtendedSelection);
     m_userTable->setSortingEnabled(true);
     m_rightSplitter->addWidget(m_userTable);
     
+    // Scrolling settles before the rows that came into view are fetched
+    m_userWindowTimer = new QTimer(this);
+    m_userWindowTimer->setSingleShot(true);
+    m_userWindowTimer->setInterval(50);
+    connect(m_userWindowTimer, &QTimer::timeout, this, &MainWindow::fetchVisibleUsers);
+    
     // Create user details pane
     m_userDetails = new UserDetailsWidget(m_rightSplitter);
     m_rightSplitter->addWidget(m_userDetails);
@@ -108,6 +205,32 @@ void MainWindow::setupUI()
     m_logDock->setAllowedAreas(Qt::BottomDockWidgetArea);
     addDockWidget(Qt::BottomDockWidgetArea, m_logDock);
     
+    // Per-operation latency, hidden until asked for
+    m_metricsTable = new QTableWidget(int(DirectoryOperation::Count), 7);
+    m_metricsTable->setHorizontalHeaderLabels({tr("Operation"), tr("Calls"), tr("Errors"), tr("p50 ms"),
+                                               tr("p90 ms"), tr("p99 ms"), tr("Max ms")});
+    m_metricsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_metricsTable->verticalHeader()->hide();
+    m_metricsTable->setEditTriggers(QTableWidget::NoEditTriggers);
+    
+    m_metricsDock = new QDockWidget(tr("Metrics"), this);
+    m_metricsDock->setWidget(m_metricsTable);
+    m_metricsDock->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::RightDockWidgetArea);
+    addDockWidget(Qt::RightDockWidgetArea, m_metricsDock);
+    m_metricsDock->hide();
+    
+    m_metricsTimer = new QTimer(this);
+    m_metricsTimer->setInterval(1000);
+    connect(m_metricsTimer, &QTimer::timeout, this, &MainWindow::refreshMetrics);
+    connect(m_metricsDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) {
+            refreshMetrics();
+            m_metricsTimer->start();
+        } else {
+            m_metricsTimer->stop();
+        }
+    });
+    
     // Set central widget
     setCentralWidget(m_mainSplitter);
     
@@ -161,6 +284,11 @@ void MainWindow::setupMenus()
     logAction->setChecked(true);
     connect(logAction, &QAction::toggled, m_logDock, &QDockWidget::setVisible);
     
+    QAction* metricsAction = viewMenu->addAction(tr("Show &Metrics"));
+    metricsAction->setCheckable(true);
+    metricsAction->setChecked(false);
+    connect(metricsAction, &QAction::toggled, m_metricsDock, &QDockWidget::setVisible);
+    
     // User menu
     QMenu* userMenu = menuBar()->addMenu(tr("&User"));
     
@@ -172,6 +300,10 @@ void MainWindow::setupMenus()
     changePasswordAction->setIcon(QIcon(":/icons/key.svg"));
     connect(changePasswordAction, &QAction::triggered, this, &MainWindow::onChangePassword);
     
+    QAction* rotatePasswordsAction = userMenu->addAction(tr("R&otate Server Passwords..."));
+    rotatePasswordsAction->setIcon(QIcon(":/icons/key.svg"));
+    connect(rotatePasswordsAction, &QAction::triggered, this, &MainWindow::onRotatePasswords);
+    
     QAction* copyConnectionAction = userMenu->addAction(tr("Copy &RDP Connection Info"));
     copyConnectionAction->setIcon(QIcon(":/icons/copy.svg"));
     connect(copyConnectionAction, &QAction::triggered, this, &MainWindow::onCopyConnectionInfo);
@@ -236,30 +368,55 @@ void MainWindow::setupConnections()
             return;
         }
         
+        // Rows of a windowed table that were not fetched yet have no items
         int row = m_userTable->selectedItems().first()->row();
-        QString userDN = m_userTable->item(row, 0)->data(Qt::UserRole).toString();
-        onUserSelected(userDN);
+        QTableWidgetItem* nameItem = m_userTable->item(row, 0);
+        if (nameItem) {
+            onUserSelected(nameItem->data(Qt::UserRole).toString());
+        }
     });
     
     connect(m_userTable, &QTableWidget::itemDoubleClicked, [this](QTableWidgetItem* item) {
-        int row = item->row();
-        QString userDN = m_userTable->item(row, 0)->data(Qt::UserRole).toString();
-        onUserDoubleClicked(userDN);
+        QTableWidgetItem* nameItem = m_userTable->item(item->row(), 0);
+        if (nameItem) {
+            onUserDoubleClicked(nameItem->data(Qt::UserRole).toString());
+        }
     });
     
+    connect(m_userTable->verticalScrollBar(), &QScrollBar::valueChanged, m_userWindowTimer,
+            qOverload<>(&QTimer::start));
+    connect(m_userTable->horizontalHeader(), &QHeaderView::sortIndicatorChanged, this, &MainWindow::onUserSortChanged);
+    
     // AD Manager signals
     connect(m_adManager.get(), &ADManager::connectionStatusChanged, this, &MainWindow::onADConnectionChanged);
     connect(m_adManager.get(), &ADManager::operationProgress, this, &MainWindow::onOperationProgress);
     connect(m_adManager.get(), &ADManager::error, this, &MainWindow::onADError);
+    
+    // Async AD results are delivered on the GUI thread
+    connect(m_adAsync.get(), &ADManagerAsync::serversLoaded, this, &MainWindow::onServersLoaded);
+    connect(m_adAsync.get(), &ADManagerAsync::userWindowLoaded, this, &MainWindow::onUserWindowLoaded);
+    connect(m_adAsync.get(), &ADManagerAsync::usersDeactivated, this, &MainWindow::onUsersDeactivated);
+    connect(m_adAsync.get(), &ADManagerAsync::userInfoLoaded, this, &MainWindow::onUserInfoLoaded);
+    connect(m_adAsync.get(), &ADManagerAsync::serverInfoLoaded, this, &MainWindow::onServerInfoLoaded);
+    connect(m_adAsync.get(), &ADManagerAsync::exportFinished, this, &MainWindow::onExportFinished);
+    connect(m_adAsync.get(), &ADManagerAsync::replicaSynced, this, &MainWindow::onReplicaSynced);
+    connect(m_adAsync.get(), &ADManagerAsync::error, this, &MainWindow::onADError);
 }
 
 void MainWindow::loadServers()
 {
-    if (!m_adManager->isConnected()) {
-        return;
+    // Local sources answer at once; the directory is asked on the pool
+    if (m_adManager->isReplicaReady()) {
+        onServersLoaded(m_adManager->getReplica()->getServerNames());
+    } else if (m_snapshot) {
+        onServersLoaded(m_snapshot->getServerNames());
+    } else if (m_adManager->isConnected()) {
+        m_adAsync->getServerList();
     }
-    
-    QStringList servers = m_adManager->getServerList();
+}
+
+void MainWindow::onServersLoaded(const QStringList& servers)
+{
     m_serverTree->setServers(servers);
     
     m_serverCount->setText(tr("Servers: %1").arg(servers.count()));
@@ -268,37 +425,132 @@ void MainWindow::loadServers()
 
 void MainWindow::loadUsers(const QString& serverName)
 {
-    if (!m_adManager->isConnected() || serverName.isEmpty()) {
+    const bool connected = m_adManager->isConnected();
+    const bool local = m_adManager->isReplicaReady() || (m_snapshot && m_snapshot->hasServer(serverName));
+    if ((!connected && !local) || serverName.isEmpty()) {
         return;
     }
     
     m_userTable->setRowCount(0);
     m_userTable->setSortingEnabled(false);
+    m_userCount->setText(tr("Users: %1").arg(0));
+    m_userWindowed = false;
+    
+    // Windows still in flight belong to the previous listing
+    m_userWindowPending = false;
+    ++m_userWindowRequest;
+    
+    // Offline, the replica or else the startup snapshot fills the whole
+    // table and the view sorts it locally
+    if (!connected) {
+        const QList<DirectoryEntry> entries = m_adManager->isReplicaReady()
+                                                  ? m_adManager->getReplica()->getUsersForServer(serverName)
+                                                  : m_snapshot->getUsersForServer(serverName);
+        QList<UserInfo> users;
+        users.reserve(entries.size());
+        for (const DirectoryEntry& entry : entries) {
+            users.append(ADManager::userInfoFromEntry(entry));
+        }
+        appendUserRows(users);
+        m_userTable->setSortingEnabled(true);
+        m_userTable->sortItems(0, Qt::AscendingOrder);
+        
+        m_userCount->setText(tr("Users: %1").arg(users.count()));
+        log(tr("Loaded %1 users for server %2").arg(users.count()).arg(serverName));
+        return;
+    }
     
-    QStringList users = m_adManager->getUsersForServer(serverName);
-    m_userTable->setRowCount(users.count());
+    // Live, the directory sorts and only the rows in view are fetched, one
+    // window per viewport, through onUserWindowLoaded
+    m_userWindowed = true;
+    m_userTotal = 0;
+    m_userContext.clear();
+    m_userTable->horizontalHeader()->setSortIndicatorShown(true);
+    requestUserWindow(0);
+}
+
+void MainWindow::requestUserWindow(int firstRow)
+{
+    if (m_userOrder.isEmpty()) {
+        const int column = m_userTable->horizontalHeader()->sortIndicatorSection();
+        onUserSortChanged(column < 0 ? 0 : column, m_userTable->horizontalHeader()->sortIndicatorOrder());
+        return;
+    }
     
-    for (int i = 0; i < users.count(); i++) {
-        UserInfo user = m_adManager->getUserInfo(users[i]);
-        
-        QTableWidgetItem* nameItem = new QTableWidgetItem(user.getFullName());
-        nameItem->setData(Qt::UserRole, user.getDistinguishedName());
-        m_userTable->setItem(i, 0, nameItem);
-        
-        m_userTable->setItem(i, 1, new QTableWidgetItem(user.getLogin()));
-        
-        QTableWidgetItem* statusItem = new QTableWidgetItem(user.isActive() ? tr("Active") : tr("Disabled"));
-        statusItem->setForeground(user.isActive() ? QBrush(Qt::darkGreen) : QBrush(Qt::red));
-        m_userTable->setItem(i, 2, statusItem);
-        
-        m_userTable->setItem(i, 3, new QTableWidgetItem(user.getCreatedDate().toString("yyyy-MM-dd")));
+    // Rows arrive through onUserWindowLoaded. The continuation runs on
+    // every outcome, loaded, failed or superseded, and only the latest
+    // request releases the flag; a failed window is retried on the next scroll
+    m_userWindowPending = true;
+    const quint64 request = ++m_userWindowRequest;
+    m_adAsync->loadUserWindow(m_currentServer, m_userOrder, firstRow, UserWindowSize, m_userTotal, m_userContext)
+        .then(this, [this, request](bool loaded) {
+            if (request != m_userWindowRequest) {
+                return;
+            }
+            m_userWindowPending = false;
+            
+            // The view may have moved on while this window was in flight
+            if (loaded) {
+                fetchVisibleUsers();
+            }
+        });
+}
+
+void MainWindow::fetchVisibleUsers()
+{
+    if (!m_userWindowed || m_userWindowPending || m_userTable->rowCount() == 0) {
+        return;
     }
     
-    m_userTable->setSortingEnabled(true);
-    m_userTable->sortItems(0, Qt::AscendingOrder);
+    // The first row in view that has not been fetched yet, if any
+    const int top = qMax(0, m_userTable->rowAt(0));
+    int bottom = m_userTable->rowAt(m_userTable->viewport()->height() - 1);
+    if (bottom < 0) {
+        bottom = m_userTable->rowCount() - 1;
+    }
+    
+    for (int row = top; row <= bottom; ++row) {
+        if (!m_userTable->item(row, 0)) {
+            // Start a little above, so scrolling back up is covered too
+            requestUserWindow(qMax(0, qMin(row - UserWindowSize / 4, m_userTable->rowCount() - UserWindowSize)));
+            return;
+        }
+    }
+}
+
+void MainWindow::refreshCurrentServer()
+{
+    // With a replica, a sync picks up the change and reloads what it touched
+    if (m_adManager->isReplicaReady()) {
+        m_adAsync->syncReplica();
+    } else if (!m_currentServer.isEmpty()) {
+        loadUsers(m_currentServer);
+    }
+}
+
+void MainWindow::appendUserRows(const QList<UserInfo>& users)
+{
+    int row = m_userTable->rowCount();
+    m_userTable->setRowCount(row + users.count());
     
-    m_userCount->setText(tr("Users: %1").arg(users.count()));
-    log(tr("Loaded %1 users for server %2").arg(users.count()).arg(serverName));
+    for (const UserInfo& user : users) {
+        setUserRow(row++, user);
+    }
+}
+
+void MainWindow::setUserRow(int row, const UserInfo& user)
+{
+    QTableWidgetItem* nameItem = new QTableWidgetItem(user.getFullName());
+    nameItem->setData(Qt::UserRole, user.getDistinguishedName());
+    m_userTable->setItem(row, 0, nameItem);
+    
+    m_userTable->setItem(row, 1, new QTableWidgetItem(user.getLogin()));
+    
+    QTableWidgetItem* statusItem = new QTableWidgetItem(user.isActive() ? tr("Active") : tr("Disabled"));
+    statusItem->setForeground(user.isActive() ? QBrush(Qt::darkGreen) : QBrush(Qt::red));
+    m_userTable->setItem(row, 2, statusItem);
+    
+    m_userTable->setItem(row, 3, new QTableWidgetItem(user.getCreatedDate().toString("yyyy-MM-dd")));
 }
 
 void MainWindow::updateStatusBar()
@@ -342,24 +594,34 @@ void MainWindow::onCreateUsers()
         return;
     }
     
-    CreateUsersDialog dialog(m_adManager->getServerList(), this);
-    dialog.setLLMService(m_llmService.get());
-    dialog.setADManager(m_adManager.get());
-    dialog.setPasswordGenerator(m_passwordGenerator.get());
-    
-    if (dialog.exec() == QDialog::Accepted) {
-        // Refresh current server if it matches the one users were created for
-        QString createdForServer = dialog.getSelectedServer();
-        if (createdForServer == m_currentServer) {
-            loadUsers(m_currentServer);
-        }
+    // The dialog opens once the directory listed the servers
+    m_adAsync->getServerList().then(this, [this](const QStringList& servers) {
+        CreateUsersDialog dialog(servers, this);
+        dialog.setLLMService(m_llmService.get());
+        dialog.setADManager(m_adManager.get());
+        dialog.setADManagerAsync(m_adAsync.get());
+        dialog.setPasswordGenerator(m_passwordGenerator.get());
+        dialog.setConcurrency(m_configManager->getAdBulkConcurrency());
         
-        log(tr("Users created for server %1").arg(createdForServer));
-    }
+        if (dialog.exec() == QDialog::Accepted) {
+            // Refresh current server if it matches the one users were created for
+            QString createdForServer = dialog.getSelectedServer();
+            if (createdForServer == m_currentServer) {
+                refreshCurrentServer();
+            }
+            
+            log(tr("Users created for server %1").arg(createdForServer));
+        }
+    });
 }
 
 void MainWindow::onRefreshServers()
 {
+    if (m_adManager->isReplicaReady()) {
+        m_adAsync->syncReplica();
+        return;
+    }
+    
     loadServers();
     
     // Also reload users for the current server
@@ -384,13 +646,12 @@ void MainWindow::onUserSelected(const QString& userDN)
         return;
     }
     
-    UserInfo user = m_adManager->getUserInfo(userDN);
-    m_userDetails->setUser(user);
+    // Details are filled in by onUserInfoLoaded / onServerInfoLoaded
+    m_adAsync->getUserInfo(userDN);
     
     // If server info is available, set RDP information
     if (!m_currentServer.isEmpty()) {
-        ServerInfo serverInfo = m_adManager->getServerInfo(m_currentServer);
-        m_userDetails->setServerInfo(serverInfo);
+        m_adAsync->getServerInfo(m_currentServer);
     }
 }
 
@@ -401,52 +662,108 @@ void MainWindow::onUserDoubleClicked(const QString& userDN)
         return;
     }
     
-    UserInfo user = m_adManager->getUserInfo(userDN);
-    QMessageBox::information(this, tr("User Details"), 
-                           tr("User: %1\nLogin: %2\nServer: %3\nCreated: %4\nLast Login: %5\nStatus: %6")
-                           .arg(user.getFullName())
-                           .arg(user.getLogin())
-                           .arg(user.getServerName())
-                           .arg(user.getCreatedDate().toString("yyyy-MM-dd"))
-                           .arg(user.getLastLogin().toString("yyyy-MM-dd"))
-                           .arg(user.isActive() ? tr("Active") : tr("Disabled")));
+    m_adAsync->getUserInfo(userDN).then(this, [this](const UserInfo& user) {
+        // A failed read was reported through onADError
+        if (user.getDistinguishedName().isEmpty()) {
+            return;
+        }
+        
+        QMessageBox::information(this, tr("User Details"), 
+                               tr("User: %1\nLogin: %2\nServer: %3\nCreated: %4\nLast Login: %5\nStatus: %6")
+                               .arg(user.getFullName())
+                               .arg(user.getLogin())
+                               .arg(user.getServerName())
+                               .arg(user.getCreatedDate().toString("yyyy-MM-dd"))
+                               .arg(user.getLastLogin().toString("yyyy-MM-dd"))
+                               .arg(user.isActive() ? tr("Active") : tr("Disabled")));
+    });
 }
 
 void MainWindow::onDeactivateUser()
 {
+    // Several rows selected: deactivate them together
+    QStringList userDNs;
+    for (const QModelIndex& index : m_userTable->selectionModel()->selectedRows()) {
+        QTableWidgetItem* nameItem = m_userTable->item(index.row(), 0);
+        if (nameItem) {
+            userDNs << nameItem->data(Qt::UserRole).toString();
+        }
+    }
+    
+    if (userDNs.size() > 1) {
+        QMessageBox::StandardButton confirm = QMessageBox::question(this, tr("Confirm Deactivation"),
+                                                                 tr("Are you sure you want to deactivate %1 users?")
+                                                                 .arg(userDNs.size()));
+        if (confirm == QMessageBox::Yes) {
+            log(tr("Deactivating %1 users...").arg(userDNs.size()));
+            m_adAsync->deactivateUsers(userDNs);
+        }
+        return;
+    }
+    
     if (m_currentUser.isEmpty()) {
         QMessageBox::warning(this, tr("No User Selected"), tr("Please select a user to deactivate."));
         return;
     }
     
-    UserInfo user = m_adManager->getUserInfo(m_currentUser);
-    
-    QMessageBox::StandardButton confirm = QMessageBox::question(this, tr("Confirm Deactivation"),
-                                                             tr("Are you sure you want to deactivate user %1?")
-                                                             .arg(user.getFullName()));
-    
-    if (confirm == QMessageBox::Yes) {
-        if (m_adManager->deactivateUser(m_currentUser)) {
-            log(tr("User %1 has been deactivated").arg(user.getFullName()));
-            
-            // Refresh user list
-            loadUsers(m_currentServer);
-        } else {
-            displayError(tr("Failed to deactivate user %1").arg(user.getFullName()));
+    const QString userDN = m_currentUser;
+    m_adAsync->getUserInfo(userDN).then(this, [this, userDN](const UserInfo& user) {
+        const QString name = user.getFullName().isEmpty() ? userDN : user.getFullName();
+        QMessageBox::StandardButton confirm = QMessageBox::question(this, tr("Confirm Deactivation"),
+                                                                 tr("Are you sure you want to deactivate user %1?")
+                                                                 .arg(name));
+        if (confirm != QMessageBox::Yes) {
+            return;
         }
-    }
+        
+        m_adAsync->deactivateUser(userDN).then(this, [this, name](bool deactivated) {
+            if (deactivated) {
+                log(tr("User %1 has been deactivated").arg(name));
+                
+                // Refresh user list
+                refreshCurrentServer();
+            } else {
+                displayError(tr("Failed to deactivate user %1").arg(name));
+            }
+        });
+    });
 }
 
-void MainWindow::onChangePassword()
+void MainWindow::onUsersDeactivated(const QList<BulkDeactivateResult>& results)
 {
-    if (m_currentUser.isEmpty()) {
-        QMessageBox::warning(this, tr("No User Selected"), tr("Please select a user to change password."));
-        return;
+    int deactivated = 0;
+    int notAttempted = 0;
+    for (const BulkDeactivateResult& result : results) {
+        switch (result.status) {
+        case BulkDeactivateResult::Status::Deactivated:
+            deactivated++;
+            break;
+        case BulkDeactivateResult::Status::NotAttempted:
+            notAttempted++;
+            log(tr("Did not deactivate %1: %2").arg(result.dn, result.error));
+            break;
+        case BulkDeactivateResult::Status::NotFound:
+        case BulkDeactivateResult::Status::Failed:
+            log(tr("Failed to deactivate %1: %2").arg(result.dn, result.error));
+            break;
+        }
     }
     
-    UserInfo user = m_adManager->getUserInfo(m_currentUser);
+    log(tr("%1 of %2 users have been deactivated").arg(deactivated).arg(results.size()));
+    if (notAttempted > 0) {
+        displayError(tr("%1 of %2 users could not be deactivated and %3 were not attempted; "
+                        "see the log for details")
+                     .arg(results.size() - deactivated - notAttempted).arg(results.size()).arg(notAttempted));
+    } else if (deactivated < results.size()) {
+        displayError(tr("%1 of %2 users could not be deactivated; see the log for details")
+                     .arg(results.size() - deactivated).arg(results.size()));
+    }
     
-    // Generate a new password according to policy
+    refreshCurrentServer();
+}
+
+PasswordPolicy MainWindow::passwordPolicy() const
+{
     QJsonObject policyJson = m_configManager->getPasswordPolicy();
     PasswordPolicy policy;
     
@@ -461,23 +778,44 @@ void MainWindow::onChangePassword()
         policy.requireEachType = policyJson["requireEachType"].toBool(true);
     }
     
-    QString newPassword = m_passwordGenerator->generatePassword(policy);
-    
-    QString message = tr("Change password for user %1?\n\nNew password: %2\n\n"
-                      "Password strength: %3%")
-                    .arg(user.getFullName())
-                    .arg(newPassword)
-                    .arg(m_passwordGenerator->calculateStrength(newPassword));
-    
-    QMessageBox::StandardButton confirm = QMessageBox::question(this, tr("Change Password"), message);
+    return policy;
+}
+
+void MainWindow::onChangePassword()
+{
+    if (m_currentUser.isEmpty()) {
+        QMessageBox::warning(this, tr("No User Selected"), tr("Please select a user to change password."));
+        return;
+    }
     
-    if (confirm == QMessageBox::Yes) {
-        if (m_adManager->changePassword(m_currentUser, newPassword)) {
-            log(tr("Password changed for user %1").arg(user.getFullName()));
+    const QString userDN = m_currentUser;
+    m_adAsync->getUserInfo(userDN).then(this, [this, userDN](const UserInfo& user) {
+        const QString name = user.getFullName().isEmpty() ? userDN : user.getFullName();
+        
+        // Generate a new password according to policy
+        QString newPassword = m_passwordGenerator->generatePassword(passwordPolicy());
+        
+        QString message = tr("Change password for user %1?\n\nNew password: %2\n\n"
+                          "Password strength: %3%")
+                        .arg(name)
+                        .arg(newPassword)
+                        .arg(m_passwordGenerator->calculateStrength(newPassword));
+        
+        QMessageBox::StandardButton confirm = QMessageBox::question(this, tr("Change Password"), message);
+        if (confirm != QMessageBox::Yes) {
+            return;
+        }
+        
+        m_adAsync->changePassword(userDN, newPassword).then(this, [this, userDN, name, newPassword](bool changed) {
+            if (!changed) {
+                displayError(tr("Failed to change password for user %1").arg(name));
+                return;
+            }
             
-            // Update the user object
-            user.setPassword(newPassword);
-            onUserSelected(m_currentUser); // Refresh display
+            log(tr("Password changed for user %1").arg(name));
+            if (userDN == m_currentUser) {
+                onUserSelected(userDN); // Refresh display
+            }
             
             // Also copy to clipboard
             QClipboard* clipboard = QApplication::clipboard();
@@ -485,33 +823,144 @@ void MainWindow::onChangePassword()
             
             QMessageBox::information(this, tr("Password Changed"),
                                   tr("Password has been changed and copied to clipboard."));
-        } else {
-            displayError(tr("Failed to change password for user %1").arg(user.getFullName()));
-        }
+        });
+    });
+}
+
+void MainWindow::onRotatePasswords()
+{
+    if (m_currentServer.isEmpty()) {
+        QMessageBox::warning(this, tr("No Server Selected"), tr("Please select a server to rotate passwords for."));
+        return;
     }
+    
+    if (m_passwordRotator && m_passwordRotator->isRunning()) {
+        QMessageBox::warning(this, tr("Rotation Running"), tr("A password rotation is already in progress."));
+        return;
+    }
+    
+    if (!SecureRecordFile::isSupported()) {
+        displayError(tr("Password rotation needs encryption support, which this build lacks."));
+        return;
+    }
+    
+    // The server's members are read on the pool
+    const QString serverName = m_currentServer;
+    m_adAsync->getUsersForServer(serverName).then(this, [this, serverName](const QStringList& userDNs) {
+        rotatePasswords(serverName, userDNs);
+    });
 }
 
-void MainWindow::onCopyConnectionInfo()
+void MainWindow::rotatePasswords(const QString& serverName, const QStringList& userDNs)
 {
-    if (m_currentUser.isEmpty() || m_currentServer.isEmpty()) {
-        QMessageBox::warning(this, tr("No Selection"), tr("Please select a user and server."));
+    if (userDNs.isEmpty()) {
+        QMessageBox::information(this, tr("Rotate Passwords"), tr("Server %1 has no users.").arg(serverName));
         return;
     }
     
-    UserInfo user = m_adManager->getUserInfo(m_currentUser);
-    ServerInfo server = m_adManager->getServerInfo(m_currentServer);
+    // Another rotation may have started while the members were read
+    if (m_passwordRotator && m_passwordRotator->isRunning()) {
+        QMessageBox::warning(this, tr("Rotation Running"), tr("A password rotation is already in progress."));
+        return;
+    }
     
-    QString connectionInfo = user.getRdpConnectionString(server.getRdpAddress(), server.getRdpPort());
+    QMessageBox::StandardButton confirm = QMessageBox::question(this, tr("Rotate Passwords"),
+                                                             tr("Set a new password for all %1 users of server %2?")
+                                                             .arg(userDNs.size()).arg(serverName));
+    if (confirm != QMessageBox::Yes) {
+        return;
+    }
     
-    QClipboard* clipboard = QApplication::clipboard();
-    clipboard->setText(connectionInfo);
+    // The new passwords are only ever written to this file, encrypted
+    QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save New Passwords"),
+                                                 defaultPath + "/" + serverName + "-passwords.admrec",
+                                                 tr("Encrypted Password Files (*.admrec);;All Files (*.*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    bool ok = false;
+    QString passphrase = QInputDialog::getText(this, tr("Encrypt Passwords"),
+                                               tr("Passphrase for the password file:"),
+                                               QLineEdit::Password, QString(), &ok);
+    if (!ok || passphrase.isEmpty()) {
+        return;
+    }
+    
+    QString confirmation = QInputDialog::getText(this, tr("Encrypt Passwords"), tr("Repeat the passphrase:"),
+                                                 QLineEdit::Password, QString(), &ok);
+    if (!ok) {
+        return;
+    }
+    if (confirmation != passphrase) {
+        displayError(tr("The passphrases do not match."));
+        return;
+    }
+    
+    if (!m_passwordRotator) {
+        m_passwordRotator = std::make_unique<BulkPasswordRotator>(m_adManager.get(), m_passwordGenerator.get());
+        connect(m_passwordRotator.get(), &BulkPasswordRotator::progress, this, [this](int completed, int total) {
+            onOperationProgress(tr("Rotate passwords"), total > 0 ? completed * 100 / total : 100);
+        });
+        connect(m_passwordRotator.get(), &BulkPasswordRotator::finished, this, &MainWindow::onRotationFinished);
+    }
     
-    QMessageBox::information(this, tr("Connection Info Copied"),
-                          tr("RDP connection info has been copied to clipboard."));
+    m_passwordRotator->setConcurrency(m_configManager->getAdRotationConcurrency());
+    if (!m_passwordRotator->start(userDNs, passwordPolicy(), fileName, passphrase)) {
+        displayError(tr("Failed to start the password rotation: %1").arg(m_passwordRotator->errorString()));
+        return;
+    }
     
-    log(tr("Copied RDP connection info for user %1 on server %2")
-        .arg(user.getFullName())
-        .arg(server.getName()));
+    log(tr("Rotating passwords of %1 users on server %2 into %3...")
+        .arg(userDNs.size()).arg(serverName).arg(fileName));
+}
+
+void MainWindow::onRotationFinished(int rotated, int total, qint64 elapsedMs)
+{
+    for (const BulkRotateResult& result : m_passwordRotator->results()) {
+        if (!result.success) {
+            log(tr("Failed to rotate the password of %1: %2").arg(result.dn, result.error));
+        }
+    }
+    
+    log(tr("Rotated %1 of %2 passwords in %3 s").arg(rotated).arg(total).arg(elapsedMs / 1000.0, 0, 'f', 1));
+    if (rotated < total) {
+        displayError(tr("%1 of %2 passwords could not be rotated; see the log for details")
+                     .arg(total - rotated).arg(total));
+    }
+    
+    refreshCurrentServer();
+}
+
+void MainWindow::onCopyConnectionInfo()
+{
+    if (m_currentUser.isEmpty() || m_currentServer.isEmpty()) {
+        QMessageBox::warning(this, tr("No Selection"), tr("Please select a user and server."));
+        return;
+    }
+    
+    const QString serverName = m_currentServer;
+    m_adAsync->getUserInfo(m_currentUser).then(this, [this, serverName](const UserInfo& user) {
+        m_adAsync->getServerInfo(serverName).then(this, [this, user](const ServerInfo& server) {
+            // Failed reads were reported through onADError
+            if (user.getDistinguishedName().isEmpty() || server.getName().isEmpty()) {
+                return;
+            }
+            
+            QString connectionInfo = user.getRdpConnectionString(server.getRdpAddress(), server.getRdpPort());
+            
+            QClipboard* clipboard = QApplication::clipboard();
+            clipboard->setText(connectionInfo);
+            
+            QMessageBox::information(this, tr("Connection Info Copied"),
+                                  tr("RDP connection info has been copied to clipboard."));
+            
+            log(tr("Copied RDP connection info for user %1 on server %2")
+                .arg(user.getFullName())
+                .arg(server.getName()));
+        });
+    });
 }
 
 void MainWindow::onExportUsers()
@@ -530,32 +979,9 @@ void MainWindow::onExportUsers()
         return;
     }
     
-    QStringList users = m_adManager->getUsersForServer(m_currentServer);
-    
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        displayError(tr("Could not open file for writing: %1").arg(fileName));
-        return;
-    }
-    
-    QTextStream out(&file);
-    out << "Full Name,Login,Status,Created Date,Last Login\n";
-    
-    for (const QString& userDN : users) {
-        UserInfo user = m_adManager->getUserInfo(userDN);
-        out << QString("%1,%2,%3,%4,%5\n")
-               .arg(user.getFullName())
-               .arg(user.getLogin())
-               .arg(user.isActive() ? "Active" : "Disabled")
-               .arg(user.getCreatedDate().toString("yyyy-MM-dd"))
-               .arg(user.getLastLogin().toString("yyyy-MM-dd"));
-    }
-    
-    file.close();
-    
-    log(tr("Exported %1 users to %2").arg(users.count()).arg(fileName));
-    QMessageBox::information(this, tr("Export Complete"), 
-                          tr("%1 users exported to %2").arg(users.count()).arg(fileName));
+    // The file is written on a worker thread; onExportFinished reports the result
+    m_adAsync->exportUsers(m_currentServer, fileName);
+    log(tr("Exporting users of server %1 to %2...").arg(m_currentServer).arg(fileName));
 }
 
 void MainWindow::onSettings()
@@ -609,3 +1035,140 @@ void MainWindow::onOperationProgress(const QString& operation, int progress)
         statusBar()->showMessage(tr("%1: %2%").arg(operation).arg(progress));
     }
 }
+
+void MainWindow::onUserWindowLoaded(const QString& serverName, int firstRow, const QList<UserInfo>& users,
+                                    int total, const QByteArray& context)
+{
+    if (!m_userWindowed || serverName != m_currentServer) {
+        return;
+    }
+    
+    m_userContext = context;
+    if (total != m_userTotal) {
+        m_userTotal = total;
+        m_userTable->setRowCount(total);
+        m_userCount->setText(tr("Users: %1").arg(total));
+    }
+    
+    for (int i = 0; i < users.count() && firstRow + i < m_userTable->rowCount(); ++i) {
+        setUserRow(firstRow + i, users[i]);
+    }
+}
+
+void MainWindow::onUserSortChanged(int column, Qt::SortOrder order)
+{
+    // Attributes behind the Full Name, Login, Status and Created Date columns
+    static const QStringList sortAttributes = {"displayName", "sAMAccountName", "userAccountControl", "whenCreated"};
+    m_userOrder = {SortKey{sortAttributes.value(column, "displayName"), order == Qt::DescendingOrder}};
+    
+    if (!m_userWindowed) {
+        return;
+    }
+    
+    // Rows are refetched in the new order; the server's sorted list is new too
+    m_userTable->clearContents();
+    m_userContext.clear();
+    requestUserWindow(qMax(0, m_userTable->rowAt(0)));
+}
+
+void MainWindow::onAutoRefresh()
+{
+    if (m_adManager->isConnected()) {
+        m_adAsync->syncReplica();
+    }
+}
+
+void MainWindow::refreshMetrics()
+{
+    auto ms = [](qint64 micros) { return QString::number(micros / 1000.0, 'f', 1); };
+    
+    const OperationMetrics& metrics = OperationMetrics::global();
+    for (int row = 0; row < int(DirectoryOperation::Count); ++row) {
+        const DirectoryOperation operation = DirectoryOperation(row);
+        const LatencySummary summary = metrics.summary(operation);
+        const QStringList cells = {OperationMetrics::operationName(operation),
+                                   QString::number(summary.count), QString::number(summary.errors),
+                                   ms(summary.p50Us), ms(summary.p90Us), ms(summary.p99Us), ms(summary.maxUs)};
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem* item = m_metricsTable->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem();
+                if (column > 0) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                m_metricsTable->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
+
+void MainWindow::exportMetrics()
+{
+    QString error;
+    if (OperationMetrics::global().writeToFile(m_metricsExportPath, m_metricsExportFormat, &error)) {
+        m_metricsExportError.clear();
+        return;
+    }
+    
+    if (error != m_metricsExportError) {
+        m_metricsExportError = error;
+        log(tr("Could not write metrics to %1: %2").arg(m_metricsExportPath, error));
+    }
+}
+
+void MainWindow::onReplicaSynced(const ReplicaSyncResult& result)
+{
+    if (!result.success) {
+        return;
+    }
+    
+    // The replica supersedes the startup snapshot; unmap it before the
+    // snapshot file is rewritten
+    m_snapshot.reset();
+    if (result.fullSync || result.updated > 0 || result.deleted > 0) {
+        m_adAsync->saveReplica();
+    }
+    
+    if (result.fullSync || !result.changedServers.isEmpty()) {
+        log(tr("Directory sync: %1 updated, %2 deleted").arg(result.updated).arg(result.deleted));
+        loadServers();
+    }
+    
+    if (!m_currentServer.isEmpty() &&
+        (result.fullSync || result.changedServers.contains(m_currentServer, Qt::CaseInsensitive))) {
+        loadUsers(m_currentServer);
+    }
+}
+
+void MainWindow::onUserInfoLoaded(const UserInfo& user)
+{
+    // The selection may have moved on while the request was in flight
+    if (user.getDistinguishedName() != m_currentUser) {
+        return;
+    }
+    
+    m_userDetails->setUser(user);
+}
+
+void MainWindow::onServerInfoLoaded(const ServerInfo& serverInfo)
+{
+    if (serverInfo.getName() != m_currentServer) {
+        return;
+    }
+    
+    m_userDetails->setServerInfo(serverInfo);
+}
+
+void MainWindow::onExportFinished(const QString& fileName, int count, bool success)
+{
+    // The cause was shown through onADError
+    if (!success) {
+        log(tr("Export to %1 failed; no file was left behind").arg(fileName));
+        return;
+    }
+    
+    log(tr("Exported %1 users to %2").arg(count).arg(fileName));
+    QMessageBox::information(this, tr("Export Complete"), 
+                          tr("%1 users exported to %2").arg(count).arg(fileName));
+}
@@ -1,6 +1,7 @@
 #include "utils/DataValidator.h"
 #include <QRegularExpression>
 #include "utils/StringUtils.h"
+#include "utils/DnTokenizer.h"
 
 thread_local QString DataValidator::s_lastError;
 
@@ -151,9 +152,20 @@ bool DataValidator::isValidDistinguishedName(const QString& dn) {
         return false;
     }
     
-    // Basic format validation for LDAP DN
-    // This is a simplified check, real validation is more complex
-    if (!dn.contains('=') || !dn.contains(',')) {
+    // RFC 4514 syntax, with at least an object and its container
+    DnTokenizer tokens(dn);
+    QStringView rdn;
+    int rdnCount = 0;
+    while (tokens.next(rdn)) {
+        ++rdnCount;
+    }
+    
+    if (tokens.hasError()) {
+        s_lastError = QString("Invalid distinguished name: %1").arg(tokens.errorString());
+        return false;
+    }
+    
+    if (rdnCount < 2) {
         s_lastError = "Distinguished name must be in LDAP format (e.g., CN=User,OU=Users,DC=example,DC=com)";
         return false;
     }
@@ -0,0 +1,253 @@
+#include "utils/DnTokenizer.h"
+#include <QByteArray>
+
+namespace {
+bool isHex(QChar c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+int hexValue(QChar c) {
+    if (c >= '0' && c <= '9') {
+        return c.unicode() - '0';
+    }
+    return (c.unicode() | 0x20) - 'a' + 10;
+}
+
+bool isAlpha(QChar c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool isDigit(QChar c) {
+    return c >= '0' && c <= '9';
+}
+
+// Characters that may follow a backslash as themselves
+bool isEscapable(QChar c) {
+    switch (c.unicode()) {
+    case '"': case '+': case ',': case ';': case '<': case '>':
+    case '\\': case '#': case '=': case ' ':
+        return true;
+    default:
+        return false;
+    }
+}
+
+void skipSpaces(QStringView dn, qsizetype& pos) {
+    while (pos < dn.size() && dn[pos] == ' ') {
+        ++pos;
+    }
+}
+
+bool fail(QString* error, const QString& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+}
+
+DnTokenizer::DnTokenizer(QStringView dn)
+    : m_dn(dn), m_pos(0), m_done(dn.trimmed().isEmpty()), m_error(false) {
+}
+
+bool DnTokenizer::next(QStringView& rdn) {
+    if (m_done || m_error) {
+        return false;
+    }
+
+    qsizetype end = 0;
+    if (!scanRdn(m_dn, m_pos, end, &m_errorString)) {
+        m_error = true;
+        return false;
+    }
+
+    rdn = m_dn.sliced(m_pos, end - m_pos).trimmed();
+    if (end < m_dn.size()) {
+        m_pos = end + 1; // past the comma; a trailing one fails on the next call
+    } else {
+        m_done = true;
+    }
+    return true;
+}
+
+QStringView DnTokenizer::attributeValue(QStringView rdn, QStringView type) {
+    qsizetype pos = 0;
+    while (true) {
+        QStringView avaType;
+        QStringView avaValue;
+        if (!scanAva(rdn, pos, avaType, avaValue, nullptr)) {
+            return QStringView();
+        }
+        if (avaType.compare(type, Qt::CaseInsensitive) == 0) {
+            return avaValue;
+        }
+
+        skipSpaces(rdn, pos);
+        if (pos >= rdn.size() || rdn[pos] != '+') {
+            return QStringView();
+        }
+        ++pos;
+    }
+}
+
+QString DnTokenizer::unescape(QStringView value) {
+    if (!value.contains('\\') || value.startsWith('#')) {
+        return value.toString();
+    }
+
+    // Hex escapes are UTF-8 octets and a character may span several of
+    // them, so they are collected and decoded together
+    QString result;
+    result.reserve(value.size());
+    QByteArray octets;
+    for (qsizetype i = 0; i < value.size(); ++i) {
+        if (value[i] == '\\' && i + 2 < value.size() && isHex(value[i + 1]) && isHex(value[i + 2])) {
+            octets.append(char(hexValue(value[i + 1]) * 16 + hexValue(value[i + 2])));
+            i += 2;
+            continue;
+        }
+
+        if (!octets.isEmpty()) {
+            result += QString::fromUtf8(octets);
+            octets.clear();
+        }
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            ++i;
+        }
+        result += value[i];
+    }
+    if (!octets.isEmpty()) {
+        result += QString::fromUtf8(octets);
+    }
+
+    return result;
+}
+
+bool DnTokenizer::sameRdn(QStringView a, QStringView b) {
+    qsizetype posA = 0;
+    qsizetype posB = 0;
+    while (true) {
+        QStringView typeA;
+        QStringView valueA;
+        QStringView typeB;
+        QStringView valueB;
+        if (!scanAva(a, posA, typeA, valueA, nullptr) || !scanAva(b, posB, typeB, valueB, nullptr)) {
+            return false;
+        }
+        if (typeA.compare(typeB, Qt::CaseInsensitive) != 0 ||
+            unescape(valueA).compare(unescape(valueB), Qt::CaseInsensitive) != 0) {
+            return false;
+        }
+
+        skipSpaces(a, posA);
+        skipSpaces(b, posB);
+        const bool moreA = posA < a.size() && a[posA] == '+';
+        const bool moreB = posB < b.size() && b[posB] == '+';
+        if (moreA != moreB) {
+            return false;
+        }
+        if (!moreA) {
+            return true;
+        }
+        ++posA;
+        ++posB;
+    }
+}
+
+bool DnTokenizer::scanAva(QStringView dn, qsizetype& pos, QStringView& type, QStringView& value,
+                          QString* error) {
+    skipSpaces(dn, pos);
+
+    // attributeType: a descriptor (cn, ou) or a numeric OID (2.5.4.3)
+    const qsizetype typeStart = pos;
+    if (pos < dn.size() && isAlpha(dn[pos])) {
+        while (pos < dn.size() && (isAlpha(dn[pos]) || isDigit(dn[pos]) || dn[pos] == '-')) {
+            ++pos;
+        }
+    } else if (pos < dn.size() && isDigit(dn[pos])) {
+        while (pos < dn.size() && (isDigit(dn[pos]) || (dn[pos] == '.' && pos + 1 < dn.size() && isDigit(dn[pos + 1])))) {
+            ++pos;
+        }
+    } else {
+        return fail(error, QString("Expected an attribute type at position %1").arg(pos));
+    }
+    type = dn.sliced(typeStart, pos - typeStart);
+
+    skipSpaces(dn, pos);
+    if (pos >= dn.size() || dn[pos] != '=') {
+        return fail(error, QString("Expected '=' at position %1").arg(pos));
+    }
+    ++pos;
+    skipSpaces(dn, pos);
+
+    const qsizetype valueStart = pos;
+
+    // hexstring: '#' followed by the BER encoding as hex pairs
+    if (pos < dn.size() && dn[pos] == '#') {
+        ++pos;
+        const qsizetype digitsStart = pos;
+        while (pos < dn.size() && isHex(dn[pos])) {
+            ++pos;
+        }
+        if (pos == digitsStart || (pos - digitsStart) % 2 != 0) {
+            return fail(error, QString("Malformed hex value at position %1").arg(valueStart));
+        }
+        value = dn.sliced(valueStart, pos - valueStart);
+        skipSpaces(dn, pos);
+        if (pos < dn.size() && dn[pos] != ',' && dn[pos] != '+') {
+            return fail(error, QString("Unexpected character after hex value at position %1").arg(pos));
+        }
+        return true;
+    }
+
+    // string: ends at an unescaped ',' or '+'; trailing spaces are not part of it
+    qsizetype valueEnd = pos;
+    while (pos < dn.size() && dn[pos] != ',' && dn[pos] != '+') {
+        const QChar c = dn[pos];
+        if (c == '\\') {
+            if (pos + 1 < dn.size() && isHex(dn[pos + 1])) {
+                if (pos + 2 >= dn.size() || !isHex(dn[pos + 2])) {
+                    return fail(error, QString("Incomplete hex escape at position %1").arg(pos));
+                }
+                pos += 3;
+            } else if (pos + 1 < dn.size() && isEscapable(dn[pos + 1])) {
+                pos += 2;
+            } else {
+                return fail(error, QString("Invalid escape at position %1").arg(pos));
+            }
+            valueEnd = pos;
+            continue;
+        }
+
+        if (c == '"' || c == ';' || c == '<' || c == '>' || c.isNull()) {
+            return fail(error, QString("Character '%1' must be escaped at position %2").arg(c).arg(pos));
+        }
+
+        ++pos;
+        if (c != ' ') {
+            valueEnd = pos;
+        }
+    }
+
+    value = dn.sliced(valueStart, valueEnd - valueStart);
+    return true;
+}
+
+bool DnTokenizer::scanRdn(QStringView dn, qsizetype pos, qsizetype& end, QString* error) {
+    // relativeDistinguishedName = attributeTypeAndValue *( PLUS attributeTypeAndValue )
+    while (true) {
+        QStringView type;
+        QStringView value;
+        if (!scanAva(dn, pos, type, value, error)) {
+            return false;
+        }
+        if (pos < dn.size() && dn[pos] == '+') {
+            ++pos;
+            continue;
+        }
+        break;
+    }
+
+    end = pos;
+    return true;
+}
@@ -0,0 +1,345 @@
+#include "utils/LdapFilter.h"
+
+LdapFilter::LdapFilter() {
+}
+
+LdapFilter LdapFilter::parse(const QString& filter) {
+    LdapFilter result;
+
+    QString text = filter.trimmed();
+    // Tolerate a bare item without the enclosing parentheses, e.g. "cn=foo"
+    if (!text.startsWith('(')) {
+        text = "(" + text + ")";
+    }
+
+    int pos = 0;
+    std::shared_ptr<Node> root = parseNode(text, pos);
+    if (root && pos == text.length()) {
+        result.m_root = root;
+    }
+
+    return result;
+}
+
+QString LdapFilter::escapeValue(const QString& value) {
+    QString escaped;
+    escaped.reserve(value.length());
+
+    for (const QChar& c : value) {
+        switch (c.unicode()) {
+        case '*':  escaped += "\\2a"; break;
+        case '(':  escaped += "\\28"; break;
+        case ')':  escaped += "\\29"; break;
+        case '\\': escaped += "\\5c"; break;
+        case 0:    escaped += "\\00"; break;
+        default:   escaped += c; break;
+        }
+    }
+
+    return escaped;
+}
+
+bool LdapFilter::matches(const DirectoryEntry& entry) const {
+    return m_root && matchesNode(*m_root, entry);
+}
+
+QString LdapFilter::requiredEquality(const QString& attribute) const {
+    if (!m_root) {
+        return QString();
+    }
+
+    if (m_root->type == Node::Equal && m_root->attribute.compare(attribute, Qt::CaseInsensitive) == 0) {
+        return m_root->value;
+    }
+
+    if (m_root->type == Node::And) {
+        for (const auto& child : m_root->children) {
+            if (child->type == Node::Equal && child->attribute.compare(attribute, Qt::CaseInsensitive) == 0) {
+                return child->value;
+            }
+        }
+    }
+
+    return QString();
+}
+
+QStringList LdapFilter::requiredEqualities(const QString& attribute) const {
+    if (!m_root) {
+        return QStringList();
+    }
+
+    auto valuesOf = [&attribute](const Node& node) {
+        QStringList values;
+        if (node.type != Node::Or) {
+            return values;
+        }
+        for (const auto& child : node.children) {
+            if (child->type != Node::Equal || child->attribute.compare(attribute, Qt::CaseInsensitive) != 0) {
+                return QStringList();
+            }
+            values << child->value;
+        }
+        return values;
+    };
+
+    if (m_root->type == Node::And) {
+        for (const auto& child : m_root->children) {
+            const QStringList values = valuesOf(*child);
+            if (!values.isEmpty()) {
+                return values;
+            }
+        }
+        return QStringList();
+    }
+
+    return valuesOf(*m_root);
+}
+
+QString LdapFilter::requiredPrefix(const QString& attribute) const {
+    if (!m_root) {
+        return QString();
+    }
+
+    auto prefixOf = [&attribute](const Node& node) {
+        if (node.type == Node::Substring && node.attribute.compare(attribute, Qt::CaseInsensitive) == 0 &&
+            !node.substrings.first().isEmpty()) {
+            return node.substrings.first();
+        }
+        return QString();
+    };
+
+    if (m_root->type == Node::And) {
+        for (const auto& child : m_root->children) {
+            const QString prefix = prefixOf(*child);
+            if (!prefix.isNull()) {
+                return prefix;
+            }
+        }
+        return QString();
+    }
+
+    return prefixOf(*m_root);
+}
+
+std::shared_ptr<LdapFilter::Node> LdapFilter::parseNode(const QString& text, int& pos) {
+    if (pos >= text.length() || text[pos] != '(') {
+        return nullptr;
+    }
+    ++pos;
+
+    if (pos >= text.length()) {
+        return nullptr;
+    }
+
+    auto node = std::make_shared<Node>();
+    const QChar op = text[pos];
+
+    if (op == '&' || op == '|' || op == '!') {
+        node->type = op == '&' ? Node::And : (op == '|' ? Node::Or : Node::Not);
+        ++pos;
+
+        while (pos < text.length() && text[pos] == '(') {
+            std::shared_ptr<Node> child = parseNode(text, pos);
+            if (!child) {
+                return nullptr;
+            }
+            node->children.append(child);
+        }
+
+        if (node->type == Node::Not && node->children.size() != 1) {
+            return nullptr;
+        }
+    } else {
+        // Simple item: attr op value
+        int end = pos;
+        while (end < text.length() && text[end] != ')') {
+            ++end;
+        }
+        if (end >= text.length()) {
+            return nullptr;
+        }
+
+        const QString item = text.mid(pos, end - pos);
+        pos = end;
+
+        int eq = item.indexOf('=');
+        if (eq <= 0) {
+            return nullptr;
+        }
+
+        QString attribute = item.left(eq);
+        const QString rawValue = item.mid(eq + 1);
+
+        if (attribute.endsWith('>')) {
+            node->type = Node::GreaterOrEqual;
+            attribute.chop(1);
+        } else if (attribute.endsWith('<')) {
+            node->type = Node::LessOrEqual;
+            attribute.chop(1);
+        } else if (attribute.endsWith('~')) {
+            // Approximate match is treated as equality
+            node->type = Node::Equal;
+            attribute.chop(1);
+        } else if (rawValue == "*") {
+            node->type = Node::Present;
+        } else if (rawValue.contains('*')) {
+            node->type = Node::Substring;
+        } else {
+            node->type = Node::Equal;
+        }
+
+        node->attribute = attribute.trimmed();
+        if (node->attribute.isEmpty()) {
+            return nullptr;
+        }
+
+        if (node->type == Node::Substring) {
+            const QStringList rawParts = rawValue.split('*');
+            for (const QString& rawPart : rawParts) {
+                QString part;
+                if (!unescape(rawPart, part)) {
+                    return nullptr;
+                }
+                node->substrings.append(part);
+            }
+        } else if (node->type != Node::Present) {
+            if (!unescape(rawValue, node->value)) {
+                return nullptr;
+            }
+        }
+    }
+
+    if (pos >= text.length() || text[pos] != ')') {
+        return nullptr;
+    }
+    ++pos;
+
+    return node;
+}
+
+bool LdapFilter::unescape(const QString& raw, QString& value) {
+    if (!raw.contains('\\')) {
+        value = raw;
+        return true;
+    }
+
+    QByteArray bytes;
+    bytes.reserve(raw.length());
+
+    for (int i = 0; i < raw.length(); ++i) {
+        if (raw[i] == '\\') {
+            if (i + 2 >= raw.length()) {
+                return false;
+            }
+            bool ok = false;
+            const int byte = raw.mid(i + 1, 2).toInt(&ok, 16);
+            if (!ok) {
+                return false;
+            }
+            bytes.append(static_cast<char>(byte));
+            i += 2;
+        } else {
+            bytes.append(QString(raw[i]).toUtf8());
+        }
+    }
+
+    value = QString::fromUtf8(bytes);
+    return true;
+}
+
+bool LdapFilter::matchesNode(const Node& node, const DirectoryEntry& entry) {
+    switch (node.type) {
+    case Node::And:
+        for (const auto& child : node.children) {
+            if (!matchesNode(*child, entry)) {
+                return false;
+            }
+        }
+        return true;
+
+    case Node::Or:
+        for (const auto& child : node.children) {
+            if (matchesNode(*child, entry)) {
+                return true;
+            }
+        }
+        return false;
+
+    case Node::Not:
+        return !matchesNode(*node.children.first(), entry);
+
+    case Node::Present:
+        if (node.attribute.compare("distinguishedName", Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+        return entry.hasAttribute(node.attribute);
+
+    default:
+        break;
+    }
+
+    QStringList values = entry.getValues(node.attribute);
+    if (values.isEmpty() && node.attribute.compare("distinguishedName", Qt::CaseInsensitive) == 0) {
+        values << entry.getDistinguishedName();
+    }
+
+    for (const QString& value : values) {
+        if (matchesValue(node, value)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool LdapFilter::matchesValue(const Node& node, const QString& value) {
+    switch (node.type) {
+    case Node::Equal:
+        return value.compare(node.value, Qt::CaseInsensitive) == 0;
+
+    case Node::Substring: {
+        const QStringList& parts = node.substrings;
+        const QString& initial = parts.first();
+        const QString& suffix = parts.last();
+
+        if (!value.startsWith(initial, Qt::CaseInsensitive)) {
+            return false;
+        }
+
+        int pos = initial.length();
+        for (int i = 1; i < parts.size() - 1; ++i) {
+            if (parts[i].isEmpty()) {
+                continue;
+            }
+            pos = value.indexOf(parts[i], pos, Qt::CaseInsensitive);
+            if (pos < 0) {
+                return false;
+            }
+            pos += parts[i].length();
+        }
+
+        return value.length() - pos >= suffix.length() && value.endsWith(suffix, Qt::CaseInsensitive);
+    }
+
+    case Node::GreaterOrEqual:
+    case Node::LessOrEqual: {
+        // Integer attributes (uSNChanged, lastLogonTimestamp, ...) compare numerically
+        bool valueIsNumber = false;
+        bool filterIsNumber = false;
+        const qlonglong left = value.toLongLong(&valueIsNumber);
+        const qlonglong right = node.value.toLongLong(&filterIsNumber);
+
+        int cmp = 0;
+        if (valueIsNumber && filterIsNumber) {
+            cmp = left < right ? -1 : (left > right ? 1 : 0);
+        } else {
+            cmp = value.compare(node.value, Qt::CaseInsensitive);
+        }
+
+        return node.type == Node::GreaterOrEqual ? cmp >= 0 : cmp <= 0;
+    }
+
+    default:
+        return false;
+    }
+}
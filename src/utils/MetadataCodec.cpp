@@ -0,0 +1,82 @@
+#include "utils/MetadataCodec.h"
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonDocument>
+
+QString MetadataCodec::encode(const QJsonObject& metadata, bool allowCompression) {
+    QString best = encodeJson(metadata);
+
+    QString binary = encodeBinary(metadata, false);
+    if (binary.length() < best.length()) {
+        best = binary;
+    }
+
+    if (allowCompression) {
+        QString compressed = encodeBinary(metadata, true);
+        if (compressed.length() < best.length()) {
+            best = compressed;
+        }
+    }
+
+    return best;
+}
+
+QJsonObject MetadataCodec::decode(const QString& value) {
+    if (value.isEmpty()) {
+        return QJsonObject();
+    }
+
+    if (!isBinary(value)) {
+        QJsonDocument doc = QJsonDocument::fromJson(value.toUtf8());
+        return doc.isObject() ? doc.object() : QJsonObject();
+    }
+
+    QByteArray::FromBase64Result decoded = QByteArray::fromBase64Encoding(
+        value.mid(int(sizeof(Header)) - 1).toLatin1(), QByteArray::AbortOnBase64DecodingErrors);
+    if (!decoded || decoded->isEmpty()) {
+        return QJsonObject();
+    }
+    const QByteArray& payload = *decoded;
+
+    // Flags this version does not know would change the meaning of the rest
+    const quint8 flags = quint8(payload[0]);
+    if (flags & ~quint8(FlagCompressed)) {
+        return QJsonObject();
+    }
+    QByteArray cbor = payload.mid(1);
+    if (flags & FlagCompressed) {
+        cbor = qUncompress(cbor);
+    }
+
+    QCborParserError error;
+    QCborValue root = QCborValue::fromCbor(cbor, &error);
+    if (error.error != QCborError::NoError || !root.isMap()) {
+        return QJsonObject();
+    }
+    return root.toMap().toJsonObject();
+}
+
+QString MetadataCodec::encodeJson(const QJsonObject& metadata) {
+    return QString::fromUtf8(QJsonDocument(metadata).toJson(QJsonDocument::Compact));
+}
+
+QString MetadataCodec::encodeBinary(const QJsonObject& metadata, bool compress) {
+    QByteArray cbor = QCborMap::fromJsonObject(metadata).toCborValue().toCbor();
+
+    quint8 flags = 0;
+    if (compress && cbor.size() >= CompressionThreshold) {
+        cbor = qCompress(cbor, 9);
+        flags |= FlagCompressed;
+    }
+
+    QByteArray payload;
+    payload.reserve(cbor.size() + 1);
+    payload.append(char(flags));
+    payload.append(cbor);
+
+    return QLatin1String(Header) + QString::fromLatin1(payload.toBase64());
+}
+
+bool MetadataCodec::isBinary(const QString& value) {
+    return value.startsWith(QLatin1String(Header));
+}
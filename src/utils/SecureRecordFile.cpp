@@ -0,0 +1,332 @@
+#include "utils/SecureRecordFile.h"
+#include <QRandomGenerator>
+#include <QtEndian>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "bcrypt.lib")
+#elif defined(HAVE_OPENSSL)
+#include <openssl/evp.h>
+#endif
+
+namespace {
+const char Magic[] = "ADMREC";
+const int MagicSize = 6;
+const char Version = 1;
+const int SaltSize = 16;
+const int KeySize = 32;
+const int NonceSize = 12;
+const int TagSize = 16;
+const int HeaderSize = MagicSize + 1 + SaltSize + 4;
+
+// Upper bounds for what a file may ask for, so a damaged header cannot
+// stall the reader or make it allocate gigabytes
+const quint32 MaxIterations = 10000000;
+const quint32 MaxRecordSize = 16 * 1024 * 1024;
+
+// count is a multiple of 4: the generator hands out 32-bit words
+QByteArray randomBytes(int count) {
+    Q_ASSERT(count % 4 == 0);
+    QByteArray bytes(count, Qt::Uninitialized);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(bytes.data()), count / 4);
+    return bytes;
+}
+
+QByteArray sequenceData(quint64 sequence) {
+    QByteArray data(8, Qt::Uninitialized);
+    qToBigEndian(sequence, data.data());
+    return data;
+}
+
+#ifdef _WIN32
+bool deriveKey(const QString& passphrase, const QByteArray& salt, quint32 iterations, QByteArray& key) {
+    BCRYPT_ALG_HANDLE prf = nullptr;
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&prf, BCRYPT_SHA256_ALGORITHM, nullptr,
+                                                    BCRYPT_ALG_HANDLE_HMAC_FLAG))) {
+        return false;
+    }
+
+    QByteArray secret = passphrase.toUtf8();
+    key.resize(KeySize);
+    NTSTATUS status = BCryptDeriveKeyPBKDF2(prf, reinterpret_cast<PUCHAR>(secret.data()), ULONG(secret.size()),
+                                            reinterpret_cast<PUCHAR>(const_cast<char*>(salt.constData())),
+                                            ULONG(salt.size()), iterations, reinterpret_cast<PUCHAR>(key.data()),
+                                            ULONG(key.size()), 0);
+    secret.fill('\0');
+    BCryptCloseAlgorithmProvider(prf, 0);
+    return BCRYPT_SUCCESS(status);
+}
+
+// AES-256-GCM; tag is written when encrypting and checked when decrypting
+bool gcm(bool encrypt, const QByteArray& key, const QByteArray& nonce, const QByteArray& aad,
+         const QByteArray& input, QByteArray& output, QByteArray& tag) {
+    BCRYPT_ALG_HANDLE aes = nullptr;
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&aes, BCRYPT_AES_ALGORITHM, nullptr, 0))) {
+        return false;
+    }
+
+    BCRYPT_KEY_HANDLE handle = nullptr;
+    bool ok = BCRYPT_SUCCESS(BCryptSetProperty(aes, BCRYPT_CHAINING_MODE,
+                                               reinterpret_cast<PUCHAR>(const_cast<wchar_t*>(BCRYPT_CHAIN_MODE_GCM)),
+                                               sizeof(BCRYPT_CHAIN_MODE_GCM), 0)) &&
+              BCRYPT_SUCCESS(BCryptGenerateSymmetricKey(aes, &handle, nullptr, 0,
+                                                        reinterpret_cast<PUCHAR>(const_cast<char*>(key.constData())),
+                                                        ULONG(key.size()), 0));
+    if (ok) {
+        QByteArray nonceCopy = nonce;
+        QByteArray aadCopy = aad;
+        if (encrypt) {
+            tag.resize(TagSize);
+        }
+
+        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+        BCRYPT_INIT_AUTH_MODE_INFO(info);
+        info.pbNonce = reinterpret_cast<PUCHAR>(nonceCopy.data());
+        info.cbNonce = ULONG(nonceCopy.size());
+        info.pbAuthData = reinterpret_cast<PUCHAR>(aadCopy.data());
+        info.cbAuthData = ULONG(aadCopy.size());
+        info.pbTag = reinterpret_cast<PUCHAR>(tag.data());
+        info.cbTag = ULONG(tag.size());
+
+        output.resize(input.size());
+        PUCHAR in = reinterpret_cast<PUCHAR>(const_cast<char*>(input.constData()));
+        PUCHAR out = reinterpret_cast<PUCHAR>(output.data());
+        ULONG written = 0;
+        NTSTATUS status = encrypt
+            ? BCryptEncrypt(handle, in, ULONG(input.size()), &info, nullptr, 0, out, ULONG(output.size()), &written, 0)
+            : BCryptDecrypt(handle, in, ULONG(input.size()), &info, nullptr, 0, out, ULONG(output.size()), &written, 0);
+        ok = BCRYPT_SUCCESS(status);
+        BCryptDestroyKey(handle);
+    }
+
+    BCryptCloseAlgorithmProvider(aes, 0);
+    return ok;
+}
+#elif defined(HAVE_OPENSSL)
+bool deriveKey(const QString& passphrase, const QByteArray& salt, quint32 iterations, QByteArray& key) {
+    QByteArray secret = passphrase.toUtf8();
+    key.resize(KeySize);
+    const bool ok = PKCS5_PBKDF2_HMAC(secret.constData(), int(secret.size()),
+                                      reinterpret_cast<const unsigned char*>(salt.constData()), int(salt.size()),
+                                      int(iterations), EVP_sha256(), KeySize,
+                                      reinterpret_cast<unsigned char*>(key.data())) == 1;
+    secret.fill('\0');
+    return ok;
+}
+
+// AES-256-GCM; tag is written when encrypting and checked when decrypting
+bool gcm(bool encrypt, const QByteArray& key, const QByteArray& nonce, const QByteArray& aad,
+         const QByteArray& input, QByteArray& output, QByteArray& tag) {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        return false;
+    }
+
+    const int mode = encrypt ? 1 : 0;
+    int length = 0;
+    output.resize(input.size());
+    if (encrypt) {
+        tag.resize(TagSize);
+    }
+
+    bool ok = EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr, mode) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, int(nonce.size()), nullptr) == 1 &&
+              EVP_CipherInit_ex(ctx, nullptr, nullptr, reinterpret_cast<const unsigned char*>(key.constData()),
+                                reinterpret_cast<const unsigned char*>(nonce.constData()), mode) == 1 &&
+              EVP_CipherUpdate(ctx, nullptr, &length, reinterpret_cast<const unsigned char*>(aad.constData()),
+                               int(aad.size())) == 1 &&
+              EVP_CipherUpdate(ctx, reinterpret_cast<unsigned char*>(output.data()), &length,
+                               reinterpret_cast<const unsigned char*>(input.constData()), int(input.size())) == 1;
+
+    if (ok && !encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TagSize, const_cast<char*>(tag.constData())) == 1;
+    }
+
+    // GCM adds nothing at the end; for decryption this is the tag check
+    int finalLength = 0;
+    ok = ok && EVP_CipherFinal_ex(ctx, reinterpret_cast<unsigned char*>(output.data()) + length, &finalLength) == 1;
+
+    if (ok && encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TagSize, tag.data()) == 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+#else
+bool deriveKey(const QString&, const QByteArray&, quint32, QByteArray&) {
+    return false;
+}
+
+bool gcm(bool, const QByteArray&, const QByteArray&, const QByteArray&, const QByteArray&, QByteArray&,
+         QByteArray&) {
+    return false;
+}
+#endif
+
+bool fail(QString* error, const QString& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+}
+
+SecureRecordFile::SecureRecordFile()
+    : m_sequence(0) {
+}
+
+SecureRecordFile::~SecureRecordFile() {
+    close();
+}
+
+bool SecureRecordFile::isSupported() {
+#if defined(_WIN32) || defined(HAVE_OPENSSL)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SecureRecordFile::create(const QString& fileName, const QString& passphrase, quint32 iterations) {
+    close();
+    m_error.clear();
+
+    if (!isSupported()) {
+        m_error = "Encryption is not available in this build";
+        return false;
+    }
+    if (passphrase.isEmpty()) {
+        m_error = "A passphrase is required";
+        return false;
+    }
+
+    const QByteArray salt = randomBytes(SaltSize);
+    if (!deriveKey(passphrase, salt, iterations, m_key)) {
+        m_error = "Could not derive the encryption key";
+        return false;
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = QString("Could not create %1: %2").arg(fileName, m_file.errorString());
+        m_key.fill('\0');
+        m_key.clear();
+        return false;
+    }
+
+    QByteArray header(Magic, MagicSize);
+    header.append(Version);
+    header.append(salt);
+    QByteArray count(4, Qt::Uninitialized);
+    qToBigEndian(iterations, count.data());
+    header.append(count);
+
+    if (m_file.write(header) != header.size() || !m_file.flush()) {
+        m_error = QString("Could not write %1: %2").arg(fileName, m_file.errorString());
+        close();
+        return false;
+    }
+
+    m_sequence = 0;
+    return true;
+}
+
+bool SecureRecordFile::append(const QByteArray& record) {
+    if (!m_file.isOpen()) {
+        m_error = "The file is not open";
+        return false;
+    }
+
+    const QByteArray nonce = randomBytes(NonceSize);
+    QByteArray ciphertext;
+    QByteArray tag;
+    if (!gcm(true, m_key, nonce, sequenceData(m_sequence), record, ciphertext, tag)) {
+        m_error = "Encryption failed";
+        return false;
+    }
+
+    QByteArray length(4, Qt::Uninitialized);
+    qToBigEndian(quint32(ciphertext.size()), length.data());
+    const QByteArray block = nonce + length + ciphertext + tag;
+
+    // Flushed right away: the record may stand for a change already made
+    if (m_file.write(block) != block.size() || !m_file.flush()) {
+        m_error = QString("Could not write %1: %2").arg(m_file.fileName(), m_file.errorString());
+        return false;
+    }
+
+    ++m_sequence;
+    return true;
+}
+
+void SecureRecordFile::close() {
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_key.fill('\0');
+    m_key.clear();
+}
+
+bool SecureRecordFile::readAll(const QString& fileName, const QString& passphrase, QList<QByteArray>& records,
+                               QString* error) {
+    if (!isSupported()) {
+        return fail(error, "Encryption is not available in this build");
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(error, QString("Could not open %1: %2").arg(fileName, file.errorString()));
+    }
+
+    const QByteArray header = file.read(HeaderSize);
+    if (header.size() != HeaderSize || !header.startsWith(QByteArray(Magic, MagicSize))) {
+        return fail(error, QString("%1 is not an encrypted record file").arg(fileName));
+    }
+    if (header[MagicSize] != Version) {
+        return fail(error, QString("Unsupported record file version %1").arg(int(header[MagicSize])));
+    }
+
+    const QByteArray salt = header.mid(MagicSize + 1, SaltSize);
+    const quint32 iterations = qFromBigEndian<quint32>(header.constData() + MagicSize + 1 + SaltSize);
+    if (iterations == 0 || iterations > MaxIterations) {
+        return fail(error, "Damaged header");
+    }
+
+    QByteArray key;
+    if (!deriveKey(passphrase, salt, iterations, key)) {
+        return fail(error, "Could not derive the encryption key");
+    }
+
+    QList<QByteArray> decrypted;
+    for (quint64 sequence = 0; !file.atEnd(); ++sequence) {
+        const QByteArray prefix = file.read(NonceSize + 4);
+        if (prefix.size() != NonceSize + 4) {
+            return fail(error, QString("Record %1 is truncated").arg(sequence + 1));
+        }
+
+        const quint32 length = qFromBigEndian<quint32>(prefix.constData() + NonceSize);
+        if (length > MaxRecordSize) {
+            return fail(error, QString("Record %1 is damaged").arg(sequence + 1));
+        }
+
+        const QByteArray ciphertext = file.read(length);
+        QByteArray tag = file.read(TagSize);
+        if (ciphertext.size() != int(length) || tag.size() != TagSize) {
+            return fail(error, QString("Record %1 is truncated").arg(sequence + 1));
+        }
+
+        QByteArray plaintext;
+        if (!gcm(false, key, prefix.left(NonceSize), sequenceData(sequence), ciphertext, plaintext, tag)) {
+            // The first record fails as well with a wrong passphrase
+            return fail(error, sequence == 0 ? QString("Wrong passphrase or damaged file")
+                                             : QString("Record %1 is damaged").arg(sequence + 1));
+        }
+        decrypted.append(plaintext);
+    }
+
+    key.fill('\0');
+    records.append(decrypted);
+    return true;
+}
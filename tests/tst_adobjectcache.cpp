@@ -0,0 +1,86 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/ADObjectCache.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+class TestADObjectCache : public QObject {
+    Q_OBJECT
+
+private slots:
+    void evictsLeastRecentlyUsed() {
+        ADObjectCache cache(300, 60000);
+        cache.insert("a", 1, "1", 100);
+        cache.insert("b", 2, "1", 100);
+        cache.insert("c", 3, "1", 100);
+
+        // Touching a makes b the least recently used
+        QVariant value;
+        QString version;
+        QCOMPARE(cache.lookup("a", value, version), ADObjectCache::Lookup::Fresh);
+        QCOMPARE(value.toInt(), 1);
+
+        cache.insert("d", 4, "1", 100);
+        QCOMPARE(cache.lookup("b", value, version), ADObjectCache::Lookup::Miss);
+        QCOMPARE(cache.lookup("a", value, version), ADObjectCache::Lookup::Fresh);
+        QCOMPARE(cache.lookup("c", value, version), ADObjectCache::Lookup::Fresh);
+        QCOMPARE(cache.lookup("d", value, version), ADObjectCache::Lookup::Fresh);
+
+        const ObjectCacheStats stats = cache.stats();
+        QCOMPARE(stats.evictions, quint64(1));
+        QCOMPARE(stats.entries, 3);
+        QCOMPARE(stats.bytes, qint64(300));
+    }
+
+    void rejectsOversizedObjects() {
+        ADObjectCache cache(300, 60000);
+        cache.insert("big", 1, "1", 200);
+        QVariant value;
+        QString version;
+        QCOMPARE(cache.lookup("big", value, version), ADObjectCache::Lookup::Miss);
+    }
+
+    void staleAfterTtlUntilRevalidated() {
+        ADObjectCache cache(1024, 0);
+        cache.insert("user", QString("cached"), "42", 10);
+
+        QVariant value;
+        QString version;
+        QCOMPARE(cache.lookup("user", value, version), ADObjectCache::Lookup::Stale);
+        QCOMPARE(version, QString("42"));
+        QCOMPARE(value.toString(), QString("cached"));
+
+        cache.setTtl(60000);
+        cache.revalidated("user");
+        QCOMPARE(cache.lookup("user", value, version), ADObjectCache::Lookup::Fresh);
+        QCOMPARE(cache.stats().revalidations, quint64(1));
+
+        cache.invalidate("user");
+        QCOMPARE(cache.lookup("user", value, version), ADObjectCache::Lookup::Miss);
+    }
+
+    void managerRevalidatesByUsn() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<InMemoryDirectoryBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(2, 1);
+        const QString dn = "CN=user000001,OU=SRV001,DC=example,DC=com";
+
+        manager.getObjectCache()->setTtl(0);
+        QCOMPARE(manager.getUserInfo(dn).getLogin(), QString("user000001"));
+
+        // Unchanged: the stale copy is confirmed by its uSNChanged
+        manager.getObjectCache()->resetStats();
+        QCOMPARE(manager.getUserInfo(dn).getLogin(), QString("user000001"));
+        QCOMPARE(manager.objectCacheStats().revalidations, quint64(1));
+
+        // Changed behind the cache's back: reloaded
+        ADObjectChangeSet changes(dn);
+        changes.put("displayName", "Renamed");
+        QVERIFY(backend->modifyEntry(changes));
+        QCOMPARE(manager.getUserInfo(dn).getFullName(), QString("Renamed"));
+        QCOMPARE(manager.objectCacheStats().revalidations, quint64(1));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestADObjectCache)
+#include "tst_adobjectcache.moc"
@@ -0,0 +1,63 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+// The read path before attributes went through IADs::Get: every read first
+// resolved the attribute name against the object's type information
+// (IDispatch::GetIDsOfNames) and then fetched the value by that id
+// (IDispatch::Invoke). Here that is one lookup of the object's attribute
+// names followed by the read itself.
+class ResolveEachReadBackend : public InMemoryDirectoryBackend {
+public:
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override {
+        DirectoryEntry typeInfo;
+        if (!InMemoryDirectoryBackend::readEntry(dn, QStringList(), typeInfo)) {
+            return false;
+        }
+        const QStringList names = typeInfo.getAttributeNames();
+        for (const QString& attribute : attributes) {
+            if (!names.contains(attribute, Qt::CaseInsensitive)) {
+                setError(DirectoryError::NoSuchAttribute, QString("Unknown name %1").arg(attribute));
+                return false;
+            }
+        }
+        return InMemoryDirectoryBackend::readEntry(dn, attributes, entry);
+    }
+};
+
+class TestAttributeReads : public QObject {
+    Q_OBJECT
+
+private slots:
+    void readAttributes_data() {
+        QTest::addColumn<bool>("resolveEachRead");
+        QTest::newRow("before: name resolved per read") << true;
+        QTest::newRow("after: read by name") << false;
+    }
+
+    // 10,000 reads of the server metadata attribute
+    void readAttributes() {
+        QFETCH(bool, resolveEachRead);
+        std::unique_ptr<InMemoryDirectoryBackend> backend;
+        if (resolveEachRead) {
+            backend = std::make_unique<ResolveEachReadBackend>();
+        } else {
+            backend = std::make_unique<InMemoryDirectoryBackend>();
+        }
+        ADManager manager(nullptr, std::move(backend));
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(10, 1);
+        QVERIFY(manager.setServerMetadata("SRV001", QJsonObject{{"owner", "ops"}}));
+
+        QBENCHMARK {
+            for (int i = 0; i < 10000; ++i) {
+                if (manager.getServerMetadata("SRV001").isEmpty()) {
+                    QFAIL("metadata read failed");
+                }
+            }
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(TestAttributeReads)
+#include "tst_attributereads.moc"
@@ -0,0 +1,52 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/BulkUserCreator.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+class TestBulkUserCreator : public QObject {
+    Q_OBJECT
+
+private slots:
+    void createsBatchForNewServerInParallel() {
+        ADManager source(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(source.connectToAD());
+
+        const int count = 40;
+        QList<UserInfo> users;
+        for (int i = 0; i < count; ++i) {
+            users << UserInfo(QString("bulk%1").arg(i), QString("Bulk User %1").arg(i));
+        }
+
+        BulkUserCreator creator(&source);
+        creator.setConcurrency(8);
+        QSignalSpy finished(&creator, &BulkUserCreator::finished);
+        QVERIFY(creator.start(users, "SRV900"));
+        QVERIFY(finished.wait(30000));
+
+        QCOMPARE(finished.first().at(0).toInt(), count);
+        for (const BulkCreateResult& result : creator.results()) {
+            QVERIFY2(result.success, qPrintable(result.error));
+        }
+        QCOMPARE(source.getUsersForServer("SRV900").size(), count);
+    }
+
+    void serverCreatedConcurrentlyIsNotAnError() {
+        ADManager first(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(first.connectToAD());
+        ADManager second(nullptr, first.getBackend()->clone());
+        QVERIFY(second.connectToAD());
+
+        // first remembers the server as missing, then second creates it
+        QVERIFY(!first.serverExists("SRV901"));
+        QVERIFY(second.createServerOU("SRV901"));
+        QVERIFY(second.createServerGroup("SRV901"));
+
+        QSignalSpy errors(&first, &ADManager::error);
+        QVERIFY(first.createServerOU("SRV901"));
+        QVERIFY(first.createServerGroup("SRV901"));
+        QCOMPARE(errors.count(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestBulkUserCreator)
+#include "tst_bulkusercreator.moc"
@@ -0,0 +1,133 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+// Drops the connection after a number of writes in a batch: the rest of
+// the batch is not sent
+class CutShortBackend : public InMemoryDirectoryBackend {
+public:
+    int writesBeforeCut = -1;
+    QString endpoint = "DC=example,DC=com";
+
+    QString getEndpoint() const override { return endpoint; }
+
+    bool modifyEntries(const QList<ADObjectChangeSet>& changes, QList<DirectoryWriteResult>& results) override {
+        if (writesBeforeCut < 0 || writesBeforeCut >= changes.size()) {
+            return InMemoryDirectoryBackend::modifyEntries(changes, results);
+        }
+        InMemoryDirectoryBackend::modifyEntries(changes.mid(0, writesBeforeCut), results);
+        setError(DirectoryError::Unavailable, "connection lost");
+        return false;
+    }
+};
+
+class TestDeactivateUsers : public QObject {
+    Q_OBJECT
+
+private:
+    static QString userDN(int i) {
+        return QString("CN=user%1,OU=SRV001,DC=example,DC=com").arg(i, 6, 10, QChar('0'));
+    }
+
+private slots:
+    void deactivatesAndSkipsDisabled() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(3, 1);
+
+        const QStringList dns{userDN(1), userDN(2), userDN(1), "CN=ghost,OU=SRV001,DC=example,DC=com"};
+        QSignalSpy errors(&manager, &ADManager::error);
+        const QList<BulkDeactivateResult> results = manager.deactivateUsers(dns);
+        QCOMPARE(results.size(), 4);
+        QVERIFY(results[0].isDeactivated());
+        QVERIFY(results[1].isDeactivated());
+        QVERIFY(results[2].isDeactivated());
+        QCOMPARE(results[3].status, BulkDeactivateResult::Status::NotFound);
+        QVERIFY(results[3].error.contains("does not exist"));
+
+        // A missing user is reported as such, not as a failed change
+        QCOMPARE(errors.count(), 1);
+        const QString message = errors.first().first().toString();
+        QVERIFY2(message.contains("1 do not exist"), qPrintable(message));
+        QVERIFY2(!message.contains("could not be deactivated"), qPrintable(message));
+
+        QVERIFY(!manager.getUserInfo(userDN(1)).isActive());
+        QVERIFY(manager.getUserInfo(userDN(3)).isActive());
+
+        // Already disabled counts as done without a write
+        errors.clear();
+        for (const BulkDeactivateResult& result : manager.deactivateUsers({userDN(1), userDN(2)})) {
+            QVERIFY(result.isDeactivated());
+        }
+        QCOMPARE(errors.count(), 0);
+    }
+
+    // The retry layer sends what a cut-short batch did not, one by one
+    void batchCutShortIsFinished() {
+        auto backend = std::make_unique<CutShortBackend>();
+        CutShortBackend* cutShort = backend.get();
+        ADManager manager(nullptr, std::move(backend));
+        QVERIFY(manager.connectToAD());
+        cutShort->seedSyntheticUsers(6, 1);
+        QVERIFY(manager.deactivateUser(userDN(2)));
+
+        cutShort->writesBeforeCut = 2;
+        QStringList dns;
+        for (int i = 1; i <= 6; ++i) {
+            dns << userDN(i);
+        }
+        QSignalSpy errors(&manager, &ADManager::error);
+        const QList<BulkDeactivateResult> results = manager.deactivateUsers(dns);
+
+        for (const BulkDeactivateResult& result : results) {
+            QVERIFY2(result.isDeactivated(), qPrintable(result.error));
+        }
+        QCOMPARE(errors.count(), 0);
+        QVERIFY(!manager.getUserInfo(userDN(6)).isActive());
+    }
+
+    // When the rest cannot be sent either, it is reported as not attempted
+    // rather than as failed changes
+    void unsentRestIsNotAttempted() {
+        auto backend = std::make_unique<CutShortBackend>();
+        CutShortBackend* cutShort = backend.get();
+        // A circuit of its own, so opening it does not affect other tests
+        cutShort->endpoint = "unreachable.example.com";
+        ADManager manager(nullptr, std::move(backend));
+        RetryPolicy policy;
+        policy.breakerThreshold = 1;
+        manager.setRetryPolicy(policy);
+        QVERIFY(manager.connectToAD());
+        cutShort->seedSyntheticUsers(6, 1);
+        QVERIFY(manager.deactivateUser(userDN(2)));
+
+        cutShort->writesBeforeCut = 2;
+        QStringList dns;
+        for (int i = 1; i <= 6; ++i) {
+            dns << userDN(i);
+        }
+        QSignalSpy errors(&manager, &ADManager::error);
+        const QList<BulkDeactivateResult> results = manager.deactivateUsers(dns);
+
+        // user 2 was already disabled; 1 and 3 were written before the cut
+        for (int i : {0, 1, 2}) {
+            QVERIFY2(results[i].isDeactivated(), qPrintable(results[i].error));
+        }
+        for (int i : {3, 4, 5}) {
+            QCOMPARE(results[i].status, BulkDeactivateResult::Status::NotAttempted);
+            QVERIFY2(results[i].error.startsWith("Not attempted: "), qPrintable(results[i].error));
+        }
+        // Read past the open circuit
+        DirectoryEntry user4;
+        QVERIFY(cutShort->readEntry(userDN(4), {"userAccountControl"}, user4));
+        QCOMPARE(user4.getValue("userAccountControl"), QString("512"));
+
+        QCOMPARE(errors.count(), 1);
+        const QString message = errors.first().first().toString();
+        QVERIFY2(message.contains("3 were not attempted"), qPrintable(message));
+        QVERIFY2(!message.contains("could not be deactivated"), qPrintable(message));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDeactivateUsers)
+#include "tst_deactivateusers.moc"
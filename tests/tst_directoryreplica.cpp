@@ -0,0 +1,79 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+class TestDirectoryReplica : public QObject {
+    Q_OBJECT
+
+private slots:
+    void incrementalSyncAppliesChangesAndTombstones() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<InMemoryDirectoryBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(6, 2);
+
+        // First sync: everything, staged into a fresh replica
+        ReplicaSyncResult full = manager.syncReplica();
+        QVERIFY(full.success);
+        QVERIFY(full.fullSync);
+        QCOMPARE(full.updated, 2 + 2 + 6); // OUs, groups, users
+        QVERIFY(full.watermark > 0);
+        QVERIFY(manager.isReplicaReady());
+        QCOMPARE(manager.getReplica()->getServerNames(), QStringList({"SRV001", "SRV002"}));
+        QCOMPARE(manager.getReplica()->getUsersForServer("SRV001").size(), 3);
+
+        // Nothing changed: nothing fetched
+        ReplicaSyncResult idle = manager.syncReplica();
+        QVERIFY(idle.success);
+        QVERIFY(!idle.fullSync);
+        QCOMPARE(idle.updated, 0);
+        QCOMPARE(idle.deleted, 0);
+        QCOMPARE(idle.watermark, full.watermark);
+
+        // One user renamed, another deleted
+        ADObjectChangeSet changes("CN=user000001,OU=SRV001,DC=example,DC=com");
+        changes.put("displayName", "Renamed");
+        QVERIFY(backend->modifyEntry(changes));
+        QVERIFY(backend->deleteEntry("CN=user000003,OU=SRV001,DC=example,DC=com"));
+
+        ReplicaSyncResult delta = manager.syncReplica();
+        QVERIFY(delta.success);
+        QVERIFY(!delta.fullSync);
+        QCOMPARE(delta.updated, 1);
+        QCOMPARE(delta.deleted, 1);
+        QVERIFY(delta.watermark > full.watermark);
+        QCOMPARE(delta.changedServers, QStringList({"SRV001"}));
+
+        // Seeded users alternate between servers: SRV001 had 1, 3 and 5
+        QStringList names;
+        for (const DirectoryEntry& user : manager.getReplica()->getUsersForServer("SRV001")) {
+            names << user.getValue("displayName");
+        }
+        names.sort();
+        QCOMPARE(names, QStringList({"Renamed", "User 5"}));
+        QCOMPARE(manager.getReplica()->getUsersForServer("SRV002").size(), 3);
+    }
+
+    void replicaOfAnotherDirectoryIsRebuilt() {
+        auto replica = std::make_shared<DirectoryReplica>();
+
+        ADManager first(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        first.setReplica(replica);
+        QVERIFY(first.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(first.getBackend())->seedSyntheticUsers(4, 1);
+        QVERIFY(first.syncReplica().fullSync);
+
+        // Another in-memory store is another directory, whatever its USNs
+        ADManager second(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        second.setReplica(replica);
+        QVERIFY(second.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(second.getBackend())->seedSyntheticUsers(2, 1);
+        ReplicaSyncResult result = second.syncReplica();
+        QVERIFY(result.success);
+        QVERIFY(result.fullSync);
+        QCOMPARE(replica->getUsersForServer("SRV001").size(), 2);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDirectoryReplica)
+#include "tst_directoryreplica.moc"
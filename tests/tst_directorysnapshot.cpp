@@ -0,0 +1,97 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "services/DirectorySnapshot.h"
+
+class TestDirectorySnapshot : public QObject {
+    Q_OBJECT
+
+private:
+    static QList<DirectorySnapshot::Object> directory(int users, int servers) {
+        QList<DirectorySnapshot::Object> objects;
+        for (int s = 1; s <= servers; ++s) {
+            const QString server = QString("SRV%1").arg(s, 3, 10, QChar('0'));
+            DirectorySnapshot::Object ou;
+            ou.kind = DirectoryObjectKind::Server;
+            ou.server = server;
+            ou.entry = DirectoryEntry(QString("OU=%1,DC=example,DC=com").arg(server));
+            ou.entry.setValue("ou", server);
+            objects << ou;
+        }
+        for (int u = 0; u < users; ++u) {
+            const QString server = QString("SRV%1").arg(u % servers + 1, 3, 10, QChar('0'));
+            DirectorySnapshot::Object user;
+            user.kind = DirectoryObjectKind::User;
+            user.server = server;
+            user.entry = DirectoryEntry(QString("CN=user%1,OU=%2,DC=example,DC=com").arg(u).arg(server));
+            user.entry.setValue("sAMAccountName", QString("user%1").arg(u));
+            user.entry.setValue("displayName", QString("User %1").arg(u));
+            objects << user;
+        }
+        return objects;
+    }
+
+private slots:
+    void roundTrip() {
+        QTemporaryDir dir;
+        const QString path = dir.filePath("directory.snapshot");
+        QVERIFY(DirectorySnapshot::write(path, "DC=example,DC=com", 4711, directory(10, 2)));
+
+        DirectorySnapshot snapshot;
+        QVERIFY(snapshot.open(path));
+        QCOMPARE(snapshot.getSource(), QString("DC=example,DC=com"));
+        QCOMPARE(snapshot.getWatermark(), qint64(4711));
+        QCOMPARE(snapshot.getServerNames(), QStringList({"SRV001", "SRV002"}));
+        QVERIFY(snapshot.hasServer("srv002"));
+        QVERIFY(!snapshot.hasServer("SRV003"));
+        QCOMPARE(snapshot.objectCount(), 12);
+
+        const QList<DirectoryEntry> users = snapshot.getUsersForServer("SRV002");
+        QCOMPARE(users.size(), 5);
+        QCOMPARE(users.first().getValue("sAMAccountName"), QString("user1"));
+        QCOMPARE(users.first().getValue("displayName"), QString("User 1"));
+        QCOMPARE(users.first().getDistinguishedName(), QString("CN=user1,OU=SRV002,DC=example,DC=com"));
+    }
+
+    void rejectsForeignAndTruncatedFiles() {
+        QTemporaryDir dir;
+        const QString path = dir.filePath("directory.snapshot");
+        QVERIFY(DirectorySnapshot::write(path, "DC=example,DC=com", 1, directory(100, 4)));
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() / 2));
+        file.close();
+        DirectorySnapshot snapshot;
+        QVERIFY(!snapshot.open(path));
+
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(QByteArray(4096, 'x'));
+        file.close();
+        QVERIFY(!snapshot.open(path));
+        QVERIFY(!snapshot.isOpen());
+        QVERIFY(snapshot.getServerNames().isEmpty());
+    }
+
+    // The window shows the last known directory at startup: opening a
+    // snapshot of 50,000 users and listing a server must take under 100 ms
+    void opensLargeSnapshotQuickly() {
+        QTemporaryDir dir;
+        const QString path = dir.filePath("directory.snapshot");
+        QVERIFY(DirectorySnapshot::write(path, "DC=example,DC=com", 1, directory(50000, 100)));
+
+        QElapsedTimer timer;
+        timer.start();
+        DirectorySnapshot snapshot;
+        QVERIFY(snapshot.open(path));
+        const QStringList servers = snapshot.getServerNames();
+        const QList<DirectoryEntry> users = snapshot.getUsersForServer(servers.first());
+        const qint64 elapsedMs = timer.elapsed();
+
+        QCOMPARE(servers.size(), 100);
+        QCOMPARE(users.size(), 500);
+        QVERIFY2(elapsedMs < 100, qPrintable(QString("startup took %1 ms").arg(elapsedMs)));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDirectorySnapshot)
+#include "tst_directorysnapshot.moc"
@@ -0,0 +1,93 @@
+#include <QtTest>
+#include <QtConcurrent>
+#include "models/DistinguishedName.h"
+
+class TestDistinguishedName : public QObject {
+    Q_OBJECT
+
+private slots:
+    void sharesNodesIgnoringCaseAndSpacing() {
+        const DistinguishedName a(u"CN=jdoe,OU=SRV01,DC=example,DC=com");
+        const DistinguishedName b(u"cn=JDOE , ou=srv01,dc=EXAMPLE,dc=com");
+        QCOMPARE(a, b);
+        QCOMPARE(qHash(a), qHash(b));
+        QVERIFY(a != DistinguishedName(u"CN=other,OU=SRV01,DC=example,DC=com"));
+        QVERIFY(DistinguishedName().isNull());
+        QVERIFY(DistinguishedName(u"  ").isNull());
+    }
+
+    void keepsEachLeafsSpelling() {
+        const DistinguishedName first(u"CN=first,OU=SRV02,DC=example,DC=com");
+        // Shares OU=SRV02 and above with first, spelled differently
+        const DistinguishedName second(u"CN=Second,ou=srv02,dc=Example,dc=Com");
+        QCOMPARE(first.toString(), QString("CN=first,OU=SRV02,DC=example,DC=com"));
+        QCOMPARE(second.toString(), QString("CN=Second,ou=srv02,dc=Example,dc=Com"));
+        QCOMPARE(second.parent(), first.parent());
+        QCOMPARE(first.parent().toString(), QString("OU=SRV02,DC=example,DC=com"));
+        QVERIFY(DistinguishedName(u"DC=com").parent().isNull());
+    }
+
+    void releasesNodesWithTheLastHandle() {
+        const qsizetype before = DistinguishedName::poolSize();
+        {
+            DistinguishedName dn(u"CN=temp,OU=Scratch,DC=unused,DC=test");
+            QCOMPARE(DistinguishedName::poolSize(), before + 4);
+
+            DistinguishedName copy = dn;
+            DistinguishedName parent = dn.parent();
+            dn = DistinguishedName();
+            QCOMPARE(DistinguishedName::poolSize(), before + 4);
+            copy = DistinguishedName();
+            QCOMPARE(DistinguishedName::poolSize(), before + 3);
+            QCOMPARE(parent.toString(), QString("OU=Scratch,DC=unused,DC=test"));
+        }
+        QCOMPARE(DistinguishedName::poolSize(), before);
+    }
+
+    void concurrentInterning() {
+        const qsizetype before = DistinguishedName::poolSize();
+        QList<int> batches(8);
+        QtConcurrent::blockingMap(batches, [](int&) {
+            for (int round = 0; round < 50; ++round) {
+                QList<DistinguishedName> dns;
+                for (int i = 0; i < 100; ++i) {
+                    dns.append(DistinguishedName(QString("CN=u%1,OU=Race,DC=example,DC=com").arg(i)));
+                }
+                for (int i = 0; i < 100; ++i) {
+                    if (dns[i].toString() != QString("CN=u%1,OU=Race,DC=example,DC=com").arg(i)) {
+                        qFatal("wrong DN text");
+                    }
+                }
+            }
+        });
+        QCOMPARE(DistinguishedName::poolSize(), before);
+    }
+
+    // 1,000,000 user DNs interned while 10,000 of them are held, as a
+    // directory cache of that size would do
+    void benchmarkInterning() {
+        QStringList text;
+        for (int i = 0; i < 10000; ++i) {
+            text << QString("CN=user%1,OU=SRV%2,DC=example,DC=com").arg(i, 6, 10, QChar('0')).arg(i % 100, 3, 10, QChar('0'));
+        }
+        QList<DistinguishedName> held;
+        for (const QString& dn : text) {
+            held.append(DistinguishedName(dn));
+        }
+        const qsizetype pooled = DistinguishedName::poolSize();
+
+        QBENCHMARK {
+            for (int pass = 0; pass < 100; ++pass) {
+                for (int i = 0; i < text.size(); ++i) {
+                    if (DistinguishedName(text[i]) != held[i]) {
+                        QFAIL("interned DN differs");
+                    }
+                }
+            }
+        }
+        QCOMPARE(DistinguishedName::poolSize(), pooled);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDistinguishedName)
+#include "tst_distinguishedname.moc"
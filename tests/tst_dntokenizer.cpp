@@ -0,0 +1,163 @@
+#include <QtTest>
+#include <QRegularExpression>
+#include "utils/DnTokenizer.h"
+
+class TestDnTokenizer : public QObject {
+    Q_OBJECT
+
+private:
+    static QStringList split(const QString& dn, bool* error = nullptr) {
+        QStringList rdns;
+        DnTokenizer tokens(dn);
+        QStringView rdn;
+        while (tokens.next(rdn)) {
+            rdns << rdn.toString();
+        }
+        if (error) {
+            *error = tokens.hasError();
+        }
+        return rdns;
+    }
+
+    // Server (first OU) and login (CN) of a user DN, as getUserInfo read
+    // them before the tokenizer: two regular expressions built per call
+    static int regexFields(const QString& dn, QString& server, QString& login) {
+        QRegularExpression serverRegex("OU=([^,]+),");
+        QRegularExpressionMatch serverMatch = serverRegex.match(dn);
+        if (serverMatch.hasMatch()) {
+            server = serverMatch.captured(1);
+        }
+        QRegularExpression loginRegex("CN=([^,]+),");
+        QRegularExpressionMatch loginMatch = loginRegex.match(dn);
+        if (loginMatch.hasMatch()) {
+            login = loginMatch.captured(1);
+        }
+        return server.length() + login.length();
+    }
+
+    static int tokenizerFields(const QString& dn, QString& server, QString& login) {
+        DnTokenizer tokens(dn);
+        QStringView rdn;
+        while (tokens.next(rdn)) {
+            QStringView cn = DnTokenizer::attributeValue(rdn, u"CN");
+            if (!cn.isNull() && login.isNull()) {
+                login = DnTokenizer::unescape(cn);
+            }
+            QStringView ou = DnTokenizer::attributeValue(rdn, u"OU");
+            if (!ou.isNull()) {
+                server = DnTokenizer::unescape(ou);
+                break;
+            }
+        }
+        return server.length() + login.length();
+    }
+
+    static QStringList userDns() {
+        QStringList dns;
+        for (int i = 0; i < 1000; ++i) {
+            dns << QString("CN=user%1,OU=SRV%2,DC=example,DC=com").arg(i, 6, 10, QChar('0')).arg(i % 100, 3, 10, QChar('0'));
+        }
+        return dns;
+    }
+
+private slots:
+    void splitsRdns_data() {
+        QTest::addColumn<QString>("dn");
+        QTest::addColumn<QStringList>("rdns");
+
+        QTest::newRow("plain") << "CN=jdoe,OU=SRV01,DC=example,DC=com"
+                               << QStringList{"CN=jdoe", "OU=SRV01", "DC=example", "DC=com"};
+        QTest::newRow("escaped comma") << "CN=Smith\\, J,OU=SRV01"
+                                       << QStringList{"CN=Smith\\, J", "OU=SRV01"};
+        QTest::newRow("hex comma") << "CN=Smith\\2C J,OU=SRV01"
+                                   << QStringList{"CN=Smith\\2C J", "OU=SRV01"};
+        QTest::newRow("multi-valued") << "CN=a+UID=b,DC=com" << QStringList{"CN=a+UID=b", "DC=com"};
+        QTest::newRow("escaped plus") << "CN=a\\+b,DC=com" << QStringList{"CN=a\\+b", "DC=com"};
+        QTest::newRow("spaces") << "CN=jdoe , OU=SRV01" << QStringList{"CN=jdoe", "OU=SRV01"};
+        QTest::newRow("hexstring") << "UID=#04024869,DC=com" << QStringList{"UID=#04024869", "DC=com"};
+        QTest::newRow("oid type") << "2.5.4.3=jdoe,DC=com" << QStringList{"2.5.4.3=jdoe", "DC=com"};
+    }
+
+    void splitsRdns() {
+        QFETCH(QString, dn);
+        QFETCH(QStringList, rdns);
+        bool error = true;
+        QCOMPARE(split(dn, &error), rdns);
+        QVERIFY(!error);
+    }
+
+    void rejectsMalformed_data() {
+        QTest::addColumn<QString>("dn");
+
+        QTest::newRow("missing equals") << "CN,DC=com";
+        QTest::newRow("incomplete hex escape") << "CN=a\\2,DC=com";
+        QTest::newRow("invalid escape") << "CN=a\\q,DC=com";
+        QTest::newRow("odd hexstring") << "UID=#123,DC=com";
+        QTest::newRow("unescaped quote") << "CN=a\"b,DC=com";
+        QTest::newRow("trailing comma") << "CN=a,DC=com,";
+    }
+
+    void rejectsMalformed() {
+        QFETCH(QString, dn);
+        bool error = false;
+        split(dn, &error);
+        QVERIFY(error);
+    }
+
+    void unescapesValues() {
+        QCOMPARE(DnTokenizer::unescape(u"Smith\\, J"), QString("Smith, J"));
+        QCOMPARE(DnTokenizer::unescape(u"Smith\\2C J"), QString("Smith, J"));
+        // A character spread over several hex pairs (UTF-8 octets)
+        QCOMPARE(DnTokenizer::unescape(u"Caf\\C3\\A9"), QString::fromUtf8("Caf\xC3\xA9"));
+        QCOMPARE(DnTokenizer::unescape(u"\\D0\\86\\D0\\B2\\D0\\B0\\D0\\BD"), QString::fromUtf8("\xD0\x86\xD0\xB2\xD0\xB0\xD0\xBD"));
+        QCOMPARE(DnTokenizer::unescape(u"#04024869"), QString("#04024869"));
+    }
+
+    void picksAttributeValues() {
+        QCOMPARE(DnTokenizer::attributeValue(u"CN=a+UID=b", u"uid").toString(), QString("b"));
+        QCOMPARE(DnTokenizer::attributeValue(u"OU=SRV01", u"ou").toString(), QString("SRV01"));
+        QVERIFY(DnTokenizer::attributeValue(u"CN=a", u"OU").isNull());
+    }
+
+    void comparesRdns() {
+        QVERIFY(DnTokenizer::sameRdn(u"DC=Example", u"dc = example"));
+        QVERIFY(DnTokenizer::sameRdn(u"CN=Smith\\, J", u"cn=Smith\\2c j"));
+        QVERIFY(DnTokenizer::sameRdn(u"CN=a+UID=b", u"CN=a + uid=B"));
+        QVERIFY(!DnTokenizer::sameRdn(u"CN=a+UID=b", u"CN=a"));
+        QVERIFY(!DnTokenizer::sameRdn(u"OU=example", u"DC=example"));
+        QVERIFY(!DnTokenizer::sameRdn(u"DC=example", u"DC=examples"));
+    }
+
+    void benchmarkUserFields_data() {
+        QTest::addColumn<bool>("tokenizer");
+        QTest::newRow("regex") << false;
+        QTest::newRow("tokenizer") << true;
+    }
+
+    // Server and login out of 1,000,000 user DNs (1,000 distinct ones)
+    void benchmarkUserFields() {
+        QFETCH(bool, tokenizer);
+        const QStringList dns = userDns();
+        for (const QString& dn : dns) {
+            QString regexServer, regexLogin, server, login;
+            regexFields(dn, regexServer, regexLogin);
+            tokenizerFields(dn, server, login);
+            QCOMPARE(server, regexServer);
+            QCOMPARE(login, regexLogin);
+        }
+
+        qint64 total = 0;
+        QBENCHMARK {
+            for (int pass = 0; pass < 1000; ++pass) {
+                for (const QString& dn : dns) {
+                    QString server, login;
+                    total += tokenizer ? tokenizerFields(dn, server, login) : regexFields(dn, server, login);
+                }
+            }
+        }
+        QVERIFY(total > 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestDnTokenizer)
+#include "tst_dntokenizer.moc"
@@ -0,0 +1,78 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+class TestExistenceChecks : public QObject {
+    Q_OBJECT
+
+private:
+    static UserInfo userNamed(const QString& login) {
+        UserInfo user;
+        user.setLogin(login);
+        return user;
+    }
+
+private slots:
+    // createUser asks whether the server exists, then createServerOU and
+    // createServerGroup ask again; one operation, one directory lookup
+    void nestedCallsLookUpOnce() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        // No reuse across operations, so only the operation scope can save lookups
+        manager.setExistenceTtl(0);
+
+        QVERIFY(manager.createUser(userNamed("jdoe"), "SRV001"));
+        ExistenceCheckStats stats = manager.existenceStats();
+        QVERIFY2(stats.checks >= 2, qPrintable(QString("%1 checks").arg(stats.checks)));
+        QCOMPARE(stats.directoryLookups, quint64(1));
+
+        // The next operation asks the directory again
+        manager.resetExistenceStats();
+        QVERIFY(manager.createUser(userNamed("asmith"), "SRV001"));
+        QCOMPARE(manager.existenceStats().directoryLookups, quint64(1));
+
+        {
+            ADManager::OperationScope scope(&manager);
+            manager.resetExistenceStats();
+            QVERIFY(manager.serverExists("SRV001"));
+            QVERIFY(manager.serverExists("srv001"));
+            QVERIFY(!manager.serverExists("SRV002"));
+            QVERIFY(!manager.serverExists("SRV002"));
+        }
+        stats = manager.existenceStats();
+        QCOMPARE(stats.checks, quint64(4));
+        QCOMPARE(stats.directoryLookups, quint64(2));
+    }
+
+    // Outside an operation an answer is reused until the TTL runs out
+    void answersExpire() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(1, 1);
+        manager.setExistenceTtl(100);
+
+        QVERIFY(manager.serverExists("SRV001"));
+        QVERIFY(manager.serverExists("SRV001"));
+        QCOMPARE(manager.existenceStats().directoryLookups, quint64(1));
+
+        QTest::qSleep(150);
+        QVERIFY(manager.serverExists("SRV001"));
+        QCOMPARE(manager.existenceStats().checks, quint64(3));
+        QCOMPARE(manager.existenceStats().directoryLookups, quint64(2));
+    }
+
+    // A server created by this manager is known to exist without a lookup
+    void createdServerIsRemembered() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        manager.setExistenceTtl(60000);
+
+        QVERIFY(manager.createServerOU("SRV003"));
+        manager.resetExistenceStats();
+        QVERIFY(manager.serverExists("SRV003"));
+        QCOMPARE(manager.existenceStats().directoryLookups, quint64(0));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestExistenceChecks)
+#include "tst_existencechecks.moc"
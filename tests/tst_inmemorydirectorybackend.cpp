@@ -0,0 +1,117 @@
+#include <QtTest>
+#include "services/InMemoryDirectoryBackend.h"
+
+class TestInMemoryDirectoryBackend : public QObject {
+    Q_OBJECT
+
+private:
+    static DirectoryEntry ou(const QString& dn) {
+        DirectoryEntry entry(dn);
+        entry.setValues("objectClass", {"top", "organizationalUnit"});
+        return entry;
+    }
+
+    static DirectoryEntry user(const QString& dn, const QString& login) {
+        DirectoryEntry entry(dn);
+        entry.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+        entry.setValue("sAMAccountName", login);
+        return entry;
+    }
+
+private slots:
+    void connectCreatesNamingContext() {
+        InMemoryDirectoryBackend backend;
+        QVERIFY(backend.connect(QString()));
+        QCOMPARE(backend.getNamingContext(), QString(InMemoryDirectoryBackend::DefaultNamingContext));
+        QVERIFY(backend.entryExists("DC=example,DC=com"));
+    }
+
+    void addReadModifyDelete() {
+        InMemoryDirectoryBackend backend;
+        backend.connect(QString());
+        QVERIFY(backend.addEntry(ou("OU=SRV,DC=example,DC=com")));
+        QVERIFY(backend.addEntry(user("CN=jdoe,OU=SRV,DC=example,DC=com", "jdoe")));
+
+        DirectoryEntry entry;
+        QVERIFY(backend.readEntry("cn=JDOE,ou=srv,dc=example,dc=com", {"sAMAccountName", "uSNChanged"}, entry));
+        QCOMPARE(entry.getValue("sAMAccountName"), QString("jdoe"));
+        const qint64 usn = entry.getValue("uSNChanged").toLongLong();
+
+        ADObjectChangeSet changes("CN=jdoe,OU=SRV,DC=example,DC=com");
+        changes.put("displayName", "John Doe").append("mail", {"a@example.com", "b@example.com"});
+        QVERIFY(backend.modifyEntry(changes));
+        QVERIFY(backend.readEntry("CN=jdoe,OU=SRV,DC=example,DC=com", {"displayName", "mail", "uSNChanged"}, entry));
+        QCOMPARE(entry.getValue("displayName"), QString("John Doe"));
+        QCOMPARE(entry.getValues("mail").size(), 2);
+        QVERIFY(entry.getValue("uSNChanged").toLongLong() > usn);
+
+        QVERIFY(backend.deleteEntry("CN=jdoe,OU=SRV,DC=example,DC=com"));
+        QVERIFY(!backend.entryExists("CN=jdoe,OU=SRV,DC=example,DC=com"));
+        QVERIFY(!backend.readEntry("CN=jdoe,OU=SRV,DC=example,DC=com", {}, entry));
+        QCOMPARE(backend.lastError(), DirectoryError::NoSuchObject);
+    }
+
+    void rejectsDuplicatesAndOrphans() {
+        InMemoryDirectoryBackend backend;
+        backend.connect(QString());
+        QVERIFY(backend.addEntry(ou("OU=SRV,DC=example,DC=com")));
+
+        QVERIFY(!backend.addEntry(ou("OU=SRV,DC=example,DC=com")));
+        QCOMPARE(backend.lastError(), DirectoryError::AlreadyExists);
+
+        QVERIFY(!backend.addEntry(ou("OU=Child,OU=Missing,DC=example,DC=com")));
+        QCOMPARE(backend.lastError(), DirectoryError::NoSuchObject);
+
+        QVERIFY(backend.addEntry(user("CN=a,OU=SRV,DC=example,DC=com", "same")));
+        QVERIFY(!backend.addEntry(user("CN=b,OU=SRV,DC=example,DC=com", "SAME")));
+        QCOMPARE(backend.lastError(), DirectoryError::AlreadyExists);
+    }
+
+    void searchFiltersAndScopes() {
+        InMemoryDirectoryBackend backend;
+        backend.connect(QString());
+        backend.seedSyntheticUsers(30, 3);
+
+        SearchRequest request;
+        request.baseDN = "OU=SRV001,DC=example,DC=com";
+        request.filter = "(&(objectClass=user)(sAMAccountName=user*))";
+        request.attributes = {"sAMAccountName"};
+        request.pageSize = 4;
+
+        int pages = 0;
+        int entries = 0;
+        QVERIFY(backend.search(request, [&](const QList<DirectoryEntry>& page) {
+            ++pages;
+            entries += page.size();
+            return true;
+        }));
+        QCOMPARE(entries, 10);
+        QCOMPARE(pages, 3);
+
+        request.baseDN = "DC=example,DC=com";
+        request.scope = SearchScope::OneLevel;
+        request.filter = "(objectClass=organizationalUnit)";
+        entries = 0;
+        QVERIFY(backend.search(request, [&](const QList<DirectoryEntry>& page) {
+            entries += page.size();
+            return true;
+        }));
+        QCOMPARE(entries, 3);
+
+        request.filter = "(objectClass=";
+        QVERIFY(!backend.search(request, [](const QList<DirectoryEntry>&) { return true; }));
+        QCOMPARE(backend.lastError(), DirectoryError::InvalidArgument);
+    }
+
+    void clonesShareTheStore() {
+        InMemoryDirectoryBackend backend;
+        backend.connect(QString());
+        std::unique_ptr<IDirectoryBackend> clone = backend.clone();
+        QVERIFY(clone->connect(backend.getNamingContext()));
+        QVERIFY(clone->addEntry(ou("OU=Shared,DC=example,DC=com")));
+        QVERIFY(backend.entryExists("OU=Shared,DC=example,DC=com"));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestInMemoryDirectoryBackend)
+#include "tst_inmemorydirectorybackend.moc"
@@ -0,0 +1,351 @@
+#include <QtTest>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "services/ADManager.h"
+#include "services/LdapDirectoryBackend.h"
+
+// LdapDirectoryBackend against a throwaway slapd listening on a unix socket.
+// slapd is looked up in PATH and the usual sbin/libexec directories, or taken
+// from ADM_TEST_SLAPD; its schema directory (core, cosine, inetorgperson)
+// from ADM_TEST_SLAPD_SCHEMA or the usual /etc locations. The test skips
+// when either is missing.
+//
+// The directory gets just enough of the AD schema for ADManager: user and
+// group classes with sAMAccountName, objectCategory and extensionAttribute1
+// under their AD OIDs. objectCategory is a plain string here, so the
+// (objectCategory=person) shorthand AD accepts matches as well.
+class TestLdapDirectoryBackend : public QObject {
+    Q_OBJECT
+
+private:
+    static constexpr int UserCount = 250;
+    static constexpr int MemberCount = 3000; // twice AD's default MaxValRange
+
+    static QString firstExisting(const QStringList& candidates, const QString& file) {
+        for (const QString& dir : candidates) {
+            if (QFileInfo::exists(dir + "/" + file)) {
+                return dir;
+            }
+        }
+        return QString();
+    }
+
+    static QString userDN(int i) {
+        return QString("CN=user%1,OU=SRV001,DC=example,DC=com").arg(i, 6, 10, QChar('0'));
+    }
+
+    LdapConnectionSettings settings() const {
+        LdapConnectionSettings settings;
+        settings.uri = m_uri;
+        settings.bindDN = "CN=admin,DC=example,DC=com";
+        settings.password = "secret";
+        settings.timeoutMs = 5000;
+        return settings;
+    }
+
+    std::unique_ptr<LdapDirectoryBackend> connected() const {
+        auto backend = std::make_unique<LdapDirectoryBackend>(settings());
+        if (!backend->connect(QString())) {
+            return nullptr;
+        }
+        return backend;
+    }
+
+    bool writeConfig(const QString& schemaDir, const QString& moduleDir) {
+        QFile schema(m_dir.filePath("ad.schema"));
+        if (!schema.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        schema.write(R"(
+attributetype ( 1.2.840.113556.1.4.221 NAME 'sAMAccountName'
+    EQUALITY caseIgnoreMatch ORDERING caseIgnoreOrderingMatch SUBSTR caseIgnoreSubstringsMatch
+    SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 SINGLE-VALUE )
+attributetype ( 1.2.840.113556.1.4.656 NAME 'userPrincipalName'
+    EQUALITY caseIgnoreMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 SINGLE-VALUE )
+attributetype ( 1.2.840.113556.1.4.8 NAME 'userAccountControl'
+    EQUALITY integerMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.27 SINGLE-VALUE )
+attributetype ( 1.2.840.113556.1.4.782 NAME 'objectCategory'
+    EQUALITY caseIgnoreMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 SINGLE-VALUE )
+attributetype ( 1.2.840.113556.1.2.423 NAME 'extensionAttribute1'
+    EQUALITY caseIgnoreMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 SINGLE-VALUE )
+attributetype ( 1.2.840.113556.1.2.120 NAME 'uSNChanged'
+    EQUALITY integerMatch ORDERING integerOrderingMatch SYNTAX 1.3.6.1.4.1.1466.115.121.1.27 SINGLE-VALUE )
+objectclass ( 1.2.840.113556.1.5.9 NAME 'user' SUP organizationalPerson STRUCTURAL
+    MAY ( sAMAccountName $ userPrincipalName $ userAccountControl $ objectCategory $
+          displayName $ givenName $ mail $ extensionAttribute1 $ uSNChanged ) )
+objectclass ( 1.2.840.113556.1.5.8 NAME 'group' SUP top STRUCTURAL MUST cn
+    MAY ( member $ sAMAccountName $ objectCategory $ description $ extensionAttribute1 $ uSNChanged ) )
+objectclass ( 1.2.840.113556.1.5.67 NAME 'domainDNS' SUP domain STRUCTURAL )
+)");
+        schema.close();
+
+        QStringList config;
+        for (const QString& name : {"core", "cosine", "inetorgperson"}) {
+            config << QString("include %1/%2.schema").arg(schemaDir, name);
+        }
+        config << "include " + schema.fileName();
+        config << "pidfile " + m_dir.filePath("slapd.pid");
+        config << "sizelimit unlimited";
+        // Distribution builds ship back_mdb and sssvlv as modules or built in
+        const bool sssvlv = !moduleDir.isEmpty() && QFileInfo::exists(moduleDir + "/sssvlv.la");
+        if (!moduleDir.isEmpty()) {
+            config << "modulepath " + moduleDir << "moduleload back_mdb";
+            if (sssvlv) {
+                config << "moduleload sssvlv";
+            }
+        }
+        config << "database mdb"
+               << "maxsize 268435456"
+               << "suffix \"DC=example,DC=com\""
+               << "rootdn \"CN=admin,DC=example,DC=com\""
+               << "rootpw secret"
+               << "directory " + m_dir.filePath("db")
+               << "index objectClass eq"
+               << "index sAMAccountName eq,sub";
+        // Sort and VLV; without it the backend falls back to client-side windows
+        if (sssvlv) {
+            config << "overlay sssvlv";
+        }
+
+        QFile file(m_dir.filePath("slapd.conf"));
+        if (!QDir().mkpath(m_dir.filePath("db")) || !file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        file.write(config.join('\n').toUtf8() + '\n');
+        return true;
+    }
+
+    bool seed() {
+        auto backend = connected();
+        if (!backend) {
+            return false;
+        }
+
+        DirectoryEntry root("DC=example,DC=com");
+        root.setValues("objectClass", {"top", "domain", "domainDNS"});
+        root.setValue("dc", "example");
+        DirectoryEntry ou("OU=SRV001,DC=example,DC=com");
+        ou.setValues("objectClass", {"top", "organizationalUnit"});
+        ou.setValue("ou", "SRV001");
+        if (!backend->addEntry(root) || !backend->addEntry(ou)) {
+            return false;
+        }
+
+        for (int i = 1; i <= UserCount; ++i) {
+            const QString login = QString("user%1").arg(i, 6, 10, QChar('0'));
+            DirectoryEntry user(userDN(i));
+            user.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+            user.setValue("cn", login);
+            user.setValue("sn", "Synthetic");
+            user.setValue("sAMAccountName", login);
+            user.setValue("objectCategory", "person");
+            user.setValue("displayName", QString("User %1").arg(i));
+            if (!backend->addEntry(user)) {
+                return false;
+            }
+        }
+
+        // Member values are DNs; they need not exist, as slapd does not check
+        QStringList members;
+        for (int i = 1; i <= MemberCount; ++i) {
+            members << userDN(i);
+        }
+        DirectoryEntry group("CN=SRV001-Group,OU=SRV001,DC=example,DC=com");
+        group.setValues("objectClass", {"top", "group"});
+        group.setValue("cn", "SRV001-Group");
+        group.setValue("sAMAccountName", "SRV001-Group");
+        group.setValues("member", members);
+        return backend->addEntry(group);
+    }
+
+    QTemporaryDir m_dir;
+    QProcess m_slapd;
+    QString m_uri;
+
+private slots:
+    void initTestCase() {
+        QString slapd = qEnvironmentVariable("ADM_TEST_SLAPD");
+        if (slapd.isEmpty()) {
+            slapd = QStandardPaths::findExecutable("slapd");
+        }
+        if (slapd.isEmpty()) {
+            slapd = QStandardPaths::findExecutable("slapd", {"/usr/sbin", "/usr/local/sbin", "/usr/libexec",
+                                                             "/usr/local/libexec", "/opt/homebrew/opt/openldap/libexec"});
+        }
+        QString schemaDir = qEnvironmentVariable("ADM_TEST_SLAPD_SCHEMA");
+        if (schemaDir.isEmpty()) {
+            schemaDir = firstExisting({"/etc/ldap/schema", "/etc/openldap/schema", "/usr/local/etc/openldap/schema",
+                                       "/opt/homebrew/etc/openldap/schema"}, "core.schema");
+        }
+        if (slapd.isEmpty() || schemaDir.isEmpty()) {
+            QSKIP("slapd or its schema directory not found");
+        }
+        const QString moduleDir = firstExisting({"/usr/lib/ldap", "/usr/lib64/openldap", "/usr/lib/openldap",
+                                                 "/usr/libexec/openldap", "/usr/local/libexec/openldap"}, "back_mdb.la");
+
+        QVERIFY(m_dir.isValid());
+        QVERIFY(writeConfig(schemaDir, moduleDir));
+
+        m_uri = "ldapi://" + QString::fromLatin1(QUrl::toPercentEncoding(m_dir.filePath("ldapi")));
+        m_slapd.setProcessChannelMode(QProcess::MergedChannels);
+        // -d keeps slapd in the foreground, so it stops with the test
+        m_slapd.start(slapd, {"-f", m_dir.filePath("slapd.conf"), "-h", m_uri, "-d", "0"});
+        QVERIFY2(m_slapd.waitForStarted(), qPrintable(m_slapd.errorString()));
+
+        bool up = false;
+        for (int attempt = 0; attempt < 100 && !up; ++attempt) {
+            QVERIFY2(m_slapd.state() == QProcess::Running, m_slapd.readAll().constData());
+            up = connected() != nullptr;
+            if (!up) {
+                QTest::qWait(100);
+            }
+        }
+        QVERIFY2(up, "slapd did not accept connections");
+        QVERIFY(seed());
+    }
+
+    void cleanupTestCase() {
+        if (m_slapd.state() != QProcess::NotRunning) {
+            m_slapd.terminate();
+            if (!m_slapd.waitForFinished(5000)) {
+                m_slapd.kill();
+                m_slapd.waitForFinished();
+            }
+        }
+    }
+
+    void pagesThroughResults() {
+        auto backend = connected();
+        QVERIFY(backend);
+        QCOMPARE(backend->getNamingContext(), QString("DC=example,DC=com"));
+        QVERIFY(!backend->isActiveDirectory());
+
+        SearchRequest request;
+        request.baseDN = "OU=SRV001,DC=example,DC=com";
+        request.filter = "(objectClass=user)";
+        request.attributes = {"sAMAccountName"};
+        request.pageSize = 100;
+
+        QList<int> pages;
+        QSet<QString> logins;
+        QVERIFY(backend->search(request, [&](const QList<DirectoryEntry>& page) {
+            pages << page.size();
+            for (const DirectoryEntry& entry : page) {
+                logins.insert(entry.getValue("sAMAccountName"));
+            }
+            return true;
+        }));
+        QCOMPARE(pages, (QList<int>{100, 100, 50}));
+        QCOMPARE(logins.size(), UserCount);
+
+        // A page size that divides the result: no empty page at the end
+        request.pageSize = 50;
+        pages.clear();
+        QVERIFY(backend->search(request, [&pages](const QList<DirectoryEntry>& page) {
+            pages << page.size();
+            return true;
+        }));
+        QCOMPARE(pages, (QList<int>{50, 50, 50, 50, 50}));
+
+        // Stopping from the callback abandons the rest
+        pages.clear();
+        QVERIFY(backend->search(request, [&pages](const QList<DirectoryEntry>& page) {
+            pages << page.size();
+            return false;
+        }));
+        QCOMPARE(pages, (QList<int>{50}));
+    }
+
+    void sortsWindows() {
+        auto backend = connected();
+        QVERIFY(backend);
+        ADManager manager(nullptr, std::move(backend));
+        QVERIFY(manager.connectToAD());
+
+        QStringList logins;
+        VlvResult result;
+        for (int first = 0; first == 0 || first < result.contentCount; first += 100) {
+            VlvWindow window;
+            window.offset = first + 1;
+            window.afterCount = 99;
+            window.contentCount = result.contentCount;
+            window.context = result.context;
+            QList<UserInfo> users;
+            QVERIFY(manager.getUsersWindow("SRV001", {SortKey{"sAMAccountName", true}}, window, users, result));
+            QCOMPARE(result.targetPosition, first + 1);
+            for (const UserInfo& user : users) {
+                logins << user.getLogin();
+            }
+        }
+
+        QCOMPARE(result.contentCount, UserCount);
+        QCOMPARE(logins.size(), UserCount);
+        QCOMPARE(logins.first(), QString("user%1").arg(UserCount, 6, 10, QChar('0')));
+        QCOMPARE(logins.last(), QString("user000001"));
+        QVERIFY(std::is_sorted(logins.rbegin(), logins.rend()));
+    }
+
+    // slapd sends member whole where AD would cut it into member;range=
+    // slices; ADManager must take either
+    void readsLargeGroups() {
+        auto backend = connected();
+        QVERIFY(backend);
+        ADManager manager(nullptr, std::move(backend));
+        QVERIFY(manager.connectToAD());
+
+        const ServerInfo server = manager.getServerInfo("SRV001");
+        QCOMPARE(server.getUsers().size(), MemberCount);
+        QCOMPARE(server.getUsers().first().toString(), userDN(1));
+        QCOMPARE(server.getUsers().last().toString(), userDN(MemberCount));
+    }
+
+    void mapsModifyErrors() {
+        auto backend = connected();
+        QVERIFY(backend);
+
+        ADObjectChangeSet missing("CN=nobody,OU=SRV001,DC=example,DC=com");
+        missing.put("displayName", "Nobody");
+        QVERIFY(!backend->modifyEntry(missing));
+        QCOMPARE(backend->lastError(), DirectoryError::NoSuchObject);
+
+        ADObjectChangeSet duplicateValue("CN=SRV001-Group,OU=SRV001,DC=example,DC=com");
+        duplicateValue.append("member", {userDN(1)});
+        QVERIFY(!backend->modifyEntry(duplicateValue));
+        QCOMPARE(backend->lastError(), DirectoryError::AlreadyExists);
+
+        ADObjectChangeSet absentValue("CN=SRV001-Group,OU=SRV001,DC=example,DC=com");
+        absentValue.remove("member", {"CN=stranger,OU=SRV001,DC=example,DC=com"});
+        QVERIFY(!backend->modifyEntry(absentValue));
+        QCOMPARE(backend->lastError(), DirectoryError::NoSuchAttribute);
+
+        ADObjectChangeSet unknownAttribute(userDN(1));
+        unknownAttribute.put("notInTheSchema", "x");
+        QVERIFY(!backend->modifyEntry(unknownAttribute));
+        QCOMPARE(backend->lastError(), DirectoryError::InvalidArgument);
+
+        DirectoryEntry existing(userDN(2));
+        existing.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+        existing.setValue("cn", "user000002");
+        existing.setValue("sn", "Synthetic");
+        QVERIFY(!backend->addEntry(existing));
+        QCOMPARE(backend->lastError(), DirectoryError::AlreadyExists);
+
+        // A batch keeps going past failures and reports each one
+        ADObjectChangeSet rename(userDN(3));
+        rename.put("displayName", "Renamed");
+        QList<DirectoryWriteResult> results;
+        QVERIFY(backend->modifyEntries({missing, rename, duplicateValue}, results));
+        QCOMPARE(results.size(), 3);
+        QCOMPARE(results[0].error, DirectoryError::NoSuchObject);
+        QCOMPARE(results[1].error, DirectoryError::None);
+        QCOMPARE(results[2].error, DirectoryError::AlreadyExists);
+
+        DirectoryEntry renamed;
+        QVERIFY(backend->readEntry(userDN(3), {"displayName"}, renamed));
+        QCOMPARE(renamed.getValue("displayName"), QString("Renamed"));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestLdapDirectoryBackend)
+#include "tst_ldapdirectorybackend.moc"
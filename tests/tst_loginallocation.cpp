@@ -0,0 +1,114 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+class TestLoginAllocation : public QObject {
+    Q_OBJECT
+
+private:
+    // A connected manager whose directory already holds the given logins
+    static std::unique_ptr<ADManager> managerWith(const QStringList& logins) {
+        auto manager = std::make_unique<ADManager>(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        if (!manager->connectToAD()) {
+            return nullptr;
+        }
+
+        IDirectoryBackend* backend = manager->getBackend();
+        DirectoryEntry ou("OU=SRV001,DC=example,DC=com");
+        ou.setValues("objectClass", {"top", "organizationalUnit"});
+        backend->addEntry(ou);
+        for (const QString& login : logins) {
+            DirectoryEntry user(QString("CN=%1,OU=SRV001,DC=example,DC=com").arg(login));
+            user.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+            user.setValue("sAMAccountName", login);
+            backend->addEntry(user);
+        }
+        return manager;
+    }
+
+    static UserInfo userNamed(const QString& login) {
+        UserInfo user;
+        user.setLogin(login);
+        return user;
+    }
+
+private slots:
+    void indexParsesSuffixes() {
+        LoginIndex index;
+        index.load("IPetrenko", {"IPetrenko", "ipetrenko1", "IPetrenko01", "IPetrenkova", "IPetrenko7"});
+        QCOMPARE(index.takenSuffixes("IPetrenko"), (std::set<quint32>{0, 1, 7}));
+        QCOMPARE(index.lowestFree("IPetrenko"), QString("IPetrenko2"));
+
+        index.noteTaken("IPetrenko2");
+        QCOMPARE(index.lowestFree("IPETRENKO"), QString("IPETRENKO3"));
+        QVERIFY(!index.isLoaded("OKovalenko"));
+    }
+
+    void uniqueLoginSkipsTakenSuffixes() {
+        auto manager = managerWith({"IPetrenko", "IPetrenko1", "IPetrenko3"});
+        QVERIFY(manager);
+        QCOMPARE(manager->generateUniqueLogin("Ivan", "Petrenko"), QString("IPetrenko2"));
+        QCOMPARE(manager->generateUniqueLogin("Olena", "Kovalenko"), QString("OKovalenko"));
+        QVERIFY(manager->getLoginIndex()->isLoaded("IPetrenko"));
+    }
+
+    void batchGetsDistinctLogins() {
+        auto manager = managerWith({"IPetrenko", "IPetrenko1", "IPetrenko3"});
+        QVERIFY(manager);
+
+        QList<NormalizedUser> users;
+        users << NormalizedUser("", "Ivan Petrenko") << NormalizedUser("", "Igor Petrenko")
+              << NormalizedUser("", "Nobody") << NormalizedUser("", "Ivan Petrenko")
+              << NormalizedUser("", "Olena Kovalenko");
+        // An explicit login that collides with one the batch hands out
+        NormalizedUser overlapping("", "Ira Petrenko");
+        overlapping.setGeneratedLogin("IPetrenko2");
+        users << overlapping;
+
+        QVERIFY(manager->allocateLogins(users));
+        QCOMPARE(users[0].getGeneratedLogin(), QString("IPetrenko2"));
+        QCOMPARE(users[1].getGeneratedLogin(), QString("IPetrenko4"));
+        QVERIFY(!users[2].getIsValid());
+        QCOMPARE(users[3].getGeneratedLogin(), QString("IPetrenko5"));
+        QCOMPARE(users[4].getGeneratedLogin(), QString("OKovalenko"));
+        QCOMPARE(users[5].getGeneratedLogin(), QString("IPetrenko21"));
+    }
+
+    // Another admin creates logins after this manager loaded their base
+    void loginTakenElsewhereIsNotHandedOut() {
+        auto manager = managerWith({"IPetrenko"});
+        QVERIFY(manager);
+        QCOMPARE(manager->generateUniqueLogin("Ivan", "Petrenko"), QString("IPetrenko1"));
+        QVERIFY(manager->getLoginIndex()->isLoaded("IPetrenko"));
+
+        // Same directory, its own login index
+        ADManager other(nullptr, manager->getBackend()->clone());
+        QVERIFY(other.connectToAD());
+
+        QVERIFY(other.createUser(userNamed("IPetrenko1"), "SRV002"));
+        QCOMPARE(manager->generateUniqueLogin("Ivan", "Petrenko"), QString("IPetrenko2"));
+
+        QVERIFY(other.createUser(userNamed("IPetrenko2"), "SRV002"));
+        QList<NormalizedUser> users{NormalizedUser("", "Ivan Petrenko")};
+        QVERIFY(manager->allocateLogins(users));
+        QCOMPARE(users[0].getGeneratedLogin(), QString("IPetrenko3"));
+
+        // A create that loses the race fails, and the index learns the login
+        QVERIFY(other.createUser(userNamed("IPetrenko3"), "SRV002"));
+        QSignalSpy errors(manager.get(), &ADManager::error);
+        QVERIFY(!manager->createUser(userNamed("IPetrenko3"), "SRV002"));
+        QCOMPARE(errors.count(), 1);
+        QCOMPARE(manager->getLoginIndex()->lowestFree("IPetrenko"), QString("IPetrenko4"));
+    }
+
+    void notConnectedFails() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QSignalSpy errors(&manager, &ADManager::error);
+        QList<NormalizedUser> users{NormalizedUser("", "Ivan Petrenko")};
+        QVERIFY(!manager.allocateLogins(users));
+        QCOMPARE(errors.count(), 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestLoginAllocation)
+#include "tst_loginallocation.moc"
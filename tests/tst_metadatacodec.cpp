@@ -0,0 +1,123 @@
+#include <QtTest>
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonArray>
+#include "utils/MetadataCodec.h"
+
+class TestMetadataCodec : public QObject {
+    Q_OBJECT
+
+private:
+    static QJsonObject sample(int tags) {
+        QJsonObject metadata;
+        metadata["owner"] = "Infrastructure";
+        metadata["environment"] = "prod";
+        metadata["rdpPort"] = 3389;
+        metadata["maintenance"] = false;
+        QJsonArray list;
+        for (int i = 0; i < tags; ++i) {
+            list.append(QString("tag-%1").arg(i));
+        }
+        metadata["tags"] = list;
+        return metadata;
+    }
+
+    // What a server group typically carries
+    static QJsonObject realistic() {
+        QJsonObject metadata = sample(8);
+        metadata["description"] = "Terminal server for the accounting department, 2nd floor";
+        metadata["contact"] = "helpdesk@example.com";
+        metadata["createdAt"] = "2026-03-14T09:26:53Z";
+        metadata["maxUsers"] = 40;
+        return metadata;
+    }
+
+    static void encodings() {
+        QTest::addColumn<QString>("encoded");
+        const QJsonObject metadata = realistic();
+        QTest::newRow("json") << MetadataCodec::encodeJson(metadata);
+        QTest::newRow("cbor") << MetadataCodec::encodeBinary(metadata, false);
+        QTest::newRow("cbor compressed") << MetadataCodec::encodeBinary(metadata, true);
+    }
+
+private slots:
+    void binaryRoundTrip() {
+        const QJsonObject metadata = sample(3);
+        const QString plain = MetadataCodec::encodeBinary(metadata, false);
+        QVERIFY(MetadataCodec::isBinary(plain));
+        QCOMPARE(MetadataCodec::decode(plain), metadata);
+
+        const QJsonObject large = sample(60);
+        const QString compressed = MetadataCodec::encodeBinary(large, true);
+        QVERIFY(compressed.length() < MetadataCodec::encodeBinary(large, false).length());
+        QCOMPARE(MetadataCodec::decode(compressed), large);
+    }
+
+    void legacyJsonDecodes() {
+        const QString legacy = "{\"owner\":\"Infrastructure\",\"rdpPort\":3389}";
+        const QJsonObject metadata = MetadataCodec::decode(legacy);
+        QCOMPARE(metadata.value("owner").toString(), QString("Infrastructure"));
+        QCOMPARE(metadata.value("rdpPort").toInt(), 3389);
+        QVERIFY(!MetadataCodec::isBinary(legacy));
+    }
+
+    void encodePicksShortest() {
+        for (int tags : {0, 3, 60}) {
+            const QJsonObject metadata = sample(tags);
+            const QString encoded = MetadataCodec::encode(metadata);
+            QVERIFY(encoded.length() <= MetadataCodec::encodeJson(metadata).length());
+            QCOMPARE(MetadataCodec::decode(encoded), metadata);
+        }
+        QCOMPARE(MetadataCodec::encode(QJsonObject()), QString("{}"));
+    }
+
+    void unreadableValuesDecodeEmpty() {
+        QVERIFY(MetadataCodec::decode(QString()).isEmpty());
+        QVERIFY(MetadataCodec::decode("not json").isEmpty());
+        QVERIFY(MetadataCodec::decode("adm1:***").isEmpty());
+
+        // A flag this version does not know
+        QByteArray payload(1, char(0x80));
+        payload.append(QCborValue(QCborMap{{"a", 1}}).toCbor());
+        QVERIFY(MetadataCodec::decode("adm1:" + QString::fromLatin1(payload.toBase64())).isEmpty());
+    }
+
+    void benchmarkDecode_data() {
+        encodings();
+    }
+
+    // Every getServerMetadata decodes the stored value; the encoded length
+    // is what the attribute carries on the wire
+    void benchmarkDecode() {
+        QFETCH(QString, encoded);
+        qInfo("%s: %lld characters", QTest::currentDataTag(), qint64(encoded.length()));
+        QCOMPARE(MetadataCodec::decode(encoded), realistic());
+
+        QBENCHMARK {
+            MetadataCodec::decode(encoded);
+        }
+    }
+
+    void benchmarkEncode_data() {
+        QTest::addColumn<int>("format");
+        QTest::newRow("json") << 0;
+        QTest::newRow("cbor") << 1;
+        QTest::newRow("cbor compressed") << 2;
+    }
+
+    void benchmarkEncode() {
+        QFETCH(int, format);
+        const QJsonObject metadata = realistic();
+
+        QBENCHMARK {
+            if (format == 0) {
+                MetadataCodec::encodeJson(metadata);
+            } else {
+                MetadataCodec::encodeBinary(metadata, format == 2);
+            }
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(TestMetadataCodec)
+#include "tst_metadatacodec.moc"
@@ -0,0 +1,203 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+#include "services/OperationMetrics.h"
+
+class TestOperationMetrics : public QObject {
+    Q_OBJECT
+
+private:
+    static constexpr int OperationCount = int(DirectoryOperation::Count);
+
+    // Two searches, 1.5 ms and a failed 2.5 ms
+    static void recordSearches(OperationMetrics& metrics) {
+        metrics.record(DirectoryOperation::Search, 1500, false);
+        metrics.record(DirectoryOperation::Search, 2500, true);
+    }
+
+private slots:
+    void smallValuesHaveTheirOwnBucket() {
+        for (qint64 micros = 0; micros < 2 * LatencyHistogram::SubBuckets; ++micros) {
+            QCOMPARE(LatencyHistogram::bucketIndex(micros), int(micros));
+            QCOMPARE(LatencyHistogram::bucketUpperBound(int(micros)), micros);
+        }
+        QCOMPARE(LatencyHistogram::bucketIndex(-5), 0);
+    }
+
+    // Above 64 us a bucket spans 1/32 of its power of two: [64, 65],
+    // [1000, 1007], ... and the last one ends at 2^40 - 1
+    void largeValuesStayWithinThreePercent() {
+        QCOMPARE(LatencyHistogram::bucketIndex(64), 64);
+        QCOMPARE(LatencyHistogram::bucketUpperBound(64), qint64(65));
+        QCOMPARE(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketIndex(1000)), qint64(1007));
+
+        const qint64 largest = (qint64(1) << (LatencyHistogram::MaxExponent + 1)) - 1;
+        QCOMPARE(LatencyHistogram::bucketIndex(largest), LatencyHistogram::BucketCount - 1);
+        QCOMPARE(LatencyHistogram::bucketIndex(largest + 1000), LatencyHistogram::BucketCount - 1);
+        QCOMPARE(LatencyHistogram::bucketUpperBound(LatencyHistogram::BucketCount - 1), largest);
+
+        int previous = -1;
+        for (qint64 micros = 1; micros < largest; micros = micros * 5 / 4 + 1) {
+            const int index = LatencyHistogram::bucketIndex(micros);
+            QVERIFY(index >= previous);
+            previous = index;
+
+            const qint64 lower = index == 0 ? 0 : LatencyHistogram::bucketUpperBound(index - 1) + 1;
+            const qint64 upper = LatencyHistogram::bucketUpperBound(index);
+            QVERIFY2(lower <= micros && micros <= upper, qPrintable(QString::number(micros)));
+            QVERIFY2(double(upper - lower) <= micros / 32.0, qPrintable(QString::number(micros)));
+        }
+    }
+
+    void summaryReportsRankedBuckets() {
+        LatencyHistogram histogram;
+        QCOMPARE(histogram.summary().count, quint64(0));
+        QCOMPARE(histogram.summary().p99Us, qint64(0));
+
+        // 1..100 us, every tenth one failed
+        for (int micros = 1; micros <= 100; ++micros) {
+            histogram.record(micros, micros % 10 == 0);
+        }
+        LatencySummary summary = histogram.summary();
+        QCOMPARE(summary.count, quint64(100));
+        QCOMPARE(summary.errors, quint64(10));
+        QCOMPARE(summary.sumUs, qint64(5050));
+        QCOMPARE(summary.maxUs, qint64(100));
+        QCOMPARE(summary.p50Us, qint64(50));
+        QCOMPARE(summary.p90Us, qint64(91)); // bucket [90, 91]
+        QCOMPARE(summary.p99Us, qint64(99)); // bucket [98, 99]
+
+        // A bucket bound above the largest value seen is capped by it
+        histogram.reset();
+        histogram.record(1000, false);
+        summary = histogram.summary();
+        QCOMPARE(summary.count, quint64(1));
+        QCOMPARE(summary.p50Us, qint64(1000));
+        QCOMPARE(summary.p99Us, qint64(1000));
+
+        // One slow call in a hundred shows in p99 only
+        histogram.reset();
+        for (int i = 0; i < 99; ++i) {
+            histogram.record(2000, false);
+        }
+        histogram.record(5000000, false);
+        summary = histogram.summary();
+        QVERIFY(qAbs(summary.p50Us - 2000) <= 2000 / 32);
+        QVERIFY(qAbs(summary.p90Us - 2000) <= 2000 / 32);
+        QVERIFY(qAbs(summary.p99Us - 2000) <= 2000 / 32);
+        histogram.record(5000000, false);
+        QVERIFY(qAbs(histogram.summary().p99Us - 5000000) <= 5000000 / 32);
+    }
+
+    void exportsPrometheusText() {
+        OperationMetrics metrics;
+        recordSearches(metrics);
+        const QStringList lines = QString::fromUtf8(metrics.toPrometheus()).split('\n', Qt::SkipEmptyParts);
+
+        QCOMPARE(lines.filter(QRegularExpression("^# TYPE ")),
+                 (QStringList{"# TYPE admanager_operation_duration_seconds summary",
+                              "# TYPE admanager_operation_errors_total counter",
+                              "# TYPE admanager_operation_max_duration_seconds gauge"}));
+
+        // name{labels} value, one summary (3 quantiles, _sum, _count), error
+        // counter and maximum per operation
+        const QRegularExpression sample(R"(^admanager_[a-z_]+\{operation="[a-z_]+"(,quantile="0\.\d+")?\} [0-9.e+-]+$)");
+        int samples = 0;
+        for (const QString& line : lines) {
+            if (!line.startsWith('#')) {
+                QVERIFY2(sample.match(line).hasMatch(), qPrintable(line));
+                ++samples;
+            }
+        }
+        QCOMPARE(samples, OperationCount * 7);
+
+        QVERIFY(lines.contains("admanager_operation_duration_seconds{operation=\"search\",quantile=\"0.5\"} 0.001503"));
+        QVERIFY(lines.contains("admanager_operation_duration_seconds{operation=\"search\",quantile=\"0.99\"} 0.0025"));
+        QVERIFY(lines.contains("admanager_operation_duration_seconds_sum{operation=\"search\"} 0.004"));
+        QVERIFY(lines.contains("admanager_operation_duration_seconds_count{operation=\"search\"} 2"));
+        QVERIFY(lines.contains("admanager_operation_errors_total{operation=\"search\"} 1"));
+        QVERIFY(lines.contains("admanager_operation_max_duration_seconds{operation=\"search\"} 0.0025"));
+        QVERIFY(lines.contains("admanager_operation_duration_seconds_count{operation=\"allocate_login\"} 0"));
+    }
+
+    void exportsJson() {
+        OperationMetrics metrics;
+        recordSearches(metrics);
+
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(metrics.toJson(), &parseError);
+        QCOMPARE(parseError.error, QJsonParseError::NoError);
+        const QJsonObject root = document.object();
+        QVERIFY(QDateTime::fromString(root.value("timestamp").toString(), Qt::ISODateWithMs).isValid());
+
+        const QJsonArray operations = root.value("operations").toArray();
+        QCOMPARE(operations.size(), OperationCount);
+        for (int i = 0; i < OperationCount; ++i) {
+            QCOMPARE(operations[i].toObject().value("name").toString(),
+                     OperationMetrics::operationName(DirectoryOperation(i)));
+        }
+
+        const QJsonObject search = operations[int(DirectoryOperation::Search)].toObject();
+        QCOMPARE(search.value("count").toInt(), 2);
+        QCOMPARE(search.value("errors").toInt(), 1);
+        QCOMPARE(search.value("sum_us").toInt(), 4000);
+        QCOMPARE(search.value("p50_us").toInt(), 1503);
+        QCOMPARE(search.value("p90_us").toInt(), 2500);
+        QCOMPARE(search.value("p99_us").toInt(), 2500);
+        QCOMPARE(search.value("max_us").toInt(), 2500);
+    }
+
+    void writesExportFiles() {
+        OperationMetrics metrics;
+        recordSearches(metrics);
+        QTemporaryDir dir;
+
+        const QString prometheus = dir.filePath("metrics.prom");
+        QVERIFY(metrics.writeToFile(prometheus, OperationMetrics::Format::Prometheus));
+        QFile file(prometheus);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), metrics.toPrometheus());
+        file.close();
+
+        const QString json = dir.filePath("metrics.json");
+        QVERIFY(metrics.writeToFile(json, OperationMetrics::Format::Json));
+        file.setFileName(json);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(QJsonDocument::fromJson(file.readAll()).isObject());
+
+        QString error;
+        QVERIFY(!metrics.writeToFile(dir.filePath("missing/metrics.prom"), OperationMetrics::Format::Prometheus, &error));
+        QVERIFY(!error.isEmpty());
+    }
+
+    void countsOutermostCallsThatReachTheDirectory() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(8, 2);
+        OperationMetrics& metrics = OperationMetrics::global();
+        metrics.reset();
+
+        // The second check is answered from memory
+        QVERIFY(manager.serverExists("SRV001"));
+        QVERIFY(manager.serverExists("SRV001"));
+        QCOMPARE(metrics.summary(DirectoryOperation::ExistsCheck).count, quint64(1));
+
+        // Its own existence check is part of the member read
+        QVERIFY(manager.streamServerMembers("SRV002", [](const QStringList&) { return true; }));
+        QCOMPARE(metrics.summary(DirectoryOperation::GetUsers).count, quint64(1));
+        QCOMPARE(metrics.summary(DirectoryOperation::ExistsCheck).count, quint64(1));
+
+        // A failed call counts as an error of its operation
+        QVERIFY(!manager.streamServerMembers("SRV404", [](const QStringList&) { return true; }));
+        QCOMPARE(metrics.summary(DirectoryOperation::GetUsers).count, quint64(2));
+        QCOMPARE(metrics.summary(DirectoryOperation::GetUsers).errors, quint64(1));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestOperationMetrics)
+#include "tst_operationmetrics.moc"
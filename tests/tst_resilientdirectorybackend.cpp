@@ -0,0 +1,159 @@
+#include <QtTest>
+#include "services/InMemoryDirectoryBackend.h"
+#include "services/ResilientDirectoryBackend.h"
+
+// Applies the first modify and then loses the reply; every later modify is
+// answered with retryError, as a strict directory answers a repeated change
+class LostReplyBackend : public InMemoryDirectoryBackend {
+public:
+    DirectoryError retryError = DirectoryError::None;
+    int modifies = 0;
+
+    bool modifyEntry(const ADObjectChangeSet& changes) override {
+        if (modifies++ == 0) {
+            InMemoryDirectoryBackend::modifyEntry(changes);
+            setError(DirectoryError::Timeout, "reply lost");
+            return false;
+        }
+        setError(retryError, "repeated change");
+        return false;
+    }
+};
+
+// Sends only the first sendBeforeCut change sets of a batch, then loses the
+// connection
+class CutBatchBackend : public InMemoryDirectoryBackend {
+public:
+    int sendBeforeCut = 0;
+    QString endpoint = "DC=example,DC=com";
+
+    QString getEndpoint() const override { return endpoint; }
+
+    bool modifyEntries(const QList<ADObjectChangeSet>& changes, QList<DirectoryWriteResult>& results) override {
+        InMemoryDirectoryBackend::modifyEntries(changes.mid(0, sendBeforeCut), results);
+        setError(DirectoryError::Unavailable, "connection lost");
+        return false;
+    }
+};
+
+class TestResilientDirectoryBackend : public QObject {
+    Q_OBJECT
+
+private:
+    static bool retriedModify(const ADObjectChangeSet& changes, DirectoryError retryError, DirectoryError* error) {
+        auto inner = std::make_unique<LostReplyBackend>();
+        inner->retryError = retryError;
+        LostReplyBackend* lostReply = inner.get();
+
+        RetryPolicy policy;
+        policy.maxAttempts = 2;
+        policy.initialBackoffMs = 1;
+        ResilientDirectoryBackend backend(std::move(inner), policy);
+        backend.connect(QString());
+        DirectoryEntry entry("CN=jdoe,DC=example,DC=com");
+        entry.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+        entry.setValues("mail", {"old@example.com"});
+        lostReply->addEntry(entry);
+
+        const bool ok = backend.modifyEntry(changes);
+        *error = backend.lastError();
+        return ok && lostReply->modifies == 2;
+    }
+
+    // Five accounts and a rename of each
+    static QList<ADObjectChangeSet> renames(IDirectoryBackend& backend) {
+        QList<ADObjectChangeSet> changes;
+        for (int i = 1; i <= 5; ++i) {
+            const QString dn = QString("CN=u%1,DC=example,DC=com").arg(i);
+            DirectoryEntry entry(dn);
+            entry.setValues("objectClass", {"top", "person", "organizationalPerson", "user"});
+            backend.addEntry(entry);
+            ADObjectChangeSet change(dn);
+            change.put("displayName", QString("User %1").arg(i));
+            changes << change;
+        }
+        return changes;
+    }
+
+private slots:
+    void appendFoundOnRetryIsDone() {
+        ADObjectChangeSet changes("CN=jdoe,DC=example,DC=com");
+        changes.append("mail", {"new@example.com"});
+        DirectoryError error;
+        QVERIFY(retriedModify(changes, DirectoryError::AlreadyExists, &error));
+        QCOMPARE(error, DirectoryError::None);
+    }
+
+    void removeMissingOnRetryIsDone() {
+        ADObjectChangeSet changes("CN=jdoe,DC=example,DC=com");
+        changes.remove("mail", {"old@example.com"});
+        DirectoryError error;
+        QVERIFY(retriedModify(changes, DirectoryError::NoSuchAttribute, &error));
+    }
+
+    void mixedChangesAreNotAssumedApplied() {
+        ADObjectChangeSet changes("CN=jdoe,DC=example,DC=com");
+        changes.put("displayName", "John Doe").append("mail", {"new@example.com"});
+        DirectoryError error;
+        QVERIFY(!retriedModify(changes, DirectoryError::AlreadyExists, &error));
+        QCOMPARE(error, DirectoryError::AlreadyExists);
+    }
+
+    void errorMustMatchTheOperation() {
+        ADObjectChangeSet changes("CN=jdoe,DC=example,DC=com");
+        changes.append("mail", {"new@example.com"});
+        DirectoryError error;
+        QVERIFY(!retriedModify(changes, DirectoryError::NoSuchAttribute, &error));
+        QCOMPARE(error, DirectoryError::NoSuchAttribute);
+
+        QVERIFY(!ResilientDirectoryBackend::isAlreadyApplied(ADObjectChangeSet("CN=x,DC=example,DC=com"),
+                                                            DirectoryError::AlreadyExists));
+    }
+
+    void unsentTailIsSentOneByOne() {
+        auto inner = std::make_unique<CutBatchBackend>();
+        CutBatchBackend* cut = inner.get();
+        cut->sendBeforeCut = 2;
+        ResilientDirectoryBackend backend(std::move(inner));
+        QVERIFY(backend.connect(QString()));
+        const QList<ADObjectChangeSet> changes = renames(*cut);
+
+        QList<DirectoryWriteResult> results;
+        QVERIFY(backend.modifyEntries(changes, results));
+        QCOMPARE(results.size(), 5);
+        for (const DirectoryWriteResult& result : results) {
+            QCOMPARE(result.error, DirectoryError::None);
+        }
+        DirectoryEntry entry;
+        QVERIFY(cut->readEntry("CN=u5,DC=example,DC=com", {"displayName"}, entry));
+        QCOMPARE(entry.getValue("displayName"), QString("User 5"));
+    }
+
+    // What cannot be sent gets no result, rather than a failure of its own
+    void unsentTailStaysWithoutResults() {
+        auto inner = std::make_unique<CutBatchBackend>();
+        CutBatchBackend* cut = inner.get();
+        cut->sendBeforeCut = 2;
+        // A circuit of its own, opened by the cut
+        cut->endpoint = "cut.example.com";
+        RetryPolicy policy;
+        policy.breakerThreshold = 1;
+        ResilientDirectoryBackend backend(std::move(inner), policy);
+        QVERIFY(backend.connect(QString()));
+        const QList<ADObjectChangeSet> changes = renames(*cut);
+
+        QList<DirectoryWriteResult> results;
+        QVERIFY(!backend.modifyEntries(changes, results));
+        QCOMPARE(results.size(), 2);
+        QCOMPARE(results[0].error, DirectoryError::None);
+        QCOMPARE(results[1].error, DirectoryError::None);
+        QCOMPARE(backend.lastError(), DirectoryError::Unavailable);
+
+        DirectoryEntry entry;
+        QVERIFY(cut->readEntry("CN=u3,DC=example,DC=com", {"displayName"}, entry));
+        QVERIFY(!entry.hasAttribute("displayName"));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestResilientDirectoryBackend)
+#include "tst_resilientdirectorybackend.moc"
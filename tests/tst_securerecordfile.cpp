@@ -0,0 +1,109 @@
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "services/ADManager.h"
+#include "services/BulkPasswordRotator.h"
+#include "services/InMemoryDirectoryBackend.h"
+#include "utils/SecureRecordFile.h"
+
+class TestSecureRecordFile : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init() {
+        if (!SecureRecordFile::isSupported()) {
+            QSKIP("Built without encryption support");
+        }
+    }
+
+    void roundTrip() {
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath("records.admrec");
+
+        SecureRecordFile file;
+        QVERIFY2(file.create(fileName, "correct horse", 1000), qPrintable(file.errorString()));
+        QVERIFY(file.append("first"));
+        QVERIFY(file.append(QByteArray(5000, 'x')));
+        file.close();
+
+        QList<QByteArray> records;
+        QString error;
+        QVERIFY2(SecureRecordFile::readAll(fileName, "correct horse", records, &error), qPrintable(error));
+        QCOMPARE(records, (QList<QByteArray>{"first", QByteArray(5000, 'x')}));
+    }
+
+    void rejectsWrongPassphrase() {
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath("records.admrec");
+
+        SecureRecordFile file;
+        QVERIFY(file.create(fileName, "correct horse", 1000));
+        QVERIFY(file.append("secret"));
+        file.close();
+
+        QList<QByteArray> records;
+        QString error;
+        QVERIFY(!SecureRecordFile::readAll(fileName, "wrong horse", records, &error));
+        QVERIFY(!error.isEmpty());
+        QVERIFY(records.isEmpty());
+    }
+
+    void rejectsTamperedFile() {
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath("records.admrec");
+
+        SecureRecordFile file;
+        QVERIFY(file.create(fileName, "correct horse", 1000));
+        QVERIFY(file.append("secret"));
+        file.close();
+
+        QFile raw(fileName);
+        QVERIFY(raw.open(QIODevice::ReadWrite));
+        raw.seek(raw.size() - 1);
+        const char last = raw.peek(1).at(0);
+        raw.write(QByteArray(1, char(last ^ 0x01)));
+        raw.close();
+
+        QList<QByteArray> records;
+        QVERIFY(!SecureRecordFile::readAll(fileName, "correct horse", records));
+    }
+
+    void rotationJournalsEveryChange() {
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath("passwords.admrec");
+
+        ADManager source(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(source.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(source.getBackend())->seedSyntheticUsers(4, 1);
+        const QStringList dns = source.getUsersForServer("SRV001") << "CN=ghost,OU=SRV001,DC=example,DC=com";
+
+        PasswordGenerator generator;
+        BulkPasswordRotator rotator(&source, &generator);
+        rotator.setConcurrency(3);
+        QSignalSpy finished(&rotator, &BulkPasswordRotator::finished);
+        QVERIFY2(rotator.start(dns, PasswordPolicy(), fileName, "passphrase"), qPrintable(rotator.errorString()));
+        QVERIFY(finished.wait(30000));
+        QCOMPARE(finished.first().at(0).toInt(), 4);
+
+        QList<QByteArray> records;
+        QVERIFY(SecureRecordFile::readAll(fileName, "passphrase", records));
+        QCOMPARE(records.size(), 2 * dns.size());
+
+        // Per account: the pending record with the password, then the outcome
+        QHash<QString, QStringList> statuses;
+        for (const QByteArray& record : records) {
+            const QJsonObject object = QJsonDocument::fromJson(record).object();
+            const QString status = object.value("status").toString();
+            statuses[object.value("dn").toString()] << status;
+            QCOMPARE(object.contains("password"), status == "pending");
+        }
+        for (const QString& dn : dns) {
+            const QString outcome = dn.startsWith("CN=ghost") ? "failed" : "rotated";
+            QCOMPARE(statuses.value(dn), (QStringList{"pending", outcome}));
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(TestSecureRecordFile)
+#include "tst_securerecordfile.moc"
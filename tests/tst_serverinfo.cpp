@@ -0,0 +1,115 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+// Misbehaves on reads of server groups on demand: fails them with an error
+// that is not retried, or answers every follow-up range read with a slice
+// that does not move forward
+class FlakyGroupBackend : public InMemoryDirectoryBackend {
+public:
+    bool failGroupReads = false;
+    bool stuckRanges = false;
+
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override {
+        const bool group = dn.startsWith("CN=SRV", Qt::CaseInsensitive);
+        if (group && failGroupReads) {
+            setError(DirectoryError::Other, "group read failed");
+            return false;
+        }
+        if (!InMemoryDirectoryBackend::readEntry(dn, attributes, entry)) {
+            return false;
+        }
+
+        AttributeRange requested;
+        if (group && stuckRanges && AttributeRange::parse(attributes.value(0), requested) && requested.low > 0) {
+            entry = DirectoryEntry(dn);
+            entry.setValues("member;range=0-1", {"CN=a,DC=example,DC=com", "CN=b,DC=example,DC=com"});
+        }
+        return true;
+    }
+};
+
+class TestServerInfo : public QObject {
+    Q_OBJECT
+
+private slots:
+    void readsMembersAndMetadata() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(8, 2);
+
+        const ServerInfo info = manager.getServerInfo("SRV002");
+        QCOMPARE(info.getName(), QString("SRV002"));
+        QCOMPARE(info.getUsers().size(), 4);
+    }
+
+    void readsLargeGroupsInRanges() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<InMemoryDirectoryBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(50000, 1);
+        backend->setMaxValRange(AttributeRange::DefaultMaxValRange);
+
+        const QList<DistinguishedName> users = manager.getServerInfo("SRV001").getUsers();
+        QCOMPARE(users.size(), 50000);
+        QCOMPARE(QSet<DistinguishedName>(users.begin(), users.end()).size(), 50000);
+
+        int ranges = 0;
+        int members = 0;
+        QVERIFY(manager.streamServerMembers("SRV001", [&](const QStringList& range) {
+            ++ranges;
+            members += range.size();
+            return true;
+        }));
+        QCOMPARE(members, 50000);
+        QCOMPARE(ranges, 34); // 33 full slices of 1500 and the rest
+
+        // Below the limit the attribute comes back whole, in one range
+        backend->setMaxValRange(50000);
+        ranges = 0;
+        QVERIFY(manager.streamServerMembers("SRV001", [&](const QStringList&) {
+            ++ranges;
+            return true;
+        }));
+        QCOMPARE(ranges, 1);
+    }
+
+    void rangeThatDoesNotAdvanceFails() {
+        auto backend = std::make_unique<FlakyGroupBackend>();
+        FlakyGroupBackend* flaky = backend.get();
+        ADManager manager(nullptr, std::move(backend));
+        QVERIFY(manager.connectToAD());
+        flaky->seedSyntheticUsers(10, 1);
+        flaky->setMaxValRange(2);
+        flaky->stuckRanges = true;
+
+        QSignalSpy errors(&manager, &ADManager::error);
+        QVERIFY(!manager.streamServerMembers("SRV001", [](const QStringList&) { return true; }));
+        QCOMPARE(errors.count(), 1);
+        QVERIFY(manager.getServerInfo("SRV001").getName().isEmpty());
+    }
+
+    void memberReadFailureIsReportedAndNotCached() {
+        auto backend = std::make_unique<FlakyGroupBackend>();
+        FlakyGroupBackend* flaky = backend.get();
+        ADManager manager(nullptr, std::move(backend));
+        QVERIFY(manager.connectToAD());
+        flaky->seedSyntheticUsers(8, 2);
+
+        QSignalSpy errors(&manager, &ADManager::error);
+        flaky->failGroupReads = true;
+        const ServerInfo failed = manager.getServerInfo("SRV001");
+        QCOMPARE(errors.count(), 1);
+        QVERIFY(errors.first().at(0).toString().contains("group read failed"));
+        QVERIFY(failed.getName().isEmpty());
+
+        // The failure left nothing behind for the next call to serve
+        flaky->failGroupReads = false;
+        const ServerInfo info = manager.getServerInfo("SRV001");
+        QCOMPARE(info.getUsers().size(), 4);
+        QCOMPARE(errors.count(), 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestServerInfo)
+#include "tst_serverinfo.moc"
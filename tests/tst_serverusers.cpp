@@ -0,0 +1,166 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+// Counts the requests that reach the directory
+class CountingBackend : public InMemoryDirectoryBackend {
+public:
+    int searches = 0;
+    int reads = 0;
+
+    bool search(const SearchRequest& request, const SearchPageCallback& onPage) override {
+        ++searches;
+        return InMemoryDirectoryBackend::search(request, onPage);
+    }
+
+    bool readEntry(const QString& dn, const QStringList& attributes, DirectoryEntry& entry) override {
+        ++reads;
+        return InMemoryDirectoryBackend::readEntry(dn, attributes, entry);
+    }
+
+    bool entryExists(const QString& dn) override {
+        ++reads;
+        return InMemoryDirectoryBackend::entryExists(dn);
+    }
+};
+
+class TestServerUsers : public QObject {
+    Q_OBJECT
+
+private slots:
+    // Every member with its attributes, from one paged search rather than a
+    // read per user
+    void listsUsersWithTheirAttributes() {
+        ADManager manager(nullptr, std::make_unique<CountingBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<CountingBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(2500, 2);
+        manager.setSearchPageSize(500);
+        backend->searches = 0;
+        backend->reads = 0;
+
+        int pages = 0;
+        connect(&manager, &ADManager::searchPageReady, this, [&pages] { ++pages; });
+        const QList<UserInfo> users = manager.getUsersWithInfoForServer("SRV001", {"lastLogonTimestamp"});
+
+        QCOMPARE(users.size(), 1250);
+        QCOMPARE(pages, 3);
+        QCOMPARE(backend->searches, 1);
+        QVERIFY2(backend->reads <= 1, qPrintable(QString("%1 reads").arg(backend->reads)));
+
+        // SRV001 holds every other synthetic user: user000001, user000003, ...
+        QSet<QString> logins;
+        for (const UserInfo& user : users) {
+            logins.insert(user.getLogin());
+            QCOMPARE(user.getServerName(), QString("SRV001"));
+            QVERIFY(user.getDistinguishedName().startsWith("CN=" + user.getLogin() + ",OU=SRV001,"));
+            QCOMPARE(user.getFirstName(), QString("User"));
+            QCOMPARE(user.getFullName(), "User " + user.getLastName());
+            QVERIFY(user.getCreatedDate().isValid());
+            QVERIFY(user.getLastLogin().isValid());
+            QVERIFY(user.isActive());
+        }
+        QCOMPARE(logins.size(), 1250);
+        QVERIFY(logins.contains("user000001"));
+        QVERIFY(logins.contains("user002499"));
+        QVERIFY(!logins.contains("user000002"));
+    }
+
+    void pagesFollowThePageSize_data() {
+        QTest::addColumn<int>("userCount");
+        QTest::addColumn<int>("pageSize");
+        QTest::addColumn<QList<int>>("pages");
+
+        QTest::newRow("exact multiple") << 1000 << 250 << QList<int>{250, 250, 250, 250};
+        QTest::newRow("short last page") << 1010 << 250 << QList<int>{250, 250, 250, 250, 10};
+        QTest::newRow("one short page") << 7 << 250 << QList<int>{7};
+        QTest::newRow("one per page") << 3 << 1 << QList<int>{1, 1, 1};
+    }
+
+    // Pages are full except the last, and an exact multiple ends without
+    // an empty page; all three entry points see the same pages
+    void pagesFollowThePageSize() {
+        QFETCH(int, userCount);
+        QFETCH(int, pageSize);
+        QFETCH(QList<int>, pages);
+
+        ADManager manager(nullptr, std::make_unique<CountingBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<CountingBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(userCount, 1);
+        manager.setSearchPageSize(pageSize);
+
+        SearchRequest request;
+        request.baseDN = "OU=SRV001,DC=example,DC=com";
+        request.filter = "(objectClass=user)";
+        request.attributes = {"sAMAccountName"};
+
+        QList<int> searched;
+        QVERIFY(manager.search(request, [&searched](const QList<DirectoryEntry>& page) {
+            searched << page.size();
+            return true;
+        }));
+        QCOMPARE(searched, pages);
+
+        QSet<QString> logins;
+        for (const DirectoryEntry& entry : manager.searchAll(request)) {
+            logins.insert(entry.getValue("sAMAccountName"));
+        }
+        QCOMPARE(logins.size(), userCount);
+
+        QList<int> streamed;
+        QVERIFY(manager.streamUsersForServer("SRV001", [&streamed](const QList<UserInfo>& page) {
+            streamed << page.size();
+            return true;
+        }));
+        QCOMPARE(streamed, pages);
+    }
+
+    // A callback that returns false ends the search: no later pages, no
+    // second search, and not an error
+    void callbackStopsTheSearch() {
+        ADManager manager(nullptr, std::make_unique<CountingBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<CountingBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(1000, 1);
+        manager.setSearchPageSize(100);
+        backend->searches = 0;
+
+        QSignalSpy errors(&manager, &ADManager::error);
+        QList<int> streamed;
+        QVERIFY(manager.streamUsersForServer("SRV001", [&streamed](const QList<UserInfo>& page) {
+            streamed << page.size();
+            return streamed.size() < 2;
+        }));
+        QCOMPARE(streamed, (QList<int>{100, 100}));
+
+        SearchRequest request;
+        request.baseDN = "OU=SRV001,DC=example,DC=com";
+        request.filter = "(objectClass=user)";
+        int pages = 0;
+        QVERIFY(manager.search(request, [&pages](const QList<DirectoryEntry>&) {
+            ++pages;
+            return false;
+        }));
+        QCOMPARE(pages, 1);
+
+        QCOMPARE(backend->searches, 2);
+        QCOMPARE(errors.count(), 0);
+    }
+
+    void missingServerListsNothing() {
+        ADManager manager(nullptr, std::make_unique<CountingBackend>());
+        QVERIFY(manager.connectToAD());
+        auto* backend = static_cast<CountingBackend*>(manager.getBackend());
+        backend->seedSyntheticUsers(10, 1);
+        backend->searches = 0;
+
+        QSignalSpy errors(&manager, &ADManager::error);
+        QVERIFY(manager.getUsersWithInfoForServer("SRV404").isEmpty());
+        QCOMPARE(errors.count(), 1);
+        QCOMPARE(backend->searches, 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestServerUsers)
+#include "tst_serverusers.moc"
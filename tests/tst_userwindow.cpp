@@ -0,0 +1,91 @@
+#include <QtTest>
+#include "services/ADManager.h"
+#include "services/InMemoryDirectoryBackend.h"
+
+// A directory without the sort and VLV controls: windows come from the
+// generic fallback, which runs the whole search and slices it client-side
+class NoVlvBackend : public InMemoryDirectoryBackend {
+public:
+    bool searchWindow(const SearchRequest& request, const VlvWindow& window,
+                      QList<DirectoryEntry>& entries, VlvResult& result) override {
+        return IDirectoryBackend::searchWindow(request, window, entries, result);
+    }
+};
+
+class TestUserWindow : public QObject {
+    Q_OBJECT
+
+private:
+    // Pages through SRV001 in windows of size rows, as the user table does
+    static QStringList pageThrough(ADManager& manager, const QList<SortKey>& order, int size, int* windows) {
+        QStringList logins;
+        VlvResult result;
+        *windows = 0;
+        for (int first = 0; *windows == 0 || first < result.contentCount; first += size) {
+            VlvWindow window;
+            window.offset = first + 1;
+            window.afterCount = size - 1;
+            window.contentCount = result.contentCount;
+            window.context = result.context;
+
+            QList<UserInfo> users;
+            if (!manager.getUsersWindow("SRV001", order, window, users, result)) {
+                return QStringList();
+            }
+            ++*windows;
+            if (result.targetPosition != first + 1) {
+                return QStringList();
+            }
+            for (const UserInfo& user : users) {
+                logins << user.getLogin();
+            }
+        }
+        return logins;
+    }
+
+    static QStringList expectedDescending(int count) {
+        QStringList logins;
+        for (int i = count; i >= 1; --i) {
+            logins << QString("user%1").arg(i, 6, 10, QChar('0'));
+        }
+        return logins;
+    }
+
+private slots:
+    void pagesThroughSortedWindows() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(250, 1);
+
+        int windows = 0;
+        const QStringList logins = pageThrough(manager, {SortKey{"sAMAccountName", true}}, 100, &windows);
+        QCOMPARE(windows, 3); // 100, 100 and a short last window of 50
+        QCOMPARE(logins, expectedDescending(250));
+    }
+
+    void fallbackMatchesTheServerSidePath() {
+        ADManager manager(nullptr, std::make_unique<NoVlvBackend>());
+        QVERIFY(manager.connectToAD());
+        static_cast<InMemoryDirectoryBackend*>(manager.getBackend())->seedSyntheticUsers(250, 1);
+
+        int windows = 0;
+        const QStringList logins = pageThrough(manager, {SortKey{"sAMAccountName", true}}, 100, &windows);
+        QCOMPARE(windows, 3);
+        QCOMPARE(logins, expectedDescending(250));
+    }
+
+    void windowOfAMissingServerFails() {
+        ADManager manager(nullptr, std::make_unique<InMemoryDirectoryBackend>());
+        QVERIFY(manager.connectToAD());
+
+        QSignalSpy errors(&manager, &ADManager::error);
+        QList<UserInfo> users;
+        VlvResult result;
+        QVERIFY(!manager.getUsersWindow("SRV404", {SortKey{"displayName", false}}, VlvWindow(), users, result));
+        QCOMPARE(errors.count(), 1);
+        QVERIFY(users.isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(TestUserWindow)
+#include "tst_userwindow.moc"